@@ -3,8 +3,7 @@
 #include "Bus.hpp"
 #include "MipsToString.hpp"
 
-#include <sstream>
-#include <iomanip>
+#include <cstdio>
 #include <fstream>
 
 AssemblyMenu::AssemblyMenu()
@@ -63,37 +62,36 @@ void AssemblyMenu::draw_menu()
 
 	for (int idx = -10; idx < 10; idx++)
 	{
-		std::stringstream asm_text;
 		unsigned int pc = cpu->current_pc + static_cast<unsigned int>(idx * 4);
 		instruction_union instruction = bus->get_word(pc);
-		// current instruction
+
+		// current instruction, next instruction
+		const char * marker = "  ";
 		if (pc == cpu->current_pc)
 		{
-			asm_text << ">>";
+			marker = ">>";
 		}
-		// next instruction
 		else if (pc == cpu->next_pc)
 		{
-			asm_text << "->";
-		}
-		else
-		{
-			asm_text << "  ";
+			marker = "->";
 		}
-		asm_text << "0x" << std::hex << std::setfill('0') << std::setw(8) << instruction.raw << "; " << MipsToString::instruction_to_string(instruction) << "\n";
-		
+
+		// formatted on the stack, this runs every frame
+		char asm_text[96];
+		int prefix_length = snprintf(asm_text, sizeof(asm_text), "%s0x%08x; ", marker, instruction.raw);
+		disassemble_instruction(instruction.raw, asm_text + prefix_length, sizeof(asm_text) - prefix_length);
+
 		if (MipsToString::is_branch_or_jump(instruction))
 		{
 			static ImVec4 red = { 1, 0, 0, 1 };
-			ImGui::TextColored(red, asm_text.str().c_str());
+			ImGui::TextColored(red, "%s", asm_text);
 		}
 		else
 		{
 			static ImVec4 yellow = { 1, 1, 0, 1 };
-			ImGui::TextColored(yellow, asm_text.str().c_str());
+			ImGui::TextColored(yellow, "%s", asm_text);
 		}
-		
-		
+
 		ImGui::SameLine();
 
 		char * buffer = assembly_comment_buffer[pc];
@@ -104,7 +102,9 @@ void AssemblyMenu::draw_menu()
 			assembly_comment_buffer[pc] = buffer;
 		}
 
-		ImGui::InputText((std::string("##") + std::to_string(idx)).c_str(), buffer, 256);
+		ImGui::PushID(idx);
+		ImGui::InputText("##comment", buffer, 256);
+		ImGui::PopID();
 	}
 
 	ImGui::End();
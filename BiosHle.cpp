@@ -0,0 +1,559 @@
+#include "BiosHle.hpp"
+#include "Cpu.hpp"
+#include "Bus.hpp"
+#include "CacheControl.hpp"
+#include "SystemControlCoprocessor.hpp"
+
+#include <iostream>
+
+static BiosHle * instance = nullptr;
+
+BiosHle * BiosHle::get_instance()
+{
+	if (instance == nullptr)
+	{
+		instance = new BiosHle();
+	}
+
+	return instance;
+}
+
+void BiosHle::reset()
+{
+	heap_start = 0;
+	heap_end = 0;
+	num_calls_handled = 0;
+	num_calls_passed_through = 0;
+}
+
+// the heap's blocks are in guest memory, only where it is has to be kept
+void BiosHle::save_state(std::stringstream& file)
+{
+	file.write(reinterpret_cast<char*>(&heap_start), sizeof(unsigned int));
+	file.write(reinterpret_cast<char*>(&heap_end), sizeof(unsigned int));
+}
+
+void BiosHle::load_state(std::stringstream& file)
+{
+	file.read(reinterpret_cast<char*>(&heap_start), sizeof(unsigned int));
+	file.read(reinterpret_cast<char*>(&heap_end), sizeof(unsigned int));
+}
+
+bool BiosHle::call(Cpu * cpu)
+{
+	Bus * bus = Bus::get_instance();
+	RegisterFile& register_file = cpu->register_file;
+
+	// the arguments are read after the jump's delay slot, which could have loaded one of them
+	unsigned int entry = cpu->current_pc & 0x1FFFFFFF;
+	unsigned int function = register_file.get_register(9, true);
+	unsigned int args[4];
+	for (unsigned int idx = 0; idx < 4; idx++)
+	{
+		args[idx] = register_file.get_register(4 + idx, true);
+	}
+
+	unsigned int table = entry == A0_ENTRY ? A0_TABLE : (entry == B0_ENTRY ? B0_TABLE : C0_TABLE);
+	unsigned int target = function < 0x100 ? bus->get_word(table + function * 4) & 0x1FFFFFFF : 0;
+	bool is_patched = target >= KERNEL_END && target < ROM_START;
+
+	unsigned int result = 0;
+	bool handled = false;
+	if (function < 0x100 && is_patched == false)
+	{
+		switch (entry)
+		{
+			case A0_ENTRY: handled = call_a0(bus, function, args, result); break;
+			case B0_ENTRY: handled = call_b0(bus, function, args, result); break;
+			case C0_ENTRY: handled = call_c0(bus, function, args, result); break;
+		}
+	}
+
+	if (handled == false)
+	{
+		num_calls_passed_through++;
+		return false;
+	}
+	num_calls_handled++;
+
+	// the whole call counts as the one instruction, it returns as if it had finished with jr ra
+	register_file.tick();
+	register_file.set_register(2, result);
+
+	unsigned int return_address = register_file.get_register(31);
+	cpu->current_pc = return_address;
+	cpu->next_instruction = CacheControl::get_instance()->fetch_instruction(return_address);
+	cpu->next_pc = return_address + 4;
+	cpu->in_delay_slot = false;
+
+	SystemControlCoprocessor::get_instance()->trigger_interrupts();
+	return true;
+}
+
+bool BiosHle::call_a0(Bus * bus, unsigned int function, const unsigned int * args, unsigned int& result)
+{
+	switch (function)
+	{
+		// strcmp
+		case 0x17:
+		// strncmp
+		case 0x18:
+		{
+			unsigned int s1 = args[0];
+			unsigned int s2 = args[1];
+			if (s1 == 0 || s2 == 0)
+			{
+				result = s1 == s2 ? 0 : (s1 == 0 ? -1 : 1);
+				return true;
+			}
+
+			unsigned int max_length = function == 0x18 ? args[2] : 0xFFFFFFFF;
+			result = 0;
+			for (unsigned int idx = 0; idx < max_length; idx++)
+			{
+				unsigned char c1 = bus->get_byte(s1 + idx);
+				unsigned char c2 = bus->get_byte(s2 + idx);
+				if (c1 != c2)
+				{
+					result = static_cast<int>(c1) - static_cast<int>(c2);
+					break;
+				}
+				if (c1 == 0)
+				{
+					break;
+				}
+			}
+		} return true;
+
+		// strcpy
+		case 0x19:
+		// strncpy, pads the rest of dst with zeroes
+		case 0x1A:
+		{
+			unsigned int dst = args[0];
+			unsigned int src = args[1];
+			if (dst == 0 || src == 0)
+			{
+				result = 0;
+				return true;
+			}
+
+			unsigned int max_length = function == 0x1A ? args[2] : 0xFFFFFFFF;
+			bool at_end = false;
+			for (unsigned int idx = 0; idx < max_length; idx++)
+			{
+				unsigned char value = at_end ? 0 : bus->get_byte(src + idx);
+				bus->set_byte(dst + idx, value);
+				at_end = value == 0;
+				if (at_end && function == 0x19)
+				{
+					break;
+				}
+			}
+			result = dst;
+		} return true;
+
+		// strlen
+		case 0x1B:
+		{
+			unsigned int src = args[0];
+			result = 0;
+			if (src != 0)
+			{
+				while (bus->get_byte(src + result) != 0)
+				{
+					result++;
+				}
+			}
+		} return true;
+
+		// toupper
+		case 0x25:
+		{
+			unsigned char value = args[0] & 0xFF;
+			result = value >= 'a' && value <= 'z' ? value - 'a' + 'A' : value;
+		} return true;
+
+		// tolower
+		case 0x26:
+		{
+			unsigned char value = args[0] & 0xFF;
+			result = value >= 'A' && value <= 'Z' ? value - 'A' + 'a' : value;
+		} return true;
+
+		// bzero
+		case 0x28:
+		// memcpy
+		case 0x2A:
+		// memset
+		case 0x2B:
+		{
+			unsigned int dst = args[0];
+			int length = static_cast<int>(function == 0x28 ? args[1] : args[2]);
+			if (dst == 0 || length <= 0 || (function == 0x2A && args[1] == 0))
+			{
+				result = 0;
+				return true;
+			}
+
+			for (int idx = 0; idx < length; idx++)
+			{
+				unsigned char value = 0;
+				if (function == 0x2A)
+				{
+					value = bus->get_byte(args[1] + idx);
+				}
+				else if (function == 0x2B)
+				{
+					value = args[1] & 0xFF;
+				}
+				bus->set_byte(dst + idx, value);
+			}
+			result = dst;
+		} return true;
+
+		// malloc
+		case 0x33:
+		{
+			if (heap_end == 0)
+			{
+				return false;
+			}
+			result = heap_alloc(bus, args[0]);
+		} return true;
+
+		// free
+		case 0x34:
+		{
+			if (heap_end == 0)
+			{
+				return false;
+			}
+			heap_free(bus, args[0]);
+		} return true;
+
+		// calloc
+		case 0x37:
+		{
+			if (heap_end == 0)
+			{
+				return false;
+			}
+			unsigned int size = args[0] * args[1];
+			result = heap_alloc(bus, size);
+			for (unsigned int idx = 0; result != 0 && idx < size; idx++)
+			{
+				bus->set_byte(result + idx, 0);
+			}
+		} return true;
+
+		// InitHeap
+		case 0x39:
+		{
+			unsigned int start = (args[0] + 3) & ~0x3;
+			unsigned int end = args[0] + args[1];
+			if (end < start + 8)
+			{
+				return false;
+			}
+
+			heap_start = start;
+			heap_end = end;
+			// one free block covering everything
+			bus->set_word(heap_start, (heap_end - heap_start - 4) & ~0x3);
+		} return true;
+
+		// putchar
+		case 0x3C:
+		{
+			put_char(args[0] & 0xFF);
+			result = args[0] & 0xFF;
+		} return true;
+
+		// puts
+		case 0x3E:
+		{
+			put_string(bus, args[0]);
+		} return true;
+	}
+
+	return false;
+}
+
+bool BiosHle::call_b0(Bus * bus, unsigned int function, const unsigned int * args, unsigned int& result)
+{
+	switch (function)
+	{
+		// DeliverEvent
+		case 0x07:
+		{
+			unsigned int base = bus->get_word(EVCB_TABLE);
+			unsigned int num_events = bus->get_word(EVCB_TABLE + 4) / EVCB_SIZE;
+			if (base == 0)
+			{
+				return false;
+			}
+
+			// a callback has to run guest code, leave the whole delivery to the bios
+			for (int pass = 0; pass < 2; pass++)
+			{
+				for (unsigned int idx = 0; idx < num_events; idx++)
+				{
+					unsigned int address = base + idx * EVCB_SIZE;
+					if (bus->get_word(address) != args[0] || bus->get_word(address + 8) != args[1] ||
+						bus->get_word(address + 4) != EVENT_ENABLED)
+					{
+						continue;
+					}
+
+					unsigned int mode = bus->get_word(address + 12);
+					if (pass == 0 && mode == EVENT_MODE_CALLBACK)
+					{
+						return false;
+					}
+					if (pass == 1 && mode == EVENT_MODE_READY)
+					{
+						bus->set_word(address + 4, EVENT_READY);
+					}
+				}
+			}
+		} return true;
+
+		// OpenEvent
+		case 0x08:
+		{
+			unsigned int base = bus->get_word(EVCB_TABLE);
+			unsigned int num_events = bus->get_word(EVCB_TABLE + 4) / EVCB_SIZE;
+			if (base == 0)
+			{
+				return false;
+			}
+
+			result = 0xFFFFFFFF;
+			for (unsigned int idx = 0; idx < num_events; idx++)
+			{
+				unsigned int address = base + idx * EVCB_SIZE;
+				if (bus->get_word(address + 4) == EVENT_FREE)
+				{
+					bus->set_word(address, args[0]);
+					bus->set_word(address + 4, EVENT_DISABLED);
+					bus->set_word(address + 8, args[1]);
+					bus->set_word(address + 12, args[2]);
+					bus->set_word(address + 16, args[3]);
+					result = EVENT_HANDLE_BASE | idx;
+					break;
+				}
+			}
+		} return true;
+
+		// CloseEvent
+		case 0x09:
+		// EnableEvent
+		case 0x0C:
+		// DisableEvent
+		case 0x0D:
+		{
+			unsigned int address = get_event_address(bus, args[0]);
+			if (address == 0)
+			{
+				return false;
+			}
+
+			if (function == 0x09)
+			{
+				bus->set_word(address + 4, EVENT_FREE);
+			}
+			else if (bus->get_word(address + 4) != EVENT_FREE)
+			{
+				bus->set_word(address + 4, function == 0x0C ? EVENT_ENABLED : EVENT_DISABLED);
+			}
+			result = 1;
+		} return true;
+
+		// WaitEvent, only when it doesn't have to wait
+		case 0x0A:
+		// TestEvent
+		case 0x0B:
+		{
+			unsigned int address = get_event_address(bus, args[0]);
+			if (address == 0)
+			{
+				return false;
+			}
+
+			unsigned int status = bus->get_word(address + 4);
+			if (status == EVENT_READY)
+			{
+				bus->set_word(address + 4, EVENT_ENABLED);
+				result = 1;
+			}
+			else if (function == 0x0A && status == EVENT_ENABLED)
+			{
+				return false;
+			}
+			else
+			{
+				result = 0;
+			}
+		} return true;
+
+		// putchar
+		case 0x3D:
+		{
+			put_char(args[0] & 0xFF);
+			result = args[0] & 0xFF;
+		} return true;
+
+		// puts
+		case 0x3F:
+		{
+			put_string(bus, args[0]);
+		} return true;
+	}
+
+	return false;
+}
+
+bool BiosHle::call_c0(Bus * bus, unsigned int function, const unsigned int * args, unsigned int& result)
+{
+	// each priority has a chain of handlers, the first word of each is the next one in the chain
+	unsigned int priority = args[0];
+	unsigned int handler = args[1];
+	unsigned int base = bus->get_word(EXCB_TABLE);
+	if (base == 0 || priority >= bus->get_word(EXCB_TABLE + 4) / 8)
+	{
+		return false;
+	}
+	unsigned int chain = base + priority * 8;
+
+	switch (function)
+	{
+		// SysEnqIntRP, adds the handler to the front of the chain
+		case 0x02:
+		{
+			bus->set_word(handler, bus->get_word(chain));
+			bus->set_word(chain, handler);
+			result = 0;
+		} return true;
+
+		// SysDeqIntRP
+		case 0x03:
+		{
+			// a corrupted chain could loop forever
+			static const unsigned int MAX_CHAIN_LENGTH = 256;
+
+			unsigned int previous = chain;
+			unsigned int current = bus->get_word(chain);
+			for (unsigned int idx = 0; current != 0 && idx < MAX_CHAIN_LENGTH; idx++)
+			{
+				if (current == handler)
+				{
+					bus->set_word(previous, bus->get_word(current));
+					break;
+				}
+				previous = current;
+				current = bus->get_word(current);
+			}
+			result = 0;
+		} return true;
+	}
+
+	return false;
+}
+
+// every block starts with a word holding its size, the bottom bit is set while it is in use
+unsigned int BiosHle::heap_alloc(Bus * bus, unsigned int size)
+{
+	size = size == 0 ? 4 : (size + 3) & ~0x3;
+
+	unsigned int address = heap_start;
+	while (address + 4 <= heap_end)
+	{
+		unsigned int header = bus->get_word(address);
+		unsigned int block_size = header & ~0x3;
+		// the guest has written over the heap
+		if (block_size > heap_end - address - 4)
+		{
+			return 0;
+		}
+
+		if ((header & 0x1) == 0)
+		{
+			// join up with any free blocks after this one
+			unsigned int next = address + 4 + block_size;
+			while (next + 4 <= heap_end && (bus->get_word(next) & 0x1) == 0)
+			{
+				unsigned int next_size = bus->get_word(next) & ~0x3;
+				if (next_size > heap_end - next - 4)
+				{
+					break;
+				}
+				block_size += 4 + next_size;
+				next = address + 4 + block_size;
+			}
+
+			if (block_size >= size)
+			{
+				// only split off what's left if it can hold something
+				if (block_size - size >= 8)
+				{
+					bus->set_word(address + 4 + size, block_size - size - 4);
+					block_size = size;
+				}
+				bus->set_word(address, block_size | 0x1);
+				return address + 4;
+			}
+			bus->set_word(address, block_size);
+		}
+		address += 4 + block_size;
+	}
+
+	return 0;
+}
+
+void BiosHle::heap_free(Bus * bus, unsigned int address)
+{
+	if (address < heap_start + 4 || address >= heap_end)
+	{
+		return;
+	}
+
+	bus->set_word(address - 4, bus->get_word(address - 4) & ~0x1);
+}
+
+unsigned int BiosHle::get_event_address(Bus * bus, unsigned int event)
+{
+	unsigned int base = bus->get_word(EVCB_TABLE);
+	unsigned int num_events = bus->get_word(EVCB_TABLE + 4) / EVCB_SIZE;
+	unsigned int index = event & 0xFFFF;
+	if (base == 0 || (event & 0xFFFF0000) != EVENT_HANDLE_BASE || index >= num_events)
+	{
+		return 0;
+	}
+
+	unsigned int address = base + index * EVCB_SIZE;
+	return bus->get_word(address + 4) == EVENT_FREE ? 0 : address;
+}
+
+void BiosHle::put_string(Bus * bus, unsigned int address)
+{
+	for (; address != 0; address++)
+	{
+		char value = bus->get_byte(address);
+		if (value == 0)
+		{
+			break;
+		}
+		put_char(value);
+	}
+	put_char('\n');
+}
+
+void BiosHle::put_char(char value)
+{
+	std::cout << value;
+	if (value == '\n')
+	{
+		std::cout.flush();
+	}
+}
\ No newline at end of file
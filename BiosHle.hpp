@@ -0,0 +1,90 @@
+#pragma once
+#include <sstream>
+
+class Cpu;
+class Bus;
+
+// Native versions of the hot kernel functions, games call them by jumping to 0xA0, 0xB0 or 0xC0 with the
+// function number in t1 and the arguments in a0-a3, the result goes back in v0 and they return to ra.
+// A call which isn't implemented here (or which would have to run guest code, e.g. an event callback)
+// carries on into the bios' own dispatcher.
+// ref: https://problemkaputt.de/psx-spx.htm#biosfunctionsummary
+class BiosHle
+{
+public:
+	static BiosHle * get_instance();
+
+	// address is where the next instruction is fetched from
+	static bool is_entry_point(unsigned int address)
+	{
+		unsigned int physical_address = address & 0x1FFFFFFF;
+		return physical_address == A0_ENTRY || physical_address == B0_ENTRY || physical_address == C0_ENTRY;
+	}
+
+	// the cpu is about to run the first instruction at one of the entry points, returns false if the bios
+	// has to run the call itself
+	bool call(Cpu * cpu);
+
+	void reset();
+	void save_state(std::stringstream& file);
+	void load_state(std::stringstream& file);
+
+	unsigned long long num_calls_handled = 0;
+	unsigned long long num_calls_passed_through = 0;
+
+private:
+	BiosHle() = default;
+	~BiosHle() = default;
+
+	static const unsigned int A0_ENTRY = 0xA0;
+	static const unsigned int B0_ENTRY = 0xB0;
+	static const unsigned int C0_ENTRY = 0xC0;
+
+	// where the dispatchers look up each function
+	static const unsigned int A0_TABLE = 0x200;
+	static const unsigned int B0_TABLE = 0x874;
+	static const unsigned int C0_TABLE = 0x674;
+
+	// the kernel copies itself into the first 64KB of ram, a table entry pointing anywhere else in ram
+	// has been patched by the game and its version has to run
+	static const unsigned int KERNEL_END = 0x10000;
+	static const unsigned int ROM_START = 0x1FC00000;
+
+	// the tables of tables, a pointer to each table followed by its size in bytes
+	static const unsigned int EXCB_TABLE = 0x100;
+	static const unsigned int EVCB_TABLE = 0x120;
+	static const unsigned int EVCB_SIZE = 0x1C;
+	static const unsigned int EVENT_HANDLE_BASE = 0xF1000000;
+
+	enum event_status : unsigned int
+	{
+		EVENT_FREE = 0x0000,
+		EVENT_DISABLED = 0x1000,
+		EVENT_ENABLED = 0x2000,
+		EVENT_READY = 0x4000
+	};
+
+	// delivering an event either marks it ready or calls its function
+	static const unsigned int EVENT_MODE_CALLBACK = 0x1000;
+	static const unsigned int EVENT_MODE_READY = 0x2000;
+
+	// v0 is only written when the function was handled
+	bool call_a0(Bus * bus, unsigned int function, const unsigned int * args, unsigned int& result);
+	bool call_b0(Bus * bus, unsigned int function, const unsigned int * args, unsigned int& result);
+	bool call_c0(Bus * bus, unsigned int function, const unsigned int * args, unsigned int& result);
+
+	unsigned int heap_alloc(Bus * bus, unsigned int size);
+	void heap_free(Bus * bus, unsigned int address);
+
+	// returns 0 if the handle isn't an open event
+	unsigned int get_event_address(Bus * bus, unsigned int event);
+
+	// the tty goes to stdout
+	void put_char(char value);
+	void put_string(Bus * bus, unsigned int address);
+
+	// the heap is only managed here if InitHeap was, otherwise malloc and free are left to the bios so both
+	// sides agree on what the blocks look like
+	unsigned int heap_start = 0;
+	unsigned int heap_end = 0;
+};
\ No newline at end of file
@@ -0,0 +1,164 @@
+#include "BlockCache.hpp"
+#include "Bus.hpp"
+#include "Ram.hpp"
+
+#ifdef PSX_JIT
+#include "Jit.hpp"
+#endif
+
+static BlockCache * instance = nullptr;
+
+BlockCache * BlockCache::get_instance()
+{
+	if (instance == nullptr)
+	{
+		instance = new BlockCache();
+	}
+
+	return instance;
+}
+
+BlockCache::BlockCache()
+{
+	ram_blocks.resize(RAM_SIZE / 4, nullptr);
+	bios_blocks.resize(BIOS_SIZE / 4, nullptr);
+
+	Ram::get_instance()->set_watched_page_write_handler([](unsigned int page_index) {
+		BlockCache::get_instance()->invalidate_ram_page(page_index);
+	});
+}
+
+BlockCache::~BlockCache()
+{
+	clear();
+	free_invalidated_blocks();
+}
+
+cached_block * BlockCache::get_block(unsigned int address)
+{
+	// KSEG2 doesn't mirror anything code runs from
+	if (address >= 0xC0000000)
+	{
+		return nullptr;
+	}
+
+	unsigned int physical_address = address & 0x1FFFFFFF;
+	cached_block ** entry = get_block_entry(physical_address);
+	if (entry == nullptr)
+	{
+		return nullptr;
+	}
+
+	if (*entry == nullptr)
+	{
+		*entry = compile_block(address, physical_address);
+	}
+
+	return *entry;
+}
+
+cached_block ** BlockCache::get_block_entry(unsigned int physical_address)
+{
+	if (physical_address & 0x3)
+	{
+		return nullptr;
+	}
+
+	if (physical_address < RAM_SIZE)
+	{
+		return &ram_blocks[physical_address >> 2];
+	}
+
+	if (physical_address >= BIOS_START && physical_address < BIOS_START + BIOS_SIZE)
+	{
+		return &bios_blocks[(physical_address - BIOS_START) >> 2];
+	}
+
+	return nullptr;
+}
+
+cached_block * BlockCache::compile_block(unsigned int address, unsigned int physical_address)
+{
+	Bus * bus = Bus::get_instance();
+
+	cached_block * block = new cached_block();
+	block->address = physical_address;
+
+	unsigned int page_end = (physical_address & ~(PAGE_SIZE - 1)) + PAGE_SIZE;
+	unsigned int delay_slot_address = 0;
+	for (unsigned int offset = 0; block->ops.size() < MAX_BLOCK_INSTRUCTIONS && physical_address + offset < page_end; offset += 4)
+	{
+		micro_op op;
+		Cpu::decode(bus->get_word(address + offset), op);
+		block->ops.push_back(op);
+
+		if (op.ends_block || physical_address + offset == delay_slot_address)
+		{
+			break;
+		}
+
+		if (op.is_branch)
+		{
+			delay_slot_address = physical_address + offset + 4;
+		}
+	}
+
+	if (physical_address < RAM_SIZE)
+	{
+		unsigned int page_index = physical_address >> PAGE_SHIFT;
+		ram_page_blocks[page_index].push_back(block);
+		Ram::get_instance()->watch_page_writes(page_index);
+	}
+
+	num_blocks++;
+	return block;
+}
+
+void BlockCache::invalidate_ram_page(unsigned int page_index)
+{
+	for (cached_block * block : ram_page_blocks[page_index])
+	{
+		block->valid = false;
+#ifdef PSX_JIT
+		Jit::get_instance()->unlink_block(block);
+#endif
+		ram_blocks[block->address >> 2] = nullptr;
+		invalidated_blocks.push_back(block);
+		num_blocks--;
+	}
+	ram_page_blocks[page_index].clear();
+}
+
+void BlockCache::clear()
+{
+	for (unsigned int page_index = 0; page_index < NUM_RAM_PAGES; page_index++)
+	{
+		invalidate_ram_page(page_index);
+	}
+
+	for (cached_block *& block : bios_blocks)
+	{
+		if (block)
+		{
+			block->valid = false;
+#ifdef PSX_JIT
+			Jit::get_instance()->unlink_block(block);
+#endif
+			invalidated_blocks.push_back(block);
+			block = nullptr;
+			num_blocks--;
+		}
+	}
+}
+
+void BlockCache::free_invalidated_blocks()
+{
+	for (cached_block * block : invalidated_blocks)
+	{
+#ifdef PSX_JIT
+		Jit::get_instance()->release_block(block);
+#endif
+		delete block;
+	}
+	invalidated_blocks.clear();
+}
\ No newline at end of file
@@ -0,0 +1,66 @@
+#pragma once
+#include <vector>
+#include "Cpu.hpp"
+
+#ifdef PSX_JIT
+struct jit_block;
+#endif
+
+// a run of instructions decoded ahead of time, it ends after a branch and its delay slot,
+// after an instruction which can change how code is fetched or at the end of a page
+struct cached_block
+{
+	// physical address of the first instruction
+	unsigned int address = 0;
+	std::vector<micro_op> ops;
+	// cleared when the memory the block was decoded from is written to
+	bool valid = true;
+#ifdef PSX_JIT
+	// the compiled code, nullptr until the jit runs the block
+	jit_block * jit = nullptr;
+#endif
+};
+
+// blocks of code in main memory and the bios, looked up by physical address
+// main memory pages which have blocks in them are watched so writes to them throw the blocks away
+class BlockCache
+{
+public:
+	static BlockCache * get_instance();
+
+	static const unsigned int MAX_BLOCK_INSTRUCTIONS = 64;
+
+	// address is the virtual address the code is fetched from, nullptr if code there can't be cached
+	cached_block * get_block(unsigned int address);
+
+	void invalidate_ram_page(unsigned int page_index);
+	void clear();
+
+	// invalidated blocks can still be running so they are only deleted when this is called between blocks
+	void free_invalidated_blocks();
+
+	unsigned int get_num_blocks() { return num_blocks; }
+
+private:
+	BlockCache();
+	~BlockCache();
+
+	cached_block * compile_block(unsigned int address, unsigned int physical_address);
+	cached_block ** get_block_entry(unsigned int physical_address);
+
+	static const unsigned int RAM_SIZE = 1024 * 512 * 4;
+	static const unsigned int BIOS_START = 0x1FC00000;
+	static const unsigned int BIOS_SIZE = 1024 * 512;
+	static const unsigned int PAGE_SHIFT = 12;
+	static const unsigned int PAGE_SIZE = 1 << PAGE_SHIFT;
+	static const unsigned int NUM_RAM_PAGES = RAM_SIZE >> PAGE_SHIFT;
+
+	// one entry per instruction, nullptr until a block starting there has been compiled
+	std::vector<cached_block*> ram_blocks;
+	std::vector<cached_block*> bios_blocks;
+	// blocks never cross a page so each block is in exactly one of these
+	std::vector<cached_block*> ram_page_blocks[NUM_RAM_PAGES];
+	std::vector<cached_block*> invalidated_blocks;
+
+	unsigned int num_blocks = 0;
+};
\ No newline at end of file
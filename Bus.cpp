@@ -1,7 +1,13 @@
 #include "Bus.hpp"
 #include <stdexcept>
 #include <iostream>
+#include <cstring>
 #include "apg_console.h"
+#include "Cpu.hpp"
+
+#ifdef PSX_BUS_PROFILER
+#include "BusProfiler.hpp"
+#endif
 
 static Bus * instance = nullptr;
 
@@ -15,15 +21,113 @@ Bus* Bus::get_instance()
 	return instance;
 }
 
+unsigned char Bus::BusDevice::get_byte(unsigned int address)
+{
+	Cpu::get_instance()->raise_pending_exception("device doesn't support reads");
+	return 0;
+}
+
+void Bus::BusDevice::set_byte(unsigned int address, unsigned char value)
+{
+	Cpu::get_instance()->raise_pending_exception("device doesn't support writes");
+}
+
+Bus::Bus()
+{
+	pages = new page_entry[NUM_PAGES];
+}
+
+Bus::~Bus()
+{
+	delete[] pages;
+}
+
 void Bus::register_device(Bus::BusDevice * device)
 {
+	// tests register the devices they need every time they run
+	for (int idx = 0; idx < num_devices; idx++)
+	{
+		if (bus_devices[idx] == device)
+		{
+			return;
+		}
+	}
+
 	bus_devices[num_devices] = device;
 	num_devices++;
+
+	device->register_io_handlers(this);
+
+	// a new device can claim pages that have already been looked up
+	clear_pages();
+}
+
+void Bus::register_io_read(unsigned int address, io_width width, void * context, io_read_handler handler)
+{
+	io_handler & entry = get_io_handler(address, width);
+	entry.read = handler;
+	entry.read_context = context;
+}
+
+void Bus::register_io_write(unsigned int address, io_width width, void * context, io_write_handler handler)
+{
+	io_handler & entry = get_io_handler(address, width);
+	entry.write = handler;
+	entry.write_context = context;
+}
+
+Bus::io_handler & Bus::get_io_handler(unsigned int address, io_width width)
+{
+	if ((address & ~PAGE_OFFSET_MASK) != IO_PAGE_START)
+	{
+		throw std::out_of_range("address is not in the I/O page");
+	}
+
+	return io_handlers[static_cast<unsigned int>(width)][address & PAGE_OFFSET_MASK];
+}
+
+void Bus::refresh_page_memory()
+{
+	for (unsigned int page_index = 0; page_index < NUM_PAGES; page_index++)
+	{
+		refresh_page_memory(page_index << PAGE_SHIFT);
+	}
+}
+
+void Bus::refresh_page_memory(unsigned int address)
+{
+	unsigned int page_index = (address & PHYSICAL_ADDRESS_MASK) >> PAGE_SHIFT;
+	page_entry & page = pages[page_index];
+	if (page.device)
+	{
+		unsigned int page_address = page_index << PAGE_SHIFT;
+		page.read_memory = page.device->get_page_memory(page_address, false);
+		page.write_memory = page.device->get_page_memory(page_address, true);
+	}
 }
 
 unsigned char Bus::get_byte(unsigned int address)
 {
-	BusDevice * device = get_bus_device_for_address(address);
+#ifdef PSX_BUS_PROFILER
+	BusProfiler::get_instance()->record(address, io_width::BYTE, false);
+#endif
+
+	page_entry * page = get_page(address);
+	if (page && page->read_memory)
+	{
+		return page->read_memory[address & PAGE_OFFSET_MASK];
+	}
+
+	if (page && page->io_page)
+	{
+		const io_handler & handler = io_handlers[static_cast<unsigned int>(io_width::BYTE)][address & PAGE_OFFSET_MASK];
+		if (handler.read)
+		{
+			return static_cast<unsigned char>(handler.read(handler.read_context, address & PHYSICAL_ADDRESS_MASK));
+		}
+	}
+
+	BusDevice * device = get_bus_device_for_access(page, address);
 	if (device)
 	{
 		return device->get_byte(address);
@@ -34,7 +138,28 @@ unsigned char Bus::get_byte(unsigned int address)
 
 unsigned short Bus::get_halfword(unsigned int address)
 {
-	BusDevice * device = get_bus_device_for_address(address);
+#ifdef PSX_BUS_PROFILER
+	BusProfiler::get_instance()->record(address, io_width::HALFWORD, false);
+#endif
+
+	page_entry * page = get_page(address);
+	if (page && page->read_memory && (address & 0x1) == 0)
+	{
+		unsigned short value = 0;
+		memcpy(&value, &page->read_memory[address & PAGE_OFFSET_MASK], sizeof(unsigned short));
+		return value;
+	}
+
+	if (page && page->io_page)
+	{
+		const io_handler & handler = io_handlers[static_cast<unsigned int>(io_width::HALFWORD)][address & PAGE_OFFSET_MASK];
+		if (handler.read)
+		{
+			return static_cast<unsigned short>(handler.read(handler.read_context, address & PHYSICAL_ADDRESS_MASK));
+		}
+	}
+
+	BusDevice * device = get_bus_device_for_access(page, address);
 	if (device)
 	{
 		return device->get_halfword(address);
@@ -45,7 +170,28 @@ unsigned short Bus::get_halfword(unsigned int address)
 
 unsigned int Bus::get_word(unsigned int address)
 {
-	BusDevice * device = get_bus_device_for_address(address);
+#ifdef PSX_BUS_PROFILER
+	BusProfiler::get_instance()->record(address, io_width::WORD, false);
+#endif
+
+	page_entry * page = get_page(address);
+	if (page && page->read_memory && (address & 0x3) == 0)
+	{
+		unsigned int value = 0;
+		memcpy(&value, &page->read_memory[address & PAGE_OFFSET_MASK], sizeof(unsigned int));
+		return value;
+	}
+
+	if (page && page->io_page)
+	{
+		const io_handler & handler = io_handlers[static_cast<unsigned int>(io_width::WORD)][address & PAGE_OFFSET_MASK];
+		if (handler.read)
+		{
+			return handler.read(handler.read_context, address & PHYSICAL_ADDRESS_MASK);
+		}
+	}
+
+	BusDevice * device = get_bus_device_for_access(page, address);
 	if (device)
 	{
 		return device->get_word(address);
@@ -56,7 +202,28 @@ unsigned int Bus::get_word(unsigned int address)
 
 void Bus::set_byte(unsigned int address, unsigned char value)
 {
-	BusDevice * device = get_bus_device_for_address(address);
+#ifdef PSX_BUS_PROFILER
+	BusProfiler::get_instance()->record(address, io_width::BYTE, true);
+#endif
+
+	page_entry * page = get_page(address);
+	if (page && page->write_memory)
+	{
+		page->write_memory[address & PAGE_OFFSET_MASK] = value;
+		return;
+	}
+
+	if (page && page->io_page)
+	{
+		const io_handler & handler = io_handlers[static_cast<unsigned int>(io_width::BYTE)][address & PAGE_OFFSET_MASK];
+		if (handler.write)
+		{
+			handler.write(handler.write_context, address & PHYSICAL_ADDRESS_MASK, value);
+			return;
+		}
+	}
+
+	BusDevice * device = get_bus_device_for_access(page, address);
 	if (device)
 	{
 		device->set_byte(address, value);
@@ -66,7 +233,28 @@ void Bus::set_byte(unsigned int address, unsigned char value)
 
 void Bus::set_halfword(unsigned int address, unsigned short value)
 {
-	BusDevice * device = get_bus_device_for_address(address);
+#ifdef PSX_BUS_PROFILER
+	BusProfiler::get_instance()->record(address, io_width::HALFWORD, true);
+#endif
+
+	page_entry * page = get_page(address);
+	if (page && page->write_memory && (address & 0x1) == 0)
+	{
+		memcpy(&page->write_memory[address & PAGE_OFFSET_MASK], &value, sizeof(unsigned short));
+		return;
+	}
+
+	if (page && page->io_page)
+	{
+		const io_handler & handler = io_handlers[static_cast<unsigned int>(io_width::HALFWORD)][address & PAGE_OFFSET_MASK];
+		if (handler.write)
+		{
+			handler.write(handler.write_context, address & PHYSICAL_ADDRESS_MASK, value);
+			return;
+		}
+	}
+
+	BusDevice * device = get_bus_device_for_access(page, address);
 	if (device)
 	{
 		device->set_halfword(address, value);
@@ -76,13 +264,163 @@ void Bus::set_halfword(unsigned int address, unsigned short value)
 
 void Bus::set_word(unsigned int address, unsigned int value)
 {
-	BusDevice * device = get_bus_device_for_address(address);
+#ifdef PSX_BUS_PROFILER
+	BusProfiler::get_instance()->record(address, io_width::WORD, true);
+#endif
+
+	page_entry * page = get_page(address);
+	if (page && page->write_memory && (address & 0x3) == 0)
+	{
+		memcpy(&page->write_memory[address & PAGE_OFFSET_MASK], &value, sizeof(unsigned int));
+		return;
+	}
+
+	if (page && page->io_page)
+	{
+		const io_handler & handler = io_handlers[static_cast<unsigned int>(io_width::WORD)][address & PAGE_OFFSET_MASK];
+		if (handler.write)
+		{
+			handler.write(handler.write_context, address & PHYSICAL_ADDRESS_MASK, value);
+			return;
+		}
+	}
+
+	BusDevice * device = get_bus_device_for_access(page, address);
 	if (device)
 	{
 		device->set_word(address, value);
 		return;
 	}
 }
+
+Bus::BusDevice * Bus::find_device(unsigned int address)
+{
+	page_entry * page = get_page(address);
+	if (page && page->device)
+	{
+		return page->device;
+	}
+
+	if (page && page->shared_devices == nullptr)
+	{
+		return nullptr;
+	}
+
+	unsigned int device_address = page ? address & PHYSICAL_ADDRESS_MASK : address;
+	for (int idx = 0; idx < num_devices; idx++)
+	{
+		if (bus_devices[idx]->is_address_for_device(device_address))
+		{
+			return bus_devices[idx];
+		}
+	}
+
+	return nullptr;
+}
+
+Bus::page_entry * Bus::get_page(unsigned int address)
+{
+	if (address >= KSEG2_START)
+	{
+		return nullptr;
+	}
+
+	unsigned int page_index = (address & PHYSICAL_ADDRESS_MASK) >> PAGE_SHIFT;
+	page_entry * page = &pages[page_index];
+	if (page->resolved == false)
+	{
+		resolve_page(page_index);
+	}
+
+	return page;
+}
+
+// pages are looked up the first time they are accessed, probing every address in the page
+// is too slow to do for the whole address space up front but only costs a little once per page
+void Bus::resolve_page(unsigned int page_index)
+{
+	page_entry & page = pages[page_index];
+	page = page_entry();
+	page.resolved = true;
+
+	unsigned int page_address = page_index << PAGE_SHIFT;
+	page.io_page = page_address == IO_PAGE_START;
+
+	std::vector<BusDevice*> devices_in_page;
+	bool single_device_owns_page = false;
+	for (int idx = 0; idx < num_devices; idx++)
+	{
+		BusDevice * device = bus_devices[idx];
+
+		unsigned int num_addresses_claimed = 0;
+		for (unsigned int offset = 0; offset < PAGE_SIZE; offset++)
+		{
+			if (device->is_address_for_device(page_address + offset))
+			{
+				num_addresses_claimed++;
+			}
+		}
+
+		if (num_addresses_claimed > 0)
+		{
+			single_device_owns_page = devices_in_page.empty() && num_addresses_claimed == PAGE_SIZE;
+			devices_in_page.push_back(device);
+		}
+	}
+
+	if (single_device_owns_page && devices_in_page.size() == 1)
+	{
+		page.device = devices_in_page.front();
+		page.read_memory = page.device->get_page_memory(page_address, false);
+		page.write_memory = page.device->get_page_memory(page_address, true);
+	}
+	else if (devices_in_page.empty() == false)
+	{
+		shared_pages[page_index] = devices_in_page;
+		page.shared_devices = &shared_pages[page_index];
+	}
+}
+
+void Bus::clear_pages()
+{
+	for (unsigned int page_index = 0; page_index < NUM_PAGES; page_index++)
+	{
+		pages[page_index] = page_entry();
+	}
+	shared_pages.clear();
+}
+
+Bus::BusDevice * Bus::get_bus_device_for_access(page_entry * page, unsigned int& address)
+{
+	// KSEG2 is not mirrored so the device sees the full address
+	if (page == nullptr)
+	{
+		return get_bus_device_for_address(address);
+	}
+
+	address &= PHYSICAL_ADDRESS_MASK;
+
+	if (page->device)
+	{
+		return page->device;
+	}
+
+	if (page->shared_devices)
+	{
+		for (BusDevice * device : *page->shared_devices)
+		{
+			if (device->is_address_for_device(address))
+			{
+				return device;
+			}
+		}
+	}
+
+	std::cerr << std::hex << "Bus address error: " << address << std::endl;
+
+	return nullptr;
+}
+
 Bus::BusDevice * Bus::get_bus_device_for_address(unsigned int address)
 {
 	for (int idx = 0; idx < num_devices; idx++)
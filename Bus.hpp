@@ -1,6 +1,8 @@
 #pragma once
 #include <memory>
 #include <stdexcept>
+#include <vector>
+#include <unordered_map>
 
 class Bus
 {
@@ -10,12 +12,15 @@ public:
 	public:
 		virtual bool is_address_for_device(unsigned int address) = 0;
 
-		virtual unsigned char get_byte(unsigned int address)
+		// used by the debug tools
+		virtual const char * get_device_name()
 		{
-			throw std::logic_error("not implemented");
-			return 0;
+			return "Unknown";
 		}
 
+		// devices which don't override these raise a pending exception on the cpu, reads return 0
+		virtual unsigned char get_byte(unsigned int address);
+
 		virtual unsigned short get_halfword(unsigned int address)
 		{
 			unsigned short result = 0;
@@ -38,10 +43,7 @@ public:
 			return result;
 		}
 
-		virtual void set_byte(unsigned int address, unsigned char value)
-		{
-			throw std::logic_error("not implemented");
-		}
+		virtual void set_byte(unsigned int address, unsigned char value);
 
 		virtual void set_halfword(unsigned int address, unsigned short value)
 		{
@@ -64,12 +66,39 @@ public:
 				set_byte(current_address, byte_value);
 			}
 		}
+
+		// lets the bus skip the device entirely for a page backed by plain host memory
+		// address is the physical start of the page, nullptr means accesses go through the functions above
+		virtual unsigned char * get_page_memory(unsigned int address, bool for_write)
+		{
+			return nullptr;
+		}
+
+		// devices with registers in the I/O page install their handlers here when they are registered
+		virtual void register_io_handlers(Bus * bus)
+		{
+		}
 	};
 
+	enum class io_width : unsigned int
+	{
+		BYTE = 0,
+		HALFWORD = 1,
+		WORD = 2
+	};
+
+	// context is whatever was passed in when registering, address is physical
+	typedef unsigned int(*io_read_handler)(void * context, unsigned int address);
+	typedef void(*io_write_handler)(void * context, unsigned int address, unsigned int value);
+
 	static Bus* get_instance();
 
 	void register_device(BusDevice * device);
 
+	// devices need to call this if the memory they hand out from get_page_memory changes
+	void refresh_page_memory();
+	void refresh_page_memory(unsigned int address);
+
 	unsigned char get_byte(unsigned int address);
 	unsigned short get_halfword(unsigned int address);
 	unsigned int get_word(unsigned int address);
@@ -78,13 +107,107 @@ public:
 	void set_halfword(unsigned int address, unsigned short value);
 	void set_word(unsigned int address, unsigned int value);
 
+	// which device an access to address ends up at, nullptr if it is unmapped
+	BusDevice * find_device(unsigned int address);
+
+	// the I/O page (0x1F801000 - 0x1F801FFF) is dispatched through a flat table of handlers
+	// per register and access width, accesses without a handler fall back to the device functions
+	void register_io_read(unsigned int address, io_width width, void * context, io_read_handler handler);
+	void register_io_write(unsigned int address, io_width width, void * context, io_write_handler handler);
+
+	// installs handlers for every access in [start, end) which call the device functions directly,
+	// this skips finding the device without the device having to split up its register decoding
+	template <class Device>
+	void register_io_range(unsigned int start, unsigned int end, Device * device)
+	{
+		for (unsigned int address = start; address < end; address++)
+		{
+			register_io_read(address, io_width::BYTE, device, [](void * context, unsigned int address) -> unsigned int {
+				return static_cast<Device*>(context)->Device::get_byte(address);
+			});
+			register_io_write(address, io_width::BYTE, device, [](void * context, unsigned int address, unsigned int value) {
+				static_cast<Device*>(context)->Device::set_byte(address, static_cast<unsigned char>(value));
+			});
+
+			if ((address & 0x1) == 0 && address + 2 <= end)
+			{
+				register_io_read(address, io_width::HALFWORD, device, [](void * context, unsigned int address) -> unsigned int {
+					return static_cast<Device*>(context)->Device::get_halfword(address);
+				});
+				register_io_write(address, io_width::HALFWORD, device, [](void * context, unsigned int address, unsigned int value) {
+					static_cast<Device*>(context)->Device::set_halfword(address, static_cast<unsigned short>(value));
+				});
+			}
+
+			if ((address & 0x3) == 0 && address + 4 <= end)
+			{
+				register_io_read(address, io_width::WORD, device, [](void * context, unsigned int address) -> unsigned int {
+					return static_cast<Device*>(context)->Device::get_word(address);
+				});
+				register_io_write(address, io_width::WORD, device, [](void * context, unsigned int address, unsigned int value) {
+					static_cast<Device*>(context)->Device::set_word(address, value);
+				});
+			}
+		}
+	}
+
 private:
 
-	Bus() = default;
-	~Bus() = default;
+	Bus();
+	~Bus();
+
+	// KUSEG, KSEG0 and KSEG1 are all mirrors of the same 512MB of physical address space
+	// so the page table only needs to cover that, KSEG2 only holds the cache control register
+	static const unsigned int PHYSICAL_ADDRESS_MASK = 0x1FFFFFFF;
+	static const unsigned int KSEG2_START = 0xC0000000;
+
+	static const unsigned int PAGE_SHIFT = 12;
+	static const unsigned int PAGE_SIZE = 1 << PAGE_SHIFT;
+	static const unsigned int PAGE_OFFSET_MASK = PAGE_SIZE - 1;
+	static const unsigned int NUM_PAGES = (PHYSICAL_ADDRESS_MASK + 1) >> PAGE_SHIFT;
 
+	static const unsigned int IO_PAGE_START = 0x1F801000;
+	static const unsigned int NUM_IO_WIDTHS = 3;
+
+	struct page_entry
+	{
+		// host memory for the whole page, nullptr if the access has to go through the device
+		unsigned char * read_memory = nullptr;
+		unsigned char * write_memory = nullptr;
+		// set if a single device owns the whole page
+		BusDevice * device = nullptr;
+		// otherwise these are the devices which own part of the page, nullptr if it is unmapped
+		std::vector<BusDevice*> * shared_devices = nullptr;
+		// accesses are looked up in io_handlers first
+		bool io_page = false;
+		bool resolved = false;
+	};
+
+	struct io_handler
+	{
+		io_read_handler read = nullptr;
+		void * read_context = nullptr;
+		io_write_handler write = nullptr;
+		void * write_context = nullptr;
+	};
+
+	io_handler & get_io_handler(unsigned int address, io_width width);
+
+	page_entry * get_page(unsigned int address);
+	void resolve_page(unsigned int page_index);
+	void clear_pages();
+
+	// translates the address into the one the device expects
+	BusDevice * get_bus_device_for_access(page_entry * page, unsigned int& address);
 	BusDevice * get_bus_device_for_address(unsigned int address);
 
 	int num_devices = 0;
 	BusDevice * bus_devices[20] = { nullptr };
+
+	page_entry * pages = nullptr;
+	// pages which more than one device lives in, e.g. the scratchpad and the I/O ports
+	std::unordered_map<unsigned int, std::vector<BusDevice*>> shared_pages;
+
+	// indexed by width and then offset into the I/O page
+	io_handler io_handlers[NUM_IO_WIDTHS][PAGE_SIZE];
 };
\ No newline at end of file
@@ -0,0 +1,154 @@
+#include "BusProfiler.hpp"
+
+#ifdef PSX_BUS_PROFILER
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include "Cpu.hpp"
+
+static BusProfiler * instance = nullptr;
+
+BusProfiler * BusProfiler::get_instance()
+{
+	if (instance == nullptr)
+	{
+		instance = new BusProfiler();
+	}
+
+	return instance;
+}
+
+unsigned long long BusProfiler::access_counts::get_total() const
+{
+	unsigned long long total = 0;
+	for (int idx = 0; idx < 3; idx++)
+	{
+		total += reads[idx] + writes[idx];
+	}
+	return total;
+}
+
+void BusProfiler::record(unsigned int address, Bus::io_width width, bool is_write)
+{
+	if (enabled == false)
+	{
+		return;
+	}
+
+	Bus::BusDevice * device = Bus::get_instance()->find_device(address);
+
+	// the segment doesn't matter for anything below KSEG2, bucket by physical address
+	unsigned int bucket_address = address < 0xC0000000 ? address & 0x1FFFFFFF : address;
+	unsigned int pc = Cpu::get_instance()->current_pc;
+
+	unsigned int width_index = static_cast<unsigned int>(width);
+	for (access_counts * counts : { &device_counts[device], &bucket_counts[bucket_address >> BUCKET_SHIFT], &pc_counts[pc] })
+	{
+		if (is_write)
+		{
+			counts->writes[width_index]++;
+		}
+		else
+		{
+			counts->reads[width_index]++;
+		}
+		counts->device = device;
+	}
+
+	total_accesses++;
+}
+
+void BusProfiler::reset()
+{
+	device_counts.clear();
+	bucket_counts.clear();
+	pc_counts.clear();
+	total_accesses = 0;
+}
+
+template <class Key>
+static std::vector<std::pair<Key, BusProfiler::access_counts>> sort_counts(const std::unordered_map<Key, BusProfiler::access_counts>& counts)
+{
+	std::vector<std::pair<Key, BusProfiler::access_counts>> result(counts.begin(), counts.end());
+	std::sort(result.begin(), result.end(), [](const std::pair<Key, BusProfiler::access_counts>& a, const std::pair<Key, BusProfiler::access_counts>& b) {
+		return a.second.get_total() > b.second.get_total();
+	});
+	return result;
+}
+
+std::vector<std::pair<Bus::BusDevice*, BusProfiler::access_counts>> BusProfiler::get_device_counts()
+{
+	return sort_counts(device_counts);
+}
+
+std::vector<std::pair<unsigned int, BusProfiler::access_counts>> BusProfiler::get_bucket_counts()
+{
+	std::vector<std::pair<unsigned int, access_counts>> result = sort_counts(bucket_counts);
+	for (std::pair<unsigned int, access_counts>& entry : result)
+	{
+		entry.first <<= BUCKET_SHIFT;
+	}
+	return result;
+}
+
+std::vector<std::pair<unsigned int, BusProfiler::access_counts>> BusProfiler::get_pc_counts()
+{
+	return sort_counts(pc_counts);
+}
+
+const char * BusProfiler::get_device_name(Bus::BusDevice * device)
+{
+	return device ? device->get_device_name() : "Unmapped";
+}
+
+static void write_row(std::ofstream& file, const char * type, const std::string& key, const BusProfiler::access_counts& counts)
+{
+	file << type << "," << key << "," << BusProfiler::get_device_name(counts.device);
+	for (int idx = 0; idx < 3; idx++)
+	{
+		file << "," << counts.reads[idx];
+	}
+	for (int idx = 0; idx < 3; idx++)
+	{
+		file << "," << counts.writes[idx];
+	}
+	file << "," << counts.get_total() << "\n";
+}
+
+static std::string to_hex(unsigned int value)
+{
+	std::stringstream text;
+	text << "0x" << std::hex << value;
+	return text.str();
+}
+
+bool BusProfiler::dump_csv(const std::string& filepath)
+{
+	std::ofstream file(filepath);
+	if (file.good() == false)
+	{
+		std::cerr << "Unable to write bus profile to " << filepath << "\n";
+		return false;
+	}
+
+	file << "type,key,device,byte_reads,halfword_reads,word_reads,byte_writes,halfword_writes,word_writes,total\n";
+
+	for (const std::pair<Bus::BusDevice*, access_counts>& entry : get_device_counts())
+	{
+		write_row(file, "device", get_device_name(entry.first), entry.second);
+	}
+
+	for (const std::pair<unsigned int, access_counts>& entry : get_bucket_counts())
+	{
+		write_row(file, "bucket", to_hex(entry.first), entry.second);
+	}
+
+	for (const std::pair<unsigned int, access_counts>& entry : get_pc_counts())
+	{
+		write_row(file, "pc", to_hex(entry.first), entry.second);
+	}
+
+	return true;
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,56 @@
+#pragma once
+
+// Counts every access that goes through the bus by device, access width, 256 byte address bucket and
+// the pc of the instruction that made it, so it's clear where the bus traffic of a title is going.
+// Only compiled in with the PSX_BUS_PROFILER cmake option. Loads and stores that fastmem handles
+// directly never reach the bus and aren't counted, only the ones that fault into it.
+#ifdef PSX_BUS_PROFILER
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Bus.hpp"
+
+class BusProfiler
+{
+public:
+	static BusProfiler * get_instance();
+
+	struct access_counts
+	{
+		// indexed by Bus::io_width
+		unsigned long long reads[3] = { 0 };
+		unsigned long long writes[3] = { 0 };
+		// the device that was accessed last, nullptr for unmapped addresses
+		Bus::BusDevice * device = nullptr;
+
+		unsigned long long get_total() const;
+	};
+
+	void record(unsigned int address, Bus::io_width width, bool is_write);
+	void reset();
+	bool dump_csv(const std::string& filepath);
+
+	// all sorted with the most accessed first
+	std::vector<std::pair<Bus::BusDevice*, access_counts>> get_device_counts();
+	std::vector<std::pair<unsigned int, access_counts>> get_bucket_counts();
+	std::vector<std::pair<unsigned int, access_counts>> get_pc_counts();
+
+	unsigned long long get_total_accesses() { return total_accesses; }
+
+	static const char * get_device_name(Bus::BusDevice * device);
+
+	static const unsigned int BUCKET_SHIFT = 8;
+
+	bool enabled = true;
+
+private:
+	BusProfiler() = default;
+	~BusProfiler() = default;
+
+	std::unordered_map<Bus::BusDevice*, access_counts> device_counts;
+	std::unordered_map<unsigned int, access_counts> bucket_counts;
+	std::unordered_map<unsigned int, access_counts> pc_counts;
+
+	unsigned long long total_accesses = 0;
+};
+#endif
\ No newline at end of file
@@ -0,0 +1,127 @@
+#include "BusProfilerMenu.hpp"
+
+#ifdef PSX_BUS_PROFILER
+#include "BusProfiler.hpp"
+#include "implot.h"
+
+#include <sstream>
+#include <iomanip>
+
+void BusProfilerMenu::draw_in_category(menubar_category category)
+{
+	if (category == menubar_category::VIEW)
+	{
+		ImGui::Checkbox("Show Bus Profiler", &is_visible);
+	}
+}
+
+void BusProfilerMenu::draw_menu()
+{
+	if (is_visible == false) return;
+
+	BusProfiler * profiler = BusProfiler::get_instance();
+
+	ImGui::Begin("Bus Profiler");
+
+	ImGui::Checkbox("Enabled", &profiler->enabled);
+	ImGui::SameLine();
+	if (ImGui::Button("Reset"))
+	{
+		profiler->reset();
+	}
+
+	ImGui::InputText("##csv_filepath", csv_filepath, sizeof(csv_filepath));
+	ImGui::SameLine();
+	if (ImGui::Button("Dump CSV"))
+	{
+		profiler->dump_csv(csv_filepath);
+	}
+
+	unsigned long long total_accesses = profiler->get_total_accesses();
+	{
+		std::stringstream text;
+		text << "Total accesses: " << total_accesses;
+		ImGui::Text(text.str().c_str());
+	}
+
+	if (total_accesses == 0)
+	{
+		ImGui::End();
+		return;
+	}
+
+	ImGui::Separator();
+	ImGui::Text("Devices");
+
+	std::vector<std::pair<Bus::BusDevice*, BusProfiler::access_counts>> device_counts = profiler->get_device_counts();
+	for (const std::pair<Bus::BusDevice*, BusProfiler::access_counts>& entry : device_counts)
+	{
+		const BusProfiler::access_counts& counts = entry.second;
+		std::stringstream text;
+		text << std::fixed << std::setprecision(1) << std::setw(5) << (100.0 * counts.get_total() / total_accesses) << "% "
+			<< BusProfiler::get_device_name(entry.first)
+			<< " - reads b/h/w " << counts.reads[0] << "/" << counts.reads[1] << "/" << counts.reads[2]
+			<< " writes b/h/w " << counts.writes[0] << "/" << counts.writes[1] << "/" << counts.writes[2];
+		ImGui::Text(text.str().c_str());
+	}
+
+	ImGui::Separator();
+
+	// hottest 256 byte buckets, the addresses are listed under the plot in the same order
+	std::vector<std::pair<unsigned int, BusProfiler::access_counts>> bucket_counts = profiler->get_bucket_counts();
+	int num_buckets = std::min(static_cast<int>(bucket_counts.size()), MAX_BUCKETS_SHOWN);
+
+	std::vector<double> bucket_reads(num_buckets);
+	std::vector<double> bucket_writes(num_buckets);
+	for (int idx = 0; idx < num_buckets; idx++)
+	{
+		const BusProfiler::access_counts& counts = bucket_counts[idx].second;
+		bucket_reads[idx] = static_cast<double>(counts.reads[0] + counts.reads[1] + counts.reads[2]);
+		bucket_writes[idx] = static_cast<double>(counts.writes[0] + counts.writes[1] + counts.writes[2]);
+	}
+
+	ImPlot::SetNextPlotLimits(-0.5, MAX_BUCKETS_SHOWN - 0.5, 0, bucket_counts.empty() ? 1.0 : bucket_counts[0].second.get_total() * 1.1, ImGuiCond_Always);
+	if (ImPlot::BeginPlot("Hottest buckets", "bucket", "accesses", ImVec2(-1, 0)))
+	{
+		ImPlot::PlotBars("reads", bucket_reads.data(), num_buckets, 0.4, -0.2);
+		ImPlot::PlotBars("writes", bucket_writes.data(), num_buckets, 0.4, 0.2);
+		ImPlot::EndPlot();
+	}
+
+	if (ImGui::TreeNode("Buckets"))
+	{
+		for (int idx = 0; idx < num_buckets; idx++)
+		{
+			const BusProfiler::access_counts& counts = bucket_counts[idx].second;
+			std::stringstream text;
+			text << std::setw(2) << idx << ": 0x" << std::hex << std::setfill('0') << std::setw(8) << bucket_counts[idx].first
+				<< std::dec << std::setfill(' ') << " " << BusProfiler::get_device_name(counts.device)
+				<< " " << std::fixed << std::setprecision(1) << (100.0 * counts.get_total() / total_accesses) << "%";
+			ImGui::Text(text.str().c_str());
+		}
+		ImGui::TreePop();
+	}
+
+	if (ImGui::TreeNode("PCs"))
+	{
+		std::vector<std::pair<unsigned int, BusProfiler::access_counts>> pc_counts = profiler->get_pc_counts();
+		int num_pcs = std::min(static_cast<int>(pc_counts.size()), MAX_PCS_SHOWN);
+		for (int idx = 0; idx < num_pcs; idx++)
+		{
+			const BusProfiler::access_counts& counts = pc_counts[idx].second;
+			std::stringstream text;
+			text << "0x" << std::hex << std::setfill('0') << std::setw(8) << pc_counts[idx].first
+				<< std::dec << std::setfill(' ') << " " << BusProfiler::get_device_name(counts.device)
+				<< " " << std::fixed << std::setprecision(1) << (100.0 * counts.get_total() / total_accesses) << "%";
+			ImGui::Text(text.str().c_str());
+		}
+		ImGui::TreePop();
+	}
+
+	ImGui::End();
+}
+
+void BusProfilerMenu::tick()
+{
+}
+#endif
\ No newline at end of file
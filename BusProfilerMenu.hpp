@@ -0,0 +1,22 @@
+#pragma once
+#include "DebugMenuManager.hpp"
+
+#ifdef PSX_BUS_PROFILER
+class BusProfilerMenu : public DebugMenu
+{
+public:
+	virtual void draw_in_category(menubar_category category) final;
+
+	virtual void draw_menu() final;
+
+	virtual void tick() final;
+
+private:
+	bool is_visible = false;
+
+	static const int MAX_BUCKETS_SHOWN = 32;
+	static const int MAX_PCS_SHOWN = 16;
+
+	char csv_filepath[256] = "bus_profile.csv";
+};
+#endif
\ No newline at end of file
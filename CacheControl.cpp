@@ -1,4 +1,7 @@
 #include "CacheControl.hpp"
+#include "MemoryControl.hpp"
+
+#include <cstring>
 
 static CacheControl * instance = nullptr;
 
@@ -12,6 +15,11 @@ CacheControl * CacheControl::get_instance()
 	return instance;
 }
 
+CacheControl::CacheControl()
+{
+	reset();
+}
+
 bool CacheControl::is_address_for_device(unsigned int address)
 {
 	if (address >= CACHE_CONTROL_START && address < CACHE_CONTROL_END)
@@ -29,4 +37,73 @@ unsigned int CacheControl::get_word(unsigned int address)
 void CacheControl::set_word(unsigned int address, unsigned int value)
 {
 	cache_control_register.raw = value;
+}
+
+void CacheControl::reset()
+{
+	cache_control_register.raw = 0;
+	instruction_cache_misses = 0;
+	fetch_cycles = 0;
+	memset(lines, 0, sizeof(lines));
+	invalidate_instruction_cache();
+}
+
+void CacheControl::invalidate_instruction_cache()
+{
+	for (unsigned int idx = 0; idx < NUM_LINES; idx++)
+	{
+		tags[idx] = INVALID_TAG;
+	}
+}
+
+unsigned int CacheControl::fetch_instruction_slow(unsigned int address)
+{
+	Bus * bus = Bus::get_instance();
+	instruction_cache_misses++;
+
+	MemoryControl * memory_control = MemoryControl::get_instance();
+	unsigned int word_cycles = memory_control->get_read_cycles(address, Bus::io_width::WORD);
+
+	if (cache_control_register.code_cache_enable == 0 || (address >> 29) == KSEG1)
+	{
+		fetch_cycles += word_cycles;
+		return bus->get_word(address);
+	}
+
+	// the rest of the line streams in after the first word
+	fetch_cycles += word_cycles + WORDS_PER_LINE - 1;
+
+	// the whole line is filled
+	unsigned int line = (address >> LINE_SHIFT) & (NUM_LINES - 1);
+	unsigned int line_address = address & ~((1 << LINE_SHIFT) - 1);
+	for (unsigned int idx = 0; idx < WORDS_PER_LINE; idx++)
+	{
+		lines[line].words[idx] = bus->get_word(line_address + idx * 4);
+	}
+	tags[line] = address & TAG_MASK;
+
+	return lines[line].words[(address >> 2) & (WORDS_PER_LINE - 1)];
+}
+
+unsigned int CacheControl::get_sequential_fetch_cycles(unsigned int address)
+{
+	if (cache_control_register.code_cache_enable && (address >> 29) != KSEG1)
+	{
+		return 0;
+	}
+	return MemoryControl::get_instance()->get_read_cycles(address, Bus::io_width::WORD);
+}
+
+unsigned char * CacheControl::get_isolated_memory(unsigned int address, bool for_write)
+{
+	unsigned int line = (address >> LINE_SHIFT) & (NUM_LINES - 1);
+	if (for_write)
+	{
+		// in tag test mode the bios writes a word to each line to invalidate it, otherwise it writes the data
+		// and the line still shouldn't be trusted until it is filled again
+		tags[line] = INVALID_TAG;
+	}
+
+	unsigned char * line_memory = reinterpret_cast<unsigned char*>(lines[line].words);
+	return &line_memory[address & ((1 << LINE_SHIFT) - 1)];
 }
\ No newline at end of file
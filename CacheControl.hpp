@@ -1,22 +1,57 @@
 #pragma once
 #include "Bus.hpp"
 
+// The cache control register and the R3000A's 4KB direct mapped instruction cache.
+// The cache has 256 lines of 4 words, tagged with the physical address so the KUSEG and KSEG0 mirrors share lines.
+// KSEG1 is never cached. While Isc is set in cop0's status register, Ram sends main memory loads and stores here
+// instead, which is how the bios flushes the cache.
 class CacheControl : public Bus::BusDevice
 {
 public:
 	static CacheControl * get_instance();
 
 	virtual bool is_address_for_device(unsigned int address) final;
+	virtual const char * get_device_name() final { return "CacheControl"; }
 
 	virtual unsigned int get_word(unsigned int address) final;
 	virtual void set_word(unsigned int address, unsigned int value) final;
 
+	void reset();
+
+	// the instruction at address, hits are served from the cache without going near the bus
+	unsigned int fetch_instruction(unsigned int address)
+	{
+		if (cache_control_register.code_cache_enable && (address >> 29) != KSEG1)
+		{
+			unsigned int line = (address >> LINE_SHIFT) & (NUM_LINES - 1);
+			if (tags[line] == (address & TAG_MASK))
+			{
+				return lines[line].words[(address >> 2) & (WORDS_PER_LINE - 1)];
+			}
+		}
+		return fetch_instruction_slow(address);
+	}
+
+	// where main memory loads and stores go while the cache is isolated, stores invalidate the line
+	unsigned char * get_isolated_memory(unsigned int address, bool for_write);
+
+	void invalidate_instruction_cache();
+
+	// cycles the fetches since the cpu last collected them spent waiting for memory, hits are free
+	unsigned int fetch_cycles = 0;
+
+	// what each instruction run straight through from address costs to fetch, the cached interpreter and the jit
+	// skip fetching inside their blocks and assume cached code always hits
+	unsigned int get_sequential_fetch_cycles(unsigned int address);
+
 	union
 	{
 		unsigned int raw;
 		struct
 		{
-			unsigned int na0 : 3;
+			unsigned int na0 : 2;
+			// isolated stores only invalidate the tags
+			unsigned int tag_test_mode : 1;
 			unsigned int scratch_pad_enable1 : 1;
 			unsigned int na1 : 2;
 			unsigned int na2 : 1;
@@ -29,11 +64,35 @@ public:
 		};
 	} cache_control_register;
 
+	// fetches which had to go to the bus, including everything uncached
+	unsigned long long instruction_cache_misses = 0;
+
 private:
-	CacheControl() = default;
+	CacheControl();
 	~CacheControl() = default;
 
+	unsigned int fetch_instruction_slow(unsigned int address);
+
 	static const unsigned int CACHE_CONTROL_SIZE = 4;
 	static const unsigned int CACHE_CONTROL_START = 0xFFFE0130;
 	static const unsigned int CACHE_CONTROL_END = CACHE_CONTROL_START + CACHE_CONTROL_SIZE;
+
+	static const unsigned int KSEG1 = 0x5;
+
+	static const unsigned int INSTRUCTION_CACHE_SIZE = 4 * 1024;
+	static const unsigned int LINE_SHIFT = 4;
+	static const unsigned int WORDS_PER_LINE = 4;
+	static const unsigned int NUM_LINES = INSTRUCTION_CACHE_SIZE >> LINE_SHIFT;
+	// the physical address of the line, the low bits are kept so a tag can't match another line
+	static const unsigned int TAG_MASK = 0x1FFFFFF0;
+	// no address masks to this, so invalid lines never hit
+	static const unsigned int INVALID_TAG = 0xFFFFFFFF;
+
+	struct cache_line
+	{
+		unsigned int words[WORDS_PER_LINE];
+	};
+
+	unsigned int tags[NUM_LINES];
+	cache_line lines[NUM_LINES];
 };
\ No newline at end of file
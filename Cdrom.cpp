@@ -3,10 +3,14 @@
 #include <fstream>
 #include "Cdrom.hpp"
 #include "Ram.hpp"
+#include "Cpu.hpp"
+#include "Scheduler.hpp"
 #include "DebugMenuManager.hpp"
 
 static Cdrom * instance = nullptr;
 
+const unsigned int Cdrom::NO_SECTOR;
+
 Cdrom * Cdrom::get_instance()
 {
 	if (instance == nullptr)
@@ -28,37 +32,36 @@ bool Cdrom::is_address_for_device(unsigned int address)
 
 unsigned char Cdrom::get_byte(unsigned int address)
 {
-	try
-	{
-		return get(address);
-	}
-	catch (...)
-	{
-		std::cerr << "Error get: " << register_index << "-" << std::hex << address << std::endl;
-		return 0;
-	}
+	return get(address);
 }
 
 void Cdrom::set_byte(unsigned int address, unsigned char value)
 {
-	try
-	{
-		set(address, value);
-	}
-	catch (...)
-	{
-		std::cerr << "Error set: " << register_index << "-" << std::hex << address << std::endl;
-	}	
+	set(address, value);
 }
 
-void Cdrom::sync_mode_manual(DMA_base_address & base_address, DMA_block_control & block_control, DMA_channel_control & channel_control)
+void Cdrom::register_io_handlers(Bus * bus)
+{
+	bus->register_io_range(CDROM_START, CDROM_END, this);
+
+	// the response and data fifos are read through the same register whatever the index is
+	bus->register_io_read(0x1F801801, Bus::io_width::BYTE, this, [](void * context, unsigned int address) -> unsigned int {
+		return static_cast<Cdrom*>(context)->get_next_response_byte();
+	});
+	bus->register_io_read(0x1F801802, Bus::io_width::BYTE, this, [](void * context, unsigned int address) -> unsigned int {
+		return static_cast<Cdrom*>(context)->get_next_data_byte();
+	});
+}
+
+unsigned int Cdrom::sync_mode_manual(DMA_base_address & base_address, DMA_block_control & block_control, DMA_channel_control & channel_control)
 {
-	Ram * ram = Ram::get_instance();
 	assert(block_control.BC == MODE1_USER_DATA_SIZE);
-	for (int idx = 0; idx < MODE1_USER_DATA_SIZE; idx++)
-	{
-		ram->set_byte(base_address.memory_address + idx, get_next_data_byte());
-	}
+
+	// the sector comes out of the fifo and goes into ram in as few pieces as it can
+	unsigned char sector_data[MODE1_USER_DATA_SIZE];
+	get_next_data_bytes(sector_data, MODE1_USER_DATA_SIZE);
+	Ram::get_instance()->write_dma_span(base_address.memory_address, sector_data, MODE1_USER_DATA_SIZE);
+	return MODE1_USER_DATA_SIZE / 4;
 }
 
 void Cdrom::init()
@@ -66,6 +69,10 @@ void Cdrom::init()
 	response_fifo = new Fifo<unsigned char>(RESPONSE_FIFO_SIZE);
 	data_fifo = new Fifo<unsigned char>(DATA_FIFO_SIZE);
 	parameter_fifo = new Fifo<unsigned char>(PARAMETER_FIFO_SIZE);
+
+	Scheduler::get_instance()->register_event(scheduler_event::CDROM, this, [](void * context) {
+		static_cast<Cdrom*>(context)->raise_response_interrupt();
+	});
 }
 
 Cdrom::~Cdrom()
@@ -86,38 +93,52 @@ Cdrom::~Cdrom()
 	}
 }
 
-void Cdrom::tick()
+// the response at the front of the queue starts counting down once the last one has been acknowledged,
+// and only counts down while interrupts are enabled
+void Cdrom::update_response_event()
 {
-	if (interrupt_enable_register)
+	Scheduler * scheduler = Scheduler::get_instance();
+	if (interrupt_enable_register == 0)
 	{
-		if (current_int == cdrom_response_interrupts::NO_RESPONSE)
+		if (scheduler->is_scheduled(scheduler_event::CDROM))
 		{
-			if (pending_response.empty() == false)
-			{
-				pending_response_data data = pending_response.front();
-				pending_response.pop_front();
-				current_int = data.int_type;
-				time_to_irq = data.delay;
-				interrupt_countdown_active = true;
-				for (auto & iter : data.responses)
-				{
-					response_fifo->push(iter);
-				}
-			}
+			unsigned long long irq_cycle = scheduler->get_event_cycle(scheduler_event::CDROM);
+			time_to_irq = irq_cycle > scheduler->current_cycle ? static_cast<int>(irq_cycle - scheduler->current_cycle) : 0;
+			scheduler->cancel(scheduler_event::CDROM);
 		}
+		return;
+	}
 
-		if (interrupt_countdown_active)
+	if (current_int == cdrom_response_interrupts::NO_RESPONSE && pending_response.empty() == false)
+	{
+		pending_response_data data = pending_response.front();
+		pending_response.pop_front();
+		current_int = data.int_type;
+		time_to_irq = data.delay;
+		interrupt_countdown_active = true;
+		for (auto & iter : data.responses)
 		{
-			time_to_irq--;
-			if (time_to_irq <= 0)
+			if (response_fifo->is_full())
 			{
-				SystemControlCoprocessor::get_instance()->set_irq_bits(system_control::CDROM_BIT);
-				interrupt_countdown_active = false;
+				Cpu::get_instance()->raise_pending_exception("cdrom response fifo overflow");
+				break;
 			}
+			response_fifo->push(iter);
 		}
+	}
 
-		// todo add read mode repeating int1 interrupt
+	if (interrupt_countdown_active && scheduler->is_scheduled(scheduler_event::CDROM) == false)
+	{
+		scheduler->schedule_in(scheduler_event::CDROM, time_to_irq > 0 ? time_to_irq : 0);
 	}
+
+	// todo add read mode repeating int1 interrupt
+}
+
+void Cdrom::raise_response_interrupt()
+{
+	SystemControlCoprocessor::get_instance()->set_irq_bits(system_control::CDROM_BIT);
+	interrupt_countdown_active = false;
 }
 
 void Cdrom::reset()
@@ -130,6 +151,9 @@ void Cdrom::reset()
 	current_int = cdrom_response_interrupts::NO_RESPONSE;
 
 	interrupt_enable_register = 0x0;
+	interrupt_countdown_active = false;
+	Scheduler::get_instance()->cancel(scheduler_event::CDROM);
+	last_read_lba = NO_SECTOR;
 }
 
 void Cdrom::save_state(std::stringstream& file)
@@ -170,6 +194,30 @@ void Cdrom::save_state(std::stringstream& file)
 	file.write(reinterpret_cast<char*>(&register_index), sizeof(unsigned int));
 	file.write(reinterpret_cast<char*>(&current_int), sizeof(cdrom_response_interrupts));
 	file.write(reinterpret_cast<char*>(&interrupt_enable_register), sizeof(unsigned int));
+
+	{
+		unsigned int num_pending = pending_response.size();
+		file.write(reinterpret_cast<char*>(&num_pending), sizeof(unsigned int));
+		for (auto & iter : pending_response)
+		{
+			unsigned int num_responses = iter.responses.size();
+			file.write(reinterpret_cast<char*>(&iter.delay), sizeof(int));
+			file.write(reinterpret_cast<char*>(&iter.int_type), sizeof(cdrom_response_interrupts));
+			file.write(reinterpret_cast<char*>(&num_responses), sizeof(unsigned int));
+			file.write(reinterpret_cast<char*>(iter.responses.data()), sizeof(unsigned char)*num_responses);
+		}
+	}
+
+	// the countdown is saved as what's left of it, the event is derived from it again on load
+	int remaining_cycles = time_to_irq;
+	Scheduler * scheduler = Scheduler::get_instance();
+	if (scheduler->is_scheduled(scheduler_event::CDROM))
+	{
+		unsigned long long irq_cycle = scheduler->get_event_cycle(scheduler_event::CDROM);
+		remaining_cycles = irq_cycle > scheduler->current_cycle ? static_cast<int>(irq_cycle - scheduler->current_cycle) : 0;
+	}
+	file.write(reinterpret_cast<char*>(&remaining_cycles), sizeof(int));
+	file.write(reinterpret_cast<char*>(&interrupt_countdown_active), sizeof(bool));
 }
 
 void Cdrom::load_state(std::stringstream& file)
@@ -225,6 +273,29 @@ void Cdrom::load_state(std::stringstream& file)
 	file.read(reinterpret_cast<char*>(&register_index), sizeof(unsigned int));
 	file.read(reinterpret_cast<char*>(&current_int), sizeof(cdrom_response_interrupts));
 	file.read(reinterpret_cast<char*>(&interrupt_enable_register), sizeof(unsigned int));
+
+	{
+		unsigned int num_pending = 0;
+		file.read(reinterpret_cast<char*>(&num_pending), sizeof(unsigned int));
+		pending_response.clear();
+		for (unsigned int idx = 0; idx < num_pending; idx++)
+		{
+			pending_response_data data;
+			unsigned int num_responses = 0;
+			file.read(reinterpret_cast<char*>(&data.delay), sizeof(int));
+			file.read(reinterpret_cast<char*>(&data.int_type), sizeof(cdrom_response_interrupts));
+			file.read(reinterpret_cast<char*>(&num_responses), sizeof(unsigned int));
+			data.responses.resize(num_responses);
+			file.read(reinterpret_cast<char*>(data.responses.data()), sizeof(unsigned char)*num_responses);
+			pending_response.push_back(data);
+		}
+	}
+
+	file.read(reinterpret_cast<char*>(&time_to_irq), sizeof(int));
+	file.read(reinterpret_cast<char*>(&interrupt_countdown_active), sizeof(bool));
+
+	Scheduler::get_instance()->cancel(scheduler_event::CDROM);
+	update_response_event();
 }
 
 bool Cdrom::load(std::string bin_file, std::string /*cue_file*/)
@@ -247,6 +318,12 @@ bool Cdrom::load(std::string bin_file, std::string /*cue_file*/)
 
 		rom_file.close();
 
+		file_sectors_read.clear();
+		if (filesystem.build(rom_data))
+		{
+			std::cout << "Indexed " << filesystem.get_files().size() << " files and directories\n";
+		}
+
 		return true;
 	}
 
@@ -283,7 +360,8 @@ unsigned char Cdrom::get(unsigned int address)
 			case 3:
 				return get_index3(address);
 			default:
-				throw std::logic_error("not implemented");
+				Cpu::get_instance()->raise_pending_exception("cdrom register not implemented");
+				return 0;
 		}
 	}
 }
@@ -300,13 +378,18 @@ void Cdrom::set(unsigned int address, unsigned char value)
 		switch (register_index)
 		{
 			case 0:
-				return set_index0(address, value);
+				set_index0(address, value);
+				break;
 			case 1:
-				return set_index1(address, value);
+				set_index1(address, value);
+				break;
 			default:
-				throw std::logic_error("not implemented");
+				Cpu::get_instance()->raise_pending_exception("cdrom register not implemented");
 			}
 	}
+
+	// commands queue responses, acknowledging one lets the next one go
+	update_response_event();
 }
 
 unsigned char Cdrom::get_index0(unsigned int address)
@@ -329,7 +412,8 @@ unsigned char Cdrom::get_index0(unsigned int address)
 		} break;
 
 		default:
-			throw std::logic_error("not implemented");
+			Cpu::get_instance()->raise_pending_exception("cdrom register not implemented");
+			return 0;
 	}
 }
 
@@ -355,7 +439,8 @@ unsigned char Cdrom::get_index1(unsigned int address)
 		} break;
 
 		default:
-			throw std::logic_error("not implemented");
+			Cpu::get_instance()->raise_pending_exception("cdrom register not implemented");
+			return 0;
 	}
 }
 
@@ -374,7 +459,8 @@ unsigned char Cdrom::get_index2(unsigned int address)
 		} break;
 
 		default:
-			throw std::logic_error("not implemented");
+			Cpu::get_instance()->raise_pending_exception("cdrom register not implemented");
+			return 0;
 	}
 }
 
@@ -393,7 +479,8 @@ unsigned char Cdrom::get_index3(unsigned int address)
 		} break;
 
 	default:
-		throw std::logic_error("not implemented");
+		Cpu::get_instance()->raise_pending_exception("cdrom register not implemented");
+		return 0;
 	}
 }
 
@@ -408,6 +495,11 @@ void Cdrom::set_index0(unsigned int address, unsigned char value)
 
 		case 0x1F801802:
 		{
+			if (parameter_fifo->is_full())
+			{
+				Cpu::get_instance()->raise_pending_exception("cdrom parameter fifo overflow");
+				break;
+			}
 			parameter_fifo->push(value);
 		} break;
 
@@ -417,7 +509,7 @@ void Cdrom::set_index0(unsigned int address, unsigned char value)
 		} break;
 
 		default:
-			throw std::logic_error("not implemented");
+			Cpu::get_instance()->raise_pending_exception("cdrom register not implemented");
 	}
 }
 
@@ -437,6 +529,7 @@ void Cdrom::set_index1(unsigned int address, unsigned char value)
 			if (irq_rg.ack_int1_7)
 			{
 				interrupt_countdown_active = false;
+				Scheduler::get_instance()->cancel(scheduler_event::CDROM);
 				current_int = cdrom_response_interrupts::NO_RESPONSE;
 				response_fifo->clear();
 			}
@@ -448,7 +541,7 @@ void Cdrom::set_index1(unsigned int address, unsigned char value)
 		} break;
 
 		default:
-			throw std::logic_error("not implemented");
+			Cpu::get_instance()->raise_pending_exception("cdrom register not implemented");
 	}
 }
 
@@ -463,6 +556,17 @@ unsigned char Cdrom::get_next_response_byte()
 	return response_byte;
 }
 
+unsigned char Cdrom::get_next_parameter_byte()
+{
+	if (parameter_fifo->is_empty())
+	{
+		Cpu::get_instance()->raise_pending_exception("cdrom command is missing parameters");
+		return 0x0;
+	}
+
+	return parameter_fifo->pop();
+}
+
 unsigned char Cdrom::get_next_data_byte()
 {
 	if (in_read_mode && data_fifo->is_empty())
@@ -479,17 +583,58 @@ unsigned char Cdrom::get_next_data_byte()
 	return data_byte;
 }
 
+void Cdrom::get_next_data_bytes(unsigned char * data, unsigned int num_bytes)
+{
+	unsigned int num_bytes_read = 0;
+	while (num_bytes_read < num_bytes)
+	{
+		if (in_read_mode && data_fifo->is_empty())
+		{
+			read_data();
+		}
+
+		unsigned int num_bytes_popped = data_fifo->pop_bulk(data + num_bytes_read, num_bytes - num_bytes_read);
+		if (num_bytes_popped == 0)
+		{
+			// an empty fifo reads as zeroes
+			memset(data + num_bytes_read, 0, num_bytes - num_bytes_read);
+			break;
+		}
+		num_bytes_read += num_bytes_popped;
+	}
+}
+
 // note i'm just assuming data cd at this point and also mode 1
 // todo add support for audio and mode 2
 void Cdrom::read_data()
 {
 	data_fifo->clear();
 
+	// the location is in bcd minutes, seconds and sectors from before the 2 second pregap
+	auto from_bcd = [](unsigned char value) { return (value >> 4) * 10 + (value & 0xF); };
+	unsigned int lba = (from_bcd(location.amm) * 60 + from_bcd(location.ass)) * 75 + from_bcd(location.asect);
+	last_read_lba = lba >= 150 ? lba - 150 : NO_SECTOR;
+	const std::string * path = filesystem.find_path(last_read_lba);
+	if (path)
+	{
+		file_sectors_read[*path]++;
+	}
+
+	// the image starts after the pregap, a sector which isn't on it reads as zeroes
+	if (last_read_lba == NO_SECTOR || last_read_lba >= num_sectors)
+	{
+		for (unsigned int byte_idx = 0; byte_idx < MODE1_USER_DATA_SIZE; byte_idx++)
+		{
+			data_fifo->push(0);
+		}
+		return;
+	}
+
 	// 16 is the size of the sync and header part of the sector
-	int sector_offset = (location.asect * SECTOR_SIZE) + 16;
-	for (int byte_idx = 0; byte_idx < MODE1_USER_DATA_SIZE; byte_idx++)
+	unsigned int sector_offset = last_read_lba * SECTOR_SIZE + 16;
+	for (unsigned int byte_idx = 0; byte_idx < MODE1_USER_DATA_SIZE; byte_idx++)
 	{
-		data_fifo->push(rom_data[sector_offset] + byte_idx);
+		data_fifo->push(rom_data[sector_offset + byte_idx]);
 	}
 }
 
@@ -546,7 +691,7 @@ void Cdrom::execute_command(unsigned char command)
 
 		default:
 			std::cerr << "Command: " << std::hex << static_cast<unsigned int>(command) << std::endl;
-			throw std::logic_error("not implemented");
+			Cpu::get_instance()->raise_pending_exception("cdrom command not implemented");
 	}
 }
 
@@ -555,7 +700,7 @@ void Cdrom::execute_test_command()
 	// the test to run is determined by the subfunction on the parameter fifo
 	// however, the ps1 only uses 0x20 which returns the cd rom bios version
 	// so no need to implement anything but that
-	unsigned char sub_function = parameter_fifo->pop();
+	unsigned char sub_function = get_next_parameter_byte();
 	if (sub_function == 0x20)
 	{
 		pending_response_data data;
@@ -572,7 +717,7 @@ void Cdrom::execute_test_command()
 	}
 	else
 	{
-		throw std::logic_error("not implemented");
+		Cpu::get_instance()->raise_pending_exception("cdrom test command not implemented");
 	}
 }
 
@@ -623,9 +768,9 @@ void Cdrom::execute_set_loc_command()
 {
 	execute_getstat_command();
 
-	seek_target.amm = parameter_fifo->pop();
-	seek_target.ass = parameter_fifo->pop();
-	seek_target.asect = parameter_fifo->pop();
+	seek_target.amm = get_next_parameter_byte();
+	seek_target.ass = get_next_parameter_byte();
+	seek_target.asect = get_next_parameter_byte();
 }
 
 // this command actually sets the location, the set_loc input
@@ -644,7 +789,7 @@ void Cdrom::execute_seek_l_command()
 
 void Cdrom::execute_set_mode_command()
 {
-	mode.raw = parameter_fifo->pop();
+	mode.raw = get_next_parameter_byte();
 
 	execute_getstat_command();
 }
@@ -2,6 +2,7 @@
 #include <string>
 #include <vector>
 #include <deque>
+#include <unordered_map>
 
 #include "Fifo.hpp"
 #include "Bus.hpp"
@@ -10,6 +11,7 @@
 #include "Dma.hpp"
 
 #include "CdromEnums.hpp"
+#include "Iso9660.hpp"
 
 class Cdrom : public Bus::BusDevice, public DMA_interface
 {
@@ -18,12 +20,14 @@ public:
 
 	// bus device functions
 	virtual bool is_address_for_device(unsigned int address) final;
+	virtual const char * get_device_name() final { return "Cdrom"; }
 
 	virtual unsigned char get_byte(unsigned int address) final;
 	virtual void set_byte(unsigned int address, unsigned char value) final;
+	virtual void register_io_handlers(Bus * bus) final;
 
 	// DMA interface functions
-	virtual void sync_mode_manual(DMA_base_address& base_address, DMA_block_control& block_control, DMA_channel_control& channel_control) final;
+	virtual unsigned int sync_mode_manual(DMA_base_address& base_address, DMA_block_control& block_control, DMA_channel_control& channel_control) final;
 
 	void init();
 
@@ -33,9 +37,12 @@ public:
 	unsigned char get(unsigned int address);
 	void set(unsigned int address, unsigned char value);
 
-	void tick();
 	void reset();
 
+	// the response delays are in cpu cycles, the interrupt is raised by a Scheduler event
+	void update_response_event();
+	void raise_response_interrupt();
+
 	bool load(std::string bin_path, std::string cue_path);
 
 	unsigned char get_index0(unsigned int address);
@@ -134,6 +141,14 @@ public:
 	unsigned int num_sectors = 0;
 	std::vector<unsigned char> rom_data;
 
+	// indexed when the disc loads, empty if the disc doesn't have a filesystem
+	Iso9660 filesystem;
+
+	// where the drive read from last and how many sectors each file has had read, for the debugger
+	static const unsigned int NO_SECTOR = 0xFFFFFFFF;
+	unsigned int last_read_lba = NO_SECTOR;
+	std::unordered_map<std::string, unsigned int> file_sectors_read;
+
 	struct pending_response_data
 	{
 		int delay = 0;
@@ -146,6 +161,7 @@ public:
 	cdrom_response_interrupts current_int = cdrom_response_interrupts::NO_RESPONSE;
 
 	bool interrupt_countdown_active = false;
+	// only kept up to date while the countdown is paused
 	int time_to_irq = 0;
 	// keep throwing int1 until pause sent
 	bool in_read_mode = false;
@@ -155,7 +171,9 @@ public:
 	Fifo<unsigned char> * parameter_fifo = nullptr;
 
 	unsigned char get_next_response_byte();
+	unsigned char get_next_parameter_byte();
 	unsigned char get_next_data_byte();
+	void get_next_data_bytes(unsigned char * data, unsigned int num_bytes);
 
 	void read_data();
 
@@ -5,6 +5,8 @@
 
 #include <sstream>
 #include <iomanip>
+#include <vector>
+#include <algorithm>
 
 void CdromMenu::draw_in_category(menubar_category category)
 {
@@ -26,6 +28,36 @@ void CdromMenu::draw_menu()
 	text << "Status Register: 0x" << std::hex << std::setfill('0') << std::setw(2) << (unsigned int)cdrom_status_register;
 	ImGui::Text(text.str().c_str());
 
+	Cdrom * cdrom = Cdrom::get_instance();
+	if (cdrom->last_read_lba != Cdrom::NO_SECTOR)
+	{
+		const std::string * path = cdrom->filesystem.find_path(cdrom->last_read_lba);
+		std::stringstream read_text;
+		read_text << "Last read: " << std::dec << cdrom->last_read_lba << " " << (path ? *path : "(not in a file)");
+		ImGui::Text(read_text.str().c_str());
+	}
+
+	// sorted by where they are on the disc
+	if (ImGui::TreeNode("Files"))
+	{
+		std::vector<std::pair<std::string, iso_file>> files(cdrom->filesystem.get_files().begin(), cdrom->filesystem.get_files().end());
+		std::sort(files.begin(), files.end(), [](const auto& lhs, const auto& rhs) { return lhs.second.lba < rhs.second.lba; });
+		for (const auto& file : files)
+		{
+			if (file.second.is_directory)
+			{
+				continue;
+			}
+
+			auto sectors_read = cdrom->file_sectors_read.find(file.first);
+			std::stringstream file_text;
+			file_text << file.first << " lba: " << file.second.lba << " size: " << file.second.size
+				<< " sectors read: " << (sectors_read == cdrom->file_sectors_read.end() ? 0 : sectors_read->second);
+			ImGui::Text(file_text.str().c_str());
+		}
+		ImGui::TreePop();
+	}
+
 	ImGui::End();
 }
 
@@ -6,6 +6,24 @@
 #include "SystemControlCoprocessor.hpp"
 #include "GTECoprocessor.hpp"
 #include "InstructionEnums.hpp"
+#include "InstructionTable.hpp"
+#include "BlockCache.hpp"
+#include "Ram.hpp"
+#include "CacheControl.hpp"
+#include "MemoryControl.hpp"
+#include "BiosHle.hpp"
+
+#ifdef PSX_FASTMEM
+#include "Fastmem.hpp"
+// loads and stores go straight to host memory, anything that isn't memory faults into the bus
+typedef Fastmem cpu_bus;
+#else
+typedef Bus cpu_bus;
+#endif
+
+#ifdef PSX_JIT
+#include "Jit.hpp"
+#endif
 
 static Cpu* instance = nullptr;
 
@@ -30,34 +48,174 @@ void Cpu::reset()
 	next_instruction = 0;
 	current_pc = static_cast<unsigned int>(system_control::exception_vector::RESET);
 	next_pc = current_pc;
+	wait_cycles = 0;
 	register_file.reset();
 }
 
-void Cpu::tick()
+unsigned int Cpu::tick()
 {
-	Bus * bus = Bus::get_instance();
+	unsigned int num_executed = execute_instructions();
+	instruction_count += num_executed;
 
+	CacheControl * cache_control = CacheControl::get_instance();
+	unsigned int num_cycles = num_executed + wait_cycles + cache_control->fetch_cycles;
+	wait_cycles = 0;
+	cache_control->fetch_cycles = 0;
+
+	if (pending_exception)
+	{
+		std::cerr << "Exception encountered: " << pending_exception << " near " << std::hex << current_pc << std::dec << "\n";
+		pending_exception = nullptr;
+	}
+
+	return num_cycles;
+}
+
+unsigned int Cpu::execute_instructions()
+{
+	// kernel calls the bios has to run itself go one instruction at a time, so a block never starts at an
+	// entry point and every call comes through here
+	if (hle_bios_calls && BiosHle::is_entry_point(current_pc) && next_pc == current_pc + 4)
+	{
+		if (BiosHle::get_instance()->call(this) == false)
+		{
+			step();
+		}
+		return 1;
+	}
+
+#ifdef PSX_JIT
+	if (mode == cpu_mode::JIT)
+	{
+		// generated code doesn't go through the instruction cache at all
+		unsigned int start_pc = current_pc;
+		unsigned int num_executed = Jit::get_instance()->execute(this);
+		if (num_executed > 0)
+		{
+			wait_cycles += num_executed * CacheControl::get_instance()->get_sequential_fetch_cycles(start_pc);
+			return num_executed;
+		}
+	}
+#endif
+
+	// the jit falls back to the cached interpreter for blocks it can't start
+	if (mode != cpu_mode::INTERPRETER)
+	{
+		unsigned int num_executed = execute_block();
+		if (num_executed > 0)
+		{
+			return num_executed;
+		}
+	}
+
+	step();
+	return 1;
+}
+
+void Cpu::set_mode(cpu_mode new_mode)
+{
+	if (new_mode == cpu_mode::JIT)
+	{
+#ifdef PSX_JIT
+		if (Jit::get_instance()->init() == false)
+		{
+			new_mode = cpu_mode::CACHED_INTERPRETER;
+		}
+#else
+		std::cerr << "Built without PSX_JIT, using the cached interpreter\n";
+		new_mode = cpu_mode::CACHED_INTERPRETER;
+#endif
+	}
+
+	mode = new_mode;
+	BlockCache::get_instance()->clear();
+}
+
+void Cpu::step()
+{
 	current_pc = next_pc;
 	current_instruction = next_instruction;
 
-	next_instruction = bus->get_word(current_pc);
+	next_instruction = CacheControl::get_instance()->fetch_instruction(current_pc);
 	next_pc = current_pc + 4;
 
-	try
-	{
-		instruction_union instr(current_instruction);
-		execute(instr);
-		SystemControlCoprocessor::get_instance()->trigger_interrupts();
-	}
-	catch (...)
+	instruction_union instr(current_instruction);
+	execute(instr);
+
+	// taken after the instruction so a branch's delay slot is still flagged for EPC
+	SystemControlCoprocessor * cop0 = SystemControlCoprocessor::get_instance();
+	if (cop0->interrupt_pending)
 	{
-		std::cerr << "Exception encountered!\n";
+		cop0->trigger_interrupts();
 	}
 
 	register_file.tick();
 	in_delay_slot = false;
 }
 
+// does exactly what calling step for each instruction would, minus the fetching and decoding
+unsigned int Cpu::execute_block()
+{
+	BlockCache * block_cache = BlockCache::get_instance();
+	block_cache->free_invalidated_blocks();
+
+	// with the cache isolated, code fetched from main memory isn't what got cached
+	if (Ram::get_instance()->is_cache_isolated())
+	{
+		return 0;
+	}
+
+	// next_instruction was fetched from current_pc, it isn't the start of the block
+	// if an exception flushed it out or the code has changed since
+	cached_block * block = block_cache->get_block(current_pc);
+	if (block == nullptr || block->ops.front().instruction.raw != next_instruction)
+	{
+		return 0;
+	}
+
+	CacheControl * cache_control = CacheControl::get_instance();
+	SystemControlCoprocessor * cop0 = SystemControlCoprocessor::get_instance();
+
+	unsigned int block_pc = current_pc;
+	unsigned int num_ops = block->ops.size();
+	unsigned int sequential_fetch_cycles = cache_control->get_sequential_fetch_cycles(block_pc);
+	unsigned int num_executed = 0;
+	while (num_executed < num_ops)
+	{
+		const micro_op& op = block->ops[num_executed];
+		num_executed++;
+
+		current_pc = next_pc;
+		current_instruction = op.instruction.raw;
+
+		// a taken branch (or a branch in a delay slot) means the next instruction comes from somewhere else
+		bool sequential = current_pc == block_pc + num_executed * 4 && num_executed < num_ops;
+		next_instruction = sequential ? block->ops[num_executed].instruction.raw : cache_control->fetch_instruction(current_pc);
+		next_pc = current_pc + 4;
+		if (sequential)
+		{
+			wait_cycles += sequential_fetch_cycles;
+		}
+
+		op.handler(this, op);
+		wait_cycles += op.interlock_cycles;
+		if (cop0->interrupt_pending)
+		{
+			cop0->trigger_interrupts();
+		}
+
+		register_file.tick();
+		in_delay_slot = false;
+
+		// exceptions replace next_instruction, writes to the block's page invalidate it
+		if (sequential == false || block->valid == false || next_instruction != block->ops[num_executed].instruction.raw)
+		{
+			break;
+		}
+	}
+
+	return num_executed;
+}
 
 void Cpu::save_state(std::stringstream& file)
 {
@@ -93,620 +251,674 @@ void Cpu::load_state(std::stringstream& file)
 
 void Cpu::execute(const instruction_union& instr)
 {
-	Bus * bus = Bus::get_instance();
+	micro_op op;
+	decode(instr, op);
+	op.handler(this, op);
+	wait_cycles += op.interlock_cycles;
+}
 
-	SystemControlCoprocessor * cop0 = SystemControlCoprocessor::get_instance();
-	GTECoprocessor * cop2 = GTECoprocessor::get_instance();
+// each instruction is a handler which reads the fields decode pulled out of it,
+// the interpreter decodes and runs one instruction at a time, the block cache keeps the decoded ops around
 
-	// doesn't matter if its a jump instruction or not, the opcode bits are the same for all instructions
-	cpu_instructions opcode = static_cast<cpu_instructions>(instr.jump_instruction.op);
+static void take_branch(Cpu * cpu, const micro_op& op)
+{
+	cpu->next_pc += op.immediate;
+	cpu->next_pc -= 4;
+	cpu->in_delay_slot = true;
+}
 
-	switch (opcode)
+static unsigned int get_load_store_addr(Cpu * cpu, const micro_op& op)
+{
+	return cpu->register_file.get_register(op.rs) + op.immediate;
+}
+
+static void wait_for_load(Cpu * cpu, unsigned int address, Bus::io_width width)
+{
+	cpu->wait_cycles += MemoryControl::get_instance()->get_read_cycles(address, width);
+}
+
+static void op_unknown(Cpu * cpu, const micro_op& op)
+{
+}
+
+static void op_addi(Cpu * cpu, const micro_op& op)
+{
+	unsigned int immediate = op.immediate;
+	unsigned int rs_value = cpu->register_file.get_register(op.rs);
+	unsigned int value = rs_value + immediate;
+
+	// check for overflow
 	{
-		case cpu_instructions::ADDI:
-		{
-			unsigned int immediate = (short)instr.immediate_instruction.immediate;
-			unsigned int rs_value = register_file.get_register(instr.immediate_instruction.rs);
-			unsigned int value = rs_value + immediate;
-
-			// check for overflow
-			{
-				int signed_value = value;
-				int signed_rs_value = rs_value;
-				int signed_imm = immediate;
-
-				if ((signed_imm >= 0 && signed_rs_value >= 0 && signed_value < 0) ||
-					(signed_imm < 0 && signed_rs_value < 0 && signed_value >= 0))
-				{
-					SystemControlCoprocessor::get_instance()->generate_interrupt(system_control::excode::Ov);
-					return;
-				}
-			}
-
-			register_file.set_register(instr.immediate_instruction.rt, value);
-		} break;
-
-		case cpu_instructions::ADDIU:
+		int signed_value = value;
+		int signed_rs_value = rs_value;
+		int signed_imm = immediate;
+
+		if ((signed_imm >= 0 && signed_rs_value >= 0 && signed_value < 0) ||
+			(signed_imm < 0 && signed_rs_value < 0 && signed_value >= 0))
 		{
-			unsigned int immediate = (short)instr.immediate_instruction.immediate;
-			unsigned int rs_value = register_file.get_register(instr.immediate_instruction.rs);
+			SystemControlCoprocessor::get_instance()->generate_interrupt(system_control::excode::Ov);
+			return;
+		}
+	}
 
-			unsigned int value = rs_value + immediate;
+	cpu->register_file.set_register(op.rt, value);
+}
 
-			register_file.set_register(instr.immediate_instruction.rt, value);
-		} break;
+static void op_addiu(Cpu * cpu, const micro_op& op)
+{
+	unsigned int rs_value = cpu->register_file.get_register(op.rs);
+	unsigned int value = rs_value + op.immediate;
+	cpu->register_file.set_register(op.rt, value);
+}
 
-		case cpu_instructions::ANDI:
-		{
-			unsigned int value = instr.immediate_instruction.immediate & register_file.get_register(instr.immediate_instruction.rs);
-			register_file.set_register(instr.immediate_instruction.rt, value);
-		} break;
+static void op_andi(Cpu * cpu, const micro_op& op)
+{
+	unsigned int value = op.immediate & cpu->register_file.get_register(op.rs);
+	cpu->register_file.set_register(op.rt, value);
+}
 
-		case cpu_instructions::BCOND:
-		{
-			execute_bcond(instr);
-		} break;
+static void op_beq(Cpu * cpu, const micro_op& op)
+{
+	unsigned int rs_value = cpu->register_file.get_register(op.rs);
+	unsigned int rt_value = cpu->register_file.get_register(op.rt);
+	if (rs_value == rt_value)
+	{
+		take_branch(cpu, op);
+	}
+}
 
-		case cpu_instructions::BEQ:
-		{
-			unsigned int rs_value = register_file.get_register(instr.immediate_instruction.rs);
-			unsigned int rt_value = register_file.get_register(instr.immediate_instruction.rt);
-			if (rs_value == rt_value)
-			{
-				unsigned int offset = (short)instr.immediate_instruction.immediate << 2;
-				next_pc += offset;
-				next_pc -= 4;
-				in_delay_slot = true;
-			}
-		} break;
-
-		case cpu_instructions::BGTZ:
-		{
-			int rs_value = register_file.get_register(instr.immediate_instruction.rs);
-			if (rs_value > 0)
-			{
-				unsigned int offset = (short)instr.immediate_instruction.immediate << 2;
-				next_pc += offset;
-				next_pc -= 4;
-				in_delay_slot = true;
-			}
-		} break;
-		
-		case cpu_instructions::BLEZ:
-		{
-			int rs_value = register_file.get_register(instr.immediate_instruction.rs);
-			if (rs_value <= 0)
-			{
-				unsigned int offset = (short)instr.immediate_instruction.immediate << 2;
-				next_pc += offset;
-				next_pc -= 4;
-				in_delay_slot = true;
-			}
-		} break;
-
-		case cpu_instructions::BNE:
-		{
-			unsigned int rs_value = register_file.get_register(instr.immediate_instruction.rs);
-			unsigned int rt_value = register_file.get_register(instr.immediate_instruction.rt);
-			if (rs_value != rt_value)
-			{
-				unsigned int offset = (short)instr.immediate_instruction.immediate << 2;
-				next_pc += offset;
-				next_pc -= 4;
-				in_delay_slot = true;
-			}
-		} break;
-
-		case cpu_instructions::SWC0:
-		case cpu_instructions::SWC2:
-		case cpu_instructions::LWC0:
-		case cpu_instructions::LWC2:
-		case cpu_instructions::COP2:
-		case cpu_instructions::COP0:
-		{
-			execute_cop(instr);
-		} break;
+static void op_bgtz(Cpu * cpu, const micro_op& op)
+{
+	int rs_value = cpu->register_file.get_register(op.rs);
+	if (rs_value > 0)
+	{
+		take_branch(cpu, op);
+	}
+}
 
-		case cpu_instructions::J:
-		{
-			unsigned int target = instr.jump_instruction.target << 2;
+static void op_blez(Cpu * cpu, const micro_op& op)
+{
+	int rs_value = cpu->register_file.get_register(op.rs);
+	if (rs_value <= 0)
+	{
+		take_branch(cpu, op);
+	}
+}
 
-			next_pc = target | (0xF0000000 & next_pc);
+static void op_bne(Cpu * cpu, const micro_op& op)
+{
+	unsigned int rs_value = cpu->register_file.get_register(op.rs);
+	unsigned int rt_value = cpu->register_file.get_register(op.rt);
+	if (rs_value != rt_value)
+	{
+		take_branch(cpu, op);
+	}
+}
 
-			in_delay_slot = true;
-		} break;
+static void op_bgez(Cpu * cpu, const micro_op& op)
+{
+	int rs_value = cpu->register_file.get_register(op.rs);
+	if (rs_value >= 0)
+	{
+		take_branch(cpu, op);
+	}
+}
 
-		case cpu_instructions::JAL:
-		{
-			register_file.set_register(31, next_pc);
-			unsigned int target = instr.jump_instruction.target << 2;
+static void op_bgezal(Cpu * cpu, const micro_op& op)
+{
+	int rs_value = cpu->register_file.get_register(op.rs);
+	if (rs_value >= 0)
+	{
+		cpu->register_file.set_register(op.rd, cpu->next_pc);
+		take_branch(cpu, op);
+	}
+}
 
-			next_pc = target | (0xF0000000 & next_pc);
+static void op_bltz(Cpu * cpu, const micro_op& op)
+{
+	int rs_value = cpu->register_file.get_register(op.rs);
+	if (rs_value < 0)
+	{
+		take_branch(cpu, op);
+	}
+}
 
-			in_delay_slot = true;
-		} break;
+static void op_bltzal(Cpu * cpu, const micro_op& op)
+{
+	int rs_value = cpu->register_file.get_register(op.rs);
+	if (rs_value < 0)
+	{
+		cpu->register_file.set_register(op.rd, cpu->next_pc);
+		take_branch(cpu, op);
+	}
+}
 
-		case cpu_instructions::LB:
-		{
-			unsigned int addr = get_immediate_base_addr(instr);
-			unsigned char value = bus->get_byte(addr);
-			register_file.set_register(instr.immediate_instruction.rt, value, true);
-		} break;
+static void op_cop(Cpu * cpu, const micro_op& op)
+{
+	cpu->execute_cop(op.instruction);
+}
 
-		case cpu_instructions::LBU:
-		{
-			unsigned int addr = get_immediate_base_addr(instr);
-			int value = (char)bus->get_byte(addr);
-			register_file.set_register(instr.immediate_instruction.rt, value, true);
-		} break;
+static void op_j(Cpu * cpu, const micro_op& op)
+{
+	cpu->next_pc = op.immediate | (0xF0000000 & cpu->next_pc);
+	cpu->in_delay_slot = true;
+}
 
-		case cpu_instructions::LH:
-		{
-			unsigned int addr = get_immediate_base_addr(instr);
-			int value = (short)bus->get_halfword(addr);
-			register_file.set_register(instr.immediate_instruction.rt, value, true);
-		} break;
+static void op_jal(Cpu * cpu, const micro_op& op)
+{
+	cpu->register_file.set_register(31, cpu->next_pc);
+	cpu->next_pc = op.immediate | (0xF0000000 & cpu->next_pc);
+	cpu->in_delay_slot = true;
+}
 
-		case cpu_instructions::LHU:
-		{
-			unsigned int addr = get_immediate_base_addr(instr);
-			unsigned short value = bus->get_halfword(addr);
-			register_file.set_register(instr.immediate_instruction.rt, value, true);
-		} break;
+static void op_lb(Cpu * cpu, const micro_op& op)
+{
+	unsigned int addr = get_load_store_addr(cpu, op);
+	wait_for_load(cpu, addr, Bus::io_width::BYTE);
+	unsigned char value = cpu_bus::get_instance()->get_byte(addr);
+	cpu->register_file.set_register(op.rt, value, true);
+}
 
-		case cpu_instructions::LUI:
-		{
-			unsigned int value = instr.immediate_instruction.immediate << 16;
-			register_file.set_register(instr.immediate_instruction.rt, value);
-		} break;
+static void op_lbu(Cpu * cpu, const micro_op& op)
+{
+	unsigned int addr = get_load_store_addr(cpu, op);
+	wait_for_load(cpu, addr, Bus::io_width::BYTE);
+	int value = (char)cpu_bus::get_instance()->get_byte(addr);
+	cpu->register_file.set_register(op.rt, value, true);
+}
 
-		case cpu_instructions::LW:
-		{
-			unsigned int addr = get_immediate_base_addr(instr);
-			unsigned int value = bus->get_word(addr);
-			register_file.set_register(instr.immediate_instruction.rt, value, true);
-		} break;
+static void op_lh(Cpu * cpu, const micro_op& op)
+{
+	unsigned int addr = get_load_store_addr(cpu, op);
+	wait_for_load(cpu, addr, Bus::io_width::HALFWORD);
+	int value = (short)cpu_bus::get_instance()->get_halfword(addr);
+	cpu->register_file.set_register(op.rt, value, true);
+}
 
-		// LWR is always called after LWL
-		case cpu_instructions::LWL:
-		{
-			unsigned int addr = get_immediate_base_addr(instr);
-			unsigned int addr_aligned = addr & ~3;
-			unsigned int aligned_value = bus->get_word(addr_aligned);
-			unsigned int current_value = register_file.get_register(instr.immediate_instruction.rt);
-
-			unsigned int alignment = addr & 3;
-			unsigned int mask = 0x00ffffff >> (alignment * 8);
-			unsigned int new_value = (current_value & mask) | (aligned_value << ((3 - alignment) * 8));
-			register_file.set_register(instr.immediate_instruction.rt, new_value, true);
-		} break;
-
-		case cpu_instructions::LWR:
-		{
-			unsigned int addr = get_immediate_base_addr(instr);
-			unsigned int addr_aligned = addr & ~3;
-			unsigned int aligned_value = bus->get_word(addr_aligned);
+static void op_lhu(Cpu * cpu, const micro_op& op)
+{
+	unsigned int addr = get_load_store_addr(cpu, op);
+	wait_for_load(cpu, addr, Bus::io_width::HALFWORD);
+	unsigned short value = cpu_bus::get_instance()->get_halfword(addr);
+	cpu->register_file.set_register(op.rt, value, true);
+}
 
-			// we assume that LWR is always called after LWL, so we ignore the load delay
-			unsigned int current_value = register_file.get_register(instr.immediate_instruction.rt, true);
+static void op_lui(Cpu * cpu, const micro_op& op)
+{
+	cpu->register_file.set_register(op.rt, op.immediate);
+}
 
-			unsigned int alignment = addr & 3;
-			unsigned int mask = 0xffffff00 << ((3 - alignment) * 8);
-			unsigned int new_value = (current_value & mask) | (aligned_value >> alignment * 8);
-			register_file.set_register(instr.immediate_instruction.rt, new_value, true);
-		} break;
+static void op_lw(Cpu * cpu, const micro_op& op)
+{
+	unsigned int addr = get_load_store_addr(cpu, op);
+	wait_for_load(cpu, addr, Bus::io_width::WORD);
+	unsigned int value = cpu_bus::get_instance()->get_word(addr);
+	cpu->register_file.set_register(op.rt, value, true);
+}
 
-		case cpu_instructions::SWR:
-		{
-			unsigned int addr = get_immediate_base_addr(instr);
-			unsigned int addr_aligned = addr & ~3;
-			unsigned int aligned_value = bus->get_word(addr_aligned);
-			unsigned int value_to_set = register_file.get_register(instr.immediate_instruction.rt);
+// LWR is always called after LWL
+static void op_lwl(Cpu * cpu, const micro_op& op)
+{
+	unsigned int addr = get_load_store_addr(cpu, op);
+	wait_for_load(cpu, addr, Bus::io_width::WORD);
+	unsigned int addr_aligned = addr & ~3;
+	unsigned int aligned_value = cpu_bus::get_instance()->get_word(addr_aligned);
+	unsigned int current_value = cpu->register_file.get_register(op.rt);
+
+	unsigned int alignment = addr & 3;
+	unsigned int mask = 0x00ffffff >> (alignment * 8);
+	unsigned int new_value = (current_value & mask) | (aligned_value << ((3 - alignment) * 8));
+	cpu->register_file.set_register(op.rt, new_value, true);
+}
 
-			unsigned int alignment = addr & 3;
-			unsigned int mask = 0x00ffffff >> ((3 - alignment) * 8);
+static void op_lwr(Cpu * cpu, const micro_op& op)
+{
+	unsigned int addr = get_load_store_addr(cpu, op);
+	wait_for_load(cpu, addr, Bus::io_width::WORD);
+	unsigned int addr_aligned = addr & ~3;
+	unsigned int aligned_value = cpu_bus::get_instance()->get_word(addr_aligned);
+
+	// we assume that LWR is always called after LWL, so we ignore the load delay
+	unsigned int current_value = cpu->register_file.get_register(op.rt, true);
+
+	unsigned int alignment = addr & 3;
+	unsigned int mask = 0xffffff00 << ((3 - alignment) * 8);
+	unsigned int new_value = (current_value & mask) | (aligned_value >> alignment * 8);
+	cpu->register_file.set_register(op.rt, new_value, true);
+}
 
-			unsigned int new_value = (aligned_value & mask) | (value_to_set << (alignment * 8));
-			bus->set_word(addr_aligned, new_value);
-		} break;
+static void op_swr(Cpu * cpu, const micro_op& op)
+{
+	cpu_bus * bus = cpu_bus::get_instance();
+	unsigned int addr = get_load_store_addr(cpu, op);
+	unsigned int addr_aligned = addr & ~3;
+	unsigned int aligned_value = bus->get_word(addr_aligned);
+	unsigned int value_to_set = cpu->register_file.get_register(op.rt);
 
-		// SWR is always called AFTER SWL
-		case cpu_instructions::SWL:
-		{
-			unsigned int addr = get_immediate_base_addr(instr);
-			unsigned int addr_aligned = addr & ~3;
-			unsigned int aligned_value = bus->get_word(addr_aligned);
-			unsigned int value_to_set = register_file.get_register(instr.immediate_instruction.rt);
+	unsigned int alignment = addr & 3;
+	unsigned int mask = 0x00ffffff >> ((3 - alignment) * 8);
 
-			unsigned int alignment = addr & 3;
-			unsigned int mask = 0xffffff00 << (alignment * 8);
+	unsigned int new_value = (aligned_value & mask) | (value_to_set << (alignment * 8));
+	bus->set_word(addr_aligned, new_value);
+}
 
-			unsigned int new_value = (aligned_value & mask) | (value_to_set >> ((3 - alignment) * 8));
-			bus->set_word(addr_aligned, new_value);
-		} break;
+// SWR is always called AFTER SWL
+static void op_swl(Cpu * cpu, const micro_op& op)
+{
+	cpu_bus * bus = cpu_bus::get_instance();
+	unsigned int addr = get_load_store_addr(cpu, op);
+	unsigned int addr_aligned = addr & ~3;
+	unsigned int aligned_value = bus->get_word(addr_aligned);
+	unsigned int value_to_set = cpu->register_file.get_register(op.rt);
 
-		case cpu_instructions::ORI:
-		{
-			unsigned int rs_value = register_file.get_register(instr.immediate_instruction.rs);
-			unsigned int value = rs_value | instr.immediate_instruction.immediate;
-			register_file.set_register(instr.immediate_instruction.rt, value);
-		} break;
+	unsigned int alignment = addr & 3;
+	unsigned int mask = 0xffffff00 << (alignment * 8);
 
-		case cpu_instructions::SB:
-		{
-			unsigned int addr = get_immediate_base_addr(instr);
-			unsigned int value = register_file.get_register(instr.immediate_instruction.rt);
-			bus->set_byte(addr, value);
-		} break;
+	unsigned int new_value = (aligned_value & mask) | (value_to_set >> ((3 - alignment) * 8));
+	bus->set_word(addr_aligned, new_value);
+}
 
-		case cpu_instructions::SH:
-		{
-			unsigned int addr = get_immediate_base_addr(instr);
-			unsigned int value = register_file.get_register(instr.immediate_instruction.rt);
-			bus->set_halfword(addr, value);
-		} break;
+static void op_ori(Cpu * cpu, const micro_op& op)
+{
+	unsigned int rs_value = cpu->register_file.get_register(op.rs);
+	cpu->register_file.set_register(op.rt, rs_value | op.immediate);
+}
 
-		case cpu_instructions::SLTI:
-		{
-			int rs_value = register_file.get_register(instr.immediate_instruction.rs);
-			int immediate_value = (short)instr.immediate_instruction.immediate;
-			register_file.set_register(instr.immediate_instruction.rt, rs_value < immediate_value ? 1 : 0);
-		} break;
+static void op_sb(Cpu * cpu, const micro_op& op)
+{
+	unsigned int addr = get_load_store_addr(cpu, op);
+	unsigned int value = cpu->register_file.get_register(op.rt);
+	cpu_bus::get_instance()->set_byte(addr, value);
+}
 
-		case cpu_instructions::SLTIU:
-		{
-			unsigned int rs_value = register_file.get_register(instr.immediate_instruction.rs);
-			int immediate_value = (short)instr.immediate_instruction.immediate;
-			register_file.set_register(instr.immediate_instruction.rt, rs_value < (unsigned int)immediate_value ? 1 : 0);
-		} break;
+static void op_sh(Cpu * cpu, const micro_op& op)
+{
+	unsigned int addr = get_load_store_addr(cpu, op);
+	unsigned int value = cpu->register_file.get_register(op.rt);
+	cpu_bus::get_instance()->set_halfword(addr, value);
+}
 
-		case cpu_instructions::SPECIAL:
-		{
-			execute_special(instr);
-		} break;
+static void op_slti(Cpu * cpu, const micro_op& op)
+{
+	int rs_value = cpu->register_file.get_register(op.rs);
+	int immediate_value = op.immediate;
+	cpu->register_file.set_register(op.rt, rs_value < immediate_value ? 1 : 0);
+}
 
-		case cpu_instructions::SW:
-		{
-			unsigned int addr = get_immediate_base_addr(instr);
-			unsigned int value = register_file.get_register(instr.immediate_instruction.rt);
-			bus->set_word(addr, value);
-		} break;
+static void op_sltiu(Cpu * cpu, const micro_op& op)
+{
+	unsigned int rs_value = cpu->register_file.get_register(op.rs);
+	cpu->register_file.set_register(op.rt, rs_value < op.immediate ? 1 : 0);
+}
+
+static void op_sw(Cpu * cpu, const micro_op& op)
+{
+	unsigned int addr = get_load_store_addr(cpu, op);
+	unsigned int value = cpu->register_file.get_register(op.rt);
+	cpu_bus::get_instance()->set_word(addr, value);
+}
+
+static void op_xori(Cpu * cpu, const micro_op& op)
+{
+	unsigned int rs_value = cpu->register_file.get_register(op.rs);
+	cpu->register_file.set_register(op.rt, rs_value ^ op.immediate);
+}
 
-		case cpu_instructions::XORI:
+static void op_add(Cpu * cpu, const micro_op& op)
+{
+	unsigned int rs_value = cpu->register_file.get_register(op.rs);
+	unsigned int rt_value = cpu->register_file.get_register(op.rt);
+	unsigned int value = rs_value + rt_value;
+
+	// check for overflow
+	{
+		int signed_value = value;
+		int signed_rs_value = rs_value;
+		int signed_rt_value = rt_value;
+
+		if ((signed_rt_value >= 0 && signed_rs_value >= 0 && signed_value < 0) ||
+			(signed_rt_value < 0 && signed_rs_value < 0 && signed_value >= 0))
 		{
-			unsigned int rs_value = register_file.get_register(instr.immediate_instruction.rs);
-			unsigned int value = rs_value ^ instr.immediate_instruction.immediate;
-			register_file.set_register(instr.immediate_instruction.rt, value);
-		} break;
+			SystemControlCoprocessor::get_instance()->generate_interrupt(system_control::excode::Ov);
+			return;
+		}
 	}
+
+	cpu->register_file.set_register(op.rd, value);
+}
+
+static void op_addu(Cpu * cpu, const micro_op& op)
+{
+	int rs_value = cpu->register_file.get_register(op.rs);
+	int rt_value = cpu->register_file.get_register(op.rt);
+	unsigned int value = rs_value + rt_value;
+	cpu->register_file.set_register(op.rd, value);
 }
 
-void Cpu::execute_special(const instruction_union& instr)
+static void op_and(Cpu * cpu, const micro_op& op)
 {
-	cpu_special_funcs func = static_cast<cpu_special_funcs>(instr.register_instruction.funct);
-	switch (func)
+	unsigned int rs_value = cpu->register_file.get_register(op.rs);
+	unsigned int rt_value = cpu->register_file.get_register(op.rt);
+	cpu->register_file.set_register(op.rd, rs_value & rt_value);
+}
+
+static void op_break(Cpu * cpu, const micro_op& op)
+{
+	SystemControlCoprocessor::get_instance()->generate_interrupt(system_control::excode::BP);
+}
+
+static void op_div(Cpu * cpu, const micro_op& op)
+{
+	int rs_value = cpu->register_file.get_register(op.rs);
+	int rt_value = cpu->register_file.get_register(op.rt);
+
+	if (rt_value == 0)
 	{
-		case cpu_special_funcs::ADD:
+		cpu->hi = rs_value;
+		if (rs_value >= 0)
 		{
-			unsigned int rs_value = register_file.get_register(instr.register_instruction.rs);
-			unsigned int rt_value = register_file.get_register(instr.register_instruction.rt);
-			unsigned int value = rs_value + rt_value;
-
-			// check for overflow
-			{
-				int signed_value = value;
-				int signed_rs_value = rs_value;
-				int signed_rt_value = rt_value;
-
-				if ((signed_rt_value >= 0 && signed_rs_value >= 0 && signed_value < 0) ||
-					(signed_rt_value < 0 && signed_rs_value < 0 && signed_value >= 0))
-				{
-					SystemControlCoprocessor::get_instance()->generate_interrupt(system_control::excode::Ov);
-					return;
-				}
-			}
-
-			register_file.set_register(instr.register_instruction.rd, value);
-		} break;
-
-		case cpu_special_funcs::ADDU:
+			cpu->lo = 0xffffffff;
+		}
+		else
 		{
-			int rs_value = register_file.get_register(instr.register_instruction.rs);
-			int rt_value = register_file.get_register(instr.register_instruction.rt);
-			unsigned int value = rs_value + rt_value;
+			cpu->lo = 1;
+		}
+	}
+	else if (rs_value == 0x80000000 && rt_value == -1)
+	{
+		cpu->hi = 0;
+		cpu->lo = 0x80000000;
+	}
+	else
+	{
+		cpu->hi = rs_value % rt_value;
+		cpu->lo = rs_value / rt_value;
+	}
+}
 
-			register_file.set_register(instr.register_instruction.rd, value);
-		} break;
+static void op_divu(Cpu * cpu, const micro_op& op)
+{
+	unsigned int rs_value = cpu->register_file.get_register(op.rs);
+	unsigned int rt_value = cpu->register_file.get_register(op.rt);
 
-		case cpu_special_funcs::AND:
-		{
-			unsigned int rs_value = register_file.get_register(instr.register_instruction.rs);
-			unsigned int rt_value = register_file.get_register(instr.register_instruction.rt);
-			unsigned int value = rs_value & rt_value;
-			register_file.set_register(instr.register_instruction.rd, value);
-		} break;
+	if (rt_value == 0)
+	{
+		cpu->hi = rs_value;
+		cpu->lo = 0xffffffff;
+	}
+	else
+	{
+		cpu->hi = rs_value % rt_value;
+		cpu->lo = rs_value / rt_value;
+	}
+}
 
-		case cpu_special_funcs::BREAK:
-		{
-			SystemControlCoprocessor::get_instance()->generate_interrupt(system_control::excode::BP);
-		} break;
+static void op_jalr(Cpu * cpu, const micro_op& op)
+{
+	cpu->register_file.set_register(op.rd, cpu->next_pc);
+	cpu->next_pc = cpu->register_file.get_register(op.rs);
+	cpu->in_delay_slot = true;
+}
 
-		case cpu_special_funcs::DIV:
-		{
-			int rs_value = register_file.get_register(instr.register_instruction.rs);
-			int rt_value = register_file.get_register(instr.register_instruction.rt);
-
-			if (rt_value == 0)
-			{
-				hi = rs_value;
-				if (rs_value >= 0)
-				{
-					lo = 0xffffffff;
-				}
-				else
-				{
-					lo = 1;
-				}
-			}
-			else if (rs_value == 0x80000000 && rt_value == -1)
-			{
-				hi = 0;
-				lo = 0x80000000;
-			}
-			else
-			{
-				hi = rs_value % rt_value;
-				lo = rs_value / rt_value;
-			}
-		} break;
-
-		case cpu_special_funcs::DIVU:
-		{
-			unsigned int rs_value = register_file.get_register(instr.register_instruction.rs);
-			unsigned int rt_value = register_file.get_register(instr.register_instruction.rt);
-
-			if (rt_value == 0)
-			{
-				hi = rs_value;
-				lo = 0xffffffff;
-			}
-			else
-			{
-				hi = rs_value % rt_value;
-				lo = rs_value / rt_value;
-			}
-		} break;
-
-		case cpu_special_funcs::JALR:
-		{
-			register_file.set_register(instr.register_instruction.rd, next_pc);
-			next_pc = register_file.get_register(instr.register_instruction.rs);
-			in_delay_slot = true;
-		} break;
+static void op_jr(Cpu * cpu, const micro_op& op)
+{
+	cpu->next_pc = cpu->register_file.get_register(op.rs);
+	cpu->in_delay_slot = true;
+}
 
-		case cpu_special_funcs::JR:
-		{
-			next_pc = register_file.get_register(instr.register_instruction.rs);
-			in_delay_slot = true;
-		} break;
+static void op_mfhi(Cpu * cpu, const micro_op& op)
+{
+	cpu->register_file.set_register(op.rd, cpu->hi);
+}
 
-		case cpu_special_funcs::MFHI:
-		{
-			register_file.set_register(instr.register_instruction.rd, hi);
-		} break;
+static void op_mflo(Cpu * cpu, const micro_op& op)
+{
+	cpu->register_file.set_register(op.rd, cpu->lo);
+}
 
-		case cpu_special_funcs::MFLO:
-		{
-			register_file.set_register(instr.register_instruction.rd, lo);
-		} break;
+static void op_mthi(Cpu * cpu, const micro_op& op)
+{
+	cpu->hi = cpu->register_file.get_register(op.rs);
+}
 
-		case cpu_special_funcs::MTHI:
-		{
-			hi = register_file.get_register(instr.register_instruction.rs);
-		} break;
+static void op_mtlo(Cpu * cpu, const micro_op& op)
+{
+	cpu->lo = cpu->register_file.get_register(op.rs);
+}
 
-		case cpu_special_funcs::MTLO:
-		{
-			lo = register_file.get_register(instr.register_instruction.rs);
-		} break;
+static void op_mult(Cpu * cpu, const micro_op& op)
+{
+	int rs_value = cpu->register_file.get_register(op.rs);
+	int rt_value = cpu->register_file.get_register(op.rt);
+	long long result = rs_value * rt_value;
+	cpu->hi = result >> 32;
+	cpu->lo = result & 0xFFFFFFFF;
+}
 
-		case cpu_special_funcs::MULT:
-		{
-			int rs_value = register_file.get_register(instr.register_instruction.rs);
-			int rt_value = register_file.get_register(instr.register_instruction.rt);
-			long long result = rs_value * rt_value;
-			hi = result >> 32;
-			lo = result & 0xFFFFFFFF;
-		} break;
-
-		case cpu_special_funcs::MULTU:
-		{
-			unsigned int rs_value = register_file.get_register(instr.register_instruction.rs);
-			unsigned int rt_value = register_file.get_register(instr.register_instruction.rt);
-			unsigned long long result = rs_value * rt_value;
-			hi = result >> 32;
-			lo = result & 0xFFFFFFFF;
-		} break;
-
-		case cpu_special_funcs::NOR:
-		{
-			unsigned int rs_value = register_file.get_register(instr.register_instruction.rs);
-			unsigned int rt_value = register_file.get_register(instr.register_instruction.rt);
-			unsigned int value = ~(rs_value | rt_value);
-			register_file.set_register(instr.register_instruction.rd, value);
-		} break;
+static void op_multu(Cpu * cpu, const micro_op& op)
+{
+	unsigned int rs_value = cpu->register_file.get_register(op.rs);
+	unsigned int rt_value = cpu->register_file.get_register(op.rt);
+	unsigned long long result = rs_value * rt_value;
+	cpu->hi = result >> 32;
+	cpu->lo = result & 0xFFFFFFFF;
+}
 
-		case cpu_special_funcs::OR:
-		{
-			unsigned int rs_value = register_file.get_register(instr.register_instruction.rs);
-			unsigned int rt_value = register_file.get_register(instr.register_instruction.rt);
-			unsigned int value = rs_value | rt_value;
-			register_file.set_register(instr.register_instruction.rd, value);
-		} break;
+static void op_nor(Cpu * cpu, const micro_op& op)
+{
+	unsigned int rs_value = cpu->register_file.get_register(op.rs);
+	unsigned int rt_value = cpu->register_file.get_register(op.rt);
+	cpu->register_file.set_register(op.rd, ~(rs_value | rt_value));
+}
 
-		case cpu_special_funcs::SLL:
-		{
-			unsigned int rt_value = register_file.get_register(instr.register_instruction.rt);
-			unsigned int value = rt_value << instr.register_instruction.shamt;
-			register_file.set_register(instr.register_instruction.rd, value);
-		} break;
+static void op_or(Cpu * cpu, const micro_op& op)
+{
+	unsigned int rs_value = cpu->register_file.get_register(op.rs);
+	unsigned int rt_value = cpu->register_file.get_register(op.rt);
+	cpu->register_file.set_register(op.rd, rs_value | rt_value);
+}
 
-		case cpu_special_funcs::SLLV:
-		{
-			unsigned int rs_value = register_file.get_register(instr.register_instruction.rs);
-			unsigned int rt_value = register_file.get_register(instr.register_instruction.rt);
-			// restrict shift values to lower 5 bits so shifts over 32 bits, result in effectively a NOP instruction
-			unsigned int value = rt_value << (0x1F & rs_value);
+static void op_sll(Cpu * cpu, const micro_op& op)
+{
+	unsigned int rt_value = cpu->register_file.get_register(op.rt);
+	cpu->register_file.set_register(op.rd, rt_value << op.shamt);
+}
 
-			register_file.set_register(instr.register_instruction.rd, value);
-		} break;
+static void op_sllv(Cpu * cpu, const micro_op& op)
+{
+	unsigned int rs_value = cpu->register_file.get_register(op.rs);
+	unsigned int rt_value = cpu->register_file.get_register(op.rt);
+	// restrict shift values to lower 5 bits so shifts over 32 bits, result in effectively a NOP instruction
+	cpu->register_file.set_register(op.rd, rt_value << (0x1F & rs_value));
+}
 
-		case cpu_special_funcs::SLT:
-		{
-			int rt_value = register_file.get_register(instr.register_instruction.rt);
-			int rs_value = register_file.get_register(instr.register_instruction.rs);
+static void op_slt(Cpu * cpu, const micro_op& op)
+{
+	int rt_value = cpu->register_file.get_register(op.rt);
+	int rs_value = cpu->register_file.get_register(op.rs);
+	cpu->register_file.set_register(op.rd, rs_value < rt_value ? 1 : 0);
+}
 
-			register_file.set_register(instr.register_instruction.rd, rs_value < rt_value ? 1 : 0);
-		} break;
+static void op_sltu(Cpu * cpu, const micro_op& op)
+{
+	unsigned int rt_value = cpu->register_file.get_register(op.rt);
+	unsigned int rs_value = cpu->register_file.get_register(op.rs);
+	cpu->register_file.set_register(op.rd, rs_value < rt_value ? 1 : 0);
+}
 
-		case cpu_special_funcs::SLTU:
-		{
-			unsigned int rt_value = register_file.get_register(instr.register_instruction.rt);
-			unsigned int rs_value = register_file.get_register(instr.register_instruction.rs);
+static void op_sra(Cpu * cpu, const micro_op& op)
+{
+	int rt_value = (int)(cpu->register_file.get_register(op.rt));
+	unsigned int value = rt_value >> op.shamt;
+	cpu->register_file.set_register(op.rd, value);
+}
 
-			register_file.set_register(instr.register_instruction.rd, rs_value < rt_value ? 1 : 0);
-		} break;
+static void op_srav(Cpu * cpu, const micro_op& op)
+{
+	int rt_value = cpu->register_file.get_register(op.rt);
+	unsigned int rs_value = cpu->register_file.get_register(op.rs);
+	unsigned int value = rt_value >> (0x1F & rs_value);
+	cpu->register_file.set_register(op.rd, value);
+}
 
-		case cpu_special_funcs::SRA:
-		{
-			int rt_value = (int)(register_file.get_register(instr.register_instruction.rt));
-			unsigned int value = rt_value >> instr.register_instruction.shamt;
-			register_file.set_register(instr.register_instruction.rd, value);
-		} break;
+static void op_srl(Cpu * cpu, const micro_op& op)
+{
+	unsigned int rt_value = cpu->register_file.get_register(op.rt);
+	cpu->register_file.set_register(op.rd, rt_value >> op.shamt);
+}
 
-		case cpu_special_funcs::SRAV:
-		{
-			int rt_value = register_file.get_register(instr.register_instruction.rt);
-			unsigned int rs_value = register_file.get_register(instr.register_instruction.rs);
-			unsigned int value = rt_value >> (0x1F & rs_value);
-			register_file.set_register(instr.register_instruction.rd, value);
-		} break;
+static void op_srlv(Cpu * cpu, const micro_op& op)
+{
+	unsigned int rt_value = cpu->register_file.get_register(op.rt);
+	unsigned int rs_value = cpu->register_file.get_register(op.rs);
+	cpu->register_file.set_register(op.rd, rt_value >> (0x1F & rs_value));
+}
 
-		case cpu_special_funcs::SRL:
-		{
-			unsigned int rt_value = register_file.get_register(instr.register_instruction.rt);
-			unsigned int value = rt_value >> instr.register_instruction.shamt;
-			register_file.set_register(instr.register_instruction.rd, value);
-		} break;
+static void op_sub(Cpu * cpu, const micro_op& op)
+{
+	unsigned int rs_value = cpu->register_file.get_register(op.rs);
+	unsigned int rt_value = cpu->register_file.get_register(op.rt);
+	unsigned int value = rs_value - rt_value;
 
-		case cpu_special_funcs::SRLV:
-		{
-			unsigned int rt_value = register_file.get_register(instr.register_instruction.rt);
-			unsigned int rs_value = register_file.get_register(instr.register_instruction.rs);
-			unsigned int value = rt_value >> (0x1F & rs_value);
-			register_file.set_register(instr.register_instruction.rd, value);
-		} break;
+	// check for overflow
+	{
+		int signed_value = value;
+		int signed_rs_value = rs_value;
+		int signed_rt_value = rt_value;
 
-		case cpu_special_funcs::SUB:
-		{
-			unsigned int rs_value = register_file.get_register(instr.register_instruction.rs);
-			unsigned int rt_value = register_file.get_register(instr.register_instruction.rt);
-			unsigned int value = rs_value - rt_value;
-
-			// check for overflow
-			{
-				int signed_value = value;
-				int signed_rs_value = rs_value;
-				int signed_rt_value = rt_value;
-
-				if ((signed_rt_value >= 0 && signed_rs_value >= 0 && signed_value < 0) ||
-					(signed_rt_value < 0 && signed_rs_value < 0 && signed_value >= 0))
-				{
-					SystemControlCoprocessor::get_instance()->generate_interrupt(system_control::excode::Ov);
-					return;
-				}
-			}
-
-			register_file.set_register(instr.register_instruction.rd, value);
-		} break;
-
-		case cpu_special_funcs::SUBU:
+		if ((signed_rt_value >= 0 && signed_rs_value >= 0 && signed_value < 0) ||
+			(signed_rt_value < 0 && signed_rs_value < 0 && signed_value >= 0))
 		{
-			int rs_value = register_file.get_register(instr.register_instruction.rs);
-			int rt_value = register_file.get_register(instr.register_instruction.rt);
-			unsigned int value = rs_value - rt_value;
-			register_file.set_register(instr.register_instruction.rd, value);
-		} break;
+			SystemControlCoprocessor::get_instance()->generate_interrupt(system_control::excode::Ov);
+			return;
+		}
+	}
 
-		case cpu_special_funcs::SYSCALL:
-		{
-			SystemControlCoprocessor::get_instance()->generate_interrupt(system_control::excode::Syscall);
-		} break;
+	cpu->register_file.set_register(op.rd, value);
+}
 
-		case cpu_special_funcs::XOR:
-		{
-			unsigned int rs_value = register_file.get_register(instr.register_instruction.rs);
-			unsigned int rt_value = register_file.get_register(instr.register_instruction.rt);
-			unsigned int value = rs_value ^ rt_value;
-			register_file.set_register(instr.register_instruction.rd, value);
-		} break;
+static void op_subu(Cpu * cpu, const micro_op& op)
+{
+	int rs_value = cpu->register_file.get_register(op.rs);
+	int rt_value = cpu->register_file.get_register(op.rt);
+	unsigned int value = rs_value - rt_value;
+	cpu->register_file.set_register(op.rd, value);
+}
+
+static void op_syscall(Cpu * cpu, const micro_op& op)
+{
+	SystemControlCoprocessor::get_instance()->generate_interrupt(system_control::excode::Syscall);
+}
+
+static void op_xor(Cpu * cpu, const micro_op& op)
+{
+	unsigned int rs_value = cpu->register_file.get_register(op.rs);
+	unsigned int rt_value = cpu->register_file.get_register(op.rt);
+	cpu->register_file.set_register(op.rd, rs_value ^ rt_value);
+}
+
+struct handler_entry
+{
+	instruction_id id;
+	micro_op::handler_function handler;
+};
+
+static constexpr handler_entry handler_entries[] =
+{
+	{ instruction_id::J, op_j }, { instruction_id::JAL, op_jal },
+	{ instruction_id::BEQ, op_beq }, { instruction_id::BNE, op_bne },
+	{ instruction_id::BLEZ, op_blez }, { instruction_id::BGTZ, op_bgtz },
+	{ instruction_id::ADDI, op_addi }, { instruction_id::ADDIU, op_addiu },
+	{ instruction_id::SLTI, op_slti }, { instruction_id::SLTIU, op_sltiu },
+	{ instruction_id::ANDI, op_andi }, { instruction_id::ORI, op_ori },
+	{ instruction_id::XORI, op_xori }, { instruction_id::LUI, op_lui },
+	{ instruction_id::LB, op_lb }, { instruction_id::LH, op_lh },
+	{ instruction_id::LWL, op_lwl }, { instruction_id::LW, op_lw },
+	{ instruction_id::LBU, op_lbu }, { instruction_id::LHU, op_lhu },
+	{ instruction_id::LWR, op_lwr }, { instruction_id::SB, op_sb },
+	{ instruction_id::SH, op_sh }, { instruction_id::SWL, op_swl },
+	{ instruction_id::SW, op_sw }, { instruction_id::SWR, op_swr },
+	{ instruction_id::LWC0, op_cop }, { instruction_id::LWC2, op_cop },
+	{ instruction_id::SWC0, op_cop }, { instruction_id::SWC2, op_cop },
+
+	{ instruction_id::SLL, op_sll }, { instruction_id::SRL, op_srl },
+	{ instruction_id::SRA, op_sra }, { instruction_id::SLLV, op_sllv },
+	{ instruction_id::SRLV, op_srlv }, { instruction_id::SRAV, op_srav },
+	{ instruction_id::JR, op_jr }, { instruction_id::JALR, op_jalr },
+	{ instruction_id::SYSCALL, op_syscall }, { instruction_id::BREAK, op_break },
+	{ instruction_id::MFHI, op_mfhi }, { instruction_id::MTHI, op_mthi },
+	{ instruction_id::MFLO, op_mflo }, { instruction_id::MTLO, op_mtlo },
+	{ instruction_id::MULT, op_mult }, { instruction_id::MULTU, op_multu },
+	{ instruction_id::DIV, op_div }, { instruction_id::DIVU, op_divu },
+	{ instruction_id::ADD, op_add }, { instruction_id::ADDU, op_addu },
+	{ instruction_id::SUB, op_sub }, { instruction_id::SUBU, op_subu },
+	{ instruction_id::AND, op_and }, { instruction_id::OR, op_or },
+	{ instruction_id::XOR, op_xor }, { instruction_id::NOR, op_nor },
+	{ instruction_id::SLT, op_slt }, { instruction_id::SLTU, op_sltu },
+
+	{ instruction_id::BLTZ, op_bltz }, { instruction_id::BGEZ, op_bgez },
+	{ instruction_id::BLTZAL, op_bltzal }, { instruction_id::BGEZAL, op_bgezal },
+
+	// the coprocessors decode their own instructions
+	{ instruction_id::COP0, op_cop }, { instruction_id::COP2, op_cop },
+};
+
+struct handler_table
+{
+	micro_op::handler_function handlers[static_cast<unsigned int>(instruction_id::NUM_INSTRUCTIONS)];
+};
+
+static constexpr handler_table make_handler_table()
+{
+	handler_table table = {};
+	for (unsigned int idx = 0; idx < NUM_INSTRUCTION_DESCRIPTIONS; idx++)
+	{
+		instruction_group group = instruction_descriptions[idx].group;
+		bool is_cop = group == instruction_group::COP0_MOVE || group == instruction_group::COP2_MOVE ||
+			group == instruction_group::COP0_FUNCTION || group == instruction_group::GTE_COMMAND;
+		table.handlers[idx] = is_cop ? op_cop : op_unknown;
+	}
+	for (const handler_entry& entry : handler_entries)
+	{
+		table.handlers[static_cast<unsigned int>(entry.id)] = entry.handler;
 	}
+	return table;
 }
 
-void Cpu::execute_bcond(const instruction_union& instr)
+static constexpr handler_table handler_table_by_id = make_handler_table();
+
+void Cpu::decode(const instruction_union& instr, micro_op& op)
 {
-	cpu_bconds cond = static_cast<cpu_bconds>(instr.immediate_instruction.rt);
-	switch (cond)
+	op = micro_op();
+	op.instruction = instr;
+	op.rs = instr.register_instruction.rs;
+	op.rt = instr.register_instruction.rt;
+	op.rd = instr.register_instruction.rd;
+	op.shamt = instr.register_instruction.shamt;
+
+	op.id = decode_instruction(instr.raw);
+	const instruction_description& description = get_instruction_description(op.id);
+	op.handler = handler_table_by_id.handlers[static_cast<unsigned int>(op.id)];
+	op.is_branch = (description.flags & INSTRUCTION_BRANCH) != 0;
+	op.ends_block = (description.flags & INSTRUCTION_ENDS_BLOCK) != 0;
+	if (description.flags & INSTRUCTION_INTERLOCK)
 	{
-		case cpu_bconds::BGEZ:
-		{
-			int rs_value = register_file.get_register(instr.immediate_instruction.rs);
-			if (rs_value >= 0)
-			{
-				unsigned int offset = (short)instr.immediate_instruction.immediate << 2;
-				next_pc += offset;
-				next_pc -= 4;
-				in_delay_slot = true;
-			}
-		} break;
-
-		case cpu_bconds::BGEZAL:
-		{
-			int rs_value = register_file.get_register(instr.immediate_instruction.rs);
-			if (rs_value >= 0)
-			{
-				register_file.set_register(instr.register_instruction.rd, next_pc);
-				unsigned int offset = (short)instr.immediate_instruction.immediate << 2;
-				next_pc += offset;
-				next_pc -= 4;
-				in_delay_slot = true;
-			}
-		} break;
-
-		case cpu_bconds::BLTZ:
-		{
-			int rs_value = register_file.get_register(instr.immediate_instruction.rs);
-			if (rs_value < 0)
-			{
-				unsigned int offset = (short)instr.immediate_instruction.immediate << 2;
-				next_pc += offset;
-				next_pc -= 4;
-				in_delay_slot = true;
-			}
-		} break;
-
-		case cpu_bconds::BLTZAL:
-		{
-			int rs_value = register_file.get_register(instr.immediate_instruction.rs);
-			if (rs_value < 0)
-			{
-				register_file.set_register(instr.register_instruction.rd, next_pc);
-				unsigned int offset = (short)instr.immediate_instruction.immediate << 2;
-				next_pc += offset;
-				next_pc -= 4;
-				in_delay_slot = true;
-			}
-		} break;
+		op.interlock_cycles = description.latency - 1;
+	}
+
+	unsigned int sign_extended = (short)instr.immediate_instruction.immediate;
+	unsigned int zero_extended = instr.immediate_instruction.immediate;
+
+	switch (description.format)
+	{
+		case operand_format::RT_RS_SIGNED:
+		case operand_format::RT_OFFSET_BASE: op.immediate = sign_extended; break;
+		case operand_format::RT_RS_UNSIGNED: op.immediate = zero_extended; break;
+		case operand_format::RT_UPPER: op.immediate = zero_extended << 16; break;
+		case operand_format::RS_RT_BRANCH:
+		case operand_format::RS_BRANCH: op.immediate = sign_extended << 2; break;
+		case operand_format::JUMP_TARGET: op.immediate = instr.jump_instruction.target << 2; break;
+		default: break;
 	}
 }
 
@@ -721,13 +933,4 @@ void Cpu::execute_cop(const instruction_union& instr)
 	{
 		GTECoprocessor::get_instance()->execute(instr);
 	}
-}
-
-unsigned int Cpu::get_immediate_base_addr(const instruction_union& instr)
-{
-	int offset = (short)instr.immediate_instruction.immediate;
-	int base = register_file.get_register(instr.immediate_instruction.rs);
-
-	unsigned int addr = offset + base;
-	return addr;
 }
\ No newline at end of file
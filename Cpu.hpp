@@ -8,6 +8,42 @@
 enum class cpu_instructions : unsigned char;
 enum class cpu_special_funcs : unsigned char;
 enum class cpu_bconds : unsigned char;
+enum class instruction_id : unsigned char;
+
+class Cpu;
+
+// an instruction with its fields pulled out ahead of time, the handler does the work
+struct micro_op
+{
+	typedef void(*handler_function)(Cpu * cpu, const micro_op& op);
+
+	handler_function handler = nullptr;
+	// which entry of the instruction table it was decoded as
+	instruction_id id{};
+	// sign or zero extended to what the instruction uses, branch offsets and jump targets are already shifted
+	unsigned int immediate = 0;
+	unsigned char rs = 0;
+	unsigned char rt = 0;
+	unsigned char rd = 0;
+	unsigned char shamt = 0;
+	// has a delay slot
+	bool is_branch = false;
+	// the cached interpreter has to go back to fetching one instruction at a time after this
+	bool ends_block = false;
+	// how long the multiplier, divider or gte keeps the cpu waiting for the result, the code reading it
+	// almost always comes straight after so it is charged up front
+	unsigned char interlock_cycles = 0;
+	instruction_union instruction;
+};
+
+enum class cpu_mode
+{
+	INTERPRETER,
+	// runs blocks of instructions decoded ahead of time, see BlockCache
+	CACHED_INTERPRETER,
+	// compiles the cached blocks to x86-64, see Jit
+	JIT
+};
 
 // ref:
 // https://svkt.org/~simias/guide.pdf
@@ -20,17 +56,20 @@ public:
 
 	void init();
 	void reset();
-	void tick();
+
+	// returns the number of cycles the instructions it ran took
+	unsigned int tick();
+
+	void set_mode(cpu_mode new_mode);
+	cpu_mode get_mode() { return mode; }
 
 	void save_state(std::stringstream& file);
 	void load_state(std::stringstream& file);
 
 	void execute(const instruction_union& instruction);
-	void execute_special(const instruction_union& instr);
-	void execute_bcond(const instruction_union& instr);
 	void execute_cop(const instruction_union& instr);
 
-	unsigned int get_immediate_base_addr(const instruction_union& instr);
+	static void decode(const instruction_union& instr, micro_op& op);
 
 	unsigned int hi = 0;
 	unsigned int lo = 0;
@@ -43,8 +82,29 @@ public:
 
 	bool in_delay_slot = false;
 
+	// cycles spent waiting on memory and interlocks since the last tick, on top of one per instruction
+	unsigned int wait_cycles = 0;
+	unsigned long long instruction_count = 0;
+
+	// runs the hot bios functions natively, see BiosHle
+	// off by default, a call takes one cycle instead of however long the bios would have taken
+	bool hle_bios_calls = false;
+
+	// devices and coprocessors set this rather than throwing when the guest does something that isn't emulated,
+	// whatever it was carries on as a no-op (reads return 0) and tick reports it once the block has finished
+	void raise_pending_exception(const char * reason) { pending_exception = reason; }
+	const char * pending_exception = nullptr;
+
 	static Cpu * get_instance();
 
 private:
 	Cpu() = default;
+
+	// fetches and executes a single instruction
+	void step();
+	// returns 0 if there wasn't a block to run
+	unsigned int execute_block();
+	unsigned int execute_instructions();
+
+	cpu_mode mode = cpu_mode::INTERPRETER;
 };
\ No newline at end of file
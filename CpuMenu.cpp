@@ -2,6 +2,7 @@
 #include "Psx.hpp"
 #include "Cpu.hpp"
 #include "Dma.hpp"
+#include "BiosHle.hpp"
 #include "SystemControlCoprocessor.hpp"
 #include "MipsToString.hpp"
 #include <sstream>
@@ -33,6 +34,20 @@ void CpuMenu::draw_menu()
 		std::stringstream current_instr_text;
 		current_instr_text << "Instr: 0x" << std::hex << std::setfill('0') << std::setw(8) << cpu->current_instruction;
 		ImGui::Text(current_instr_text.str().c_str());
+	}
+
+	{
+		std::stringstream idle_text;
+		idle_text << "Idle cycles skipped: " << Psx::get_instance()->idle_cycles_skipped;
+		ImGui::Text(idle_text.str().c_str());
+	}
+
+	{
+		ImGui::Checkbox("HLE bios calls", &cpu->hle_bios_calls);
+		BiosHle * bios_hle = BiosHle::get_instance();
+		std::stringstream hle_text;
+		hle_text << "Handled: " << bios_hle->num_calls_handled << " Passed through: " << bios_hle->num_calls_passed_through;
+		ImGui::Text(hle_text.str().c_str());
 		ImGui::Separator();
 	}
 
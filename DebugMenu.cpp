@@ -462,39 +462,33 @@ void DebugMenuManager::draw_bus_menu()
 
 	bool save_enable_pause_state = psx->bus->enable_pause_on_address_access;
 	psx->bus->enable_pause_on_address_access = false;
-	try
+	// unsupported reads don't throw, they return 0 and leave a pending exception on the cpu
+	const char * cpu_exception = psx->cpu->pending_exception;
+	psx->cpu->pending_exception = nullptr;
+
 	{
 		std::stringstream text;
 		text << "Word: 0x" << std::hex << std::setfill('0') << std::setw(8) << psx->bus->get_word(address_of_interest);
-		ImGui::Text(text.str().c_str());
-	}
-	catch (...)
-	{
-		ImGui::Text("Word access not supported");
+		ImGui::Text(psx->cpu->pending_exception ? "Word access not supported" : text.str().c_str());
+		psx->cpu->pending_exception = nullptr;
 	}
 
-	try
 	{
 		std::stringstream text;
 		text << "Halfword: 0x" << std::hex << std::setfill('0') << std::setw(4) << psx->bus->get_halfword(address_of_interest);
-		ImGui::Text(text.str().c_str());
-	}
-	catch (...)
-	{
-		ImGui::Text("Halfword access not supported");
+		ImGui::Text(psx->cpu->pending_exception ? "Halfword access not supported" : text.str().c_str());
+		psx->cpu->pending_exception = nullptr;
 	}
 
-	try
 	{
 		std::stringstream text;
 		text << "Byte: 0x" << std::hex << std::setfill('0') << std::setw(2) << (unsigned int)psx->bus->get_byte(address_of_interest);
-		ImGui::Text(text.str().c_str());
-	}
-	catch (...)
-	{
-		ImGui::Text("Byte access not supported");
+		ImGui::Text(psx->cpu->pending_exception ? "Byte access not supported" : text.str().c_str());
+		psx->cpu->pending_exception = nullptr;
 	}
 
+	psx->cpu->pending_exception = cpu_exception;
+
 	static int new_value = 0x0;
 	ImGui::NewLine();
 	ImGui::InputInt("New Value", &new_value, 1, 100, ImGuiInputTextFlags_CharsHexadecimal);
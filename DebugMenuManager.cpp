@@ -3,6 +3,7 @@
 #include "Psx.hpp"
 #include "AssemblyMenu.hpp"
 #include "MemoryMenu.hpp"
+#include "BusProfilerMenu.hpp"
 #include "CpuMenu.hpp"
 #include "GpuMenu.hpp"
 #include "CdromMenu.hpp"
@@ -37,6 +38,9 @@ void DebugMenuManager::init(GLFWwindow* window)
 
 	menus.push_back(std::make_shared<AssemblyMenu>());
 	menus.push_back(std::make_shared<MemoryMenu>());
+#ifdef PSX_BUS_PROFILER
+	menus.push_back(std::make_shared<BusProfilerMenu>());
+#endif
 	menus.push_back(std::make_shared<CpuMenu>());
 	menus.push_back(std::make_shared<GpuMenu>());
 	menus.push_back(std::make_shared<CdromMenu>());
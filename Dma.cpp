@@ -3,8 +3,34 @@
 #include "Spu.hpp"
 #include "Cdrom.hpp"
 #include "SystemControlCoprocessor.hpp"
+#include "Cpu.hpp"
+#include "Scheduler.hpp"
+#include "Psx.hpp"
+#include "Ram.hpp"
 #include <iostream>
 #include <fstream>
+#include <cstring>
+
+unsigned int DMA_interface::sync_mode_manual(DMA_base_address& base_address, DMA_block_control& block_control, DMA_channel_control& channel_control)
+{
+	Cpu::get_instance()->raise_pending_exception("dma sync mode not supported");
+	return 0;
+}
+
+unsigned int DMA_interface::sync_mode_request(DMA_base_address& base_address, DMA_block_control& block_control, DMA_channel_control& channel_control)
+{
+	Cpu::get_instance()->raise_pending_exception("dma sync mode not supported");
+	return 0;
+}
+
+unsigned int DMA_interface::sync_mode_linked_list(DMA_base_address& base_address, DMA_block_control& block_control, DMA_channel_control& channel_control)
+{
+	Cpu::get_instance()->raise_pending_exception("dma sync mode not supported");
+	return 0;
+}
+
+// https://psx-spx.consoledev.net/dmachannels/#dma-transfer-rates
+const unsigned int Dma::CYCLES_PER_WORD[NUM_CHANNELS] = { 1, 1, 1, 24, 4, 20, 1 };
 
 static Dma * instance = nullptr;
 Dma * Dma::get_instance()
@@ -62,6 +88,27 @@ void Dma::set_byte(unsigned int address, unsigned char value)
 		}
 	}
 	dma_registers[address - DMA_START] = value;
+	on_register_write(address);
+}
+
+void Dma::register_io_handlers(Bus * bus)
+{
+	bus->register_io_range(DMA_START, DMA_END, this);
+
+	// the channel registers and DPCR are plain memory, so word accesses don't need to go a byte at a time
+	for (unsigned int address = DMA_BASE_ADDRESS_START; address < DMA_INTERRUPT_REGISTER_START; address += 4)
+	{
+		bus->register_io_read(address, Bus::io_width::WORD, this, [](void * context, unsigned int address) -> unsigned int {
+			unsigned int value = 0;
+			memcpy(&value, &static_cast<Dma*>(context)->dma_registers[address - DMA_START], sizeof(unsigned int));
+			return value;
+		});
+		bus->register_io_write(address, Bus::io_width::WORD, this, [](void * context, unsigned int address, unsigned int value) {
+			Dma * dma = static_cast<Dma*>(context);
+			memcpy(&dma->dma_registers[address - DMA_START], &value, sizeof(unsigned int));
+			dma->on_register_write(address);
+		});
+	}
 }
 
 void Dma::init()
@@ -79,6 +126,10 @@ void Dma::init()
 	devices[static_cast<unsigned int>(DMA_channel_type::GPU)] = Gpu::get_instance();
 	devices[static_cast<unsigned int>(DMA_channel_type::SPU)] = Spu::get_instance();
 	devices[static_cast<unsigned int>(DMA_channel_type::CDROM)] = Cdrom::get_instance();
+
+	Scheduler::get_instance()->register_event(scheduler_event::DMA, this, [](void * context) {
+		static_cast<Dma*>(context)->run_event();
+	});
 	
 	reset();
 }
@@ -90,77 +141,187 @@ void Dma::reset()
 	// according to problem kaputt documentation
 	*control_register = 0x07654321;
 	interrupt_register.value = 0x0;
+
+	requested_channels = 0;
+	active_channel = NO_CHANNEL;
+	remaining_words = 0;
+	Scheduler::get_instance()->cancel(scheduler_event::DMA);
 }
 
-void Dma::tick()
+void Dma::on_register_write(unsigned int address)
 {
-	// this is used to compare against the DICR IRQ enable and IRQ flags fields
-	unsigned char irq_mask = 0x1;
-	for (int chan_idx = 0; chan_idx < NUM_CHANNELS; chan_idx++)
+	if (address >= DMA_INTERRUPT_REGISTER_START && address < DMA_INTERRUPT_REGISTER_START + 4)
+	{
+		update_interrupt();
+	}
+	else if (address >= DMA_CONTROL_REGISTER_START && address < DMA_CONTROL_REGISTER_START + 4)
 	{
-		DMA_base_address base_address;
-		base_address.int_value = *base_address_registers[chan_idx];
+		for (unsigned int chan_idx = 0; chan_idx < NUM_CHANNELS; chan_idx++)
+		{
+			update_channel_request(chan_idx);
+		}
+	}
+	else if (address >= DMA_CHANNEL_CONTROL_START && address < DMA_CONTROL_REGISTER_START && ((address - DMA_CHANNEL_CONTROL_START) & 0xF) < 4)
+	{
+		update_channel_request((address - DMA_CHANNEL_CONTROL_START) / 16);
+	}
+}
 
-		DMA_block_control block_control;
-		block_control.int_value = *block_control_registers[chan_idx];
+bool Dma::is_channel_ready(unsigned int chan_idx) const
+{
+	DMA_channel_control channel_control;
+	channel_control.int_value = *channel_control_registers[chan_idx];
 
-		DMA_channel_control channel_control;
-		channel_control.int_value = *channel_control_registers[chan_idx];
+	// manual transfers wait for the trigger as well, and every channel has an enable in DPCR
+	bool master_enable = (*control_register >> (chan_idx * 4 + 3)) & 0x1;
+	bool triggered = static_cast<DMA_sync_mode>(channel_control.sync_mode) != DMA_sync_mode::manual || channel_control.start_trigger;
+	return master_enable && channel_control.start_busy && triggered;
+}
 
-		DMA_channel_type type = static_cast<DMA_channel_type>(chan_idx);
+void Dma::update_channel_request(unsigned int chan_idx)
+{
+	// a transfer which has started carries on whatever's written to it
+	if (chan_idx == active_channel)
+	{
+		return;
+	}
 
-		DMA_interface * device =  devices[static_cast<unsigned int>(type)];
+	unsigned int channel_bit = 0x1 << chan_idx;
+	if (is_channel_ready(chan_idx))
+	{
+		requested_channels |= channel_bit;
+	}
+	else
+	{
+		requested_channels &= ~channel_bit;
+	}
+
+	Scheduler * scheduler = Scheduler::get_instance();
+	if (requested_channels != 0 && active_channel == NO_CHANNEL && scheduler->is_scheduled(scheduler_event::DMA) == false)
+	{
+		scheduler->schedule(scheduler_event::DMA, scheduler->current_cycle);
+	}
+}
 
-		bool dma_complete = false;
-		if (channel_control.start_busy == 1)
+void Dma::run_event()
+{
+	if (active_channel != NO_CHANNEL)
+	{
+		if (remaining_words > 0)
 		{
-			switch (static_cast<DMA_sync_mode>(channel_control.sync_mode))
-			{
-				case DMA_sync_mode::manual:
-				{
-					if (channel_control.start_trigger == 1)
-					{
-						channel_control.start_trigger = 0;
-						device->sync_mode_manual(base_address, block_control, channel_control);
-						channel_control.start_busy = 0;
-						dma_complete = true;
-					}
-				} break;
-
-				case DMA_sync_mode::request:
-				{
-					channel_control.start_trigger = 0;
-					device->sync_mode_request(base_address, block_control, channel_control);
-					channel_control.start_busy = 0;
-					dma_complete = true;
-				} break;
-
-				case DMA_sync_mode::linked_list:
-				{
-					channel_control.start_trigger = 0;
-					device->sync_mode_linked_list(base_address, block_control, channel_control);
-					channel_control.start_busy = 0;
-					dma_complete = true;
-				} break;
-			}
+			run_chunk();
+			return;
 		}
+		complete_transfer();
+	}
 
-		*base_address_registers[chan_idx] = base_address.int_value;
-		*block_control_registers[chan_idx] = block_control.int_value;
-		*channel_control_registers[chan_idx] = channel_control.int_value;
+	start_next_transfer();
+}
 
-		// according to problemkaputt, on dma completion IF enabled, the irq should be set
-		if (dma_complete && (interrupt_register.irq_enable & irq_mask))
+void Dma::start_next_transfer()
+{
+	// the lowest priority value goes first, a tie goes to the higher channel
+	unsigned int chan_idx = NO_CHANNEL;
+	unsigned int best_priority = 0;
+	for (unsigned int idx = 0; idx < NUM_CHANNELS; idx++)
+	{
+		unsigned int priority = (*control_register >> (idx * 4)) & 0x7;
+		if ((requested_channels & (0x1 << idx)) && (chan_idx == NO_CHANNEL || priority <= best_priority))
 		{
-			interrupt_register.irq_flags |= irq_mask;
+			chan_idx = idx;
+			best_priority = priority;
 		}
+	}
+
+	if (chan_idx == NO_CHANNEL)
+	{
+		return;
+	}
+	requested_channels &= ~(0x1 << chan_idx);
+	active_channel = chan_idx;
+
+	DMA_base_address base_address;
+	base_address.int_value = *base_address_registers[chan_idx];
+
+	DMA_block_control block_control;
+	block_control.int_value = *block_control_registers[chan_idx];
+
+	DMA_channel_control channel_control;
+	channel_control.int_value = *channel_control_registers[chan_idx];
+	channel_control.start_trigger = 0;
+
+	// everything moves now, the time it takes is spent afterwards
+	unsigned int num_words = 0;
+	DMA_interface * device = devices[chan_idx];
+	if (device == nullptr)
+	{
+		Cpu::get_instance()->raise_pending_exception("dma channel has no device");
+	}
+	else
+	{
+		switch (static_cast<DMA_sync_mode>(channel_control.sync_mode))
+		{
+			case DMA_sync_mode::manual:
+			{
+				num_words = device->sync_mode_manual(base_address, block_control, channel_control);
+			} break;
+
+			case DMA_sync_mode::request:
+			{
+				num_words = device->sync_mode_request(base_address, block_control, channel_control);
+			} break;
+
+			case DMA_sync_mode::linked_list:
+			{
+				num_words = device->sync_mode_linked_list(base_address, block_control, channel_control);
+			} break;
+		}
+	}
 
-		// shift the mast
-		// first channel it will be 0000001
-		// second channel it will be 0000010 and so on
-		irq_mask <<= 1;
+	*base_address_registers[chan_idx] = base_address.int_value;
+	*block_control_registers[chan_idx] = block_control.int_value;
+	*channel_control_registers[chan_idx] = channel_control.int_value;
+
+	// chopping hands the bus back to the cpu for a while between each chunk of words
+	remaining_words = num_words;
+	chunk_words = channel_control.chopping_enable ? 0x1 << channel_control.chopping_dma_window_size : 0;
+	cpu_window_cycles = channel_control.chopping_enable ? 0x1 << channel_control.chopping_cpu_window_size : 0;
+	run_chunk();
+}
+
+void Dma::run_chunk()
+{
+	unsigned int num_words = (chunk_words == 0 || chunk_words > remaining_words) ? remaining_words : chunk_words;
+	remaining_words -= num_words;
+
+	// the cpu can't get at the bus while the words go over it
+	Scheduler * scheduler = Scheduler::get_instance();
+	unsigned long long chunk_end_cycle = scheduler->current_cycle + static_cast<unsigned long long>(num_words) * CYCLES_PER_WORD[active_channel];
+	Psx::get_instance()->stall_cpu_until(chunk_end_cycle);
+
+	scheduler->schedule(scheduler_event::DMA, chunk_end_cycle + (remaining_words > 0 ? cpu_window_cycles : 0));
+}
+
+void Dma::complete_transfer()
+{
+	DMA_channel_control channel_control;
+	channel_control.int_value = *channel_control_registers[active_channel];
+	channel_control.start_busy = 0;
+	*channel_control_registers[active_channel] = channel_control.int_value;
+
+	// according to problemkaputt, on dma completion IF enabled, the irq should be set
+	unsigned char irq_mask = 0x1 << active_channel;
+	if (interrupt_register.irq_enable & irq_mask)
+	{
+		interrupt_register.irq_flags |= irq_mask;
 	}
 
+	active_channel = NO_CHANNEL;
+	update_interrupt();
+}
+
+void Dma::update_interrupt()
+{
 	// setup the interrupts, failing to setup this stuff
 	bool previous_interrupt_master_flag_value = interrupt_register.irq_master_flag;
 
@@ -190,9 +351,19 @@ void Dma::load_state(std::stringstream& file)
 {
 	file.read(reinterpret_cast<char*>(&dma_registers[0]), sizeof(unsigned char) * 128);
 	file.read(reinterpret_cast<char*>(interrupt_register.byte_value), sizeof(unsigned char) * 4);
+
+	// where a transfer had got to isn't saved, any channel still busy starts over
+	requested_channels = 0;
+	active_channel = NO_CHANNEL;
+	remaining_words = 0;
+	Scheduler::get_instance()->cancel(scheduler_event::DMA);
+	for (unsigned int chan_idx = 0; chan_idx < NUM_CHANNELS; chan_idx++)
+	{
+		update_channel_request(chan_idx);
+	}
 }
 
-void Dma::sync_mode_manual(DMA_base_address& base_address, DMA_block_control& block_control, DMA_channel_control& channel_control)
+unsigned int Dma::sync_mode_manual(DMA_base_address& base_address, DMA_block_control& block_control, DMA_channel_control& channel_control)
 {
 	//std::cout << "Starting OTC manual DMA\n";
 	unsigned int num_words = block_control.BC;
@@ -200,19 +371,37 @@ void Dma::sync_mode_manual(DMA_base_address& base_address, DMA_block_control& bl
 	DMA_direction dir = static_cast<DMA_direction>(channel_control.transfer_direction);
 	DMA_address_step step = static_cast<DMA_address_step>(channel_control.memory_address_step);
 	unsigned int addr = base_address.memory_address & 0x1ffffc;
+	Ram * ram = Ram::get_instance();
 
+	// the usual table runs down from addr, which is the same as building it up from its lowest entry with each
+	// entry pointing at the one below and the lowest ending the list
+	if (step == DMA_address_step::decrement && num_words > 0 && (num_words - 1) * 4 <= addr)
+	{
+		unsigned int table_start = addr - (num_words - 1) * 4;
+		unsigned int * table = reinterpret_cast<unsigned int*>(ram->get_dma_span_for_write(table_start, num_words * 4));
+		table[0] = 0xffffffff;
+		for (unsigned int idx = 1; idx < num_words; idx++)
+		{
+			table[idx] = table_start + (idx - 1) * 4;
+		}
+		return num_words;
+	}
+
+	unsigned int num_words_moved = num_words;
 	while (num_words > 0)
 	{
 		num_words--;
 		if (num_words == 0)
 		{
-			Bus::get_instance()->set_word(addr, 0xffffffff);
+			ram->set_dma_word(addr, 0xffffffff);
 		}
 		else
 		{
-			Bus::get_instance()->set_word(addr, (addr - 4) & 0x1fffff);
+			ram->set_dma_word(addr, (addr - 4) & 0x1fffff);
 		}
 
-		addr += (step == DMA_address_step::increment ? 4 : -4);
+		addr = (addr + (step == DMA_address_step::increment ? 4 : -4)) & 0x1ffffc;
 	}
+
+	return num_words_moved;
 }
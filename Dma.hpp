@@ -133,9 +133,11 @@ enum class DMA_channel_type
 class DMA_interface
 {
 public:
-	virtual void sync_mode_manual(DMA_base_address& base_address, DMA_block_control& block_control, DMA_channel_control& channel_control) { throw std::logic_error("not supported"); }
-	virtual void sync_mode_request(DMA_base_address& base_address, DMA_block_control& block_control, DMA_channel_control& channel_control) { throw std::logic_error("not supported"); }
-	virtual void sync_mode_linked_list(DMA_base_address& base_address, DMA_block_control& block_control, DMA_channel_control& channel_control) { throw std::logic_error("not supported"); }
+	// each returns the number of words it moved, which is what the transfer's duration is worked out from
+	// the defaults raise a pending exception on the cpu and transfer nothing
+	virtual unsigned int sync_mode_manual(DMA_base_address& base_address, DMA_block_control& block_control, DMA_channel_control& channel_control);
+	virtual unsigned int sync_mode_request(DMA_base_address& base_address, DMA_block_control& block_control, DMA_channel_control& channel_control);
+	virtual unsigned int sync_mode_linked_list(DMA_base_address& base_address, DMA_block_control& block_control, DMA_channel_control& channel_control);
 };
 
 class Dma : public DMA_interface, public Bus::BusDevice
@@ -143,17 +145,18 @@ class Dma : public DMA_interface, public Bus::BusDevice
 public:
 
 	virtual bool is_address_for_device(unsigned int address) final;
+	virtual const char * get_device_name() final { return "Dma"; }
 	virtual unsigned char get_byte(unsigned int address) final;
 	virtual void set_byte(unsigned int address, unsigned char value) final;
+	virtual void register_io_handlers(Bus * bus) final;
 
 	void init();
 	void reset();
-	void tick();
 	void save_state(std::stringstream& file);
 	void load_state(std::stringstream& file);
 
 	// for OTC channel - since its basically DMA to ram
-	virtual void sync_mode_manual(DMA_base_address& base_address, DMA_block_control& block_control, DMA_channel_control& channel_control) override;
+	virtual unsigned int sync_mode_manual(DMA_base_address& base_address, DMA_block_control& block_control, DMA_channel_control& channel_control) override;
 
 	DMA_interface* devices[7] = { nullptr };
 	DMA_interrupt_register interrupt_register;
@@ -172,6 +175,30 @@ private:
 	static const unsigned int DMA_INTERRUPT_REGISTER_START = 0x1F8010F4;
 	static const unsigned int DMA_GARBAGE_START = 0x1F8010F8;
 
+	static const unsigned int NO_CHANNEL = 0xFFFFFFFF;
+
+	// how long the bus is busy for each word, CDROM and SPU transfers wait on the device
+	static const unsigned int CYCLES_PER_WORD[NUM_CHANNELS];
+
+	// a write to CHCR or DPCR can leave a channel ready to go, the DMA event starts them one at a time by
+	// priority and then runs the transfer's chunks until it's done
+	void update_channel_request(unsigned int chan_idx);
+	bool is_channel_ready(unsigned int chan_idx) const;
+	void on_register_write(unsigned int address);
+	void run_event();
+	void start_next_transfer();
+	void run_chunk();
+	void complete_transfer();
+	void update_interrupt();
+
+	// bit per channel
+	unsigned int requested_channels = 0;
+	unsigned int active_channel = NO_CHANNEL;
+	// the data has all moved when the transfer starts, this is how much of the time it takes is left
+	unsigned int remaining_words = 0;
+	unsigned int chunk_words = 0;
+	unsigned int cpu_window_cycles = 0;
+
 	unsigned char dma_registers[128] = { 0 };
 	unsigned int * base_address_registers[7] = { nullptr };
 	unsigned int * block_control_registers[7] = { nullptr };
@@ -0,0 +1,216 @@
+#include "Fastmem.hpp"
+
+#ifdef PSX_FASTMEM
+#include <iostream>
+#include <cstring>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <ucontext.h>
+
+#include "Bus.hpp"
+#include "Ram.hpp"
+#include "Rom.hpp"
+
+static Fastmem * instance = nullptr;
+
+// segments which mirror the 512MB physical address space
+static const unsigned int segments[] = { 0x00000000, 0x80000000, 0xA0000000 };
+
+static const unsigned int SCRATCHPAD_START = 0x1F800000;
+static const unsigned int BIOS_START = 0x1FC00000;
+
+Fastmem * Fastmem::get_instance()
+{
+	if (instance == nullptr)
+	{
+		instance = new Fastmem();
+	}
+
+	return instance;
+}
+
+bool Fastmem::init()
+{
+	// already set up, the benchmarks share one instance between them
+	if (base != nullptr)
+	{
+		return true;
+	}
+
+	memory_fd = memfd_create("psx-memory", 0);
+	if (memory_fd < 0 || ftruncate(memory_fd, SHARED_MEMORY_SIZE) != 0)
+	{
+		std::cerr << "Fastmem: unable to create shared memory\n";
+		return false;
+	}
+
+	// reserve the address space first so nothing else can end up inside it
+	void * reserved = mmap(nullptr, ADDRESS_SPACE_SIZE, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	if (reserved == MAP_FAILED)
+	{
+		std::cerr << "Fastmem: unable to reserve address space\n";
+		return false;
+	}
+	base = static_cast<unsigned char*>(reserved);
+
+	void * view = mmap(nullptr, SHARED_MEMORY_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, memory_fd, 0);
+	if (view == MAP_FAILED)
+	{
+		std::cerr << "Fastmem: unable to map shared memory\n";
+		return false;
+	}
+	host_view = static_cast<unsigned char*>(view);
+
+	for (unsigned int segment : segments)
+	{
+		if (map_view(segment, MAIN_MEMORY_OFFSET, MAIN_MEMORY_SIZE, PROT_READ | PROT_WRITE) == false ||
+			map_view(segment + SCRATCHPAD_START, SCRATCHPAD_OFFSET, SCRATCHPAD_SIZE, PROT_READ | PROT_WRITE) == false ||
+			// stores to the bios fault and get handed to Rom
+			map_view(segment + BIOS_START, BIOS_OFFSET, BIOS_SIZE, PROT_READ) == false)
+		{
+			std::cerr << "Fastmem: unable to map segment " << std::hex << segment << "\n";
+			return false;
+		}
+	}
+
+	Ram::get_instance()->attach_memory(host_view + MAIN_MEMORY_OFFSET, host_view + SCRATCHPAD_OFFSET);
+	Rom::get_instance()->attach_memory(host_view + BIOS_OFFSET);
+
+	struct sigaction action;
+	memset(&action, 0, sizeof(action));
+	action.sa_sigaction = fault_handler;
+	action.sa_flags = SA_SIGINFO;
+	sigemptyset(&action.sa_mask);
+
+	if (sigaction(SIGSEGV, &action, &previous_action) != 0)
+	{
+		std::cerr << "Fastmem: unable to install fault handler\n";
+		return false;
+	}
+
+	return true;
+}
+
+void Fastmem::set_ram_accessible(bool accessible)
+{
+	ram_accessible = accessible;
+	if (base == nullptr)
+	{
+		return;
+	}
+
+	for (unsigned int segment : segments)
+	{
+		mprotect(base + segment, MAIN_MEMORY_SIZE, accessible ? PROT_READ | PROT_WRITE : PROT_NONE);
+	}
+
+	if (accessible)
+	{
+		Ram * ram = Ram::get_instance();
+		for (unsigned int address = 0; address < MAIN_MEMORY_SIZE; address += 1 << Ram::DIRTY_PAGE_SHIFT)
+		{
+			if (ram->is_page_write_direct(address >> Ram::DIRTY_PAGE_SHIFT) == false)
+			{
+				set_ram_page_writable(address, false);
+			}
+		}
+	}
+}
+
+void Fastmem::set_ram_page_writable(unsigned int physical_address, bool writable)
+{
+	// while the cache is isolated every page stays inaccessible, set_ram_accessible sorts them out afterwards
+	if (base == nullptr || ram_accessible == false)
+	{
+		return;
+	}
+
+	for (unsigned int segment : segments)
+	{
+		mprotect(base + segment + physical_address, 1 << Ram::DIRTY_PAGE_SHIFT, writable ? PROT_READ | PROT_WRITE : PROT_READ);
+	}
+}
+
+bool Fastmem::map_view(unsigned int guest_address, unsigned int offset, unsigned int size, int protection)
+{
+	void * address = base + guest_address;
+	return mmap(address, size, protection, MAP_SHARED | MAP_FIXED, memory_fd, offset) == address;
+}
+
+// the only instructions that can fault inside the address space are the ones in Fastmem.hpp
+// all of them use rdi as the base, rsi as the guest address and eax as the value
+void Fastmem::fault_handler(int signal, siginfo_t * info, void * context)
+{
+	unsigned char * fault_address = static_cast<unsigned char*>(info->si_addr);
+	if (instance == nullptr)
+	{
+		// nothing to hand the fault back to, the default action stops the process when it faults again
+		struct sigaction default_action = {};
+		default_action.sa_handler = SIG_DFL;
+		sigaction(SIGSEGV, &default_action, nullptr);
+		return;
+	}
+
+	if (fault_address < instance->base || fault_address >= instance->base + ADDRESS_SPACE_SIZE)
+	{
+		// a genuine crash, put the old handler back and let the instruction fault again
+		sigaction(SIGSEGV, &instance->previous_action, nullptr);
+		return;
+	}
+
+	greg_t * registers = static_cast<ucontext_t*>(context)->uc_mcontext.gregs;
+	const unsigned char * instruction = reinterpret_cast<const unsigned char*>(registers[REG_RIP]);
+	unsigned int address = static_cast<unsigned int>(registers[REG_RSI]);
+	unsigned int value = static_cast<unsigned int>(registers[REG_RAX]);
+
+	static const unsigned char load_word[] = { 0x8B, 0x04, 0x37 };
+	static const unsigned char load_halfword[] = { 0x0F, 0xB7, 0x04, 0x37 };
+	static const unsigned char load_byte[] = { 0x0F, 0xB6, 0x04, 0x37 };
+	static const unsigned char store_word[] = { 0x89, 0x04, 0x37 };
+	static const unsigned char store_halfword[] = { 0x66, 0x89, 0x04, 0x37 };
+	static const unsigned char store_byte[] = { 0x88, 0x04, 0x37 };
+
+	Bus * bus = Bus::get_instance();
+	unsigned int instruction_length = 0;
+
+	if (memcmp(instruction, load_word, sizeof(load_word)) == 0)
+	{
+		registers[REG_RAX] = bus->get_word(address);
+		instruction_length = sizeof(load_word);
+	}
+	else if (memcmp(instruction, load_halfword, sizeof(load_halfword)) == 0)
+	{
+		registers[REG_RAX] = bus->get_halfword(address);
+		instruction_length = sizeof(load_halfword);
+	}
+	else if (memcmp(instruction, load_byte, sizeof(load_byte)) == 0)
+	{
+		registers[REG_RAX] = bus->get_byte(address);
+		instruction_length = sizeof(load_byte);
+	}
+	else if (memcmp(instruction, store_word, sizeof(store_word)) == 0)
+	{
+		bus->set_word(address, value);
+		instruction_length = sizeof(store_word);
+	}
+	else if (memcmp(instruction, store_halfword, sizeof(store_halfword)) == 0)
+	{
+		bus->set_halfword(address, static_cast<unsigned short>(value));
+		instruction_length = sizeof(store_halfword);
+	}
+	else if (memcmp(instruction, store_byte, sizeof(store_byte)) == 0)
+	{
+		bus->set_byte(address, static_cast<unsigned char>(value));
+		instruction_length = sizeof(store_byte);
+	}
+
+	if (instruction_length == 0)
+	{
+		std::cerr << "Fastmem: fault from unknown instruction at " << std::hex << address << std::endl;
+		sigaction(SIGSEGV, &instance->previous_action, nullptr);
+		return;
+	}
+
+	registers[REG_RIP] += instruction_length;
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,97 @@
+#pragma once
+
+// Maps the whole 4GB PSX address space onto a block of host address space, so a load or store from
+// the cpu is a single host memory access with no decoding at all.
+// Main memory, the scratchpad and the bios all live in one shared memory object which is mapped
+// into every segment that mirrors them, so the mirrors alias the same host pages. Everything else
+// (the I/O ports, expansion regions, KSEG2) is left unmapped and accesses there fault into a
+// signal handler which replays them through the bus.
+// Only supported on x86-64 linux, enable it with the PSX_FASTMEM cmake option.
+// When debugging use "handle SIGSEGV nostop noprint" in gdb, every I/O access raises one.
+#ifdef PSX_FASTMEM
+#include <csignal>
+
+class Fastmem
+{
+public:
+	static Fastmem * get_instance();
+
+	bool init();
+
+	// main memory has to fault into the bus while the cache is isolated
+	void set_ram_accessible(bool accessible);
+
+	// clean pages of main memory are read only so Ram sees the first write to them
+	void set_ram_page_writable(unsigned int physical_address, bool writable);
+
+	// the jit emits the same accesses as the functions below so the fault handler can decode them
+	unsigned char * get_base() { return base; }
+
+	// the accesses are written in assembly so the signal handler knows exactly which
+	// instruction faulted, where the guest address is and where a loaded value has to go
+	unsigned char get_byte(unsigned int address)
+	{
+		unsigned int value;
+		asm volatile("movzbl (%%rdi,%%rsi,1), %%eax" : "=a"(value) : "D"(base), "S"(static_cast<unsigned long long>(address)) : "memory");
+		return static_cast<unsigned char>(value);
+	}
+
+	unsigned short get_halfword(unsigned int address)
+	{
+		unsigned int value;
+		asm volatile("movzwl (%%rdi,%%rsi,1), %%eax" : "=a"(value) : "D"(base), "S"(static_cast<unsigned long long>(address)) : "memory");
+		return static_cast<unsigned short>(value);
+	}
+
+	unsigned int get_word(unsigned int address)
+	{
+		unsigned int value;
+		asm volatile("movl (%%rdi,%%rsi,1), %%eax" : "=a"(value) : "D"(base), "S"(static_cast<unsigned long long>(address)) : "memory");
+		return value;
+	}
+
+	void set_byte(unsigned int address, unsigned char value)
+	{
+		asm volatile("movb %%al, (%%rdi,%%rsi,1)" : : "a"(value), "D"(base), "S"(static_cast<unsigned long long>(address)) : "memory");
+	}
+
+	void set_halfword(unsigned int address, unsigned short value)
+	{
+		asm volatile("movw %%ax, (%%rdi,%%rsi,1)" : : "a"(value), "D"(base), "S"(static_cast<unsigned long long>(address)) : "memory");
+	}
+
+	void set_word(unsigned int address, unsigned int value)
+	{
+		asm volatile("movl %%eax, (%%rdi,%%rsi,1)" : : "a"(value), "D"(base), "S"(static_cast<unsigned long long>(address)) : "memory");
+	}
+
+private:
+	Fastmem() = default;
+	~Fastmem() = default;
+
+	static void fault_handler(int signal, siginfo_t * info, void * context);
+
+	bool map_view(unsigned int guest_address, unsigned int offset, unsigned int size, int protection);
+
+	// sizes of the memory backed regions, the scratchpad is only 1KB but has to be mapped as a full page
+	static const unsigned int MAIN_MEMORY_SIZE = 1024 * 512 * 4;
+	static const unsigned int SCRATCHPAD_SIZE = 1024 * 4;
+	static const unsigned int BIOS_SIZE = 1024 * 512;
+
+	// where each region lives in the shared memory object
+	static const unsigned int MAIN_MEMORY_OFFSET = 0;
+	static const unsigned int SCRATCHPAD_OFFSET = MAIN_MEMORY_OFFSET + MAIN_MEMORY_SIZE;
+	static const unsigned int BIOS_OFFSET = SCRATCHPAD_OFFSET + SCRATCHPAD_SIZE;
+	static const unsigned int SHARED_MEMORY_SIZE = BIOS_OFFSET + BIOS_SIZE;
+
+	static const unsigned long long ADDRESS_SPACE_SIZE = 0x100000000ull;
+
+	unsigned char * base = nullptr;
+	// the same shared memory mapped once more, writable, for Ram and Rom to use
+	unsigned char * host_view = nullptr;
+	int memory_fd = -1;
+	bool ram_accessible = true;
+
+	struct sigaction previous_action;
+};
+#endif
\ No newline at end of file
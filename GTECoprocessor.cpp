@@ -136,5 +136,5 @@ void GTECoprocessor::move_control_from_cop(const instruction_union& instr)
 
 void GTECoprocessor::move_control_to_cop_fun(const instruction_union& instr)
 {
-	throw std::logic_error("not implemented");
+	Cpu::get_instance()->raise_pending_exception("gte commands not implemented");
 }
\ No newline at end of file
@@ -1,7 +1,12 @@
 #include "Gpu.hpp"
 #include "Ram.hpp"
+#include "Cpu.hpp"
 #include "InstructionEnums.hpp"
 #include "InstructionTypes.hpp"
+#include "SystemControlCoprocessor.hpp"
+#include "Scheduler.hpp"
+#include "Timers.hpp"
+#include "SpanKernels.hpp"
 #include <fstream>
 #include <iostream>
 #include <iomanip>
@@ -11,6 +16,10 @@
 
 static Gpu * instance = nullptr;
 
+// https://psx-spx.consoledev.net/graphicsprocessingunitgpu/#gpu-timings
+const Gpu::video_timing Gpu::NTSC_TIMING = { 53693175, 3413, 263, 240 };
+const Gpu::video_timing Gpu::PAL_TIMING = { 53203425, 3406, 314, 288 };
+
 Gpu * Gpu::get_instance()
 {
 	if (instance == nullptr)
@@ -53,10 +62,11 @@ unsigned int Gpu::get_word(unsigned int address)
 	}
 	else if (address == GP1_Send_GPUSTAT)
 	{
-		return gpu_status.int_value;
+		return get_status();
 	}
 
-	throw std::out_of_range("address out of range");
+	Cpu::get_instance()->raise_pending_exception("gpu address out of range");
+	return 0;
 }
 
 void Gpu::set_word(unsigned int address, unsigned int value)
@@ -71,10 +81,26 @@ void Gpu::set_word(unsigned int address, unsigned int value)
 	}
 	else
 	{
-		throw std::out_of_range("address out of range");
+		Cpu::get_instance()->raise_pending_exception("gpu address out of range");
 	}
 }
 
+void Gpu::register_io_handlers(Bus * bus)
+{
+	bus->register_io_read(GP0_Send_GPUREAD, Bus::io_width::WORD, this, [](void * context, unsigned int address) -> unsigned int {
+		return static_cast<Gpu*>(context)->Gpu::get_word(address);
+	});
+	bus->register_io_write(GP0_Send_GPUREAD, Bus::io_width::WORD, this, [](void * context, unsigned int address, unsigned int value) {
+		static_cast<Gpu*>(context)->add_gp0_command(value, false);
+	});
+	bus->register_io_read(GP1_Send_GPUSTAT, Bus::io_width::WORD, this, [](void * context, unsigned int address) -> unsigned int {
+		return static_cast<Gpu*>(context)->get_status();
+	});
+	bus->register_io_write(GP1_Send_GPUSTAT, Bus::io_width::WORD, this, [](void * context, unsigned int address, unsigned int value) {
+		static_cast<Gpu*>(context)->execute_gp1_command(value);
+	});
+}
+
 Gpu::~Gpu()
 {
 	if (video_ram)
@@ -94,17 +120,36 @@ void Gpu::init()
     // else I get a compiler out of heap space issue at compile time
 	video_ram = new unsigned short[VRAM_SIZE];
 	memset(video_ram, 0, VRAM_SIZE * sizeof(unsigned short));
+	dirty_tiles.set_all();
 
 	gp0_fifo = new Fifo<unsigned int>(16);
 
 	// hardcoded according to simias guide to get the emulator moving a bit further through the code
 	gpu_status.ready_dma = true;
 	gpu_status.ready_cmd_word = true;
+
+	// the event alternates between the start of vblank and the start of the next field
+	Scheduler::get_instance()->register_event(scheduler_event::GPU, this, [](void * context) {
+		Gpu * gpu = static_cast<Gpu*>(context);
+		if (gpu->in_vblank)
+		{
+			gpu->field_start_cycle = Scheduler::get_instance()->get_event_cycle(scheduler_event::GPU);
+			gpu->num_scanlines_before_field += gpu->get_video_timing().scanlines_per_field;
+			gpu->start_field();
+		}
+		else
+		{
+			gpu->start_vblank();
+		}
+	});
+	field_start_cycle = Scheduler::get_instance()->current_cycle;
+	start_field();
 }
 
 void Gpu::reset()
 {
 	memset(video_ram, 0, VRAM_SIZE * sizeof(unsigned short));
+	dirty_tiles.set_all();
 
 	gp0_fifo->clear();
 
@@ -133,10 +178,98 @@ void Gpu::reset()
 	copy_to_cpu_current_coord = 0x0;
 	copy_to_cpu_width_height = 0x0;
 	num_words_to_copy_to_cpu = 0;
+
+	num_fields = 0;
+	num_scanlines_before_field = 0;
+	field_start_cycle = Scheduler::get_instance()->current_cycle;
+	start_field();
+}
+
+unsigned int Gpu::get_status()
+{
+	// 240 line modes alternate every scanline, 480 line modes every field, it's always 0 in vblank
+	if (in_vblank)
+	{
+		gpu_status.even_odd = 0;
+	}
+	else if (gpu_status.v_interlace && gpu_status.v_res)
+	{
+		gpu_status.even_odd = gpu_status.interlace_field;
+	}
+	else
+	{
+		gpu_status.even_odd = get_scanline() & 0x1;
+	}
+
+	return gpu_status.int_value;
+}
+
+unsigned int Gpu::get_scanline() const
+{
+	const video_timing& timing = get_video_timing();
+	unsigned long long num_cycles = Scheduler::get_instance()->current_cycle - field_start_cycle;
+	unsigned long long scanline = num_cycles * timing.video_clock / (static_cast<unsigned long long>(timing.dots_per_scanline) * CPU_CLOCK);
+
+	// the cpu can run a little past the end of the field before the event starts the next one
+	return scanline < timing.scanlines_per_field ? static_cast<unsigned int>(scanline) : timing.scanlines_per_field - 1;
+}
+
+unsigned long long Gpu::get_next_vblank_cycle() const
+{
+	const video_timing& timing = get_video_timing();
+	return get_scanline_cycle(in_vblank ? timing.scanlines_per_field + timing.vblank_start_scanline : timing.vblank_start_scanline);
+}
+
+unsigned long long Gpu::get_num_scanlines_cycle(unsigned long long num_scanlines) const
+{
+	if (num_scanlines <= num_scanlines_before_field)
+	{
+		return field_start_cycle;
+	}
+	return get_scanline_cycle(static_cast<unsigned int>(num_scanlines - num_scanlines_before_field));
+}
+
+unsigned int Gpu::get_dot_clock_divider() const
+{
+	// 368 pixels wide overrides the other widths, otherwise 256, 320, 512 or 640
+	if (gpu_status.h_res_2)
+	{
+		return 7;
+	}
+	const unsigned int dividers[] = { 10, 8, 5, 4 };
+	return dividers[gpu_status.h_res_1];
 }
 
-void Gpu::tick()
+double Gpu::get_field_rate() const
 {
+	const video_timing& timing = gpu_status.video_mode ? PAL_TIMING : NTSC_TIMING;
+	return static_cast<double>(timing.video_clock) / (static_cast<double>(timing.dots_per_scanline) * timing.scanlines_per_field);
+}
+
+unsigned long long Gpu::get_scanline_cycle(unsigned int scanline) const
+{
+	const video_timing& timing = get_video_timing();
+	return field_start_cycle + static_cast<unsigned long long>(scanline) * timing.dots_per_scanline * CPU_CLOCK / timing.video_clock;
+}
+
+void Gpu::start_field()
+{
+	field_is_pal = gpu_status.video_mode != 0;
+	in_vblank = false;
+
+	// the field only alternates in interlaced modes, otherwise it reads as 1
+	gpu_status.interlace_field = gpu_status.v_interlace ? !gpu_status.interlace_field : 1;
+
+	Scheduler::get_instance()->schedule(scheduler_event::GPU, get_scanline_cycle(get_video_timing().vblank_start_scanline));
+}
+
+void Gpu::start_vblank()
+{
+	in_vblank = true;
+	num_fields++;
+	SystemControlCoprocessor::get_instance()->set_irq_bits(system_control::VBLANK_BIT);
+
+	Scheduler::get_instance()->schedule(scheduler_event::GPU, get_scanline_cycle(get_video_timing().scanlines_per_field));
 }
 
 void Gpu::save_state(std::stringstream& file, bool ignore_vram)
@@ -158,6 +291,13 @@ void Gpu::save_state(std::stringstream& file, bool ignore_vram)
 
 	file.write(reinterpret_cast<char*>(&num_commands), sizeof(unsigned int));
 	file.write(reinterpret_cast<char*>(commands.data()), sizeof(unsigned int)*num_commands);
+
+	// the GPU event itself is saved with the scheduler
+	file.write(reinterpret_cast<char*>(&field_start_cycle), sizeof(unsigned long long));
+	file.write(reinterpret_cast<char*>(&num_scanlines_before_field), sizeof(unsigned long long));
+	file.write(reinterpret_cast<char*>(&num_fields), sizeof(unsigned long long));
+	file.write(reinterpret_cast<char*>(&in_vblank), sizeof(bool));
+	file.write(reinterpret_cast<char*>(&field_is_pal), sizeof(bool));
 }
 
 void Gpu::load_state(std::stringstream& file, bool ignore_vram)
@@ -167,6 +307,7 @@ void Gpu::load_state(std::stringstream& file, bool ignore_vram)
 	if (ignore_vram == false)
 	{
 		file.read(reinterpret_cast<char*>(video_ram), sizeof(unsigned short)*VRAM_SIZE);
+		dirty_tiles.set_all();
 	}
 
 	unsigned int num_commands = 0;
@@ -182,9 +323,15 @@ void Gpu::load_state(std::stringstream& file, bool ignore_vram)
 	{
 		gp0_fifo->push(iter);
 	}
+
+	file.read(reinterpret_cast<char*>(&field_start_cycle), sizeof(unsigned long long));
+	file.read(reinterpret_cast<char*>(&num_scanlines_before_field), sizeof(unsigned long long));
+	file.read(reinterpret_cast<char*>(&num_fields), sizeof(unsigned long long));
+	file.read(reinterpret_cast<char*>(&in_vblank), sizeof(bool));
+	file.read(reinterpret_cast<char*>(&field_is_pal), sizeof(bool));
 }
 
-void Gpu::sync_mode_request(DMA_base_address& base_address, DMA_block_control& block_control, DMA_channel_control& channel_control)
+unsigned int Gpu::sync_mode_request(DMA_base_address& base_address, DMA_block_control& block_control, DMA_channel_control& channel_control)
 {
 	if (channel_control.transfer_direction == 0)
 	{
@@ -192,23 +339,27 @@ void Gpu::sync_mode_request(DMA_base_address& base_address, DMA_block_control& b
 		//throw std::logic_error("have not implemented gpu to ram transfer");
 	}
 
-	unsigned int num_words = block_control.BS * block_control.BC;
+	unsigned int num_words = block_control.BS * block_control.BA;
+	unsigned int num_words_moved = num_words;
 	DMA_address_step step = static_cast<DMA_address_step>(channel_control.memory_address_step);
 	unsigned int addr = base_address.memory_address & 0x1ffffc;
+	Ram * ram = Ram::get_instance();
 
 	while (num_words > 0)
 	{
 		num_words--;
 
-		unsigned int word = Bus::get_instance()->get_word(addr);
+		unsigned int word = ram->get_dma_word(addr);
 
 		// todo implement
 
 		addr += (step == DMA_address_step::increment ? 4 : -4);
 	}
+
+	return num_words_moved;
 }
 
-void Gpu::sync_mode_linked_list(DMA_base_address& base_address, DMA_block_control& block_control, DMA_channel_control& channel_control)
+unsigned int Gpu::sync_mode_linked_list(DMA_base_address& base_address, DMA_block_control& block_control, DMA_channel_control& channel_control)
 {
 	if (channel_control.transfer_direction == 0)
 	{
@@ -216,17 +367,21 @@ void Gpu::sync_mode_linked_list(DMA_base_address& base_address, DMA_block_contro
 		//throw std::logic_error("have not implemented gpu to ram transfer");
 	}
 
+	// the headers count too
+	unsigned int num_words_moved = 0;
 	unsigned int addr = base_address.memory_address & 0x1ffffc;
+	Ram * ram = Ram::get_instance();
 	while (true)
 	{
-		unsigned int header = Bus::get_instance()->get_word(addr);
+		unsigned int header = ram->get_dma_word(addr);
 		unsigned int num_words = header >> 24;
+		num_words_moved += num_words + 1;
 
 		while (num_words > 0)
 		{
 			addr = (addr + 4) & 0x1ffffc;
 
-			unsigned int command = Bus::get_instance()->get_word(addr);
+			unsigned int command = ram->get_dma_word(addr);
 			add_gp0_command(command, true);
 
 			num_words--;
@@ -241,6 +396,8 @@ void Gpu::sync_mode_linked_list(DMA_base_address& base_address, DMA_block_contro
 			addr = header & 0x1ffffc;
 		}
 	}
+
+	return num_words_moved;
 }
 
 void Gpu::execute_gp0_commands()
@@ -329,7 +486,12 @@ void Gpu::execute_gp0_commands()
 		} break;
 
 		default:
-			throw std::logic_error("not implemented");
+		{
+			// drop it, otherwise it sits at the front of the fifo and every later command fails behind it
+			gp0_fifo->pop();
+			Cpu::get_instance()->raise_pending_exception("gp0 command not implemented");
+			command_executed = true;
+		} break;
 		}
 
 		if (false == command_executed)
@@ -402,13 +564,16 @@ void Gpu::execute_gp1_command(gp_command command)
 		case gp1_commands::DISPLAY_MODE:
 		{
 			// Some of these values if set cause the psx to get stuck in an infinite loop at startup
-			//gpu_status.h_res_1 = command.display_mode.horizontal_res;
-			//gpu_status.v_res = command.display_mode.vertical_res;
+			// the video mode and interlacing take effect from the next field, the resolution sets the timers' dot clock
+			Timers::get_instance()->on_dot_clock_changing();
+			gpu_status.h_res_1 = command.display_mode.horizontal_res;
+			gpu_status.v_res = command.display_mode.vertical_res;
 			gpu_status.video_mode = command.display_mode.video_mode;
 			//gpu_status.display_depth = command.display_mode.display_color_depth;
-			//gpu_status.v_interlace = command.display_mode.vertical_interlace;
-			//gpu_status.h_res_2 = command.display_mode.horizontal_res_2;
+			gpu_status.v_interlace = command.display_mode.vertical_interlace;
+			gpu_status.h_res_2 = command.display_mode.horizontal_res_2;
 			//gpu_status.reverse = command.display_mode.reverse_flag;
+			Timers::get_instance()->on_dot_clock_changed();
 		} break;
 
 		case gp1_commands::GET_GPU_INFO:
@@ -417,83 +582,187 @@ void Gpu::execute_gp1_command(gp_command command)
 		} break;
 
 		default:
-			throw std::logic_error("not implemented");
+			Cpu::get_instance()->raise_pending_exception("gp1 command not implemented");
 	}
 }
 
-// http://www.sunshine2k.de/coding/java/TriangleRasterization/TriangleRasterization.html
-// https://codeplea.com/triangular-interpolation
+// the first x which satisfies a * x >= k for a > 0, and the last one for a < 0
+static int first_x_on_edge(long long a, long long k)
+{
+	long long quotient = k / a;
+	return static_cast<int>((quotient * a < k) ? quotient + 1 : quotient);
+}
+
+static int last_x_on_edge(long long a, long long k)
+{
+	long long quotient = k / a;
+	return static_cast<int>((quotient * a < k) ? quotient - 1 : quotient);
+}
+
+// https://fgiesen.wordpress.com/2013/02/08/triangle-rasterization-in-practice/
+// each edge function is 0 along its edge and positive on the triangle's side of it, the pixels in a row which
+// are inside all three make one span. A pixel exactly on an edge is only drawn for top and left edges, so
+// triangles which share an edge don't both draw it. Colours are planes over the triangle in 16.16 fixed point
 void Gpu::draw_triangle(glm::ivec2 v0, glm::ivec2 v1, glm::ivec2 v2, glm::u8vec3 rgb0, glm::u8vec3 rgb1, glm::u8vec3 rgb2)
 {
-	glm::vec2 e0 = v1 - v0;
-	glm::vec2 e1 = v2 - v0;
+	glm::ivec2 offset(x_offset, y_offset);
+	v0 = v0 + offset;
+	v1 = v1 + offset;
+	v2 = v2 + offset;
+
+	// the edges are worked out for clockwise triangles
+	long long area = static_cast<long long>(v1.x - v0.x) * (v2.y - v0.y) - static_cast<long long>(v1.y - v0.y) * (v2.x - v0.x);
+	if (area < 0)
+	{
+		std::swap(v1, v2);
+		std::swap(rgb1, rgb2);
+		area = -area;
+	}
+	else if (area == 0)
+	{
+		return;
+	}
 
-	// does component wise min/max operations
+	// the gpu skips anything too big rather than drawing part of it
 	glm::ivec2 min_val = glm::min(v0, glm::min(v1, v2));
 	glm::ivec2 max_val = glm::max(v0, glm::max(v1, v2));
+	if (max_val.x - min_val.x >= MAX_PRIMITIVE_WIDTH || max_val.y - min_val.y >= MAX_PRIMITIVE_HEIGHT)
+	{
+		return;
+	}
+
+	int clip_min_x = std::max({ min_val.x, static_cast<int>(draw_area_min_x), 0 });
+	int clip_max_x = std::min({ max_val.x, static_cast<int>(draw_area_max_x), static_cast<int>(width) - 1 });
+	int clip_min_y = std::max({ min_val.y, static_cast<int>(draw_area_min_y), 0 });
+	int clip_max_y = std::min({ max_val.y, static_cast<int>(draw_area_max_y), static_cast<int>(height) - 1 });
+	if (clip_min_x > clip_max_x || clip_min_y > clip_max_y)
+	{
+		return;
+	}
 
-	for (int y = min_val.y; y <= max_val.y; y++)
+	// edge from p to q, a pixel is inside it if a * x + b * y + c >= 0
+	struct raster_edge
 	{
-		for (int x = min_val.x; x <= max_val.x; x++)
+		long long a;
+		long long b;
+		long long c;
+	};
+
+	auto make_edge = [](glm::ivec2 p, glm::ivec2 q) {
+		raster_edge edge;
+		edge.a = p.y - q.y;
+		edge.b = q.x - p.x;
+		edge.c = -(edge.a * p.x) - (edge.b * p.y);
+
+		// top and left edges keep the pixels on them
+		bool is_top_left = (q.y < p.y) || (q.y == p.y && q.x > p.x);
+		if (is_top_left == false)
 		{
-			glm::ivec2 cur_pos = glm::ivec2(x, y);
-			glm::vec3 w = calc_barycentric(cur_pos, v0, v1, v2);
+			edge.c -= 1;
+		}
+		return edge;
+	};
 
-			if (w[0] >= 0 && w[1] >= 0 && (w[0] + w[1] <= 1))
-			{
-				glm::u8vec3 rgb;
-				rgb.r = rgb0.r*w[0] + rgb1.r*w[1] + rgb2.r*w[2];
-				rgb.g = rgb0.g*w[0] + rgb1.g*w[1] + rgb2.g*w[2];
-				rgb.b = rgb0.b*w[0] + rgb1.b*w[1] + rgb2.b*w[2];
+	const raster_edge edges[3] = { make_edge(v1, v2), make_edge(v2, v0), make_edge(v0, v1) };
 
-				draw_pixel(cur_pos, rgb);
-			}
-		}
+	// the colour planes, with half a step added so the values round rather than truncate
+	bool is_flat = (rgb0 == rgb1) && (rgb0 == rgb2);
+	long long colour_dx[3] = { 0 };
+	long long colour_dy[3] = { 0 };
+	for (unsigned int channel = 0; channel < 3 && is_flat == false; channel++)
+	{
+		long long d1 = static_cast<long long>(rgb1[channel]) - rgb0[channel];
+		long long d2 = static_cast<long long>(rgb2[channel]) - rgb0[channel];
+		colour_dx[channel] = (d1 * (v2.y - v0.y) - d2 * (v1.y - v0.y)) * 65536 / area;
+		colour_dy[channel] = (d2 * (v1.x - v0.x) - d1 * (v2.x - v0.x)) * 65536 / area;
 	}
-}
 
-void Gpu::draw_rectangle(glm::ivec2 top_left, glm::ivec2 width_height, glm::u8vec3 rgb)
-{
-	for (int y = top_left.y; y <= (top_left.y + width_height.y); y++)
+	SpanKernels * span_kernels = SpanKernels::get_instance();
+	unsigned short flat_colour = SpanKernels::to_vram_colour(rgb0.r, rgb0.g, rgb0.b);
+	for (int y = clip_min_y; y <= clip_max_y; y++)
 	{
-		for (int x = top_left.x; x <= (top_left.x + width_height.x); x++)
+		int span_min_x = clip_min_x;
+		int span_max_x = clip_max_x;
+		for (const raster_edge& edge : edges)
 		{
-			glm::ivec2 cur_pos = glm::ivec2(x, y);
-			// fill rect ignores the pixel draw area
-			draw_pixel(cur_pos, rgb, true);
+			long long k = -(edge.b * y) - edge.c;
+			if (edge.a > 0)
+			{
+				span_min_x = std::max(span_min_x, first_x_on_edge(edge.a, k));
+			}
+			else if (edge.a < 0)
+			{
+				span_max_x = std::min(span_max_x, last_x_on_edge(edge.a, k));
+			}
+			else if (k > 0)
+			{
+				span_max_x = span_min_x - 1;
+			}
 		}
-	}
-}
 
-void Gpu::draw_pixel(glm::ivec2 v, glm::u8vec3 rgb, bool ignore_draw_offset)
-{
-	int x = static_cast<int>(v.x) + x_offset;
-	int y = static_cast<int>(v.y) + y_offset;
-
-	if (ignore_draw_offset == false)
-	{
-		if (x < static_cast<int>(draw_area_min_x) || x > static_cast<int>(draw_area_max_x))
+		if (span_min_x > span_max_x)
 		{
-			return;
+			continue;
 		}
 
-		if (y < static_cast<int>(draw_area_min_y) || y > static_cast<int>(draw_area_max_y))
+		unsigned short * span = &video_ram[y * FRAME_WIDTH + span_min_x];
+		unsigned int num_pixels = span_max_x - span_min_x + 1;
+		if (is_flat)
 		{
-			return;
+			span_kernels->fill(span, num_pixels, flat_colour);
 		}
+		else
+		{
+			SpanKernels::gouraud_span gouraud;
+			for (unsigned int channel = 0; channel < 3; channel++)
+			{
+				gouraud.colour[channel] = static_cast<int>(static_cast<long long>(rgb0[channel]) * 65536 + 0x8000 +
+					colour_dx[channel] * (span_min_x - v0.x) + colour_dy[channel] * (y - v0.y));
+				gouraud.colour_step[channel] = static_cast<int>(colour_dx[channel]);
+			}
+			span_kernels->shade(span, num_pixels, gouraud);
+		}
+
+		mark_dirty_span(span_min_x, span_max_x, y);
+	}
+}
+
+void Gpu::draw_rectangle(glm::ivec2 top_left, glm::ivec2 width_height, glm::u8vec3 rgb)
+{
+	// fill rect ignores the pixel draw area, it's still moved by the drawing offset
+	int min_x = std::max(top_left.x + x_offset, 0);
+	int max_x = std::min(top_left.x + width_height.x + x_offset, static_cast<int>(width) - 1);
+	int min_y = std::max(top_left.y + y_offset, 0);
+	int max_y = std::min(top_left.y + width_height.y + y_offset, static_cast<int>(height) - 1);
+	if (min_x > max_x)
+	{
+		return;
 	}
 
-	if (x >= 0 && x < width)
+	SpanKernels * span_kernels = SpanKernels::get_instance();
+	unsigned short colour = SpanKernels::to_vram_colour(rgb.r, rgb.g, rgb.b);
+	for (int y = min_y; y <= max_y; y++)
 	{
-		if (y >= 0 && y < height)
-		{
-			unsigned int index = ((y*FRAME_WIDTH) + x);
-			unsigned short colour_16 = (rgb.r >> 3) | ((rgb.g >> 2) << 5) | ((rgb.b >> 3) << 11);
-			video_ram[index] = colour_16;
-		}
+		span_kernels->fill(&video_ram[y * FRAME_WIDTH + min_x], max_x - min_x + 1, colour);
+		mark_dirty_span(min_x, max_x, y);
 	}
 }
 
+bool Gpu::is_tile_dirty(unsigned int tile_index)
+{
+	return dirty_tiles.is_set(tile_index);
+}
+
+void Gpu::get_dirty_tiles(std::vector<unsigned int>& tile_indices)
+{
+	dirty_tiles.get_set(tile_indices);
+}
+
+void Gpu::clear_dirty_tiles()
+{
+	dirty_tiles.clear_all();
+}
+
 void Gpu::copy_next_pixel_to_framebuffer(unsigned int short pixel_data)
 {
 	unsigned int x = copy_to_gpu_current_coord.dest_coord.x_pos;
@@ -503,6 +772,7 @@ void Gpu::copy_next_pixel_to_framebuffer(unsigned int short pixel_data)
 	{
 		unsigned int index = ((y*FRAME_WIDTH) + x);
 		video_ram[index] = pixel_data;
+		mark_dirty(x, y);
 	}
 
 	x++;
@@ -541,24 +811,6 @@ unsigned short Gpu::copy_next_pixel_from_framebuffer()
 	return result;
 }
 
-// https://codeplea.com/triangular-interpolation
-glm::vec3 Gpu::calc_barycentric(glm::ivec2 pos, glm::ivec2 v0, glm::ivec2 v1, glm::ivec2 v2)
-{
-	glm::vec3 w;
-
-	float d = (v1.y - v2.y)*(v0.x - v2.x) + (v2.x - v1.x)*(v0.y - v2.y);
-
-	w[0] = (v1.y - v2.y)*(pos.x - v2.x) + (v2.x - v1.x)*(pos.y - v2.y);
-	w[0] /= d;
-
-	w[1] = (v2.y - v0.y)*(pos.x - v2.x) + (v0.x - v2.x)*(pos.y - v2.y);
-	w[1] /= d;
-
-	w[2] = 1 - w[0] - w[1];
-
-	return w;
-}
-
 bool Gpu::mono_4_pt_opaque()
 {
 	if (gp0_fifo->get_current_size() < 5)
@@ -4,6 +4,7 @@
 #include <unordered_map>
 #include <glm/fwd.hpp>
 #include "Fifo.hpp"
+#include "DirtyBitmap.hpp"
 #include "InstructionTypes.hpp"
 #include "Dma.hpp"
 #include "Bus.hpp"
@@ -18,20 +19,21 @@ public:
 	static const unsigned int FRAME_HEIGHT = 512;
 
 	virtual bool is_address_for_device(unsigned int address) final;
+	virtual const char * get_device_name() final { return "Gpu"; }
 
 	// AFAIK the GPU is only accessed with full word accesses
 	virtual unsigned int get_word(unsigned int address) final;
 	virtual void set_word(unsigned int address, unsigned int value) final;
+	virtual void register_io_handlers(Bus * bus) final;
 
 	~Gpu();
 	void init();
 	void reset();
-	void tick();
 	void save_state(std::stringstream& file, bool ignore_vram = false);
 	void load_state(std::stringstream& file, bool ignore_vram = false);
 
-	virtual void sync_mode_request(DMA_base_address& base_address, DMA_block_control& block_control, DMA_channel_control& channel_control) override;
-	virtual void sync_mode_linked_list(DMA_base_address& base_address, DMA_block_control& block_control, DMA_channel_control& channel_control) override;
+	virtual unsigned int sync_mode_request(DMA_base_address& base_address, DMA_block_control& block_control, DMA_channel_control& channel_control) override;
+	virtual unsigned int sync_mode_linked_list(DMA_base_address& base_address, DMA_block_control& block_control, DMA_channel_control& channel_control) override;
 
 	union gpu_status_union
 	{
@@ -87,12 +89,84 @@ public:
 	unsigned int draw_area_max_x = 0;
 	unsigned int draw_area_max_y = 0;
 
+	// the status register with the bits which depend on where the beam is brought up to date
+	unsigned int get_status();
+
+	// video timing, the cpu clock is what the scheduler counts in
+	static const unsigned int CPU_CLOCK = 33868800;
+	// a field is one pass of the beam down the screen, interlaced modes draw a frame over two of them
+	unsigned long long num_fields = 0;
+	bool is_in_vblank() const { return in_vblank; }
+	unsigned int get_scanline() const;
+	// scanlines since reset, which is what a timer counting hblanks sees
+	unsigned long long get_num_scanlines() const { return num_scanlines_before_field + get_scanline(); }
+	// the cycle the count of scanlines since reset reaches num_scanlines, later fields are assumed to keep the current timing
+	unsigned long long get_num_scanlines_cycle(unsigned long long num_scanlines) const;
+	// the dot clock is the gpu clock (cpu clock * 11 / 7) divided by this, it depends on the horizontal resolution
+	unsigned int get_dot_clock_divider() const;
+	// the cycle the vblank after the current one starts on, it moves if the video mode changes before then
+	unsigned long long get_next_vblank_cycle() const;
+	// fields per second in the current video mode, just under 60 for NTSC and 50 for PAL
+	double get_field_rate() const;
+
+	// vram is tracked in 64x64 pixel tiles, a tile is dirty if it has been written since the dirty tiles were last cleared
+	static const unsigned int VRAM_TILE_SHIFT = 6;
+	static const unsigned int NUM_VRAM_TILES_X = FRAME_WIDTH >> VRAM_TILE_SHIFT;
+	static const unsigned int NUM_VRAM_TILES_Y = FRAME_HEIGHT >> VRAM_TILE_SHIFT;
+	// tiles are indexed by tile_y * NUM_VRAM_TILES_X + tile_x
+	bool is_tile_dirty(unsigned int tile_index);
+	void get_dirty_tiles(std::vector<unsigned int>& tile_indices);
+	void clear_dirty_tiles();
+
 	static Gpu * get_instance();
 
 private:
 	static const unsigned int VRAM_SIZE = FRAME_WIDTH * FRAME_HEIGHT;
 	static const unsigned int GP0_FIFO_SIZE = 16;
 
+	void mark_dirty(unsigned int x, unsigned int y)
+	{
+		dirty_tiles.set(((y >> VRAM_TILE_SHIFT) * NUM_VRAM_TILES_X) + (x >> VRAM_TILE_SHIFT));
+	}
+
+	// from min_x to max_x inclusive on row y
+	void mark_dirty_span(unsigned int min_x, unsigned int max_x, unsigned int y)
+	{
+		unsigned int row_tile_index = (y >> VRAM_TILE_SHIFT) * NUM_VRAM_TILES_X;
+		for (unsigned int tile_x = min_x >> VRAM_TILE_SHIFT; tile_x <= (max_x >> VRAM_TILE_SHIFT); tile_x++)
+		{
+			dirty_tiles.set(row_tile_index + tile_x);
+		}
+	}
+
+	// polygons any bigger than this aren't drawn at all
+	static const int MAX_PRIMITIVE_WIDTH = 1024;
+	static const int MAX_PRIMITIVE_HEIGHT = 512;
+
+	struct video_timing
+	{
+		unsigned int video_clock;
+		unsigned int dots_per_scanline;
+		unsigned int scanlines_per_field;
+		unsigned int vblank_start_scanline;
+	};
+
+	static const video_timing NTSC_TIMING;
+	static const video_timing PAL_TIMING;
+
+	// the video mode is picked up at the start of each field
+	const video_timing& get_video_timing() const { return field_is_pal ? PAL_TIMING : NTSC_TIMING; }
+	unsigned long long get_scanline_cycle(unsigned int scanline) const;
+	void start_field();
+	void start_vblank();
+
+	unsigned long long field_start_cycle = 0;
+	unsigned long long num_scanlines_before_field = 0;
+	bool field_is_pal = false;
+	bool in_vblank = false;
+
+	DirtyBitmap dirty_tiles = DirtyBitmap(NUM_VRAM_TILES_X * NUM_VRAM_TILES_Y);
+
 	static const unsigned int GPU_SIZE = 8;
 	static const unsigned int GPU_START = 0x1F801810;
 	static const unsigned int GPU_END = GPU_START + GPU_SIZE;
@@ -117,13 +191,10 @@ private:
 
 	void draw_triangle(glm::ivec2 v0, glm::ivec2 v1, glm::ivec2 v2, glm::u8vec3 rgb0, glm::u8vec3 rgb1, glm::u8vec3 rgb2);
 	void draw_rectangle(glm::ivec2 top_left, glm::ivec2 width_height, glm::u8vec3 rgb);
-	void draw_pixel(glm::ivec2 v, glm::u8vec3 rgb, bool ignore_draw_offsets = false);
 
 	void copy_next_pixel_to_framebuffer(unsigned int short pixel_data);
 	unsigned short copy_next_pixel_from_framebuffer();
 
-	glm::vec3 calc_barycentric(glm::ivec2 pos, glm::ivec2 v0, glm::ivec2 v1, glm::ivec2 v2);
-
 	// GP0 commands
 	bool set_draw_top_left();
 	bool set_draw_bottom_right();
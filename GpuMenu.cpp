@@ -23,9 +23,15 @@ void GpuMenu::draw_menu()
 
 	{
 		std::stringstream status_text;
-		status_text << "Status Register: 0x" << std::hex << std::setfill('0') << std::setw(8) << gpu->gpu_status.int_value;
+		status_text << "Status Register: 0x" << std::hex << std::setfill('0') << std::setw(8) << gpu->get_status();
 		ImGui::Text(status_text.str().c_str());
 
+		{
+			std::stringstream text;
+			text << "Scanline: " << gpu->get_scanline() << (gpu->is_in_vblank() ? " (Vblank)" : "") << " Fields: " << gpu->num_fields;
+			ImGui::Text(text.str().c_str());
+		}
+
 		{
 			std::stringstream text;
 			text << "Drawing offsets: " << gpu->x_offset << " " << gpu->y_offset;
@@ -0,0 +1,302 @@
+#include "IdleLoopDetector.hpp"
+#include "Cpu.hpp"
+#include "Bus.hpp"
+#include "Ram.hpp"
+#include "InstructionTypes.hpp"
+#include "InstructionEnums.hpp"
+
+static IdleLoopDetector * instance = nullptr;
+
+IdleLoopDetector * IdleLoopDetector::get_instance()
+{
+	if (instance == nullptr)
+	{
+		instance = new IdleLoopDetector();
+	}
+
+	return instance;
+}
+
+void IdleLoopDetector::reset()
+{
+	last_pc = 0;
+	loop_start = INVALID_PC;
+	loop_rejected = false;
+}
+
+bool IdleLoopDetector::is_idle(Cpu * cpu)
+{
+	// the pc only goes backwards (or stays put when a tick runs a whole loop) after a branch back to the start of a loop
+	unsigned int pc = cpu->current_pc;
+	bool branched_back = pc <= last_pc && last_pc - pc <= (MAX_LOOP_INSTRUCTIONS + 1) * 4;
+	last_pc = pc;
+	if (branched_back == false)
+	{
+		return false;
+	}
+
+	if (pc != loop_start)
+	{
+		loop_start = pc;
+		loop_registers = cpu->register_file;
+		loop_rejected = false;
+		return false;
+	}
+
+	if (loop_rejected || (cpu->register_file == loop_registers) == false)
+	{
+		loop_registers = cpu->register_file;
+		return false;
+	}
+
+	// with the cache isolated loads don't go where they look like they go
+	if (Ram::get_instance()->is_cache_isolated())
+	{
+		return false;
+	}
+
+	// same place with the same registers as last time, if nothing in the loop can change anything
+	// it is going to keep doing this until a device does
+	if (is_loop_body_idle(cpu))
+	{
+		return true;
+	}
+
+	// no point looking at it again every time round
+	loop_rejected = true;
+	return false;
+}
+
+bool IdleLoopDetector::is_loop_body_idle(Cpu * cpu)
+{
+	// the code has to be somewhere reading it doesn't do anything
+	if (is_polled_address(loop_start) == false || is_polled_address(loop_start + MAX_LOOP_INSTRUCTIONS * 4) == false)
+	{
+		return false;
+	}
+
+	Bus * bus = Bus::get_instance();
+	instruction_union body[MAX_LOOP_INSTRUCTIONS];
+	unsigned int num_instructions = 0;
+	bool inner_branches = false;
+	bool written[32] = { false };
+
+	// find the branch back to the start, everything up to it (and its delay slot) has to be free of side effects
+	bool found_end = false;
+	bool after_branch = false;
+	bool after_branch_back = false;
+	for (unsigned int idx = 0; idx < MAX_LOOP_INSTRUCTIONS; idx++)
+	{
+		unsigned int address = loop_start + idx * 4;
+		instruction_union instr(bus->get_word(address));
+		body[num_instructions++] = instr;
+
+		bool is_branch = false;
+		unsigned int target = 0;
+		unsigned int written_register = 0;
+		unsigned int branch_target = address + 4 + (static_cast<int>(static_cast<short>(instr.immediate_instruction.immediate)) << 2);
+
+		switch (static_cast<cpu_instructions>(instr.immediate_instruction.op))
+		{
+			case cpu_instructions::SPECIAL:
+			{
+				switch (static_cast<cpu_special_funcs>(instr.register_instruction.funct))
+				{
+					case cpu_special_funcs::SLL:
+					case cpu_special_funcs::SRL:
+					case cpu_special_funcs::SRA:
+					case cpu_special_funcs::SLLV:
+					case cpu_special_funcs::SRLV:
+					case cpu_special_funcs::SRAV:
+					case cpu_special_funcs::MFHI:
+					case cpu_special_funcs::MFLO:
+					case cpu_special_funcs::ADDU:
+					case cpu_special_funcs::SUBU:
+					case cpu_special_funcs::AND:
+					case cpu_special_funcs::OR:
+					case cpu_special_funcs::XOR:
+					case cpu_special_funcs::NOR:
+					case cpu_special_funcs::SLT:
+					case cpu_special_funcs::SLTU:
+						written_register = instr.register_instruction.rd;
+						break;
+
+					// jumps through registers, exceptions and anything touching hi and lo
+					default:
+						return false;
+				}
+			} break;
+
+			case cpu_instructions::BCOND:
+			{
+				// the linking versions write ra
+				cpu_bconds bcond = static_cast<cpu_bconds>(instr.immediate_instruction.rt);
+				if (bcond != cpu_bconds::BLTZ && bcond != cpu_bconds::BGEZ)
+				{
+					return false;
+				}
+				is_branch = true;
+				target = branch_target;
+			} break;
+
+			case cpu_instructions::BEQ:
+			case cpu_instructions::BNE:
+			case cpu_instructions::BLEZ:
+			case cpu_instructions::BGTZ:
+				is_branch = true;
+				target = branch_target;
+				break;
+
+			case cpu_instructions::J:
+				is_branch = true;
+				target = ((address + 4) & 0xF0000000) | (instr.jump_instruction.target << 2);
+				break;
+
+			case cpu_instructions::ADDIU:
+			case cpu_instructions::SLTI:
+			case cpu_instructions::SLTIU:
+			case cpu_instructions::ANDI:
+			case cpu_instructions::ORI:
+			case cpu_instructions::XORI:
+			case cpu_instructions::LUI:
+			case cpu_instructions::LB:
+			case cpu_instructions::LH:
+			case cpu_instructions::LW:
+			case cpu_instructions::LBU:
+			case cpu_instructions::LHU:
+				written_register = instr.immediate_instruction.rt;
+				break;
+
+			default:
+				return false;
+		}
+
+		written[written_register] = true;
+
+		if (is_branch)
+		{
+			// a branch in a delay slot isn't worth working out, leaving the loop forwards is fine,
+			// that is how it finishes
+			if (after_branch || target < loop_start)
+			{
+				return false;
+			}
+			inner_branches |= target != loop_start;
+		}
+
+		// the delay slot of the branch back is the end of the loop
+		if (after_branch_back)
+		{
+			found_end = true;
+			break;
+		}
+		after_branch = is_branch;
+		after_branch_back = is_branch && target == loop_start;
+	}
+
+	if (found_end == false)
+	{
+		return false;
+	}
+
+	// every load has to read from somewhere reading doesn't change, which needs the address it loads from.
+	// registers the loop doesn't write still have the values they have now, constants built in the loop are
+	// worked out as long as there are no branches inside the loop which could skip them
+	bool known[32];
+	unsigned int values[32];
+	for (unsigned int idx = 0; idx < 32; idx++)
+	{
+		known[idx] = idx == 0 || written[idx] == false;
+		values[idx] = cpu->register_file.get_register(idx);
+	}
+
+	for (unsigned int idx = 0; idx < num_instructions; idx++)
+	{
+		const instruction_union& instr = body[idx];
+		unsigned int rs = instr.immediate_instruction.rs;
+		unsigned int rt = instr.immediate_instruction.rt;
+		unsigned int immediate = instr.immediate_instruction.immediate;
+		unsigned int sign_extended = static_cast<unsigned int>(static_cast<int>(static_cast<short>(immediate)));
+
+		bool result_known = false;
+		unsigned int result = 0;
+		switch (static_cast<cpu_instructions>(instr.immediate_instruction.op))
+		{
+			case cpu_instructions::LUI:
+				result_known = true;
+				result = immediate << 16;
+				break;
+
+			case cpu_instructions::ADDIU:
+				result_known = known[rs];
+				result = values[rs] + sign_extended;
+				break;
+
+			case cpu_instructions::ORI:
+				result_known = known[rs];
+				result = values[rs] | immediate;
+				break;
+
+			case cpu_instructions::LB:
+			case cpu_instructions::LH:
+			case cpu_instructions::LW:
+			case cpu_instructions::LBU:
+			case cpu_instructions::LHU:
+			{
+				if (known[rs] == false || is_polled_address(values[rs] + sign_extended) == false)
+				{
+					return false;
+				}
+			} break;
+
+			case cpu_instructions::SPECIAL:
+				rt = instr.register_instruction.rd;
+				break;
+
+			// branches don't write anything
+			case cpu_instructions::BCOND:
+			case cpu_instructions::BEQ:
+			case cpu_instructions::BNE:
+			case cpu_instructions::BLEZ:
+			case cpu_instructions::BGTZ:
+			case cpu_instructions::J:
+				continue;
+
+			// nothing else is needed to work out addresses
+			default:
+				break;
+		}
+
+		if (rt != 0)
+		{
+			known[rt] = result_known && inner_branches == false;
+			values[rt] = result;
+		}
+	}
+
+	return true;
+}
+
+bool IdleLoopDetector::is_polled_address(unsigned int address)
+{
+	unsigned int physical_address = address & 0x1FFFFFFF;
+
+	// main memory, the scratchpad and the bios
+	if (physical_address < 0x200000 ||
+		(physical_address >= 0x1F800000 && physical_address < 0x1F800400) ||
+		(physical_address >= 0x1FC00000 && physical_address < 0x1FC80000))
+	{
+		return true;
+	}
+
+	// I_STAT and I_MASK, the dma registers and the cdrom status register. GPUSTAT isn't one, its even/odd
+	// bit changes every scanline without an event
+	if ((physical_address >= 0x1F801070 && physical_address < 0x1F801078) ||
+		(physical_address >= 0x1F801080 && physical_address < 0x1F801100) ||
+		physical_address == 0x1F801800)
+	{
+		return true;
+	}
+
+	return false;
+}
\ No newline at end of file
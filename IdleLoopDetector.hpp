@@ -0,0 +1,42 @@
+#pragma once
+#include "RegisterFile.hpp"
+
+class Cpu;
+
+// Spots the cpu spinning in a short loop which polls memory or a status register until a device raises an
+// interrupt, e.g. the bios waiting on I_STAT or a game waiting for a cdrom response.
+// A loop counts as idle when it has just branched back to its start with exactly the registers it had the last
+// time it did, and its body only reads memory and registers which don't change when they are read. Every
+// iteration after that does exactly the same thing until a device changes something, so Psx can skip ahead to
+// the next device event instead of running them.
+class IdleLoopDetector
+{
+public:
+	static IdleLoopDetector * get_instance();
+
+	// called after each cpu tick, returns true if the cpu is sitting in an idle loop
+	bool is_idle(Cpu * cpu);
+
+	void reset();
+
+	// longest loop which is checked, in instructions
+	static const unsigned int MAX_LOOP_INSTRUCTIONS = 16;
+
+private:
+	IdleLoopDetector() = default;
+	~IdleLoopDetector() = default;
+
+	bool is_loop_body_idle(Cpu * cpu);
+	bool is_polled_address(unsigned int address);
+
+	static const unsigned int INVALID_PC = 0xFFFFFFFF;
+
+	// where the cpu was after the last tick
+	unsigned int last_pc = 0;
+
+	// the loop seen last and the registers it had when it branched back
+	unsigned int loop_start = INVALID_PC;
+	RegisterFile loop_registers;
+	// the loop does something other than poll, it isn't looked at again until the cpu goes somewhere else
+	bool loop_rejected = false;
+};
\ No newline at end of file
@@ -0,0 +1,93 @@
+#include "InstructionTable.hpp"
+
+#include <cstdio>
+
+unsigned int disassemble_instruction(unsigned int raw, char * buffer, unsigned int buffer_size)
+{
+	if (buffer_size == 0)
+	{
+		return 0;
+	}
+
+	if (raw == 0x0)
+	{
+		int length = snprintf(buffer, buffer_size, "NOP");
+		return length < static_cast<int>(buffer_size) ? length : buffer_size - 1;
+	}
+
+	const instruction_description& description = get_instruction_description(raw);
+	const char * mnemonic = description.mnemonic;
+
+	unsigned int rs = (raw >> 21) & 0x1F;
+	unsigned int rt = (raw >> 16) & 0x1F;
+	unsigned int rd = (raw >> 11) & 0x1F;
+	unsigned int shamt = (raw >> 6) & 0x1F;
+	unsigned int immediate = raw & 0xFFFF;
+	unsigned int sign_extended = static_cast<unsigned int>(static_cast<int>(static_cast<short>(immediate)));
+
+	int length = 0;
+	switch (description.format)
+	{
+		case operand_format::NONE:
+			length = snprintf(buffer, buffer_size, "%s", mnemonic);
+			break;
+		case operand_format::RD_RS_RT:
+			length = snprintf(buffer, buffer_size, "%s rd[%u], rs[%u], rt[%u]", mnemonic, rd, rs, rt);
+			break;
+		case operand_format::RD_RT_SHAMT:
+			length = snprintf(buffer, buffer_size, "%s rd[%u], rt[%u], %u", mnemonic, rd, rt, shamt);
+			break;
+		case operand_format::RD_RT_RS:
+			length = snprintf(buffer, buffer_size, "%s rd[%u], rt[%u], rs[%u]", mnemonic, rd, rt, rs);
+			break;
+		case operand_format::RS_RT:
+			length = snprintf(buffer, buffer_size, "%s rs[%u], rt[%u]", mnemonic, rs, rt);
+			break;
+		case operand_format::RD:
+			length = snprintf(buffer, buffer_size, "%s rd[%u]", mnemonic, rd);
+			break;
+		case operand_format::RS:
+			length = snprintf(buffer, buffer_size, "%s rs[%u]", mnemonic, rs);
+			break;
+		case operand_format::RS_TARGET:
+			length = snprintf(buffer, buffer_size, "%s @rs[%u]", mnemonic, rs);
+			break;
+		case operand_format::RS_TARGET_RD:
+			length = snprintf(buffer, buffer_size, "%s @rs[%u], rd[%u]", mnemonic, rs, rd);
+			break;
+		case operand_format::RT_RS_SIGNED:
+			length = snprintf(buffer, buffer_size, "%s rt[%u], rs[%u], 0x%x", mnemonic, rt, rs, sign_extended);
+			break;
+		case operand_format::RT_RS_UNSIGNED:
+			length = snprintf(buffer, buffer_size, "%s rt[%u], rs[%u], 0x%x", mnemonic, rt, rs, immediate);
+			break;
+		case operand_format::RT_UPPER:
+			length = snprintf(buffer, buffer_size, "%s rt[%u], 0x%x", mnemonic, rt, immediate << 16);
+			break;
+		case operand_format::RT_OFFSET_BASE:
+			length = snprintf(buffer, buffer_size, "%s rt[%u], @rs[%u]+0x%x", mnemonic, rt, rs, sign_extended);
+			break;
+		case operand_format::RS_RT_BRANCH:
+			length = snprintf(buffer, buffer_size, "%s rs[%u], rt[%u], @+0x%x", mnemonic, rs, rt, sign_extended << 2);
+			break;
+		case operand_format::RS_BRANCH:
+			length = snprintf(buffer, buffer_size, "%s rs[%u], @+0x%x", mnemonic, rs, sign_extended << 2);
+			break;
+		case operand_format::JUMP_TARGET:
+			length = snprintf(buffer, buffer_size, "%s @0x%x", mnemonic, (raw & 0x3FFFFFF) << 2);
+			break;
+		case operand_format::RT_COP_RD:
+			length = snprintf(buffer, buffer_size, "%s rt[%u], rd[%u]", mnemonic, rt, rd);
+			break;
+		case operand_format::COP_FUNCTION:
+			length = snprintf(buffer, buffer_size, "%s 0x%x", mnemonic, raw & 0x1FFFFFF);
+			break;
+	}
+
+	if (length < 0)
+	{
+		buffer[0] = '\0';
+		return 0;
+	}
+	return length < static_cast<int>(buffer_size) ? length : buffer_size - 1;
+}
\ No newline at end of file
@@ -0,0 +1,306 @@
+#pragma once
+#include "InstructionEnums.hpp"
+
+// One description of every R3000A and GTE instruction. The decode lookup tables are generated from it at
+// compile time, and the interpreter, the disassembler and anything else that needs to know what an
+// instruction is (where its operands are, whether it branches, loads or stores) read it from here.
+
+enum class instruction_id : unsigned char
+{
+	UNKNOWN,
+
+	// primary opcodes
+	J, JAL, BEQ, BNE, BLEZ, BGTZ,
+	ADDI, ADDIU, SLTI, SLTIU, ANDI, ORI, XORI, LUI,
+	LB, LH, LWL, LW, LBU, LHU, LWR,
+	SB, SH, SWL, SW, SWR,
+	LWC0, LWC2, SWC0, SWC2,
+
+	// SPECIAL, by funct
+	SLL, SRL, SRA, SLLV, SRLV, SRAV,
+	JR, JALR, SYSCALL, BREAK,
+	MFHI, MTHI, MFLO, MTLO, MULT, MULTU, DIV, DIVU,
+	ADD, ADDU, SUB, SUBU, AND, OR, XOR, NOR, SLT, SLTU,
+
+	// BCOND, by rt
+	BLTZ, BGEZ, BLTZAL, BGEZAL,
+
+	// coprocessor 0, COP0 is anything else cop0 is asked to do
+	COP0, MFC0, MTC0, RFE,
+
+	// coprocessor 2, COP2 is anything else the GTE is asked to do
+	COP2, MFC2, CFC2, MTC2, CTC2,
+	RTPS, NCLIP, OP, DPCS, INTPL, MVMVA, NCDS, CDP, NCDT, NCCS, CC, NCS, NCT,
+	SQR, DCPL, DPCT, AVSZ3, AVSZ4, RTPT, GPF, GPL, NCCT,
+
+	NUM_INSTRUCTIONS
+};
+
+// which field of the instruction picks it out
+enum class instruction_group : unsigned char
+{
+	PRIMARY,
+	SPECIAL,
+	BCOND,
+	// rs of a cop0/cop2 instruction which doesn't have bit 25 set
+	COP0_MOVE,
+	COP2_MOVE,
+	// funct of a cop0/cop2 instruction with bit 25 set
+	COP0_FUNCTION,
+	GTE_COMMAND
+};
+
+// what the operands are and how the immediate is extended
+enum class operand_format : unsigned char
+{
+	NONE,
+	RD_RS_RT,
+	RD_RT_SHAMT,
+	RD_RT_RS,
+	RS_RT,
+	RD,
+	RS,
+	// jr and jalr
+	RS_TARGET,
+	RS_TARGET_RD,
+	// sign extended immediate
+	RT_RS_SIGNED,
+	// zero extended immediate
+	RT_RS_UNSIGNED,
+	// lui
+	RT_UPPER,
+	// loads and stores, offset(base)
+	RT_OFFSET_BASE,
+	// branches, the offset is sign extended and shifted
+	RS_RT_BRANCH,
+	RS_BRANCH,
+	// j and jal, the target is shifted
+	JUMP_TARGET,
+	// mfc, mtc, cfc and ctc
+	RT_COP_RD,
+	// the 25 bits the coprocessor gets
+	COP_FUNCTION
+};
+
+enum instruction_flags : unsigned char
+{
+	// has a delay slot
+	INSTRUCTION_BRANCH = 1 << 0,
+	// writes the return address
+	INSTRUCTION_LINK = 1 << 1,
+	INSTRUCTION_LOAD = 1 << 2,
+	INSTRUCTION_STORE = 1 << 3,
+	// can raise an exception besides an address error
+	INSTRUCTION_TRAP = 1 << 4,
+	// can change how the instructions after it are fetched, the cached interpreter stops after it
+	INSTRUCTION_ENDS_BLOCK = 1 << 5,
+	// the result comes from a unit which carries on working after the instruction, reading it early waits
+	INSTRUCTION_INTERLOCK = 1 << 6
+};
+
+struct instruction_description
+{
+	instruction_id id;
+	const char * mnemonic;
+	instruction_group group;
+	// value of the field the group looks at
+	unsigned char code;
+	operand_format format;
+	unsigned char flags;
+	// cycles until the result can be used, loads include the delay slot, multiplies and divides are
+	// the worst case and GTE commands are how long the command keeps the GTE busy
+	unsigned char latency;
+};
+
+constexpr instruction_description instruction_descriptions[] =
+{
+	{ instruction_id::UNKNOWN, "UNKNOWN", instruction_group::PRIMARY, 0xFF, operand_format::NONE, 0, 1 },
+
+	{ instruction_id::J, "J", instruction_group::PRIMARY, 002, operand_format::JUMP_TARGET, INSTRUCTION_BRANCH, 1 },
+	{ instruction_id::JAL, "JAL", instruction_group::PRIMARY, 003, operand_format::JUMP_TARGET, INSTRUCTION_BRANCH | INSTRUCTION_LINK, 1 },
+	{ instruction_id::BEQ, "BEQ", instruction_group::PRIMARY, 004, operand_format::RS_RT_BRANCH, INSTRUCTION_BRANCH, 1 },
+	{ instruction_id::BNE, "BNE", instruction_group::PRIMARY, 005, operand_format::RS_RT_BRANCH, INSTRUCTION_BRANCH, 1 },
+	{ instruction_id::BLEZ, "BLEZ", instruction_group::PRIMARY, 006, operand_format::RS_BRANCH, INSTRUCTION_BRANCH, 1 },
+	{ instruction_id::BGTZ, "BGTZ", instruction_group::PRIMARY, 007, operand_format::RS_BRANCH, INSTRUCTION_BRANCH, 1 },
+	{ instruction_id::ADDI, "ADDI", instruction_group::PRIMARY, 010, operand_format::RT_RS_SIGNED, INSTRUCTION_TRAP, 1 },
+	{ instruction_id::ADDIU, "ADDIU", instruction_group::PRIMARY, 011, operand_format::RT_RS_SIGNED, 0, 1 },
+	{ instruction_id::SLTI, "SLTI", instruction_group::PRIMARY, 012, operand_format::RT_RS_SIGNED, 0, 1 },
+	{ instruction_id::SLTIU, "SLTIU", instruction_group::PRIMARY, 013, operand_format::RT_RS_SIGNED, 0, 1 },
+	{ instruction_id::ANDI, "ANDI", instruction_group::PRIMARY, 014, operand_format::RT_RS_UNSIGNED, 0, 1 },
+	{ instruction_id::ORI, "ORI", instruction_group::PRIMARY, 015, operand_format::RT_RS_UNSIGNED, 0, 1 },
+	{ instruction_id::XORI, "XORI", instruction_group::PRIMARY, 016, operand_format::RT_RS_UNSIGNED, 0, 1 },
+	{ instruction_id::LUI, "LUI", instruction_group::PRIMARY, 017, operand_format::RT_UPPER, 0, 1 },
+	{ instruction_id::LB, "LB", instruction_group::PRIMARY, 040, operand_format::RT_OFFSET_BASE, INSTRUCTION_LOAD, 2 },
+	{ instruction_id::LH, "LH", instruction_group::PRIMARY, 041, operand_format::RT_OFFSET_BASE, INSTRUCTION_LOAD, 2 },
+	{ instruction_id::LWL, "LWL", instruction_group::PRIMARY, 042, operand_format::RT_OFFSET_BASE, INSTRUCTION_LOAD, 2 },
+	{ instruction_id::LW, "LW", instruction_group::PRIMARY, 043, operand_format::RT_OFFSET_BASE, INSTRUCTION_LOAD, 2 },
+	{ instruction_id::LBU, "LBU", instruction_group::PRIMARY, 044, operand_format::RT_OFFSET_BASE, INSTRUCTION_LOAD, 2 },
+	{ instruction_id::LHU, "LHU", instruction_group::PRIMARY, 045, operand_format::RT_OFFSET_BASE, INSTRUCTION_LOAD, 2 },
+	{ instruction_id::LWR, "LWR", instruction_group::PRIMARY, 046, operand_format::RT_OFFSET_BASE, INSTRUCTION_LOAD, 2 },
+	{ instruction_id::SB, "SB", instruction_group::PRIMARY, 050, operand_format::RT_OFFSET_BASE, INSTRUCTION_STORE, 1 },
+	{ instruction_id::SH, "SH", instruction_group::PRIMARY, 051, operand_format::RT_OFFSET_BASE, INSTRUCTION_STORE, 1 },
+	{ instruction_id::SWL, "SWL", instruction_group::PRIMARY, 052, operand_format::RT_OFFSET_BASE, INSTRUCTION_STORE, 1 },
+	{ instruction_id::SW, "SW", instruction_group::PRIMARY, 053, operand_format::RT_OFFSET_BASE, INSTRUCTION_STORE, 1 },
+	{ instruction_id::SWR, "SWR", instruction_group::PRIMARY, 056, operand_format::RT_OFFSET_BASE, INSTRUCTION_STORE, 1 },
+	{ instruction_id::LWC0, "LWC0", instruction_group::PRIMARY, 060, operand_format::RT_OFFSET_BASE, INSTRUCTION_LOAD, 2 },
+	{ instruction_id::LWC2, "LWC2", instruction_group::PRIMARY, 062, operand_format::RT_OFFSET_BASE, INSTRUCTION_LOAD, 2 },
+	{ instruction_id::SWC0, "SWC0", instruction_group::PRIMARY, 070, operand_format::RT_OFFSET_BASE, INSTRUCTION_STORE, 1 },
+	{ instruction_id::SWC2, "SWC2", instruction_group::PRIMARY, 072, operand_format::RT_OFFSET_BASE, INSTRUCTION_STORE, 1 },
+
+	{ instruction_id::SLL, "SLL", instruction_group::SPECIAL, 000, operand_format::RD_RT_SHAMT, 0, 1 },
+	{ instruction_id::SRL, "SRL", instruction_group::SPECIAL, 002, operand_format::RD_RT_SHAMT, 0, 1 },
+	{ instruction_id::SRA, "SRA", instruction_group::SPECIAL, 003, operand_format::RD_RT_SHAMT, 0, 1 },
+	{ instruction_id::SLLV, "SLLV", instruction_group::SPECIAL, 004, operand_format::RD_RT_RS, 0, 1 },
+	{ instruction_id::SRLV, "SRLV", instruction_group::SPECIAL, 006, operand_format::RD_RT_RS, 0, 1 },
+	{ instruction_id::SRAV, "SRAV", instruction_group::SPECIAL, 007, operand_format::RD_RT_RS, 0, 1 },
+	{ instruction_id::JR, "JR", instruction_group::SPECIAL, 010, operand_format::RS_TARGET, INSTRUCTION_BRANCH, 1 },
+	{ instruction_id::JALR, "JALR", instruction_group::SPECIAL, 011, operand_format::RS_TARGET_RD, INSTRUCTION_BRANCH | INSTRUCTION_LINK, 1 },
+	{ instruction_id::SYSCALL, "SYSCALL", instruction_group::SPECIAL, 014, operand_format::NONE, INSTRUCTION_TRAP | INSTRUCTION_ENDS_BLOCK, 1 },
+	{ instruction_id::BREAK, "BREAK", instruction_group::SPECIAL, 015, operand_format::NONE, INSTRUCTION_TRAP | INSTRUCTION_ENDS_BLOCK, 1 },
+	{ instruction_id::MFHI, "MFHI", instruction_group::SPECIAL, 020, operand_format::RD, 0, 1 },
+	{ instruction_id::MTHI, "MTHI", instruction_group::SPECIAL, 021, operand_format::RS, 0, 1 },
+	{ instruction_id::MFLO, "MFLO", instruction_group::SPECIAL, 022, operand_format::RD, 0, 1 },
+	{ instruction_id::MTLO, "MTLO", instruction_group::SPECIAL, 023, operand_format::RS, 0, 1 },
+	{ instruction_id::MULT, "MULT", instruction_group::SPECIAL, 030, operand_format::RS_RT, INSTRUCTION_INTERLOCK, 13 },
+	{ instruction_id::MULTU, "MULTU", instruction_group::SPECIAL, 031, operand_format::RS_RT, INSTRUCTION_INTERLOCK, 13 },
+	{ instruction_id::DIV, "DIV", instruction_group::SPECIAL, 032, operand_format::RS_RT, INSTRUCTION_INTERLOCK, 36 },
+	{ instruction_id::DIVU, "DIVU", instruction_group::SPECIAL, 033, operand_format::RS_RT, INSTRUCTION_INTERLOCK, 36 },
+	{ instruction_id::ADD, "ADD", instruction_group::SPECIAL, 040, operand_format::RD_RS_RT, INSTRUCTION_TRAP, 1 },
+	{ instruction_id::ADDU, "ADDU", instruction_group::SPECIAL, 041, operand_format::RD_RS_RT, 0, 1 },
+	{ instruction_id::SUB, "SUB", instruction_group::SPECIAL, 042, operand_format::RD_RS_RT, INSTRUCTION_TRAP, 1 },
+	{ instruction_id::SUBU, "SUBU", instruction_group::SPECIAL, 043, operand_format::RD_RS_RT, 0, 1 },
+	{ instruction_id::AND, "AND", instruction_group::SPECIAL, 044, operand_format::RD_RS_RT, 0, 1 },
+	{ instruction_id::OR, "OR", instruction_group::SPECIAL, 045, operand_format::RD_RS_RT, 0, 1 },
+	{ instruction_id::XOR, "XOR", instruction_group::SPECIAL, 046, operand_format::RD_RS_RT, 0, 1 },
+	{ instruction_id::NOR, "NOR", instruction_group::SPECIAL, 047, operand_format::RD_RS_RT, 0, 1 },
+	{ instruction_id::SLT, "SLT", instruction_group::SPECIAL, 052, operand_format::RD_RS_RT, 0, 1 },
+	{ instruction_id::SLTU, "SLTU", instruction_group::SPECIAL, 053, operand_format::RD_RS_RT, 0, 1 },
+
+	{ instruction_id::BLTZ, "BLTZ", instruction_group::BCOND, 000, operand_format::RS_BRANCH, INSTRUCTION_BRANCH, 1 },
+	{ instruction_id::BGEZ, "BGEZ", instruction_group::BCOND, 001, operand_format::RS_BRANCH, INSTRUCTION_BRANCH, 1 },
+	{ instruction_id::BLTZAL, "BLTZAL", instruction_group::BCOND, 020, operand_format::RS_BRANCH, INSTRUCTION_BRANCH | INSTRUCTION_LINK, 1 },
+	{ instruction_id::BGEZAL, "BGEZAL", instruction_group::BCOND, 021, operand_format::RS_BRANCH, INSTRUCTION_BRANCH | INSTRUCTION_LINK, 1 },
+
+	// anything cop0 does can change the status register
+	{ instruction_id::COP0, "COP0", instruction_group::PRIMARY, 020, operand_format::COP_FUNCTION, INSTRUCTION_ENDS_BLOCK, 1 },
+	{ instruction_id::MFC0, "MFC0", instruction_group::COP0_MOVE, 000, operand_format::RT_COP_RD, INSTRUCTION_ENDS_BLOCK, 2 },
+	{ instruction_id::MTC0, "MTC0", instruction_group::COP0_MOVE, 004, operand_format::RT_COP_RD, INSTRUCTION_ENDS_BLOCK, 1 },
+	{ instruction_id::RFE, "RFE", instruction_group::COP0_FUNCTION, 020, operand_format::NONE, INSTRUCTION_ENDS_BLOCK, 1 },
+
+	{ instruction_id::COP2, "COP2", instruction_group::PRIMARY, 022, operand_format::COP_FUNCTION, 0, 1 },
+	{ instruction_id::MFC2, "MFC2", instruction_group::COP2_MOVE, 000, operand_format::RT_COP_RD, 0, 2 },
+	{ instruction_id::CFC2, "CFC2", instruction_group::COP2_MOVE, 002, operand_format::RT_COP_RD, 0, 2 },
+	{ instruction_id::MTC2, "MTC2", instruction_group::COP2_MOVE, 004, operand_format::RT_COP_RD, 0, 1 },
+	{ instruction_id::CTC2, "CTC2", instruction_group::COP2_MOVE, 006, operand_format::RT_COP_RD, 0, 1 },
+	{ instruction_id::RTPS, "RTPS", instruction_group::GTE_COMMAND, 0x01, operand_format::COP_FUNCTION, INSTRUCTION_INTERLOCK, 15 },
+	{ instruction_id::NCLIP, "NCLIP", instruction_group::GTE_COMMAND, 0x06, operand_format::COP_FUNCTION, INSTRUCTION_INTERLOCK, 8 },
+	{ instruction_id::OP, "OP", instruction_group::GTE_COMMAND, 0x0C, operand_format::COP_FUNCTION, INSTRUCTION_INTERLOCK, 6 },
+	{ instruction_id::DPCS, "DPCS", instruction_group::GTE_COMMAND, 0x10, operand_format::COP_FUNCTION, INSTRUCTION_INTERLOCK, 8 },
+	{ instruction_id::INTPL, "INTPL", instruction_group::GTE_COMMAND, 0x11, operand_format::COP_FUNCTION, INSTRUCTION_INTERLOCK, 8 },
+	{ instruction_id::MVMVA, "MVMVA", instruction_group::GTE_COMMAND, 0x12, operand_format::COP_FUNCTION, INSTRUCTION_INTERLOCK, 8 },
+	{ instruction_id::NCDS, "NCDS", instruction_group::GTE_COMMAND, 0x13, operand_format::COP_FUNCTION, INSTRUCTION_INTERLOCK, 19 },
+	{ instruction_id::CDP, "CDP", instruction_group::GTE_COMMAND, 0x14, operand_format::COP_FUNCTION, INSTRUCTION_INTERLOCK, 13 },
+	{ instruction_id::NCDT, "NCDT", instruction_group::GTE_COMMAND, 0x16, operand_format::COP_FUNCTION, INSTRUCTION_INTERLOCK, 44 },
+	{ instruction_id::NCCS, "NCCS", instruction_group::GTE_COMMAND, 0x1B, operand_format::COP_FUNCTION, INSTRUCTION_INTERLOCK, 17 },
+	{ instruction_id::CC, "CC", instruction_group::GTE_COMMAND, 0x1C, operand_format::COP_FUNCTION, INSTRUCTION_INTERLOCK, 11 },
+	{ instruction_id::NCS, "NCS", instruction_group::GTE_COMMAND, 0x1E, operand_format::COP_FUNCTION, INSTRUCTION_INTERLOCK, 14 },
+	{ instruction_id::NCT, "NCT", instruction_group::GTE_COMMAND, 0x20, operand_format::COP_FUNCTION, INSTRUCTION_INTERLOCK, 30 },
+	{ instruction_id::SQR, "SQR", instruction_group::GTE_COMMAND, 0x28, operand_format::COP_FUNCTION, INSTRUCTION_INTERLOCK, 5 },
+	{ instruction_id::DCPL, "DCPL", instruction_group::GTE_COMMAND, 0x29, operand_format::COP_FUNCTION, INSTRUCTION_INTERLOCK, 8 },
+	{ instruction_id::DPCT, "DPCT", instruction_group::GTE_COMMAND, 0x2A, operand_format::COP_FUNCTION, INSTRUCTION_INTERLOCK, 17 },
+	{ instruction_id::AVSZ3, "AVSZ3", instruction_group::GTE_COMMAND, 0x2D, operand_format::COP_FUNCTION, INSTRUCTION_INTERLOCK, 5 },
+	{ instruction_id::AVSZ4, "AVSZ4", instruction_group::GTE_COMMAND, 0x2E, operand_format::COP_FUNCTION, INSTRUCTION_INTERLOCK, 6 },
+	{ instruction_id::RTPT, "RTPT", instruction_group::GTE_COMMAND, 0x30, operand_format::COP_FUNCTION, INSTRUCTION_INTERLOCK, 23 },
+	{ instruction_id::GPF, "GPF", instruction_group::GTE_COMMAND, 0x3D, operand_format::COP_FUNCTION, INSTRUCTION_INTERLOCK, 5 },
+	{ instruction_id::GPL, "GPL", instruction_group::GTE_COMMAND, 0x3E, operand_format::COP_FUNCTION, INSTRUCTION_INTERLOCK, 5 },
+	{ instruction_id::NCCT, "NCCT", instruction_group::GTE_COMMAND, 0x3F, operand_format::COP_FUNCTION, INSTRUCTION_INTERLOCK, 39 },
+};
+
+constexpr unsigned int NUM_INSTRUCTION_DESCRIPTIONS = sizeof(instruction_descriptions) / sizeof(instruction_description);
+static_assert(NUM_INSTRUCTION_DESCRIPTIONS == static_cast<unsigned int>(instruction_id::NUM_INSTRUCTIONS),
+	"every instruction needs a description");
+
+constexpr bool are_descriptions_in_order()
+{
+	for (unsigned int idx = 0; idx < NUM_INSTRUCTION_DESCRIPTIONS; idx++)
+	{
+		if (static_cast<unsigned int>(instruction_descriptions[idx].id) != idx)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+static_assert(are_descriptions_in_order(), "descriptions have to be in the same order as instruction_id");
+
+// one entry per value of the field each group is picked out by
+struct instruction_decode_tables
+{
+	instruction_id primary[64];
+	instruction_id special[64];
+	instruction_id bcond[32];
+	instruction_id cop0_move[32];
+	instruction_id cop2_move[32];
+	instruction_id cop0_function[64];
+	instruction_id gte_command[64];
+};
+
+constexpr instruction_decode_tables make_instruction_decode_tables()
+{
+	instruction_decode_tables tables = {};
+	for (unsigned int idx = 1; idx < NUM_INSTRUCTION_DESCRIPTIONS; idx++)
+	{
+		const instruction_description& description = instruction_descriptions[idx];
+		switch (description.group)
+		{
+			case instruction_group::PRIMARY: tables.primary[description.code] = description.id; break;
+			case instruction_group::SPECIAL: tables.special[description.code] = description.id; break;
+			case instruction_group::BCOND: tables.bcond[description.code] = description.id; break;
+			case instruction_group::COP0_MOVE: tables.cop0_move[description.code] = description.id; break;
+			case instruction_group::COP2_MOVE: tables.cop2_move[description.code] = description.id; break;
+			case instruction_group::COP0_FUNCTION: tables.cop0_function[description.code] = description.id; break;
+			case instruction_group::GTE_COMMAND: tables.gte_command[description.code] = description.id; break;
+		}
+	}
+	return tables;
+}
+
+constexpr instruction_decode_tables instruction_decode = make_instruction_decode_tables();
+
+constexpr instruction_id decode_instruction(unsigned int raw)
+{
+	unsigned int op = raw >> 26;
+	switch (static_cast<cpu_instructions>(op))
+	{
+		case cpu_instructions::SPECIAL: return instruction_decode.special[raw & 0x3F];
+		case cpu_instructions::BCOND: return instruction_decode.bcond[(raw >> 16) & 0x1F];
+
+		// what the coprocessor doesn't understand still goes to it
+		case cpu_instructions::COP0:
+		{
+			instruction_id id = (raw & (1 << 25)) ? instruction_decode.cop0_function[raw & 0x3F] : instruction_decode.cop0_move[(raw >> 21) & 0x1F];
+			return id == instruction_id::UNKNOWN ? instruction_id::COP0 : id;
+		}
+		case cpu_instructions::COP2:
+		{
+			instruction_id id = (raw & (1 << 25)) ? instruction_decode.gte_command[raw & 0x3F] : instruction_decode.cop2_move[(raw >> 21) & 0x1F];
+			return id == instruction_id::UNKNOWN ? instruction_id::COP2 : id;
+		}
+
+		default: return instruction_decode.primary[op];
+	}
+}
+
+constexpr const instruction_description& get_instruction_description(instruction_id id)
+{
+	return instruction_descriptions[static_cast<unsigned int>(id)];
+}
+
+constexpr const instruction_description& get_instruction_description(unsigned int raw)
+{
+	return get_instruction_description(decode_instruction(raw));
+}
+
+// writes the instruction as text to buffer without allocating, returns the length written (not counting the
+// null terminator) which is cut short if it doesn't fit
+unsigned int disassemble_instruction(unsigned int raw, char * buffer, unsigned int buffer_size);
\ No newline at end of file
@@ -0,0 +1,219 @@
+#include "Iso9660.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+	unsigned int get_word(const unsigned char * data)
+	{
+		return data[0] | (data[1] << 8) | (data[2] << 16) | (data[3] << 24);
+	}
+
+	unsigned int get_halfword(const unsigned char * data)
+	{
+		return data[0] | (data[1] << 8);
+	}
+}
+
+void Iso9660::clear()
+{
+	files.clear();
+	extents.clear();
+}
+
+bool Iso9660::build(const std::vector<unsigned char>& disc_data)
+{
+	clear();
+
+	const unsigned char * volume_descriptor = get_sector_data(disc_data, PRIMARY_VOLUME_DESCRIPTOR_LBA);
+	if (volume_descriptor == nullptr || volume_descriptor[0] != 1 || memcmp(volume_descriptor + 1, "CD001", 5) != 0)
+	{
+		return false;
+	}
+
+	// the little endian path table lists every directory, each after its parent
+	unsigned int path_table_size = get_word(volume_descriptor + 132);
+	unsigned int path_table_lba = get_word(volume_descriptor + 140);
+	std::vector<unsigned char> path_table;
+	for (unsigned int offset = 0; offset < path_table_size; offset += USER_DATA_SIZE)
+	{
+		const unsigned char * sector = get_sector_data(disc_data, path_table_lba + offset / USER_DATA_SIZE);
+		if (sector == nullptr)
+		{
+			return false;
+		}
+		unsigned int length = path_table_size - offset < USER_DATA_SIZE ? path_table_size - offset : USER_DATA_SIZE;
+		path_table.insert(path_table.end(), sector, sector + length);
+	}
+
+	std::vector<std::string> directory_paths;
+	unsigned int offset = 0;
+	while (offset + 8 <= path_table.size())
+	{
+		unsigned int name_length = path_table[offset];
+		unsigned int lba = get_word(&path_table[offset + 2]);
+		unsigned int parent = get_halfword(&path_table[offset + 6]);
+		if (name_length == 0 || offset + 8 + name_length > path_table.size())
+		{
+			break;
+		}
+
+		// directory numbers start at 1 with the root, which is its own parent
+		std::string path = "\\";
+		if (directory_paths.empty() == false)
+		{
+			if (parent == 0 || parent > directory_paths.size())
+			{
+				break;
+			}
+			std::string name(reinterpret_cast<const char*>(&path_table[offset + 8]), name_length);
+			const std::string& parent_path = directory_paths[parent - 1];
+			path = normalise_path(parent_path + (parent_path == "\\" ? "" : "\\") + name);
+		}
+		directory_paths.push_back(path);
+
+		// the directory's own record has its size
+		const unsigned char * directory = get_sector_data(disc_data, lba);
+		if (directory != nullptr)
+		{
+			iso_file entry;
+			entry.lba = lba;
+			entry.size = get_word(directory + 10);
+			entry.is_directory = true;
+			files[path] = entry;
+			add_directory(disc_data, path, entry);
+		}
+
+		// entries are padded to an even length
+		offset += 8 + name_length + (name_length & 1);
+	}
+
+	std::sort(extents.begin(), extents.end(), [](const file_extent& lhs, const file_extent& rhs) { return lhs.lba < rhs.lba; });
+	return files.empty() == false;
+}
+
+// adds the files in the directory, the directories in it come from the path table
+void Iso9660::add_directory(const std::vector<unsigned char>& disc_data, const std::string& path, const iso_file& directory)
+{
+	unsigned int num_sectors = (directory.size + USER_DATA_SIZE - 1) / USER_DATA_SIZE;
+	for (unsigned int sector_idx = 0; sector_idx < num_sectors; sector_idx++)
+	{
+		const unsigned char * sector = get_sector_data(disc_data, directory.lba + sector_idx);
+		if (sector == nullptr)
+		{
+			return;
+		}
+
+		// records don't cross into the next sector, the rest of the sector is zeroes
+		unsigned int offset = 0;
+		while (offset + 33 <= USER_DATA_SIZE && sector[offset] != 0)
+		{
+			const unsigned char * record = sector + offset;
+			unsigned int record_length = record[0];
+			unsigned int name_length = record[32];
+			bool is_directory = (record[25] & 0x2) != 0;
+			if (offset + record_length > USER_DATA_SIZE || 33 + name_length > record_length)
+			{
+				return;
+			}
+
+			if (is_directory == false)
+			{
+				std::string name(reinterpret_cast<const char*>(record + 33), name_length);
+
+				iso_file entry;
+				entry.lba = get_word(record + 2);
+				entry.size = get_word(record + 10);
+				std::string file_path = normalise_path((path == "\\" ? "" : path) + "\\" + name);
+				files[file_path] = entry;
+				extents.push_back({ entry.lba, (entry.size + USER_DATA_SIZE - 1) / USER_DATA_SIZE, file_path });
+			}
+
+			offset += record_length;
+		}
+	}
+}
+
+const iso_file * Iso9660::find(const std::string& path) const
+{
+	auto iter = files.find(normalise_path(path));
+	return iter == files.end() ? nullptr : &iter->second;
+}
+
+bool Iso9660::read_file(const std::vector<unsigned char>& disc_data, const std::string& path, std::vector<unsigned char>& data) const
+{
+	const iso_file * file = find(path);
+	if (file == nullptr || file->is_directory)
+	{
+		return false;
+	}
+
+	data.resize(file->size);
+	for (unsigned int offset = 0; offset < file->size; offset += USER_DATA_SIZE)
+	{
+		const unsigned char * sector = get_sector_data(disc_data, file->lba + offset / USER_DATA_SIZE);
+		if (sector == nullptr)
+		{
+			return false;
+		}
+		memcpy(&data[offset], sector, file->size - offset < USER_DATA_SIZE ? file->size - offset : USER_DATA_SIZE);
+	}
+	return true;
+}
+
+const std::string * Iso9660::find_path(unsigned int lba) const
+{
+	auto iter = std::upper_bound(extents.begin(), extents.end(), lba, [](unsigned int value, const file_extent& extent) { return value < extent.lba; });
+	if (iter == extents.begin())
+	{
+		return nullptr;
+	}
+
+	--iter;
+	return lba < iter->lba + iter->num_sectors ? &iter->path : nullptr;
+}
+
+std::string Iso9660::normalise_path(const std::string& path)
+{
+	std::string result = path;
+	for (char& character : result)
+	{
+		character = character == '/' ? '\\' : static_cast<char>(toupper(static_cast<unsigned char>(character)));
+	}
+
+	if (result.compare(0, 6, "CDROM:") == 0)
+	{
+		result.erase(0, 6);
+	}
+
+	// the version goes, and so does the dot of a name without an extension
+	size_t version = result.find(';');
+	if (version != std::string::npos)
+	{
+		result.resize(version);
+	}
+	if (result.empty() == false && result.back() == '.')
+	{
+		result.pop_back();
+	}
+
+	if (result.empty() || result.front() != '\\')
+	{
+		result.insert(result.begin(), '\\');
+	}
+	return result;
+}
+
+const unsigned char * Iso9660::get_sector_data(const std::vector<unsigned char>& disc_data, unsigned int lba)
+{
+	size_t offset = static_cast<size_t>(lba) * SECTOR_SIZE;
+	if (offset + SECTOR_SIZE > disc_data.size())
+	{
+		return nullptr;
+	}
+
+	// mode 2 sectors (every playstation disc) have an 8 byte subheader after the 12 byte sync and 4 byte header
+	const unsigned char * sector = &disc_data[offset];
+	return sector + (sector[15] == 2 ? 24 : 16);
+}
\ No newline at end of file
@@ -0,0 +1,56 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+struct iso_file
+{
+	unsigned int lba = 0;
+	unsigned int size = 0;
+	bool is_directory = false;
+};
+
+// An index of the ISO9660 filesystem on a disc image, built once when the disc loads so files can be pulled
+// straight out of it and a sector can be traced back to the file it belongs to.
+// Paths are upper case, start with a backslash and have no version, e.g. \DATA\LEVEL1.BIN. Lookups accept
+// the forms games use as well, cdrom:\SLUS_000.01;1 finds \SLUS_000.01.
+// ref: https://problemkaputt.de/psx-spx.htm#cdromisovolumedescriptors
+class Iso9660
+{
+public:
+	// disc_data is the raw 2352 byte sectors of the data track, returns false if there isn't a filesystem
+	bool build(const std::vector<unsigned char>& disc_data);
+	void clear();
+
+	// nullptr if there's no such file or directory
+	const iso_file * find(const std::string& path) const;
+	bool read_file(const std::vector<unsigned char>& disc_data, const std::string& path, std::vector<unsigned char>& data) const;
+
+	// the file the sector is part of, nullptr if it isn't in a file (e.g. the volume descriptors)
+	const std::string * find_path(unsigned int lba) const;
+
+	const std::unordered_map<std::string, iso_file>& get_files() const { return files; }
+
+	static std::string normalise_path(const std::string& path);
+
+private:
+	static const unsigned int SECTOR_SIZE = 2352;
+	static const unsigned int USER_DATA_SIZE = 2048;
+	static const unsigned int PRIMARY_VOLUME_DESCRIPTOR_LBA = 16;
+
+	// the 2048 bytes of data in a sector whatever mode it is, nullptr past the end of the disc
+	static const unsigned char * get_sector_data(const std::vector<unsigned char>& disc_data, unsigned int lba);
+
+	void add_directory(const std::vector<unsigned char>& disc_data, const std::string& path, const iso_file& directory);
+
+	std::unordered_map<std::string, iso_file> files;
+
+	// the files in order on the disc, for find_path
+	struct file_extent
+	{
+		unsigned int lba;
+		unsigned int num_sectors;
+		std::string path;
+	};
+	std::vector<file_extent> extents;
+};
\ No newline at end of file
@@ -0,0 +1,1542 @@
+#ifdef PSX_JIT
+#include <sys/mman.h>
+#include <cstring>
+#include <cstddef>
+#include <iostream>
+#include <initializer_list>
+#include "Jit.hpp"
+#include "Cpu.hpp"
+#include "BlockCache.hpp"
+#include "Bus.hpp"
+#include "Ram.hpp"
+#include "MemoryControl.hpp"
+#include "SystemControlCoprocessor.hpp"
+#include "InstructionEnums.hpp"
+
+#ifdef PSX_FASTMEM
+#include "Fastmem.hpp"
+#endif
+
+static Jit * instance = nullptr;
+
+Jit * Jit::get_instance()
+{
+	if (instance == nullptr)
+	{
+		instance = new Jit();
+	}
+
+	return instance;
+}
+
+namespace
+{
+	enum host_register : unsigned int
+	{
+		RAX = 0, RCX, RDX, RBX, RSP, RBP, RSI, RDI,
+		R8, R9, R10, R11, R12, R13, R14, R15
+	};
+
+	enum condition : unsigned char
+	{
+		CC_O = 0x0,
+		CC_B = 0x2,
+		CC_AE = 0x3,
+		CC_E = 0x4,
+		CC_NE = 0x5,
+		CC_L = 0xC,
+		CC_GE = 0xD,
+		CC_LE = 0xE,
+		CC_G = 0xF
+	};
+
+	// the /digit of the 0x81 (alu with imm32), 0xC1 (shift by imm8) and 0xD3 (shift by cl) groups
+	enum alu_op : unsigned int
+	{
+		ALU_ADD = 0, ALU_OR = 1, ALU_AND = 4, ALU_SUB = 5, ALU_XOR = 6, ALU_CMP = 7
+	};
+
+	enum shift_op : unsigned int
+	{
+		SHIFT_SHL = 4, SHIFT_SHR = 5, SHIFT_SAR = 7
+	};
+
+	// host register use inside generated code:
+	// rbx - the Cpu, r12d - virtual pc of the block, ebp - instructions executed since entering
+	// r13 - main memory, r14 - Ram's write direct pages, r15 - fastmem base
+	// everything else is scratch and gets trashed by calls
+	class Emitter
+	{
+	public:
+		Emitter(unsigned char * _start, unsigned int _capacity)
+		{
+			start = _start;
+			position = _start;
+			end = _start + _capacity;
+		}
+
+		unsigned char * get_position() { return position; }
+		unsigned int get_size() { return static_cast<unsigned int>(position - start); }
+		bool is_full() { return position + 16 > end; }
+
+		void byte(unsigned char value)
+		{
+			if (position < end)
+			{
+				*position = value;
+			}
+			position++;
+		}
+
+		void dword(unsigned int value)
+		{
+			for (unsigned int idx = 0; idx < 4; idx++)
+			{
+				byte((value >> (idx * 8)) & 0xFF);
+			}
+		}
+
+		void qword(unsigned long long value)
+		{
+			dword(static_cast<unsigned int>(value));
+			dword(static_cast<unsigned int>(value >> 32));
+		}
+
+		// reg is the modrm reg field (or /digit), rm is a register
+		void op_reg(std::initializer_list<unsigned char> opcode, unsigned int reg, unsigned int rm, bool wide = false)
+		{
+			rex(wide, reg, 0, rm);
+			for (unsigned char value : opcode) byte(value);
+			byte(0xC0 | ((reg & 7) << 3) | (rm & 7));
+		}
+
+		// [base + disp32]
+		void op_mem(std::initializer_list<unsigned char> opcode, unsigned int reg, unsigned int base, int disp, bool wide = false)
+		{
+			rex(wide, reg, 0, base);
+			for (unsigned char value : opcode) byte(value);
+			byte(0x80 | ((reg & 7) << 3) | (base & 7));
+			if ((base & 7) == RSP)
+			{
+				byte(0x24);
+			}
+			dword(static_cast<unsigned int>(disp));
+		}
+
+		// [base + index * 4 + disp32]
+		void op_scaled(std::initializer_list<unsigned char> opcode, unsigned int reg, unsigned int base, unsigned int index, int disp)
+		{
+			rex(false, reg, index, base);
+			for (unsigned char value : opcode) byte(value);
+			byte(0x84 | ((reg & 7) << 3));
+			byte(0x80 | ((index & 7) << 3) | (base & 7));
+			dword(static_cast<unsigned int>(disp));
+		}
+
+		// [base + index], always with a zero disp8 so r13 works as a base
+		void op_index(std::initializer_list<unsigned char> opcode, unsigned int reg, unsigned int base, unsigned int index, bool prefix_16 = false)
+		{
+			if (prefix_16)
+			{
+				byte(0x66);
+			}
+			rex(false, reg, index, base);
+			for (unsigned char value : opcode) byte(value);
+			byte(0x44 | ((reg & 7) << 3));
+			byte(((index & 7) << 3) | (base & 7));
+			byte(0x00);
+		}
+
+		void mov_imm(unsigned int reg, unsigned int value)
+		{
+			rex(false, 0, 0, reg);
+			byte(0xB8 | (reg & 7));
+			dword(value);
+		}
+
+		void mov_imm64(unsigned int reg, unsigned long long value)
+		{
+			rex(true, 0, 0, reg);
+			byte(0xB8 | (reg & 7));
+			qword(value);
+		}
+
+		void mov_imm64(unsigned int reg, const void * value)
+		{
+			mov_imm64(reg, reinterpret_cast<unsigned long long>(value));
+		}
+
+		void load(unsigned int reg, unsigned int base, int disp) { op_mem({ 0x8B }, reg, base, disp); }
+		void store(unsigned int base, int disp, unsigned int reg) { op_mem({ 0x89 }, reg, base, disp); }
+
+		void store_imm(unsigned int base, int disp, unsigned int value)
+		{
+			op_mem({ 0xC7 }, 0, base, disp);
+			dword(value);
+		}
+
+		void store_imm8(unsigned int base, int disp, unsigned char value)
+		{
+			op_mem({ 0xC6 }, 0, base, disp);
+			byte(value);
+		}
+
+		void mov(unsigned int dst, unsigned int src) { op_reg({ 0x89 }, src, dst); }
+		void mov64(unsigned int dst, unsigned int src) { op_reg({ 0x89 }, src, dst, true); }
+		void add(unsigned int dst, unsigned int src) { op_reg({ 0x01 }, src, dst); }
+		void sub(unsigned int dst, unsigned int src) { op_reg({ 0x29 }, src, dst); }
+		void and_(unsigned int dst, unsigned int src) { op_reg({ 0x21 }, src, dst); }
+		void or_(unsigned int dst, unsigned int src) { op_reg({ 0x09 }, src, dst); }
+		void xor_(unsigned int dst, unsigned int src) { op_reg({ 0x31 }, src, dst); }
+		void cmp(unsigned int lhs, unsigned int rhs) { op_reg({ 0x39 }, rhs, lhs); }
+		void test(unsigned int lhs, unsigned int rhs) { op_reg({ 0x85 }, rhs, lhs); }
+		// a bool return value is only defined in al
+		void test_bool() { op_reg({ 0x84 }, RAX, RAX); }
+		void not_(unsigned int reg) { op_reg({ 0xF7 }, 2, reg); }
+		void imul(unsigned int dst, unsigned int src) { op_reg({ 0x0F, 0xAF }, dst, src); }
+
+		void alu_imm(alu_op op, unsigned int reg, unsigned int value)
+		{
+			op_reg({ 0x81 }, op, reg);
+			dword(value);
+		}
+
+		void shift_imm(shift_op op, unsigned int reg, unsigned char amount)
+		{
+			op_reg({ 0xC1 }, op, reg);
+			byte(amount);
+		}
+
+		void shift_cl(shift_op op, unsigned int reg) { op_reg({ 0xD3 }, op, reg); }
+
+		// only for eax, ecx and edx, anything else needs a rex prefix to get the low byte
+		void setcc(condition cc, unsigned int reg) { op_reg({ 0x0F, static_cast<unsigned char>(0x90 | cc) }, 0, reg); }
+		void movzx8(unsigned int dst, unsigned int src) { op_reg({ 0x0F, 0xB6 }, dst, src); }
+		void movzx16(unsigned int dst, unsigned int src) { op_reg({ 0x0F, 0xB7 }, dst, src); }
+		void movsx8(unsigned int dst, unsigned int src) { op_reg({ 0x0F, 0xBE }, dst, src); }
+		void movsx16(unsigned int dst, unsigned int src) { op_reg({ 0x0F, 0xBF }, dst, src); }
+
+		void call(const void * function)
+		{
+			mov_imm64(RAX, function);
+			op_reg({ 0xFF }, 2, RAX);
+		}
+
+		void push(unsigned int reg)
+		{
+			rex(false, 0, 0, reg);
+			byte(0x50 | (reg & 7));
+		}
+
+		void pop(unsigned int reg)
+		{
+			rex(false, 0, 0, reg);
+			byte(0x58 | (reg & 7));
+		}
+
+		// jumps return where their rel32 is so it can be bound once the target is known
+		unsigned char * jcc(condition cc)
+		{
+			byte(0x0F);
+			byte(0x80 | cc);
+			dword(0);
+			return position - 4;
+		}
+
+		unsigned char * jmp()
+		{
+			byte(0xE9);
+			dword(0);
+			return position - 4;
+		}
+
+		void jmp(const unsigned char * target)
+		{
+			bind(jmp(), target);
+		}
+
+		static void bind(unsigned char * fixup, const unsigned char * target)
+		{
+			int rel = static_cast<int>(target - (fixup + 4));
+			memcpy(fixup, &rel, sizeof(int));
+		}
+
+		void bind(unsigned char * fixup)
+		{
+			bind(fixup, position);
+		}
+
+	private:
+		void rex(bool wide, unsigned int reg, unsigned int index, unsigned int base)
+		{
+			unsigned char value = 0x40 | (wide << 3) | ((reg >> 3) << 2) | ((index >> 3) << 1) | (base >> 3);
+			if (value != 0x40)
+			{
+				byte(value);
+			}
+		}
+
+		unsigned char * start = nullptr;
+		unsigned char * position = nullptr;
+		unsigned char * end = nullptr;
+	};
+
+	// where everything the generated code touches lives, relative to the Cpu in rbx
+	struct cpu_layout
+	{
+		int current_pc = 0;
+		int next_pc = 0;
+		int current_instruction = 0;
+		int next_instruction = 0;
+		int in_delay_slot = 0;
+		int hi = 0;
+		int lo = 0;
+		int registers = 0;
+		// pending loads are the register index followed by the value
+		int delayed_load = 0;
+		int next_load = 0;
+		int wait_cycles = 0;
+
+		const bool * interrupt_pending = nullptr;
+	};
+
+	// the generated code calls these, anything the guest does that isn't supported is left in cpu->pending_exception for tick
+
+	void jit_call_handler(Cpu * cpu, const micro_op * op)
+	{
+		op->handler(cpu, *op);
+	}
+
+	// returns true if an interrupt was raised
+	bool jit_trigger_interrupts(Cpu * cpu)
+	{
+		return SystemControlCoprocessor::get_instance()->trigger_interrupts();
+	}
+
+	void jit_tick_registers(Cpu * cpu)
+	{
+		cpu->register_file.tick();
+		cpu->in_delay_slot = false;
+	}
+
+	// the loads the guest makes wait for memory, fetching the next instruction doesn't
+	template <bool wait>
+	unsigned int jit_load_byte(Cpu * cpu, unsigned int address)
+	{
+		if (wait)
+		{
+			cpu->wait_cycles += MemoryControl::get_instance()->get_read_cycles(address, Bus::io_width::BYTE);
+		}
+		return Bus::get_instance()->get_byte(address);
+	}
+
+	template <bool wait>
+	unsigned int jit_load_halfword(Cpu * cpu, unsigned int address)
+	{
+		if (wait)
+		{
+			cpu->wait_cycles += MemoryControl::get_instance()->get_read_cycles(address, Bus::io_width::HALFWORD);
+		}
+		return Bus::get_instance()->get_halfword(address);
+	}
+
+	template <bool wait>
+	unsigned int jit_load_word(Cpu * cpu, unsigned int address)
+	{
+		if (wait)
+		{
+			cpu->wait_cycles += MemoryControl::get_instance()->get_read_cycles(address, Bus::io_width::WORD);
+		}
+		return Bus::get_instance()->get_word(address);
+	}
+
+#ifndef PSX_FASTMEM
+	// with fastmem stores go straight to the mapping and fault into the bus instead
+	void jit_store_byte(Cpu * cpu, unsigned int address, unsigned int value)
+	{
+		Bus::get_instance()->set_byte(address, static_cast<unsigned char>(value));
+	}
+
+	void jit_store_halfword(Cpu * cpu, unsigned int address, unsigned int value)
+	{
+		Bus::get_instance()->set_halfword(address, static_cast<unsigned short>(value));
+	}
+
+	void jit_store_word(Cpu * cpu, unsigned int address, unsigned int value)
+	{
+		Bus::get_instance()->set_word(address, value);
+	}
+#endif
+
+	enum class access_size : unsigned int
+	{
+		BYTE = 1,
+		HALFWORD = 2,
+		WORD = 4
+	};
+
+	// compiles one block, the structure of each instruction follows Cpu::execute_block:
+	// set up the pcs, run the instruction, check for interrupts, tick the register file
+	class BlockCompiler
+	{
+	public:
+		BlockCompiler(Emitter& _emitter, const cpu_layout& _layout, cached_block * _block, jit_block * _compiled, unsigned char * _exit_code, jit_block ** _last_exit)
+			: emitter(_emitter), layout(_layout)
+		{
+			block = _block;
+			compiled = _compiled;
+			exit_code = _exit_code;
+			last_exit = _last_exit;
+			num_ops = static_cast<unsigned int>(block->ops.size());
+		}
+
+		void compile()
+		{
+			for (unsigned int idx = 0; idx < num_ops; idx++)
+			{
+				compile_op(idx);
+			}
+
+			emitter.alu_imm(ALU_ADD, RBP, num_ops);
+
+			const micro_op& last_op = block->ops.back();
+			if (last_op.is_branch || last_op.ends_block)
+			{
+				// whatever runs next has to go through the dispatcher
+				emit_exit_without_link();
+			}
+			else
+			{
+				emit_links();
+			}
+
+			for (const cold_path& path : cold_paths)
+			{
+				emit_cold_path(path);
+			}
+		}
+
+	private:
+		enum class cold_path_type
+		{
+			// an interrupt is pending, raise it and leave
+			INTERRUPT,
+			// ADD and ADDI call the interpreter handler to raise the exception
+			OVERFLOW,
+			// the instruction is done but the rest of the block can't run
+			EXIT
+		};
+
+		struct cold_path
+		{
+			cold_path_type type;
+			unsigned int index;
+			unsigned char * fixup;
+			// where the interrupt path goes back to if nothing was raised
+			unsigned char * resume;
+		};
+
+		bool is_last(unsigned int index) { return index + 1 == num_ops; }
+
+		int register_offset(unsigned int reg)
+		{
+			return layout.registers + static_cast<int>(reg * sizeof(unsigned int));
+		}
+
+		void load_register(unsigned int host, unsigned int reg)
+		{
+			if (reg == 0)
+			{
+				emitter.xor_(host, host);
+			}
+			else
+			{
+				emitter.load(host, RBX, register_offset(reg));
+			}
+		}
+
+		// same as RegisterFile::set_register, next_load is always empty when an inline instruction starts
+		// so only the delayed load can be dropped
+		void store_register(unsigned int reg, unsigned int host, bool load_delay = false)
+		{
+			if (reg == 0)
+			{
+				return;
+			}
+
+			if (load_delay)
+			{
+				emitter.store_imm(RBX, layout.next_load, reg);
+				emitter.store(RBX, layout.next_load + 4, host);
+				return;
+			}
+
+			emitter.store(RBX, register_offset(reg), host);
+
+			if (delayed_load == delayed_load_state::UNKNOWN)
+			{
+				emitter.op_mem({ 0x81 }, ALU_CMP, RBX, layout.delayed_load);
+				emitter.dword(reg);
+				unsigned char * skip = emitter.jcc(CC_NE);
+				emitter.op_mem({ 0xC7 }, 0, RBX, layout.delayed_load, true);
+				emitter.dword(0);
+				emitter.bind(skip);
+			}
+			else if (delayed_load == delayed_load_state::KNOWN && delayed_load_index == reg)
+			{
+				emitter.op_mem({ 0xC7 }, 0, RBX, layout.delayed_load, true);
+				emitter.dword(0);
+				delayed_load = delayed_load_state::NONE;
+			}
+		}
+
+		void add_cold_path(cold_path_type type, unsigned int index, unsigned char * fixup, unsigned char * resume = nullptr)
+		{
+			cold_paths.push_back({ type, index, fixup, resume });
+		}
+
+		// instructions in the middle of a block keep their pcs in registers until something needs them
+		void sync_state(unsigned int index, bool include_next_pc = true)
+		{
+			if (is_last(index))
+			{
+				// the last instruction always writes them out as it starts
+				return;
+			}
+
+			emitter.mov(RAX, R12);
+			emitter.alu_imm(ALU_ADD, RAX, (index + 1) * 4);
+			emitter.store(RBX, layout.current_pc, RAX);
+			if (include_next_pc)
+			{
+				emitter.alu_imm(ALU_ADD, RAX, 4);
+				emitter.store(RBX, layout.next_pc, RAX);
+			}
+			emitter.store_imm(RBX, layout.current_instruction, block->ops[index].instruction.raw);
+			emitter.store_imm(RBX, layout.next_instruction, block->ops[index + 1].instruction.raw);
+		}
+
+		// the value next_pc has when the instruction starts executing
+		void load_next_pc(unsigned int index, unsigned int host)
+		{
+			if (is_last(index))
+			{
+				emitter.load(host, RBX, layout.next_pc);
+			}
+			else
+			{
+				emitter.mov(host, R12);
+				emitter.alu_imm(ALU_ADD, host, (index + 2) * 4);
+			}
+		}
+
+		bool is_inline_load(const micro_op& op)
+		{
+			switch (static_cast<cpu_instructions>(op.instruction.immediate_instruction.op))
+			{
+				case cpu_instructions::LB:
+				case cpu_instructions::LBU:
+				case cpu_instructions::LH:
+				case cpu_instructions::LHU:
+				case cpu_instructions::LW:
+					return true;
+				default:
+					return false;
+			}
+		}
+
+		bool is_store(const micro_op& op)
+		{
+			switch (static_cast<cpu_instructions>(op.instruction.immediate_instruction.op))
+			{
+				case cpu_instructions::SB:
+				case cpu_instructions::SH:
+				case cpu_instructions::SW:
+					return true;
+				default:
+					return false;
+			}
+		}
+
+		// register the instruction writes with a load delay, 0 if none
+		unsigned int get_load_target(unsigned int index)
+		{
+			const micro_op& op = block->ops[index];
+			return is_inline_load(op) ? op.rt : 0;
+		}
+
+		void compile_op(unsigned int index)
+		{
+			const micro_op& op = block->ops[index];
+
+			if (is_last(index))
+			{
+				// the pc can be anywhere after a branch so it has to come from next_pc
+				if (index > 0 && block->ops[index - 1].is_branch)
+				{
+					emitter.load(RAX, RBX, layout.next_pc);
+				}
+				else
+				{
+					emitter.mov(RAX, R12);
+					emitter.alu_imm(ALU_ADD, RAX, (index + 1) * 4);
+				}
+				emitter.store(RBX, layout.current_pc, RAX);
+				emitter.store_imm(RBX, layout.current_instruction, op.instruction.raw);
+				emitter.mov(RSI, RAX);
+				emit_load(index, access_size::WORD, false);
+				emitter.store(RBX, layout.next_instruction, RAX);
+				emitter.load(RAX, RBX, layout.current_pc);
+				emitter.alu_imm(ALU_ADD, RAX, 4);
+				emitter.store(RBX, layout.next_pc, RAX);
+			}
+
+			// what the delayed load slot holds going into this instruction
+			const micro_op * previous = index > 0 ? &block->ops[index - 1] : nullptr;
+			if (previous == nullptr || is_inline(*previous) == false)
+			{
+				delayed_load = delayed_load_state::UNKNOWN;
+			}
+			else
+			{
+				delayed_load_index = get_load_target(index - 1);
+				delayed_load = delayed_load_index ? delayed_load_state::KNOWN : delayed_load_state::NONE;
+			}
+
+			bool inline_op = compile_inline(index);
+			if (inline_op == false)
+			{
+				sync_state(index);
+				emitter.mov64(RDI, RBX);
+				emitter.mov_imm64(RSI, &op);
+				emitter.call(reinterpret_cast<const void*>(&jit_call_handler));
+			}
+
+			if (op.interlock_cycles)
+			{
+				emit_wait(op.interlock_cycles);
+			}
+
+			// only the guest's own memory accesses and calls out can make an interrupt pending part way through, one
+			// which was pending before the block is caught after its first instruction like the interpreter does
+			inline_kind kind = get_inline_kind(op);
+			if (index == 0 || inline_op == false || kind == inline_kind::LOAD || kind == inline_kind::STORE)
+			{
+				emitter.mov_imm64(RAX, layout.interrupt_pending);
+				emitter.op_mem({ 0x80 }, 7, RAX, 0);
+				emitter.byte(0);
+				unsigned char * interrupt_fixup = emitter.jcc(CC_NE);
+				add_cold_path(cold_path_type::INTERRUPT, index, interrupt_fixup, emitter.get_position());
+			}
+
+			if (op.is_branch || inline_op == false)
+			{
+				emitter.store_imm8(RBX, layout.in_delay_slot, 0);
+			}
+
+			emit_register_tick(index, inline_op);
+
+			if (inline_op == false && op.is_branch == false && is_last(index) == false)
+			{
+				// an exception moves next_pc somewhere else
+				load_next_pc(index, RCX);
+				emitter.op_mem({ 0x3B }, RCX, RBX, layout.next_pc);
+				add_cold_path(cold_path_type::EXIT, index, emitter.jcc(CC_NE));
+			}
+
+			if (inline_op == false || is_store(op))
+			{
+				// the block wrote over itself
+				emitter.mov_imm64(RAX, &block->valid);
+				emitter.op_mem({ 0x80 }, 7, RAX, 0);
+				emitter.byte(0);
+				add_cold_path(cold_path_type::EXIT, index, emitter.jcc(CC_E));
+			}
+		}
+
+		// RegisterFile::tick, skipping whatever is known to be empty
+		void emit_register_tick(unsigned int index, bool inline_op)
+		{
+			if (inline_op == false)
+			{
+				emitter.mov64(RDI, RBX);
+				emitter.call(reinterpret_cast<const void*>(&jit_tick_registers));
+				return;
+			}
+
+			if (delayed_load == delayed_load_state::KNOWN)
+			{
+				emitter.load(RCX, RBX, layout.delayed_load + 4);
+				emitter.store(RBX, register_offset(delayed_load_index), RCX);
+			}
+			else if (delayed_load == delayed_load_state::UNKNOWN)
+			{
+				emitter.load(RAX, RBX, layout.delayed_load);
+				emitter.load(RCX, RBX, layout.delayed_load + 4);
+				emitter.op_scaled({ 0x89 }, RCX, RBX, RAX, layout.registers);
+			}
+
+			if (get_load_target(index))
+			{
+				emitter.op_mem({ 0x8B }, RAX, RBX, layout.next_load, true);
+				emitter.op_mem({ 0x89 }, RAX, RBX, layout.delayed_load, true);
+				emitter.op_mem({ 0xC7 }, 0, RBX, layout.next_load, true);
+				emitter.dword(0);
+			}
+			else if (delayed_load != delayed_load_state::NONE)
+			{
+				emitter.op_mem({ 0xC7 }, 0, RBX, layout.delayed_load, true);
+				emitter.dword(0);
+			}
+		}
+
+		bool is_inline(const micro_op& op)
+		{
+			return get_inline_kind(op) != inline_kind::NONE;
+		}
+
+		enum class inline_kind
+		{
+			NONE,
+			ALU,
+			LOAD,
+			STORE,
+			BRANCH
+		};
+
+		inline_kind get_inline_kind(const micro_op& op)
+		{
+			const instruction_union& instr = op.instruction;
+			switch (static_cast<cpu_instructions>(instr.immediate_instruction.op))
+			{
+				case cpu_instructions::ADDI:
+				case cpu_instructions::ADDIU:
+				case cpu_instructions::ANDI:
+				case cpu_instructions::ORI:
+				case cpu_instructions::XORI:
+				case cpu_instructions::LUI:
+				case cpu_instructions::SLTI:
+				case cpu_instructions::SLTIU:
+					return inline_kind::ALU;
+
+				case cpu_instructions::LB:
+				case cpu_instructions::LBU:
+				case cpu_instructions::LH:
+				case cpu_instructions::LHU:
+				case cpu_instructions::LW:
+					return inline_kind::LOAD;
+
+				case cpu_instructions::SB:
+				case cpu_instructions::SH:
+				case cpu_instructions::SW:
+					return inline_kind::STORE;
+
+				case cpu_instructions::BEQ:
+				case cpu_instructions::BNE:
+				case cpu_instructions::BLEZ:
+				case cpu_instructions::BGTZ:
+				case cpu_instructions::J:
+				case cpu_instructions::JAL:
+					return inline_kind::BRANCH;
+
+				case cpu_instructions::BCOND:
+				{
+					cpu_bconds cond = static_cast<cpu_bconds>(instr.immediate_instruction.rt);
+					return cond == cpu_bconds::BGEZ || cond == cpu_bconds::BLTZ ? inline_kind::BRANCH : inline_kind::NONE;
+				}
+
+				case cpu_instructions::SPECIAL:
+				{
+					switch (static_cast<cpu_special_funcs>(instr.register_instruction.funct))
+					{
+						case cpu_special_funcs::ADD:
+						case cpu_special_funcs::ADDU:
+						case cpu_special_funcs::SUBU:
+						case cpu_special_funcs::AND:
+						case cpu_special_funcs::OR:
+						case cpu_special_funcs::XOR:
+						case cpu_special_funcs::NOR:
+						case cpu_special_funcs::SLT:
+						case cpu_special_funcs::SLTU:
+						case cpu_special_funcs::SLL:
+						case cpu_special_funcs::SRL:
+						case cpu_special_funcs::SRA:
+						case cpu_special_funcs::SLLV:
+						case cpu_special_funcs::SRLV:
+						case cpu_special_funcs::SRAV:
+						case cpu_special_funcs::MFHI:
+						case cpu_special_funcs::MFLO:
+						case cpu_special_funcs::MTHI:
+						case cpu_special_funcs::MTLO:
+						case cpu_special_funcs::MULT:
+						case cpu_special_funcs::MULTU:
+							return inline_kind::ALU;
+
+						case cpu_special_funcs::JR:
+						case cpu_special_funcs::JALR:
+							return inline_kind::BRANCH;
+
+						// SUB doesn't raise overflow on the same inputs x86 does, so it stays on its handler
+						default:
+							return inline_kind::NONE;
+					}
+				}
+
+				default:
+					return inline_kind::NONE;
+			}
+		}
+
+		// returns false if the instruction has to go through its handler
+		bool compile_inline(unsigned int index)
+		{
+			const micro_op& op = block->ops[index];
+			switch (get_inline_kind(op))
+			{
+				case inline_kind::ALU:
+					compile_alu(index);
+					return true;
+				case inline_kind::LOAD:
+					compile_load(index);
+					return true;
+				case inline_kind::STORE:
+					compile_store(index);
+					return true;
+				case inline_kind::BRANCH:
+					compile_branch(index);
+					return true;
+				default:
+					return false;
+			}
+		}
+
+		void compile_alu(unsigned int index)
+		{
+			const micro_op& op = block->ops[index];
+			const instruction_union& instr = op.instruction;
+
+			cpu_instructions opcode = static_cast<cpu_instructions>(instr.immediate_instruction.op);
+			if (opcode != cpu_instructions::SPECIAL)
+			{
+				switch (opcode)
+				{
+					case cpu_instructions::ADDI:
+					{
+						load_register(RAX, op.rs);
+						emitter.alu_imm(ALU_ADD, RAX, op.immediate);
+						add_cold_path(cold_path_type::OVERFLOW, index, emitter.jcc(CC_O));
+					} break;
+
+					case cpu_instructions::ADDIU:
+					{
+						load_register(RAX, op.rs);
+						emitter.alu_imm(ALU_ADD, RAX, op.immediate);
+					} break;
+
+					case cpu_instructions::ANDI: load_register(RAX, op.rs); emitter.alu_imm(ALU_AND, RAX, op.immediate); break;
+					case cpu_instructions::ORI: load_register(RAX, op.rs); emitter.alu_imm(ALU_OR, RAX, op.immediate); break;
+					case cpu_instructions::XORI: load_register(RAX, op.rs); emitter.alu_imm(ALU_XOR, RAX, op.immediate); break;
+					case cpu_instructions::LUI: emitter.mov_imm(RAX, op.immediate); break;
+
+					case cpu_instructions::SLTI:
+					case cpu_instructions::SLTIU:
+					{
+						load_register(RCX, op.rs);
+						emitter.xor_(RAX, RAX);
+						emitter.alu_imm(ALU_CMP, RCX, op.immediate);
+						emitter.setcc(opcode == cpu_instructions::SLTI ? CC_L : CC_B, RAX);
+					} break;
+
+					default:
+						break;
+				}
+
+				store_register(op.rt, RAX);
+				return;
+			}
+
+			cpu_special_funcs func = static_cast<cpu_special_funcs>(instr.register_instruction.funct);
+			switch (func)
+			{
+				case cpu_special_funcs::MTHI:
+				case cpu_special_funcs::MTLO:
+				{
+					load_register(RAX, op.rs);
+					emitter.store(RBX, func == cpu_special_funcs::MTHI ? layout.hi : layout.lo, RAX);
+				} return;
+
+				case cpu_special_funcs::MULT:
+				{
+					// Cpu::execute multiplies in 32 bits before widening, so hi is just the sign of lo
+					load_register(RAX, op.rs);
+					load_register(RCX, op.rt);
+					emitter.imul(RAX, RCX);
+					emitter.store(RBX, layout.lo, RAX);
+					emitter.shift_imm(SHIFT_SAR, RAX, 31);
+					emitter.store(RBX, layout.hi, RAX);
+				} return;
+
+				case cpu_special_funcs::MULTU:
+				{
+					load_register(RAX, op.rs);
+					load_register(RCX, op.rt);
+					emitter.imul(RAX, RCX);
+					emitter.store(RBX, layout.lo, RAX);
+					emitter.store_imm(RBX, layout.hi, 0);
+				} return;
+
+				case cpu_special_funcs::MFHI: emitter.load(RAX, RBX, layout.hi); break;
+				case cpu_special_funcs::MFLO: emitter.load(RAX, RBX, layout.lo); break;
+
+				case cpu_special_funcs::SLL:
+				case cpu_special_funcs::SRL:
+				case cpu_special_funcs::SRA:
+				{
+					load_register(RAX, op.rt);
+					shift_op shift = func == cpu_special_funcs::SLL ? SHIFT_SHL : func == cpu_special_funcs::SRL ? SHIFT_SHR : SHIFT_SAR;
+					if (op.shamt)
+					{
+						emitter.shift_imm(shift, RAX, op.shamt);
+					}
+				} break;
+
+				case cpu_special_funcs::SLLV:
+				case cpu_special_funcs::SRLV:
+				case cpu_special_funcs::SRAV:
+				{
+					// x86 masks the shift to 5 bits too
+					load_register(RAX, op.rt);
+					load_register(RCX, op.rs);
+					shift_op shift = func == cpu_special_funcs::SLLV ? SHIFT_SHL : func == cpu_special_funcs::SRLV ? SHIFT_SHR : SHIFT_SAR;
+					emitter.shift_cl(shift, RAX);
+				} break;
+
+				case cpu_special_funcs::SLT:
+				case cpu_special_funcs::SLTU:
+				{
+					load_register(RCX, op.rs);
+					load_register(RDX, op.rt);
+					emitter.xor_(RAX, RAX);
+					emitter.cmp(RCX, RDX);
+					emitter.setcc(func == cpu_special_funcs::SLT ? CC_L : CC_B, RAX);
+				} break;
+
+				default:
+				{
+					load_register(RAX, op.rs);
+					load_register(RCX, op.rt);
+					switch (func)
+					{
+						case cpu_special_funcs::ADD:
+						{
+							emitter.add(RAX, RCX);
+							add_cold_path(cold_path_type::OVERFLOW, index, emitter.jcc(CC_O));
+						} break;
+						case cpu_special_funcs::ADDU: emitter.add(RAX, RCX); break;
+						case cpu_special_funcs::SUBU: emitter.sub(RAX, RCX); break;
+						case cpu_special_funcs::AND: emitter.and_(RAX, RCX); break;
+						case cpu_special_funcs::OR: emitter.or_(RAX, RCX); break;
+						case cpu_special_funcs::XOR: emitter.xor_(RAX, RCX); break;
+						case cpu_special_funcs::NOR: emitter.or_(RAX, RCX); emitter.not_(RAX); break;
+						default: break;
+					}
+				} break;
+			}
+
+			store_register(op.rd, RAX);
+		}
+
+		void compute_address(const micro_op& op)
+		{
+			load_register(RSI, op.rs);
+			if (op.immediate)
+			{
+				emitter.alu_imm(ALU_ADD, RSI, op.immediate);
+			}
+		}
+
+		void compile_load(unsigned int index)
+		{
+			const micro_op& op = block->ops[index];
+			compute_address(op);
+
+			// the sign handling matches Cpu::execute, LB and LBU are the wrong way round there
+			switch (static_cast<cpu_instructions>(op.instruction.immediate_instruction.op))
+			{
+				case cpu_instructions::LB:
+					emit_load(index, access_size::BYTE);
+					emitter.movzx8(RAX, RAX);
+					break;
+				case cpu_instructions::LBU:
+					emit_load(index, access_size::BYTE);
+					emitter.movsx8(RAX, RAX);
+					break;
+				case cpu_instructions::LH:
+					emit_load(index, access_size::HALFWORD);
+					emitter.movsx16(RAX, RAX);
+					break;
+				case cpu_instructions::LHU:
+					emit_load(index, access_size::HALFWORD);
+					emitter.movzx16(RAX, RAX);
+					break;
+				default:
+					emit_load(index, access_size::WORD);
+					break;
+			}
+
+			store_register(op.rt, RAX, true);
+		}
+
+		void compile_store(unsigned int index)
+		{
+			const micro_op& op = block->ops[index];
+			compute_address(op);
+			load_register(RDX, op.rt);
+
+			switch (static_cast<cpu_instructions>(op.instruction.immediate_instruction.op))
+			{
+				case cpu_instructions::SB: emit_store(index, access_size::BYTE); break;
+				case cpu_instructions::SH: emit_store(index, access_size::HALFWORD); break;
+				default: emit_store(index, access_size::WORD); break;
+			}
+		}
+
+		void emit_wait(unsigned int num_cycles)
+		{
+			emitter.op_mem({ 0x81 }, ALU_ADD, RBX, layout.wait_cycles);
+			emitter.dword(num_cycles);
+		}
+
+		// address in esi, the value ends up zero extended in eax, wait is false for instruction fetches
+		void emit_load(unsigned int index, access_size size, bool wait = true)
+		{
+#ifdef PSX_FASTMEM
+			// exactly what Fastmem::get_word etc are, anything that isn't memory faults into the bus
+			// there is no telling which region it was without the fault, so every load waits as long as main memory
+			emitter.mov64(RDI, R15);
+			switch (size)
+			{
+				case access_size::BYTE: for (unsigned char value : { 0x0F, 0xB6, 0x04, 0x37 }) emitter.byte(value); break;
+				case access_size::HALFWORD: for (unsigned char value : { 0x0F, 0xB7, 0x04, 0x37 }) emitter.byte(value); break;
+				case access_size::WORD: for (unsigned char value : { 0x8B, 0x04, 0x37 }) emitter.byte(value); break;
+			}
+			if (wait)
+			{
+				emit_wait(MemoryControl::MAIN_MEMORY_READ_CYCLES);
+			}
+#else
+			std::vector<unsigned char*> slow_fixups;
+#ifndef PSX_BUS_PROFILER
+			emit_ram_check(size, slow_fixups);
+			switch (size)
+			{
+				case access_size::BYTE: emitter.op_index({ 0x0F, 0xB6 }, RAX, R13, RAX); break;
+				case access_size::HALFWORD: emitter.op_index({ 0x0F, 0xB7 }, RAX, R13, RAX); break;
+				case access_size::WORD: emitter.op_index({ 0x8B }, RAX, R13, RAX); break;
+			}
+			if (wait)
+			{
+				emit_wait(MemoryControl::MAIN_MEMORY_READ_CYCLES);
+			}
+			unsigned char * done = emitter.jmp();
+			for (unsigned char * fixup : slow_fixups)
+			{
+				emitter.bind(fixup);
+			}
+#else
+			// every access has to reach the bus to be counted
+			unsigned char * done = nullptr;
+#endif
+
+			sync_state(index);
+			emitter.mov64(RDI, RBX);
+			switch (size)
+			{
+				case access_size::BYTE: emitter.call(reinterpret_cast<const void*>(wait ? &jit_load_byte<true> : &jit_load_byte<false>)); break;
+				case access_size::HALFWORD: emitter.call(reinterpret_cast<const void*>(wait ? &jit_load_halfword<true> : &jit_load_halfword<false>)); break;
+				case access_size::WORD: emitter.call(reinterpret_cast<const void*>(wait ? &jit_load_word<true> : &jit_load_word<false>)); break;
+			}
+
+			if (done)
+			{
+				emitter.bind(done);
+			}
+#endif
+		}
+
+		// address in esi, value in edx
+		void emit_store(unsigned int index, access_size size)
+		{
+#ifdef PSX_FASTMEM
+			emitter.mov(RAX, RDX);
+			emitter.mov64(RDI, R15);
+			switch (size)
+			{
+				case access_size::BYTE: for (unsigned char value : { 0x88, 0x04, 0x37 }) emitter.byte(value); break;
+				case access_size::HALFWORD: for (unsigned char value : { 0x66, 0x89, 0x04, 0x37 }) emitter.byte(value); break;
+				case access_size::WORD: for (unsigned char value : { 0x89, 0x04, 0x37 }) emitter.byte(value); break;
+			}
+#else
+			std::vector<unsigned char*> slow_fixups;
+#ifndef PSX_BUS_PROFILER
+			emit_ram_check(size, slow_fixups);
+
+			// clean and watched pages have to go through Ram
+			emitter.mov(RCX, RAX);
+			emitter.shift_imm(SHIFT_SHR, RCX, Ram::DIRTY_PAGE_SHIFT);
+			emitter.op_index({ 0x80 }, 7, R14, RCX);
+			emitter.byte(0);
+			slow_fixups.push_back(emitter.jcc(CC_E));
+
+			switch (size)
+			{
+				case access_size::BYTE: emitter.op_index({ 0x88 }, RDX, R13, RAX); break;
+				case access_size::HALFWORD: emitter.op_index({ 0x89 }, RDX, R13, RAX, true); break;
+				case access_size::WORD: emitter.op_index({ 0x89 }, RDX, R13, RAX); break;
+			}
+			unsigned char * done = emitter.jmp();
+			for (unsigned char * fixup : slow_fixups)
+			{
+				emitter.bind(fixup);
+			}
+#else
+			unsigned char * done = nullptr;
+#endif
+
+			sync_state(index);
+			emitter.mov64(RDI, RBX);
+			switch (size)
+			{
+				case access_size::BYTE: emitter.call(reinterpret_cast<const void*>(&jit_store_byte)); break;
+				case access_size::HALFWORD: emitter.call(reinterpret_cast<const void*>(&jit_store_halfword)); break;
+				case access_size::WORD: emitter.call(reinterpret_cast<const void*>(&jit_store_word)); break;
+			}
+
+			if (done)
+			{
+				emitter.bind(done);
+			}
+#endif
+		}
+
+		// leaves the offset into main memory in eax, jumps to slow_fixups for anything else
+		void emit_ram_check(access_size size, std::vector<unsigned char*>& slow_fixups)
+		{
+			// KSEG2 isn't a mirror of main memory
+			emitter.alu_imm(ALU_CMP, RSI, 0xC0000000);
+			slow_fixups.push_back(emitter.jcc(CC_AE));
+			emitter.mov(RAX, RSI);
+			emitter.alu_imm(ALU_AND, RAX, 0x1FFFFFFF);
+			emitter.alu_imm(ALU_CMP, RAX, RAM_SIZE);
+			slow_fixups.push_back(emitter.jcc(CC_AE));
+			if (size != access_size::BYTE)
+			{
+				emitter.op_reg({ 0xF7 }, 0, RSI);
+				emitter.dword(static_cast<unsigned int>(size) - 1);
+				slow_fixups.push_back(emitter.jcc(CC_NE));
+			}
+		}
+
+		void compile_branch(unsigned int index)
+		{
+			const micro_op& op = block->ops[index];
+			const instruction_union& instr = op.instruction;
+
+			load_next_pc(index, RCX);
+
+			cpu_instructions opcode = static_cast<cpu_instructions>(instr.immediate_instruction.op);
+			switch (opcode)
+			{
+				case cpu_instructions::J:
+				case cpu_instructions::JAL:
+				{
+					if (opcode == cpu_instructions::JAL)
+					{
+						store_register(31, RCX);
+					}
+					emitter.alu_imm(ALU_AND, RCX, 0xF0000000);
+					emitter.alu_imm(ALU_OR, RCX, op.immediate);
+					emitter.store_imm8(RBX, layout.in_delay_slot, 1);
+				} break;
+
+				case cpu_instructions::SPECIAL:
+				{
+					// JALR writes the link register before reading rs, in case they are the same register
+					if (static_cast<cpu_special_funcs>(instr.register_instruction.funct) == cpu_special_funcs::JALR)
+					{
+						store_register(op.rd, RCX);
+					}
+					load_register(RCX, op.rs);
+					emitter.store_imm8(RBX, layout.in_delay_slot, 1);
+				} break;
+
+				default:
+				{
+					condition not_taken = CC_NE;
+					load_register(RAX, op.rs);
+					switch (opcode)
+					{
+						case cpu_instructions::BEQ:
+							load_register(RDX, op.rt);
+							emitter.cmp(RAX, RDX);
+							not_taken = CC_NE;
+							break;
+						case cpu_instructions::BNE:
+							load_register(RDX, op.rt);
+							emitter.cmp(RAX, RDX);
+							not_taken = CC_E;
+							break;
+						case cpu_instructions::BLEZ:
+							emitter.test(RAX, RAX);
+							not_taken = CC_G;
+							break;
+						case cpu_instructions::BGTZ:
+							emitter.test(RAX, RAX);
+							not_taken = CC_LE;
+							break;
+						default:
+						{
+							// BCOND
+							emitter.test(RAX, RAX);
+							not_taken = static_cast<cpu_bconds>(instr.immediate_instruction.rt) == cpu_bconds::BGEZ ? CC_L : CC_GE;
+						} break;
+					}
+
+					unsigned char * skip = emitter.jcc(not_taken);
+					emitter.alu_imm(ALU_ADD, RCX, op.immediate - 4);
+					emitter.store_imm8(RBX, layout.in_delay_slot, 1);
+					emitter.bind(skip);
+				} break;
+			}
+
+			emitter.store(RBX, layout.next_pc, RCX);
+		}
+
+		void emit_exit_without_link()
+		{
+			emitter.jmp(exit_code);
+		}
+
+		// each link compares the pc against the one it was linked for, and checks nothing moved next_pc
+		// (an interrupt on the last instruction) and that the budget isn't used up before jumping
+		void emit_links()
+		{
+			std::vector<unsigned char*> exit_fixups;
+			for (unsigned int idx = 0; idx < jit_block::MAX_LINKS; idx++)
+			{
+				jit_link& link = compiled->links[idx];
+
+				emitter.load(RAX, RBX, layout.current_pc);
+				emitter.op_reg({ 0x81 }, ALU_CMP, RAX);
+				link.expected_pc_site = emitter.get_position();
+				emitter.dword(0xFFFFFFFF);
+				unsigned char * next_link = emitter.jcc(CC_NE);
+
+				emitter.load(RCX, RBX, layout.next_pc);
+				emitter.sub(RCX, RAX);
+				emitter.alu_imm(ALU_CMP, RCX, 4);
+				exit_fixups.push_back(emitter.jcc(CC_NE));
+				emitter.alu_imm(ALU_CMP, RBP, Jit::MAX_LINKED_INSTRUCTIONS);
+				exit_fixups.push_back(emitter.jcc(CC_AE));
+				emitter.mov(R12, RAX);
+				link.jump_site = emitter.jmp();
+				exit_fixups.push_back(link.jump_site);
+
+				emitter.bind(next_link);
+			}
+			compiled->num_links = jit_block::MAX_LINKS;
+
+			// leaving through here tells the dispatcher it can link one of the exits to what runs next
+			for (unsigned char * fixup : exit_fixups)
+			{
+				emitter.bind(fixup);
+			}
+			emitter.mov_imm64(RAX, last_exit);
+			emitter.mov_imm64(RCX, compiled);
+			emitter.op_mem({ 0x89 }, RCX, RAX, 0, true);
+			// skip the part of the exit which clears last_exit
+			emitter.jmp(exit_code + EXIT_CLEAR_SIZE);
+		}
+
+		void emit_cold_path(const cold_path& path)
+		{
+			const micro_op& op = block->ops[path.index];
+			emitter.bind(path.fixup);
+
+			switch (path.type)
+			{
+				case cold_path_type::INTERRUPT:
+				{
+					// instructions which called their handler already wrote everything out (and it may have changed since),
+					// branches have already written next_pc
+					if (is_inline(op))
+					{
+						sync_state(path.index, op.is_branch == false);
+					}
+					emitter.mov64(RDI, RBX);
+					emitter.call(reinterpret_cast<const void*>(&jit_trigger_interrupts));
+					emitter.test_bool();
+					emitter.bind(emitter.jcc(CC_E), path.resume);
+				} break;
+
+				case cold_path_type::OVERFLOW:
+				{
+					// the handler redoes the add and raises the exception
+					sync_state(path.index);
+					emitter.mov64(RDI, RBX);
+					emitter.mov_imm64(RSI, &op);
+					emitter.call(reinterpret_cast<const void*>(&jit_call_handler));
+					emitter.mov64(RDI, RBX);
+					emitter.call(reinterpret_cast<const void*>(&jit_trigger_interrupts));
+				} break;
+
+				case cold_path_type::EXIT:
+				{
+					// stores which didn't go through the bus helper haven't written anything out yet
+					if (is_inline(op))
+					{
+						sync_state(path.index, op.is_branch == false);
+					}
+				} break;
+
+				default:
+					break;
+			}
+
+			if (path.type != cold_path_type::EXIT)
+			{
+				emitter.mov64(RDI, RBX);
+				emitter.call(reinterpret_cast<const void*>(&jit_tick_registers));
+			}
+
+			emitter.alu_imm(ALU_ADD, RBP, path.index + 1);
+			emitter.jmp(exit_code);
+		}
+
+	public:
+		static const unsigned int RAM_SIZE = 1024 * 512 * 4;
+		// exit_code starts by clearing last_exit, this is how many bytes that takes
+		static const unsigned int EXIT_CLEAR_SIZE = 10 + 11;
+
+	private:
+		Emitter& emitter;
+		const cpu_layout& layout;
+		cached_block * block = nullptr;
+		jit_block * compiled = nullptr;
+		unsigned char * exit_code = nullptr;
+		jit_block ** last_exit = nullptr;
+		unsigned int num_ops = 0;
+
+		std::vector<cold_path> cold_paths;
+
+		// the delayed load slot is only known for certain after an inline instruction
+		enum class delayed_load_state
+		{
+			NONE,
+			KNOWN,
+			UNKNOWN
+		};
+		delayed_load_state delayed_load = delayed_load_state::UNKNOWN;
+		unsigned int delayed_load_index = 0;
+	};
+}
+
+Jit::~Jit()
+{
+	if (code_buffer)
+	{
+		munmap(code_buffer, CODE_BUFFER_SIZE);
+	}
+}
+
+bool Jit::init()
+{
+	if (code_buffer)
+	{
+		return true;
+	}
+
+	void * memory = mmap(nullptr, CODE_BUFFER_SIZE, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (memory == MAP_FAILED)
+	{
+		std::cerr << "Jit: unable to allocate the code buffer\n";
+		return false;
+	}
+	code_buffer = static_cast<unsigned char*>(memory);
+
+	// enter(cpu, block_pc, context, code)
+	Emitter emitter(code_buffer, CODE_BUFFER_SIZE);
+	enter = reinterpret_cast<enter_function>(emitter.get_position());
+	for (unsigned int reg : { RBX, RBP, R12, R13, R14, R15 })
+	{
+		emitter.push(reg);
+	}
+	// keep the stack 16 byte aligned for the calls out of generated code
+	for (unsigned char value : { 0x48, 0x83, 0xEC, 0x08 }) emitter.byte(value);
+	emitter.mov64(RBX, RDI);
+	emitter.mov(R12, RSI);
+	emitter.op_mem({ 0x8B }, R13, RDX, offsetof(jit_context, main_memory), true);
+	emitter.op_mem({ 0x8B }, R14, RDX, offsetof(jit_context, write_direct_pages), true);
+	emitter.op_mem({ 0x8B }, R15, RDX, offsetof(jit_context, fastmem_base), true);
+	emitter.xor_(RBP, RBP);
+	emitter.op_reg({ 0xFF }, 4, RCX);
+
+	// exit, returns the number of instructions executed
+	exit_code = emitter.get_position();
+	emitter.mov_imm64(RAX, &last_exit);
+	emitter.op_mem({ 0xC7 }, 0, RAX, 0, true);
+	emitter.dword(0);
+	if (emitter.get_position() - exit_code != BlockCompiler::EXIT_CLEAR_SIZE)
+	{
+		std::cerr << "Jit: exit code is the wrong size\n";
+		return false;
+	}
+	emitter.mov(RAX, RBP);
+	for (unsigned char value : { 0x48, 0x83, 0xC4, 0x08 }) emitter.byte(value);
+	for (unsigned int reg : { R15, R14, R13, R12, RBP, RBX })
+	{
+		emitter.pop(reg);
+	}
+	emitter.byte(0xC3);
+
+	code_used = (emitter.get_size() + 15) & ~15;
+	return true;
+}
+
+unsigned int Jit::execute(Cpu * cpu)
+{
+	BlockCache * block_cache = BlockCache::get_instance();
+	block_cache->free_invalidated_blocks();
+
+	// the same conditions as Cpu::execute_block, plus the block can't start in a delay slot
+	Ram * ram = Ram::get_instance();
+	cached_block * block = ram->is_cache_isolated() ? nullptr : block_cache->get_block(cpu->current_pc);
+	if (block == nullptr || block->ops.front().instruction.raw != cpu->next_instruction || cpu->next_pc != cpu->current_pc + 4)
+	{
+		last_exit = nullptr;
+		return 0;
+	}
+
+	if (block->jit == nullptr)
+	{
+		if (code_used + MAX_BLOCK_CODE_SIZE > CODE_BUFFER_SIZE)
+		{
+			flush();
+			block = block_cache->get_block(cpu->current_pc);
+		}
+
+		block->jit = compile(block);
+		if (block->jit == nullptr)
+		{
+			last_exit = nullptr;
+			return 0;
+		}
+	}
+
+	if (last_exit)
+	{
+		link(last_exit, block, cpu->current_pc);
+		last_exit = nullptr;
+	}
+
+	context.main_memory = ram->get_main_memory();
+	context.write_direct_pages = ram->get_write_direct_pages();
+#ifdef PSX_FASTMEM
+	context.fastmem_base = Fastmem::get_instance()->get_base();
+#endif
+
+	return enter(cpu, cpu->current_pc, &context, block->jit->code);
+}
+
+jit_block * Jit::compile(cached_block * block)
+{
+	Cpu * cpu = Cpu::get_instance();
+	auto offset_of = [cpu](const void * field) {
+		return static_cast<int>(static_cast<const char*>(field) - reinterpret_cast<const char*>(cpu));
+	};
+
+	cpu_layout layout;
+	layout.current_pc = offset_of(&cpu->current_pc);
+	layout.next_pc = offset_of(&cpu->next_pc);
+	layout.current_instruction = offset_of(&cpu->current_instruction);
+	layout.next_instruction = offset_of(&cpu->next_instruction);
+	layout.in_delay_slot = offset_of(&cpu->in_delay_slot);
+	layout.hi = offset_of(&cpu->hi);
+	layout.lo = offset_of(&cpu->lo);
+	layout.registers = offset_of(cpu->register_file.registers);
+	layout.delayed_load = offset_of(&cpu->register_file.delayed_load);
+	layout.next_load = offset_of(&cpu->register_file.next_load);
+	layout.wait_cycles = offset_of(&cpu->wait_cycles);
+	layout.interrupt_pending = &SystemControlCoprocessor::get_instance()->interrupt_pending;
+
+	jit_block * compiled = new jit_block();
+	compiled->code = code_buffer + code_used;
+
+	Emitter emitter(compiled->code, MAX_BLOCK_CODE_SIZE);
+	BlockCompiler compiler(emitter, layout, block, compiled, exit_code, &last_exit);
+	compiler.compile();
+
+	if (emitter.get_size() > MAX_BLOCK_CODE_SIZE)
+	{
+		std::cerr << "Jit: block at " << std::hex << block->address << " is too big to compile\n";
+		delete compiled;
+		return nullptr;
+	}
+
+	code_used = (code_used + emitter.get_size() + 15) & ~15;
+	return compiled;
+}
+
+void Jit::link(jit_block * from, cached_block * to, unsigned int pc)
+{
+	for (unsigned int idx = 0; idx < from->num_links; idx++)
+	{
+		jit_link& link = from->links[idx];
+		if (link.used == false)
+		{
+			memcpy(link.expected_pc_site, &pc, sizeof(unsigned int));
+			Emitter::bind(link.jump_site, to->jit->code);
+			link.used = true;
+			to->jit->incoming_links.push_back(link.expected_pc_site);
+			return;
+		}
+	}
+}
+
+void Jit::unlink_block(cached_block * block)
+{
+	if (block->jit == nullptr)
+	{
+		return;
+	}
+
+	// nothing compares equal to this so the exits fall through to the dispatcher,
+	// the link itself stays used so a block which keeps getting rewritten doesn't keep getting relinked
+	const unsigned int unlinked = 0xFFFFFFFF;
+	for (unsigned char * site : block->jit->incoming_links)
+	{
+		memcpy(site, &unlinked, sizeof(unsigned int));
+	}
+	block->jit->incoming_links.clear();
+
+	if (last_exit == block->jit)
+	{
+		last_exit = nullptr;
+	}
+}
+
+void Jit::release_block(cached_block * block)
+{
+	unlink_block(block);
+	delete block->jit;
+	block->jit = nullptr;
+}
+
+void Jit::flush()
+{
+	// every block goes, including their links, so the code buffer can be reused
+	BlockCache::get_instance()->clear();
+	last_exit = nullptr;
+	code_used = static_cast<unsigned int>(exit_code - code_buffer) + 64;
+}
+#endif
\ No newline at end of file
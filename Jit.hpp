@@ -0,0 +1,89 @@
+#pragma once
+
+// Translates the blocks in the block cache into x86-64 code.
+// The common instructions (alu, shifts, multiplies, loads, stores and branches) are emitted inline,
+// everything else (cop0, the gte, divides, unaligned loads and stores, syscall and break) calls the
+// same handler the interpreter uses. The guest registers stay in the RegisterFile so the load
+// delay behaves exactly as it does in the interpreter.
+// Loads and stores to main memory go straight to host memory (or through fastmem when it is enabled),
+// everything else calls into the bus.
+// A block which ends by falling through or branching gets up to two exits which are patched to jump
+// straight into the block that ran next, so hot loops stay in generated code until the instruction budget
+// for the tick runs out.
+// Only supported on x86-64 linux, enable it with the PSX_JIT cmake option.
+#ifdef PSX_JIT
+#include <vector>
+
+class Cpu;
+struct cached_block;
+
+struct jit_link
+{
+	// the pc the exit was linked for, 0xFFFFFFFF while unlinked
+	unsigned char * expected_pc_site = nullptr;
+	// rel32 of the jump into the next block
+	unsigned char * jump_site = nullptr;
+	bool used = false;
+};
+
+struct jit_block
+{
+	unsigned char * code = nullptr;
+
+	static const unsigned int MAX_LINKS = 2;
+	jit_link links[MAX_LINKS];
+	unsigned int num_links = 0;
+
+	// exits of other blocks which jump into this one, they are unlinked when this block goes away
+	std::vector<unsigned char*> incoming_links;
+};
+
+class Jit
+{
+public:
+	static Jit * get_instance();
+
+	bool init();
+
+	// runs the block at the cpu's pc and whatever it links to, returns 0 if there wasn't a block it could run
+	unsigned int execute(Cpu * cpu);
+
+	// called by the block cache when a block is invalidated and when it is deleted
+	void unlink_block(cached_block * block);
+	void release_block(cached_block * block);
+
+	// most instructions a chain of linked blocks runs before returning to let the devices tick
+	static const unsigned int MAX_LINKED_INSTRUCTIONS = 256;
+
+private:
+	Jit() = default;
+	~Jit();
+
+	jit_block * compile(cached_block * block);
+	void link(jit_block * from, cached_block * to, unsigned int pc);
+	void flush();
+
+	static const unsigned int CODE_BUFFER_SIZE = 32 * 1024 * 1024;
+	// compiling a block never needs more than this
+	static const unsigned int MAX_BLOCK_CODE_SIZE = 64 * 1024;
+
+	unsigned char * code_buffer = nullptr;
+	unsigned int code_used = 0;
+
+	// shared by every block, enter sets up the host registers and jumps to the block
+	typedef unsigned int(*enter_function)(Cpu * cpu, unsigned int block_pc, const void * context, const unsigned char * code);
+	enter_function enter = nullptr;
+	unsigned char * exit_code = nullptr;
+
+	// host memory the generated code needs, passed to enter
+	struct jit_context
+	{
+		unsigned char * main_memory = nullptr;
+		const unsigned char * write_direct_pages = nullptr;
+		unsigned char * fastmem_base = nullptr;
+	} context;
+
+	// set by the exit a block leaves through when it could be linked to whatever runs next
+	jit_block * last_exit = nullptr;
+};
+#endif
\ No newline at end of file
@@ -12,6 +12,26 @@ MemoryControl * MemoryControl::get_instance()
 	return instance;
 }
 
+MemoryControl::MemoryControl()
+{
+	reset();
+}
+
+void MemoryControl::reset()
+{
+	registers[EXPANSION_1_BASE] = 0x1F000000;
+	registers[EXPANSION_2_BASE] = 0x1F802000;
+	registers[DELAY_SIZE_START + EXPANSION_1] = 0x0013243F;
+	registers[DELAY_SIZE_START + EXPANSION_3] = 0x00003022;
+	registers[DELAY_SIZE_START + BIOS] = 0x0013243F;
+	registers[DELAY_SIZE_START + SPU] = 0x200931E1;
+	registers[DELAY_SIZE_START + CDROM] = 0x00020843;
+	registers[DELAY_SIZE_START + EXPANSION_2] = 0x00070777;
+	registers[COMMON_DELAY] = 0x00031125;
+	registers[RAM_SIZE] = 0x00000B88;
+	update_read_cycles();
+}
+
 bool MemoryControl::is_address_for_device(unsigned int address)
 {
 	if (address >= MEMORY_CONTROL_1_START && address < MEMORY_CONTROL_1_END)
@@ -27,11 +47,122 @@ bool MemoryControl::is_address_for_device(unsigned int address)
 
 unsigned char MemoryControl::get_byte(unsigned int address)
 {
-	// TODO
-	return 0;
+	unsigned int index = address >= MEMORY_CONTROL_2_START ? RAM_SIZE : (address - MEMORY_CONTROL_1_START) / 4;
+	return (registers[index] >> ((address & 0x3) * 8)) & 0xFF;
 }
 
 void MemoryControl::set_byte(unsigned int address, unsigned char value)
 {
-	// TODO
+	unsigned int index = address >= MEMORY_CONTROL_2_START ? RAM_SIZE : (address - MEMORY_CONTROL_1_START) / 4;
+	unsigned int shift = (address & 0x3) * 8;
+	registers[index] = (registers[index] & ~(0xFF << shift)) | (value << shift);
+
+	if (index >= DELAY_SIZE_START && index <= COMMON_DELAY)
+	{
+		update_read_cycles();
+	}
+}
+
+void MemoryControl::register_io_handlers(Bus * bus)
+{
+	bus->register_io_range(MEMORY_CONTROL_1_START, MEMORY_CONTROL_1_END, this);
+	bus->register_io_range(MEMORY_CONTROL_2_START, MEMORY_CONTROL_2_END, this);
+}
+
+unsigned int MemoryControl::get_external_read_cycles(unsigned int physical_address, Bus::io_width width)
+{
+	unsigned int width_index = static_cast<unsigned int>(width);
+
+	if (physical_address >= 0x1FC00000 && physical_address < 0x1FC80000)
+	{
+		return region_read_cycles[BIOS][width_index];
+	}
+
+	// scratchpad
+	if (physical_address >= 0x1F800000 && physical_address < 0x1F800400)
+	{
+		return 0;
+	}
+
+	if (physical_address >= 0x1F801000 && physical_address < 0x1F802000)
+	{
+		if (physical_address >= 0x1F801C00)
+		{
+			return region_read_cycles[SPU][width_index];
+		}
+		if (physical_address >= 0x1F801800 && physical_address < 0x1F801810)
+		{
+			return region_read_cycles[CDROM][width_index];
+		}
+		return IO_READ_CYCLES;
+	}
+
+	if (physical_address >= 0x1F000000 && physical_address < 0x1F800000)
+	{
+		return region_read_cycles[EXPANSION_1][width_index];
+	}
+	if (physical_address >= 0x1F802000 && physical_address < 0x1F804000)
+	{
+		return region_read_cycles[EXPANSION_2][width_index];
+	}
+	if (physical_address >= 0x1FA00000 && physical_address < 0x1FC00000)
+	{
+		return region_read_cycles[EXPANSION_3][width_index];
+	}
+
+	return IO_READ_CYCLES;
+}
+
+// the first access of a read pays for setting up the address, the accesses after it on an 8 or 16 bit bus
+// only pay for the data, recovery, floating release and pre-strobe add the common delays
+void MemoryControl::update_read_cycles()
+{
+	memory_common_delay common_delay = get_common_delay();
+
+	for (unsigned int region_index = 0; region_index < NUM_REGIONS; region_index++)
+	{
+		memory_delay_size delay_size = get_delay_size(static_cast<region>(region_index));
+
+		int first = 0;
+		int sequential = 0;
+		int minimum = 0;
+		if (delay_size.recovery_period)
+		{
+			first += static_cast<int>(common_delay.com0) - 1;
+			sequential += static_cast<int>(common_delay.com0) - 1;
+		}
+		if (delay_size.floating_release)
+		{
+			first += common_delay.com2;
+			sequential += common_delay.com2;
+		}
+		if (delay_size.pre_strobe)
+		{
+			minimum = common_delay.com3;
+		}
+
+		if (first < 6)
+		{
+			first++;
+		}
+		first += delay_size.read_delay + 2;
+		sequential += delay_size.read_delay + 2;
+
+		if (first < minimum + 6)
+		{
+			first = minimum + 6;
+		}
+		if (sequential < minimum + 2)
+		{
+			sequential = minimum + 2;
+		}
+
+		unsigned int byte_cycles = first;
+		unsigned int halfword_cycles = delay_size.data_bus_16bit ? first : first + sequential;
+		unsigned int word_cycles = delay_size.data_bus_16bit ? first + sequential : first + sequential * 3;
+
+		region_read_cycles[region_index][static_cast<unsigned int>(Bus::io_width::BYTE)] = byte_cycles;
+		region_read_cycles[region_index][static_cast<unsigned int>(Bus::io_width::HALFWORD)] = halfword_cycles;
+		region_read_cycles[region_index][static_cast<unsigned int>(Bus::io_width::WORD)] = word_cycles;
+	}
 }
\ No newline at end of file
@@ -1,21 +1,114 @@
 #pragma once
 #include "Bus.hpp"
 
+// delay/size register for each of the regions on the external bus
+union memory_delay_size
+{
+	unsigned int raw;
+	struct
+	{
+		unsigned int write_delay : 4;
+		unsigned int read_delay : 4;
+		// each of these adds one of the com delays
+		unsigned int recovery_period : 1;
+		unsigned int hold_period : 1;
+		unsigned int floating_release : 1;
+		unsigned int pre_strobe : 1;
+		// otherwise 8 bits, wider accesses are split up
+		unsigned int data_bus_16bit : 1;
+		unsigned int auto_increment : 1;
+		unsigned int na0 : 2;
+		// the region is 1 << address_bits bytes
+		unsigned int address_bits : 5;
+		unsigned int na1 : 3;
+		unsigned int dma_timing_override : 4;
+		unsigned int address_error : 1;
+		unsigned int dma_timing_select : 1;
+		unsigned int wide_dma : 1;
+		unsigned int wait : 1;
+	};
+};
+
+union memory_common_delay
+{
+	unsigned int raw;
+	struct
+	{
+		unsigned int com0 : 4;
+		unsigned int com1 : 4;
+		unsigned int com2 : 4;
+		unsigned int com3 : 4;
+		unsigned int na : 16;
+	};
+};
+
+// The memory control registers, and what they make reads cost.
+// The bios programs how long each region on the external bus (the expansion ports, the bios rom, the spu and
+// the cdrom) takes to access, main memory, the scratchpad and the other I/O registers have fixed timings.
+// Costs are the cycles a load waits on top of the one every instruction takes. Stores go through the
+// write buffer so they don't cost anything.
 class MemoryControl : public Bus::BusDevice
 {
 public:
 	static MemoryControl * get_instance();
 
+	// the regions with a delay/size register, in the order of the registers
+	enum region : unsigned int
+	{
+		EXPANSION_1 = 0,
+		EXPANSION_3 = 1,
+		BIOS = 2,
+		SPU = 3,
+		CDROM = 4,
+		EXPANSION_2 = 5,
+		NUM_REGIONS = 6
+	};
+
 	virtual bool is_address_for_device(unsigned int address) final;
+	virtual const char * get_device_name() final { return "MemoryControl"; }
 
 	virtual unsigned char get_byte(unsigned int address) final;
 
 	virtual void set_byte(unsigned int address, unsigned char value) final;
+	virtual void register_io_handlers(Bus * bus) final;
+
+	// the values the registers have at power on
+	void reset();
+
+	static const unsigned int MAIN_MEMORY_READ_CYCLES = 5;
+	static const unsigned int IO_READ_CYCLES = 2;
+
+	unsigned int get_read_cycles(unsigned int address, Bus::io_width width)
+	{
+		unsigned int physical_address = address & 0x1FFFFFFF;
+		// KSEG2 only has the cache control register
+		if (address >= 0xC0000000)
+		{
+			return 0;
+		}
+
+		if (physical_address < MAIN_MEMORY_MIRROR_END)
+		{
+			return MAIN_MEMORY_READ_CYCLES;
+		}
+
+		return get_external_read_cycles(physical_address, width);
+	}
+
+	memory_delay_size get_delay_size(region delay_region) { return memory_delay_size{ registers[DELAY_SIZE_START + delay_region] }; }
+	memory_common_delay get_common_delay() { return memory_common_delay{ registers[COMMON_DELAY] }; }
+
+	// recomputed whenever the registers change, indexed by region then width
+	unsigned int region_read_cycles[NUM_REGIONS][3];
+
 private:
 
-	MemoryControl() = default;
+	MemoryControl();
 	~MemoryControl() = default;
 
+	unsigned int get_external_read_cycles(unsigned int physical_address, Bus::io_width width);
+	void update_read_cycles();
+
 	static const unsigned int MEMORY_CONTROL_1_SIZE = 36;
 	static const unsigned int MEMORY_CONTROL_2_SIZE = 4;
 
@@ -24,4 +117,17 @@ private:
 
 	static const unsigned int MEMORY_CONTROL_2_START = 0x1F801060;
 	static const unsigned int MEMORY_CONTROL_2_END = MEMORY_CONTROL_2_START + MEMORY_CONTROL_2_SIZE;
+
+	// 2MB mirrored four times
+	static const unsigned int MAIN_MEMORY_MIRROR_END = 0x00800000;
+
+	// word indices into registers, the ram size register comes last
+	static const unsigned int EXPANSION_1_BASE = 0;
+	static const unsigned int EXPANSION_2_BASE = 1;
+	static const unsigned int DELAY_SIZE_START = 2;
+	static const unsigned int COMMON_DELAY = 8;
+	static const unsigned int RAM_SIZE = 9;
+	static const unsigned int NUM_REGISTERS = 10;
+
+	unsigned int registers[NUM_REGISTERS];
 };
\ No newline at end of file
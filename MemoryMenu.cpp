@@ -26,39 +26,34 @@ void MemoryMenu::draw_menu()
 	static int address_of_interest = 0x0;
 	ImGui::InputInt("Address", &address_of_interest, 1, 100, ImGuiInputTextFlags_CharsHexadecimal);
 
-	try
+	// unsupported reads don't throw, they return 0 and leave a pending exception on the cpu
+	Cpu * cpu = Cpu::get_instance();
+	const char * cpu_exception = cpu->pending_exception;
+	cpu->pending_exception = nullptr;
+
 	{
 		std::stringstream text;
 		text << "Word: 0x" << std::hex << std::setfill('0') << std::setw(8) << bus->get_word(address_of_interest);
-		ImGui::Text(text.str().c_str());
-	}
-	catch (...)
-	{
-		ImGui::Text("Word access not supported");
+		ImGui::Text(cpu->pending_exception ? "Word access not supported" : text.str().c_str());
+		cpu->pending_exception = nullptr;
 	}
 
-	try
 	{
 		std::stringstream text;
 		text << "Halfword: 0x" << std::hex << std::setfill('0') << std::setw(4) << bus->get_halfword(address_of_interest);
-		ImGui::Text(text.str().c_str());
-	}
-	catch (...)
-	{
-		ImGui::Text("Halfword access not supported");
+		ImGui::Text(cpu->pending_exception ? "Halfword access not supported" : text.str().c_str());
+		cpu->pending_exception = nullptr;
 	}
 
-	try
 	{
 		std::stringstream text;
 		text << "Byte: 0x" << std::hex << std::setfill('0') << std::setw(2) << (unsigned int)bus->get_byte(address_of_interest);
-		ImGui::Text(text.str().c_str());
-	}
-	catch (...)
-	{
-		ImGui::Text("Byte access not supported");
+		ImGui::Text(cpu->pending_exception ? "Byte access not supported" : text.str().c_str());
+		cpu->pending_exception = nullptr;
 	}
 
+	cpu->pending_exception = cpu_exception;
+
 	static int new_value = 0x0;
 	ImGui::NewLine();
 	ImGui::InputInt("New Value", &new_value, 1, 100, ImGuiInputTextFlags_CharsHexadecimal);
@@ -7,6 +7,7 @@ public:
 	static ParallelPort * get_instance();
 
 	virtual bool is_address_for_device(unsigned int address) final;
+	virtual const char * get_device_name() final { return "ParallelPort"; }
 	virtual unsigned char get_byte(unsigned int address) final;
 	virtual void set_byte(unsigned int address, unsigned char value) final;
 private:
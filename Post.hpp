@@ -7,6 +7,7 @@ public:
 	static Post * get_instance();
 
 	virtual bool is_address_for_device(unsigned int address) final;
+	virtual const char * get_device_name() final { return "Post"; }
 
 	virtual void set_byte(unsigned int address, unsigned char value) final;
 
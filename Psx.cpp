@@ -14,9 +14,17 @@
 #include "ParallelPort.hpp"
 #include "Timers.hpp"
 #include "Post.hpp"
+#include "IdleLoopDetector.hpp"
+#include "BiosHle.hpp"
+#include "Scheduler.hpp"
+
+#ifdef PSX_FASTMEM
+#include "Fastmem.hpp"
+#endif
 
 #include <iostream>
 #include <fstream>
+#include <algorithm>
 
 static Psx * instance = nullptr;
 
@@ -55,10 +63,19 @@ bool Psx::init(std::string bios_path)
 		return false;
 	}
 
+#ifdef PSX_FASTMEM
+	if (Fastmem::get_instance()->init() == false)
+	{
+		std::cerr << "Failed to initialise fastmem\n";
+		return false;
+	}
+#endif
+
 	MemoryControl * memory_control = MemoryControl::get_instance();
 	CacheControl * cache_control = CacheControl::get_instance();
 	ParallelPort * parallel_port = ParallelPort::get_instance();
 	Timers * timers = Timers::get_instance();
+	timers->init();
 
 	// hook up the bus
 	Bus * bus = Bus::get_instance();
@@ -87,43 +104,166 @@ bool Psx::init(std::string bios_path)
 
 void Psx::tick()
 {
-	Cpu::get_instance()->tick();
-	Dma::get_instance()->tick();
-	Gpu::get_instance()->tick();
-	Cdrom::get_instance()->tick();
+	Scheduler * scheduler = Scheduler::get_instance();
+	scheduler->run_due_events();
+	step_cpu(Scheduler::NEVER);
+	scheduler->run_due_events();
+}
+
+void Psx::run_until(unsigned long long target_cycle)
+{
+	Scheduler * scheduler = Scheduler::get_instance();
+	while (scheduler->current_cycle < target_cycle)
+	{
+		// the cpu runs until the next device event, which a write can bring forward
+		unsigned long long end_cycle = std::min(target_cycle, scheduler->get_next_event_cycle());
+		while (scheduler->current_cycle < end_cycle)
+		{
+			step_cpu(end_cycle);
+			end_cycle = std::min(target_cycle, scheduler->get_next_event_cycle());
+		}
+		scheduler->run_due_events();
+	}
+}
+
+void Psx::run_frame()
+{
+	// the vblank moves if the game changes video mode, so keep going until it's actually happened
+	Gpu * gpu = Gpu::get_instance();
+	unsigned long long num_fields = gpu->num_fields;
+	while (gpu->num_fields == num_fields)
+	{
+		run_until(gpu->get_next_vblank_cycle());
+	}
+}
+
+void Psx::step_cpu(unsigned long long end_cycle)
+{
+	Scheduler * scheduler = Scheduler::get_instance();
+	Cpu * cpu = Cpu::get_instance();
+	if (is_exe_pending && cpu->current_pc == BIOS_SHELL_ENTRY)
+	{
+		pending_exe.start();
+		is_exe_pending = false;
+	}
+
+	// the devices carry on while the cpu waits for the bus
+	if (scheduler->current_cycle < cpu_stall_end_cycle)
+	{
+		unsigned long long skip_to = std::min(std::min(end_cycle, scheduler->get_next_event_cycle()), cpu_stall_end_cycle);
+		if (skip_to > scheduler->current_cycle)
+		{
+			scheduler->current_cycle = skip_to;
+			return;
+		}
+	}
+
+	scheduler->current_cycle += cpu->tick();
 
-	tick_count++;
+	// an idle loop keeps doing the same thing until the next device event, so time can go straight to it
+	if (skip_idle_loops && IdleLoopDetector::get_instance()->is_idle(cpu))
+	{
+		unsigned long long skip_to = std::min(std::min(end_cycle, scheduler->get_next_event_cycle()), scheduler->current_cycle + MAX_IDLE_CYCLES_SKIPPED);
+		if (skip_to > scheduler->current_cycle)
+		{
+			idle_cycles_skipped += skip_to - scheduler->current_cycle;
+			scheduler->current_cycle = skip_to;
+		}
+	}
 }
 
 void Psx::reset()
 {
+	Scheduler::get_instance()->reset();
+	cpu_stall_end_cycle = 0;
 	Cpu::get_instance()->reset();
+	MemoryControl::get_instance()->reset();
 	Gpu::get_instance()->reset();
+	Timers::get_instance()->reset();
 	Ram::get_instance()->reset();
 	Cdrom::get_instance()->reset();
 	Spu::get_instance()->reset();
 	Dma::get_instance()->reset();
+	CacheControl::get_instance()->reset();
+	IdleLoopDetector::get_instance()->reset();
+	BiosHle::get_instance()->reset();
 }
 
 void Psx::save_state(std::stringstream& state_stream, bool ignore_vram)
 {
+	// first so the devices load against the time they were saved at
+	Scheduler::get_instance()->save_state(state_stream);
 	Cpu::get_instance()->save_state(state_stream);
 	Gpu::get_instance()->save_state(state_stream, ignore_vram);
 	Dma::get_instance()->save_state(state_stream);
 	Ram::get_instance()->save_state(state_stream);
 	Cdrom::get_instance()->save_state(state_stream);
+	Timers::get_instance()->save_state(state_stream);
+	BiosHle::get_instance()->save_state(state_stream);
 }
 
 void Psx::load_state(std::stringstream& state_stream, bool ignore_vram)
 {
+	Scheduler::get_instance()->load_state(state_stream);
 	Cpu::get_instance()->load_state(state_stream);
 	Gpu::get_instance()->load_state(state_stream, ignore_vram);
 	Dma::get_instance()->load_state(state_stream);
 	Ram::get_instance()->load_state(state_stream);
 	Cdrom::get_instance()->load_state(state_stream);
+	Timers::get_instance()->load_state(state_stream);
+	BiosHle::get_instance()->load_state(state_stream);
+	cpu_stall_end_cycle = 0;
+
+	// the cache isn't saved, it fills again from the restored memory
+	CacheControl::get_instance()->invalidate_instruction_cache();
+	IdleLoopDetector::get_instance()->reset();
 }
 
 bool Psx::load(std::string bin_path, std::string cue_path)
 {
 	return Cdrom::get_instance()->load(bin_path, cue_path);
+}
+
+bool Psx::sideload_exe(std::string exe_path)
+{
+	is_exe_pending = pending_exe.load(exe_path);
+	return is_exe_pending;
+}
+
+bool Psx::sideload_disc_exe()
+{
+	Cdrom * cdrom = Cdrom::get_instance();
+
+	// a line like BOOT = cdrom:\SLUS_000.01;1, discs without a SYSTEM.CNF boot PSX.EXE
+	std::string boot_path = "PSX.EXE";
+	std::vector<unsigned char> system_cnf;
+	if (cdrom->filesystem.read_file(cdrom->rom_data, "SYSTEM.CNF", system_cnf))
+	{
+		std::stringstream lines(std::string(system_cnf.begin(), system_cnf.end()));
+		std::string line;
+		while (std::getline(lines, line))
+		{
+			size_t key_start = line.find_first_not_of(" \t");
+			size_t equals = line.find('=');
+			if (key_start == std::string::npos || equals == std::string::npos || line.compare(key_start, 4, "BOOT") != 0)
+			{
+				continue;
+			}
+
+			std::stringstream value(line.substr(equals + 1));
+			value >> boot_path;
+			break;
+		}
+	}
+
+	std::vector<unsigned char> exe_data;
+	if (cdrom->filesystem.read_file(cdrom->rom_data, boot_path, exe_data) == false || pending_exe.parse(exe_data) == false)
+	{
+		std::cerr << "Unable to load " << boot_path << " from the disc\n";
+		return false;
+	}
+
+	std::cout << "Booting " << boot_path << "\n";
+	is_exe_pending = true;
+	return true;
 }
\ No newline at end of file
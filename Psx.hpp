@@ -2,6 +2,7 @@
 #include <memory>
 #include <string>
 #include <sstream>
+#include "PsxExe.hpp"
 
 class Psx
 {
@@ -10,15 +11,45 @@ public:
 
 	bool init(std::string bios_path);
 	bool load(std::string bin_path, std::string cue_path);
+	// runs the cpu for one tick (an instruction or a block) and any device events which come due
 	void tick();
+	// runs until the scheduler reaches the cycle, the cpu can overshoot it by a block
+	void run_until(unsigned long long target_cycle);
+	// runs until the next vblank starts, so one field of video
+	void run_frame();
 	void reset();
 
+	// the exe runs instead of the bios' shell, the bios still sets up the kernel first
+	bool sideload_exe(std::string exe_path);
+	// the exe SYSTEM.CNF on the loaded disc boots
+	bool sideload_disc_exe();
+
 	void save_state(std::stringstream& state_stream, bool ignore_vram = false);
 	void load_state(std::stringstream& state_stream, bool ignore_vram = false);
 
-	unsigned long long tick_count = 0;
+	// cycles which were skipped because the cpu was waiting in an idle loop, the scheduler's time includes them
+	bool skip_idle_loops = true;
+	unsigned long long idle_cycles_skipped = 0;
+
+	// the cpu doesn't run again until the scheduler gets to the cycle, dma uses it while it has the bus
+	void stall_cpu_until(unsigned long long cycle) { cpu_stall_end_cycle = cycle; }
 
 private:
 	Psx() = default;
+
+	// idle loops are skipped no further than end_cycle
+	void step_cpu(unsigned long long end_cycle);
+
+	// with no device event coming up the loop can only be waiting for something which isn't emulated,
+	// time still moves on but not all at once
+	static const unsigned int MAX_IDLE_CYCLES_SKIPPED = 64 * 1024;
+
+	// where the bios jumps once the kernel is set up
+	static const unsigned int BIOS_SHELL_ENTRY = 0x80030000;
+	PsxExe pending_exe;
+	bool is_exe_pending = false;
+
+	unsigned long long cpu_stall_end_cycle = 0;
+
 	~Psx() = default;
 };
\ No newline at end of file
@@ -0,0 +1,93 @@
+#include "PsxExe.hpp"
+#include "Cpu.hpp"
+#include "Bus.hpp"
+#include "CacheControl.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include <algorithm>
+
+bool PsxExe::load(std::string exe_path)
+{
+	std::ifstream exe_file(exe_path, std::ios::binary);
+	if (exe_file.is_open() == false)
+	{
+		std::cerr << "Unable to load " << exe_path << "\n";
+		return false;
+	}
+
+	exe_file.seekg(0, exe_file.end);
+	int num_bytes = static_cast<int>(exe_file.tellg());
+	exe_file.seekg(0, exe_file.beg);
+
+	std::vector<unsigned char> data(num_bytes);
+	exe_file.read((char*)data.data(), num_bytes);
+	exe_file.close();
+
+	if (parse(data) == false)
+	{
+		std::cerr << exe_path << " isn't a PS-X EXE\n";
+		return false;
+	}
+	return true;
+}
+
+bool PsxExe::parse(const std::vector<unsigned char>& data)
+{
+	if (data.size() < HEADER_SIZE || memcmp(data.data(), "PS-X EXE", 8) != 0)
+	{
+		return false;
+	}
+
+	auto get_word = [&data](unsigned int offset)
+	{
+		return data[offset] | (data[offset + 1] << 8) | (data[offset + 2] << 16) | (data[offset + 3] << 24);
+	};
+
+	pc = get_word(0x10);
+	gp = get_word(0x14);
+	text_address = get_word(0x18);
+	unsigned int text_size = get_word(0x1C);
+	bss_address = get_word(0x28);
+	bss_size = get_word(0x2C);
+	stack_address = get_word(0x30);
+	stack_size = get_word(0x34);
+
+	// some tools pad the size in the header past the end of the file
+	text_size = std::min<unsigned int>(text_size, data.size() - HEADER_SIZE);
+	text.assign(data.begin() + HEADER_SIZE, data.begin() + HEADER_SIZE + text_size);
+	return true;
+}
+
+void PsxExe::start() const
+{
+	Bus * bus = Bus::get_instance();
+	for (unsigned int idx = 0; idx < text.size(); idx++)
+	{
+		bus->set_byte(text_address + idx, text[idx]);
+	}
+	for (unsigned int idx = 0; idx < bss_size; idx++)
+	{
+		bus->set_byte(bss_address + idx, 0);
+	}
+
+	Cpu * cpu = Cpu::get_instance();
+	cpu->register_file.set_register(28, gp);
+	if (stack_address != 0)
+	{
+		cpu->register_file.set_register(29, stack_address + stack_size);
+		cpu->register_file.set_register(30, stack_address + stack_size);
+	}
+
+	// the text went around the cache, whatever it held for those addresses is stale
+	CacheControl * cache_control = CacheControl::get_instance();
+	cache_control->invalidate_instruction_cache();
+
+	cpu->current_pc = pc;
+	cpu->next_instruction = cache_control->fetch_instruction(pc);
+	cpu->next_pc = pc + 4;
+	cpu->in_delay_slot = false;
+
+	std::cout << "Started exe at 0x" << std::hex << pc << std::dec << ", " << text.size() << " bytes of text\n";
+}
\ No newline at end of file
@@ -0,0 +1,32 @@
+#pragma once
+#include <string>
+#include <vector>
+
+// A PS-X EXE, the format of the executable a disc boots and of homebrew.
+// A 2KB header says where the text goes and what the registers start as, the text follows it.
+// ref: https://problemkaputt.de/psx-spx.htm#cdromfileformats
+class PsxExe
+{
+public:
+	bool load(std::string exe_path);
+	bool parse(const std::vector<unsigned char>& data);
+
+	// copies the text into memory and points the cpu at the entry point, the kernel has to be set up already
+	void start() const;
+
+	unsigned int pc = 0;
+	unsigned int gp = 0;
+	unsigned int text_address = 0;
+	std::vector<unsigned char> text;
+
+	// zeroed before starting
+	unsigned int bss_address = 0;
+	unsigned int bss_size = 0;
+
+	// sp is only set if the header gives a stack
+	unsigned int stack_address = 0;
+	unsigned int stack_size = 0;
+
+private:
+	static const unsigned int HEADER_SIZE = 0x800;
+};
\ No newline at end of file
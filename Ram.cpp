@@ -2,8 +2,14 @@
 #include <iostream>
 #include <sstream>
 #include <assert.h>
+#include <cstring>
+#include <algorithm>
 #include "Ram.hpp"
-#include "SystemControlCoprocessor.hpp"
+#include "CacheControl.hpp"
+
+#ifdef PSX_FASTMEM
+#include "Fastmem.hpp"
+#endif
 
 static Ram * instance = nullptr;
 
@@ -17,6 +23,25 @@ Ram * Ram::get_instance()
 	return instance;
 }
 
+Ram::Ram()
+{
+	memory = new unsigned char[MAIN_MEMORY_SIZE]();
+	scratchpad = new unsigned char[SCRATCHPAD_SIZE]();
+
+	// nothing has looked at memory yet so all of it counts as changed
+	dirty_pages.set_all();
+	memset(write_direct_pages, 1, NUM_DIRTY_PAGES);
+}
+
+Ram::~Ram()
+{
+	if (owns_memory)
+	{
+		delete[] memory;
+		delete[] scratchpad;
+	}
+}
+
 bool Ram::is_address_for_device(unsigned int address)
 {
 	if (address >= 0x0 && address < MAIN_MEMORY_SIZE)
@@ -45,45 +70,267 @@ bool Ram::is_address_for_device(unsigned int address)
 
 unsigned char Ram::get_byte(unsigned int address)
 {
-	if ((address >= 0x0 && address < MAIN_MEMORY_SIZE) ||
-		(address >= 0x80000000 && address < 0x80000000 + MAIN_MEMORY_SIZE) ||
-		(address >= 0xa0000000 && address < 0xa0000000 + MAIN_MEMORY_SIZE))
+	return *get_memory_for_address(address);
+}
+
+unsigned short Ram::get_halfword(unsigned int address)
+{
+	// misaligned accesses could run off the end of the scratchpad
+	if (address & 0x1)
 	{
-		system_control::status_register sr = SystemControlCoprocessor::get_instance()->get_control_register(system_control::register_names::SR);
-		if (sr.Isc)
+		return Bus::BusDevice::get_halfword(address);
+	}
+
+	unsigned short value = 0;
+	memcpy(&value, get_memory_for_address(address), sizeof(unsigned short));
+	return value;
+}
+
+unsigned int Ram::get_word(unsigned int address)
+{
+	if (address & 0x3)
+	{
+		return Bus::BusDevice::get_word(address);
+	}
+
+	unsigned int value = 0;
+	memcpy(&value, get_memory_for_address(address), sizeof(unsigned int));
+	return value;
+}
+
+void Ram::set_byte(unsigned int address, unsigned char value)
+{
+	*get_memory_for_write(address) = value;
+}
+
+void Ram::set_halfword(unsigned int address, unsigned short value)
+{
+	if (address & 0x1)
+	{
+		Bus::BusDevice::set_halfword(address, value);
+		return;
+	}
+
+	memcpy(get_memory_for_write(address), &value, sizeof(unsigned short));
+}
+
+void Ram::set_word(unsigned int address, unsigned int value)
+{
+	if (address & 0x3)
+	{
+		Bus::BusDevice::set_word(address, value);
+		return;
+	}
+
+	memcpy(get_memory_for_write(address), &value, sizeof(unsigned int));
+}
+
+unsigned char * Ram::get_page_memory(unsigned int address, bool for_write)
+{
+	// isolating the cache redirects main memory accesses, so they have to go through the device functions
+	if (cache_isolated == false && address < MAIN_MEMORY_SIZE)
+	{
+		if (for_write && is_page_write_direct(address >> DIRTY_PAGE_SHIFT) == false)
 		{
-			return scratchpad[address & 0x3FF];
+			return nullptr;
 		}
-		else
+
+		return &memory[address];
+	}
+
+	return nullptr;
+}
+
+void Ram::set_cache_isolated(bool isolated)
+{
+	if (cache_isolated != isolated)
+	{
+		cache_isolated = isolated;
+		Bus::get_instance()->refresh_page_memory();
+#ifdef PSX_FASTMEM
+		Fastmem::get_instance()->set_ram_accessible(isolated == false);
+#endif
+	}
+}
+
+void Ram::attach_memory(unsigned char * main_memory, unsigned char * scratchpad_memory)
+{
+	memcpy(main_memory, memory, MAIN_MEMORY_SIZE);
+	memcpy(scratchpad_memory, scratchpad, SCRATCHPAD_SIZE);
+
+	if (owns_memory)
+	{
+		delete[] memory;
+		delete[] scratchpad;
+		owns_memory = false;
+	}
+
+	memory = main_memory;
+	scratchpad = scratchpad_memory;
+	Bus::get_instance()->refresh_page_memory();
+}
+
+unsigned char * Ram::get_memory_for_address(unsigned int address)
+{
+	// main memory is mirrored in KUSEG, KSEG0 and KSEG1
+	unsigned int physical_address = address & 0x1FFFFFFF;
+	if (physical_address < MAIN_MEMORY_SIZE)
+	{
+		// with the cache isolated, main memory accesses go to the instruction cache
+		if (cache_isolated)
 		{
-			return memory[address & 0x0FFFFFFF];
+			return CacheControl::get_instance()->get_isolated_memory(address, false);
 		}
+		return &memory[physical_address];
 	}
-	else
+
+	return &scratchpad[address & 0x3FF];
+}
+
+unsigned char * Ram::get_memory_for_write(unsigned int address)
+{
+	unsigned int physical_address = address & 0x1FFFFFFF;
+	if (physical_address < MAIN_MEMORY_SIZE && cache_isolated)
+	{
+		return CacheControl::get_instance()->get_isolated_memory(address, true);
+	}
+	else if (physical_address < MAIN_MEMORY_SIZE)
 	{
-		return scratchpad[address & 0x3FF];
+		mark_page_written(physical_address >> DIRTY_PAGE_SHIFT);
 	}
+
+	return get_memory_for_address(address);
 }
 
-void Ram::set_byte(unsigned int address, unsigned char value)
+void Ram::mark_page_written(unsigned int page_index)
+{
+	bool access_changed = dirty_pages.set(page_index);
+	if (watched_pages.is_set(page_index))
+	{
+		watched_pages.clear(page_index);
+		access_changed = true;
+		if (watched_page_write)
+		{
+			watched_page_write(page_index);
+		}
+	}
+
+	// first write since the page was cleared or watched, later writes can go straight to memory
+	if (access_changed)
+	{
+		update_page_access(page_index);
+	}
+}
+
+void Ram::mark_span_written(unsigned int address, unsigned int num_bytes)
 {
-	if ((address >= 0x0 && address < MAIN_MEMORY_SIZE) ||
-		(address >= 0x80000000 && address < 0x80000000 + MAIN_MEMORY_SIZE) ||
-		(address >= 0xa0000000 && address < 0xa0000000 + MAIN_MEMORY_SIZE))
+	if (num_bytes == 0)
+	{
+		return;
+	}
+
+	unsigned int first_page = (address & MAIN_MEMORY_MASK) >> DIRTY_PAGE_SHIFT;
+	unsigned int num_pages = ((((address & MAIN_MEMORY_MASK) + num_bytes - 1) >> DIRTY_PAGE_SHIFT) - first_page) + 1;
+	for (unsigned int idx = 0; idx < num_pages && idx < NUM_DIRTY_PAGES; idx++)
 	{
-		system_control::status_register sr = SystemControlCoprocessor::get_instance()->get_control_register(system_control::register_names::SR);
-		if (sr.Isc)
+		unsigned int page_index = (first_page + idx) % NUM_DIRTY_PAGES;
+		if (is_page_write_direct(page_index) == false)
 		{
-			scratchpad[address & 0x3FF] = value;
+			mark_page_written(page_index);
 		}
-		else
+	}
+}
+
+void Ram::set_dma_word(unsigned int address, unsigned int value)
+{
+	address &= MAIN_MEMORY_MASK & ~0x3;
+	mark_span_written(address, sizeof(unsigned int));
+	memcpy(&memory[address], &value, sizeof(unsigned int));
+}
+
+void Ram::write_dma_span(unsigned int address, const unsigned char * source, unsigned int num_bytes)
+{
+	address &= MAIN_MEMORY_MASK;
+	mark_span_written(address, num_bytes);
+
+	// whatever runs off the end carries on from the start of main memory
+	unsigned int first_size = std::min(num_bytes, MAIN_MEMORY_SIZE - address);
+	memcpy(&memory[address], source, first_size);
+	memcpy(&memory[0], source + first_size, num_bytes - first_size);
+}
+
+unsigned char * Ram::get_dma_span_for_write(unsigned int address, unsigned int num_bytes)
+{
+	address &= MAIN_MEMORY_MASK;
+	assert(address + num_bytes <= MAIN_MEMORY_SIZE);
+	mark_span_written(address, num_bytes);
+	return &memory[address];
+}
+
+bool Ram::is_page_dirty(unsigned int page_index)
+{
+	return dirty_pages.is_set(page_index);
+}
+
+void Ram::get_dirty_pages(std::vector<unsigned int>& page_indices)
+{
+	dirty_pages.get_set(page_indices);
+}
+
+void Ram::clear_dirty_pages()
+{
+	std::vector<unsigned int> page_indices;
+	dirty_pages.get_set(page_indices);
+	dirty_pages.clear_all();
+
+	// take the pages away from the bus again so the next write to each of them is seen
+	for (unsigned int page_index : page_indices)
+	{
+		update_page_access(page_index);
+	}
+}
+
+void Ram::set_watched_page_write_handler(watched_page_write_handler handler)
+{
+	watched_page_write = handler;
+}
+
+void Ram::watch_page_writes(unsigned int page_index)
+{
+	if (watched_pages.set(page_index) && dirty_pages.is_set(page_index))
+	{
+		update_page_access(page_index);
+	}
+}
+
+void Ram::update_page_access(unsigned int page_index)
+{
+	write_direct_pages[page_index] = is_page_write_direct(page_index) ? 1 : 0;
+	Bus::get_instance()->refresh_page_memory(page_index << DIRTY_PAGE_SHIFT);
+#ifdef PSX_FASTMEM
+	Fastmem::get_instance()->set_ram_page_writable(page_index << DIRTY_PAGE_SHIFT, is_page_write_direct(page_index));
+#endif
+}
+
+void Ram::mark_all_dirty()
+{
+	dirty_pages.set_all();
+
+	// all of memory was replaced so whoever is watching needs to know
+	std::vector<unsigned int> page_indices;
+	watched_pages.get_set(page_indices);
+	watched_pages.clear_all();
+	for (unsigned int page_index : page_indices)
+	{
+		if (watched_page_write)
 		{
-			memory[address & 0x0FFFFFFF] = value;
+			watched_page_write(page_index);
 		}
 	}
-	else
+
+	for (unsigned int page_index = 0; page_index < NUM_DIRTY_PAGES; page_index++)
 	{
-		scratchpad[address & 0x3FF] = value;
+		update_page_access(page_index);
 	}
 }
 
@@ -95,9 +342,11 @@ void Ram::save_state(std::stringstream& file)
 void Ram::load_state(std::stringstream& file)
 {
 	file.read(reinterpret_cast<char*>(&memory[0]), sizeof(unsigned char) * MAIN_MEMORY_SIZE);
+	mark_all_dirty();
 }
 
 void Ram::reset()
 {
 	memset(memory, 0, MAIN_MEMORY_SIZE);
+	mark_all_dirty();
 }
\ No newline at end of file
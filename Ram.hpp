@@ -1,6 +1,8 @@
 #pragma once
 #include "Bus.hpp"
+#include "DirtyBitmap.hpp"
 
+#include <cstring>
 #include <string>
 #include <unordered_map>
 #include <deque>
@@ -11,21 +13,89 @@ public:
 	static Ram * get_instance();
 
 	virtual bool is_address_for_device(unsigned int address) final;
+	virtual const char * get_device_name() final { return "Ram"; }
 	virtual unsigned char get_byte(unsigned int address) final;
+	virtual unsigned short get_halfword(unsigned int address) final;
+	virtual unsigned int get_word(unsigned int address) final;
 	virtual void set_byte(unsigned int address, unsigned char value) final;
+	virtual void set_halfword(unsigned int address, unsigned short value) final;
+	virtual void set_word(unsigned int address, unsigned int value) final;
+	virtual unsigned char * get_page_memory(unsigned int address, bool for_write) final;
+
+	// cop0 tells us when the Isc bit in the status register changes
+	void set_cache_isolated(bool isolated);
+	bool is_cache_isolated() { return cache_isolated; }
+
+	// moves main memory and the scratchpad into memory owned by someone else (fastmem)
+	void attach_memory(unsigned char * main_memory, unsigned char * scratchpad_memory);
+
+	// main memory is tracked in 4KB pages, a page is dirty if it has been written since the dirty pages were last cleared
+	// while a page is clean the bus (and fastmem) send writes to it through here so they can be caught
+	static const unsigned int DIRTY_PAGE_SHIFT = 12;
+	bool is_page_dirty(unsigned int page_index);
+	void get_dirty_pages(std::vector<unsigned int>& page_indices);
+	void clear_dirty_pages();
+
+	// a watched page has its next write sent through here even if it is already dirty, the handler is called
+	// with the page index and the page stops being watched, the block cache uses this to spot code being overwritten
+	typedef void(*watched_page_write_handler)(unsigned int page_index);
+	void set_watched_page_write_handler(watched_page_write_handler handler);
+	void watch_page_writes(unsigned int page_index);
+
+	// writes to the page can skip the device entirely
+	bool is_page_write_direct(unsigned int page_index)
+	{
+		return dirty_pages.is_set(page_index) && watched_pages.is_set(page_index) == false;
+	}
+
+	// for the jit, one byte per page which is 1 if is_page_write_direct
+	const unsigned char * get_write_direct_pages() { return write_direct_pages; }
+	unsigned char * get_main_memory() { return memory; }
+
+	// dma goes straight to main memory instead of through the bus a word at a time. The word and span accesses
+	// wrap at the end of main memory and the cache being isolated doesn't affect them, writes still dirty and
+	// trip watched pages
+	unsigned int get_dma_word(unsigned int address)
+	{
+		unsigned int value = 0;
+		memcpy(&value, &memory[address & MAIN_MEMORY_MASK & ~0x3], sizeof(unsigned int));
+		return value;
+	}
+	void set_dma_word(unsigned int address, unsigned int value);
+	void write_dma_span(unsigned int address, const unsigned char * source, unsigned int num_bytes);
+	// marks the span as written and hands back its memory for the caller to fill. Unlike the others this
+	// doesn't wrap, the caller has to keep the whole span inside main memory
+	unsigned char * get_dma_span_for_write(unsigned int address, unsigned int num_bytes);
 
 	void save_state(std::stringstream& file);
 	void load_state(std::stringstream& file);
 	void reset();
 
 private:
-	Ram() = default;
-	~Ram() = default;
+	Ram();
+	~Ram();
+
+	unsigned char * get_memory_for_address(unsigned int address);
+	unsigned char * get_memory_for_write(unsigned int address);
+	void mark_all_dirty();
+	void mark_page_written(unsigned int page_index);
+	void mark_span_written(unsigned int address, unsigned int num_bytes);
+	void update_page_access(unsigned int page_index);
+
+	bool cache_isolated = false;
+	bool owns_memory = true;
 
 	static const unsigned int MAIN_MEMORY_SIZE = 1024 * 512 * 4;
+	static const unsigned int MAIN_MEMORY_MASK = MAIN_MEMORY_SIZE - 1;
 	// four SRAM chips of 512KB
-	unsigned char memory[MAIN_MEMORY_SIZE] = { 0 };
+	unsigned char * memory = nullptr;
 
 	static const unsigned int SCRATCHPAD_SIZE = 1024;
-	unsigned char scratchpad[SCRATCHPAD_SIZE];
+	unsigned char * scratchpad = nullptr;
+
+	static const unsigned int NUM_DIRTY_PAGES = MAIN_MEMORY_SIZE >> DIRTY_PAGE_SHIFT;
+	DirtyBitmap dirty_pages = DirtyBitmap(NUM_DIRTY_PAGES);
+	DirtyBitmap watched_pages = DirtyBitmap(NUM_DIRTY_PAGES);
+	unsigned char write_direct_pages[NUM_DIRTY_PAGES];
+	watched_page_write_handler watched_page_write = nullptr;
 };
\ No newline at end of file
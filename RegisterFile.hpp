@@ -1,7 +1,11 @@
 #pragma once
 #include <iostream>
 #include <sstream>
+#include <cstring>
 
+// loads write their register one instruction late, the instruction after a load still sees the old value
+// the registers hold what instructions see, a load waits in next_load until the end of its instruction
+// and then in delayed_load until the end of the following one, when it is written to the registers
 class RegisterFile
 {
 public:
@@ -9,19 +13,88 @@ public:
 	void load_state(std::stringstream& file);
 
 	void reset();
-	void tick();
 
-	unsigned int get_register(unsigned int index, bool ignore_load_delay = false);
-	void set_register(unsigned int index, unsigned int value, bool load_delay = false);
+	// called at the end of every instruction
+	void tick()
+	{
+		registers[delayed_load.index] = delayed_load.value;
+		delayed_load = next_load;
+		next_load = pending_load();
+	}
+
+	// ignore_load_delay sees loads which haven't landed yet, LWL and LWR merge with them
+	// (an empty slot matches register 0 but its value is 0 anyway)
+	unsigned int get_register(unsigned int index, bool ignore_load_delay = false)
+	{
+		if (ignore_load_delay)
+		{
+			if (next_load.index == index)
+			{
+				return next_load.value;
+			}
+
+			if (delayed_load.index == index)
+			{
+				return delayed_load.value;
+			}
+		}
+
+		return registers[index];
+	}
+
+	void set_register(unsigned int index, unsigned int value, bool load_delay = false)
+	{
+		if (index == 0)
+		{
+			return;
+		}
+
+		if (load_delay)
+		{
+			next_load.index = index;
+			next_load.value = value;
+			return;
+		}
+
+		registers[index] = value;
+
+		// a write lands before a load to the same register which is still in flight, so the load is dropped
+		if (delayed_load.index == index)
+		{
+			delayed_load = pending_load();
+		}
+		if (next_load.index == index)
+		{
+			next_load = pending_load();
+		}
+	}
+
+	// the same registers with the same loads in flight
+	bool operator==(const RegisterFile& other) const
+	{
+		return memcmp(registers, other.registers, sizeof(registers)) == 0 &&
+			delayed_load.index == other.delayed_load.index && delayed_load.value == other.delayed_load.value &&
+			next_load.index == other.next_load.index && next_load.value == other.next_load.value;
+	}
 
 	// used for debug purposes only
 	unsigned int * get_register_ref(unsigned int index)
 	{
-		return &stage_3_registers[index];
+		return &registers[index];
 	}
 
 private:
-	unsigned int stage_1_registers[32] = { 0 };
-	unsigned int stage_2_registers[32] = { 0 };
-	unsigned int stage_3_registers[32] = { 0 };
+	// the jit reads and writes the registers and the loads directly
+	friend class Jit;
+
+	// an empty slot is register 0 with a value of 0 so tick can always write it
+	struct pending_load
+	{
+		unsigned int index = 0;
+		unsigned int value = 0;
+	};
+
+	unsigned int registers[32] = { 0 };
+	pending_load delayed_load;
+	pending_load next_load;
 };
\ No newline at end of file
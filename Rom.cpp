@@ -2,6 +2,8 @@
 #include <fstream>
 #include <iostream>
 #include <string>
+#include <cstring>
+#include <algorithm>
 
 static Rom * instance = nullptr;
 
@@ -15,6 +17,19 @@ Rom * Rom::get_instance()
 	return instance;
 }
 
+Rom::Rom()
+{
+	bios = new unsigned char[BIOS_SIZE]();
+}
+
+Rom::~Rom()
+{
+	if (owns_memory)
+	{
+		delete[] bios;
+	}
+}
+
 bool Rom::is_address_for_device(unsigned int address)
 {
 	if (address >= 0x1FC00000 && address < 0x1FC00000 + BIOS_SIZE)
@@ -38,6 +53,45 @@ unsigned char Rom::get_byte(unsigned int address)
 	return bios[address & 0x000FFFFF];
 }
 
+unsigned short Rom::get_halfword(unsigned int address)
+{
+	unsigned short value = 0;
+	memcpy(&value, &bios[address & 0x000FFFFE], sizeof(unsigned short));
+	return value;
+}
+
+unsigned int Rom::get_word(unsigned int address)
+{
+	unsigned int value = 0;
+	memcpy(&value, &bios[address & 0x000FFFFC], sizeof(unsigned int));
+	return value;
+}
+
+unsigned char * Rom::get_page_memory(unsigned int address, bool for_write)
+{
+	// writes to the bios are not allowed, let them go to the device
+	if (for_write)
+	{
+		return nullptr;
+	}
+
+	return &bios[address & 0x000FFFFF];
+}
+
+void Rom::attach_memory(unsigned char * bios_memory)
+{
+	memcpy(bios_memory, bios, BIOS_SIZE);
+
+	if (owns_memory)
+	{
+		delete[] bios;
+		owns_memory = false;
+	}
+
+	bios = bios_memory;
+	Bus::get_instance()->refresh_page_memory();
+}
+
 bool Rom::load_bios(std::string bios_filepath)
 {
 	if (bios_filepath.empty() == false)
@@ -50,7 +104,7 @@ bool Rom::load_bios(std::string bios_filepath)
 			std::streampos len = bios_file.tellg();
 
 			bios_file.seekg(0, std::ios::beg);
-			bios_file.read((char*)&bios, len);
+			bios_file.read((char*)bios, std::min<std::streamoff>(len, BIOS_SIZE));
 			bios_file.close();
 		}
 		else
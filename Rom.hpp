@@ -7,15 +7,23 @@ public:
 	static Rom * get_instance();
 
 	virtual bool is_address_for_device(unsigned int address) final;
+	virtual const char * get_device_name() final { return "Rom"; }
 	virtual unsigned char get_byte(unsigned int address) final;
+	virtual unsigned short get_halfword(unsigned int address) final;
+	virtual unsigned int get_word(unsigned int address) final;
+	virtual unsigned char * get_page_memory(unsigned int address, bool for_write) final;
 
 	bool load_bios(std::string bios_filepath);
 
+	// moves the bios into memory owned by someone else (fastmem)
+	void attach_memory(unsigned char * bios_memory);
+
 private:
-	Rom() = default;
-	~Rom() = default;
+	Rom();
+	~Rom();
 
 	static const unsigned int BIOS_SIZE = 1024 * 512;
 
-	unsigned char bios[BIOS_SIZE] = { 0 };
+	unsigned char * bios = nullptr;
+	bool owns_memory = true;
 };
\ No newline at end of file
@@ -0,0 +1,178 @@
+#include "Scheduler.hpp"
+
+static Scheduler * instance = nullptr;
+
+const unsigned long long Scheduler::NEVER;
+
+Scheduler * Scheduler::get_instance()
+{
+	if (instance == nullptr)
+	{
+		instance = new Scheduler();
+	}
+
+	return instance;
+}
+
+void Scheduler::register_event(scheduler_event event, void * context, event_handler handler)
+{
+	event_entry& entry = events[static_cast<unsigned int>(event)];
+	entry.context = context;
+	entry.handler = handler;
+}
+
+void Scheduler::schedule(scheduler_event event, unsigned long long cycle)
+{
+	unsigned int index = static_cast<unsigned int>(event);
+	event_entry& entry = events[index];
+	unsigned long long previous_cycle = entry.cycle;
+	entry.cycle = cycle;
+
+	if (entry.heap_position == NOT_SCHEDULED)
+	{
+		place(heap_size, index);
+		heap_size++;
+		sift_up(entry.heap_position);
+	}
+	else if (cycle < previous_cycle)
+	{
+		sift_up(entry.heap_position);
+	}
+	else
+	{
+		sift_down(entry.heap_position);
+	}
+}
+
+void Scheduler::cancel(scheduler_event event)
+{
+	event_entry& entry = events[static_cast<unsigned int>(event)];
+	unsigned int position = entry.heap_position;
+	if (position == NOT_SCHEDULED)
+	{
+		return;
+	}
+	entry.heap_position = NOT_SCHEDULED;
+
+	// the last event fills the gap, it can belong either side of where it lands
+	heap_size--;
+	if (position < heap_size)
+	{
+		unsigned int moved = heap[heap_size];
+		place(position, moved);
+		sift_up(position);
+		if (events[moved].heap_position == position)
+		{
+			sift_down(position);
+		}
+	}
+}
+
+void Scheduler::run_due_events()
+{
+	while (heap_size > 0 && events[heap[0]].cycle <= current_cycle)
+	{
+		unsigned int index = heap[0];
+		cancel(static_cast<scheduler_event>(index));
+
+		const event_entry& entry = events[index];
+		if (entry.handler)
+		{
+			entry.handler(entry.context);
+		}
+	}
+}
+
+void Scheduler::run_events_until(unsigned long long cycle)
+{
+	while (get_next_event_cycle() <= cycle)
+	{
+		current_cycle = get_next_event_cycle();
+		run_due_events();
+	}
+	current_cycle = cycle;
+}
+
+void Scheduler::reset()
+{
+	for (unsigned int idx = 0; idx < heap_size; idx++)
+	{
+		events[heap[idx]].heap_position = NOT_SCHEDULED;
+	}
+	heap_size = 0;
+	current_cycle = 0;
+}
+
+void Scheduler::save_state(std::stringstream& file)
+{
+	file.write(reinterpret_cast<char*>(&current_cycle), sizeof(unsigned long long));
+	for (unsigned int idx = 0; idx < NUM_EVENTS; idx++)
+	{
+		bool scheduled = events[idx].heap_position != NOT_SCHEDULED;
+		file.write(reinterpret_cast<char*>(&scheduled), sizeof(bool));
+		file.write(reinterpret_cast<char*>(&events[idx].cycle), sizeof(unsigned long long));
+	}
+}
+
+void Scheduler::load_state(std::stringstream& file)
+{
+	reset();
+	file.read(reinterpret_cast<char*>(&current_cycle), sizeof(unsigned long long));
+	for (unsigned int idx = 0; idx < NUM_EVENTS; idx++)
+	{
+		bool scheduled = false;
+		unsigned long long cycle = 0;
+		file.read(reinterpret_cast<char*>(&scheduled), sizeof(bool));
+		file.read(reinterpret_cast<char*>(&cycle), sizeof(unsigned long long));
+		if (scheduled)
+		{
+			schedule(static_cast<scheduler_event>(idx), cycle);
+		}
+	}
+}
+
+void Scheduler::sift_up(unsigned int position)
+{
+	unsigned int index = heap[position];
+	while (position > 0)
+	{
+		unsigned int parent = (position - 1) / 2;
+		if (events[heap[parent]].cycle <= events[index].cycle)
+		{
+			break;
+		}
+		place(position, heap[parent]);
+		position = parent;
+	}
+	place(position, index);
+}
+
+void Scheduler::sift_down(unsigned int position)
+{
+	unsigned int index = heap[position];
+	while (true)
+	{
+		unsigned int child = position * 2 + 1;
+		if (child >= heap_size)
+		{
+			break;
+		}
+		if (child + 1 < heap_size && events[heap[child + 1]].cycle < events[heap[child]].cycle)
+		{
+			child++;
+		}
+		if (events[index].cycle <= events[heap[child]].cycle)
+		{
+			break;
+		}
+		place(position, heap[child]);
+		position = child;
+	}
+	place(position, index);
+}
+
+void Scheduler::place(unsigned int position, unsigned int index)
+{
+	heap[position] = index;
+	events[index].heap_position = position;
+}
\ No newline at end of file
@@ -0,0 +1,80 @@
+#pragma once
+#include <sstream>
+
+// every device which does something at a point in time rather than when it's accessed
+enum class scheduler_event : unsigned int
+{
+	CDROM,
+	DMA,
+	GPU,
+	TIMER0,
+	TIMER1,
+	TIMER2,
+	NUM_EVENTS
+};
+
+// Keeps the time every device runs off and each device's next event in a min-heap ordered by the cycle it's
+// due on. Psx runs the cpu in batches up to the earliest one and then runs whatever is due, so a device
+// with nothing coming up costs nothing.
+class Scheduler
+{
+public:
+	static Scheduler * get_instance();
+
+	using event_handler = void(*)(void * context);
+
+	static const unsigned long long NEVER = ~0ull;
+
+	// the handler runs once current_cycle has reached the cycle the event was scheduled for, the cpu can
+	// overshoot it by an instruction or a block
+	void register_event(scheduler_event event, void * context, event_handler handler);
+
+	// replaces whatever the event was scheduled for before
+	void schedule(scheduler_event event, unsigned long long cycle);
+	void schedule_in(scheduler_event event, unsigned long long num_cycles) { schedule(event, current_cycle + num_cycles); }
+	void cancel(scheduler_event event);
+
+	bool is_scheduled(scheduler_event event) const { return events[static_cast<unsigned int>(event)].heap_position != NOT_SCHEDULED; }
+	// still set while the handler runs, periodic events schedule the next one from it so they don't drift
+	unsigned long long get_event_cycle(scheduler_event event) const { return events[static_cast<unsigned int>(event)].cycle; }
+	unsigned long long get_next_event_cycle() const { return heap_size == 0 ? NEVER : events[heap[0]].cycle; }
+
+	// runs every event which is due in the order they're due, handlers can schedule more
+	void run_due_events();
+	// moves time on to the cycle without the cpu, running each event on the cycle it's due
+	void run_events_until(unsigned long long cycle);
+
+	// drops every event and starts time again, the handlers stay registered
+	void reset();
+
+	// the time and when each event is due, devices can still cancel or reschedule theirs as they load
+	void save_state(std::stringstream& file);
+	void load_state(std::stringstream& file);
+
+	unsigned long long current_cycle = 0;
+
+private:
+	Scheduler() = default;
+	~Scheduler() = default;
+
+	void sift_up(unsigned int position);
+	void sift_down(unsigned int position);
+	void place(unsigned int position, unsigned int index);
+
+	static const unsigned int NUM_EVENTS = static_cast<unsigned int>(scheduler_event::NUM_EVENTS);
+	static const unsigned int NOT_SCHEDULED = 0xFFFFFFFF;
+
+	struct event_entry
+	{
+		unsigned long long cycle = 0;
+		void * context = nullptr;
+		event_handler handler = nullptr;
+		unsigned int heap_position = NOT_SCHEDULED;
+	};
+
+	event_entry events[NUM_EVENTS];
+
+	// indices into events
+	unsigned int heap[NUM_EVENTS];
+	unsigned int heap_size = 0;
+};
\ No newline at end of file
@@ -0,0 +1,210 @@
+#include "SpanKernels.hpp"
+
+#ifdef PSX_SIMD
+#include <immintrin.h>
+#endif
+
+static SpanKernels * instance = nullptr;
+
+SpanKernels * SpanKernels::get_instance()
+{
+	if (instance == nullptr)
+	{
+		instance = new SpanKernels();
+	}
+
+	return instance;
+}
+
+void SpanKernels::fill_scalar(unsigned short * span, unsigned int num_pixels, unsigned short colour)
+{
+	for (unsigned int idx = 0; idx < num_pixels; idx++)
+	{
+		span[idx] = colour;
+	}
+}
+
+// the colour at a pixel is worked out from its index rather than stepped, so the simd kernels can start
+// anywhere in the span and still match
+static void shade_scalar_from(unsigned short * span, unsigned int first_idx, unsigned int num_pixels, const SpanKernels::gouraud_span& gouraud)
+{
+	for (unsigned int idx = first_idx; idx < num_pixels; idx++)
+	{
+		int pixel_idx = static_cast<int>(idx);
+		unsigned int r = static_cast<unsigned int>(gouraud.colour[0] + gouraud.colour_step[0] * pixel_idx) >> 16;
+		unsigned int g = static_cast<unsigned int>(gouraud.colour[1] + gouraud.colour_step[1] * pixel_idx) >> 16;
+		unsigned int b = static_cast<unsigned int>(gouraud.colour[2] + gouraud.colour_step[2] * pixel_idx) >> 16;
+		span[idx] = SpanKernels::to_vram_colour(r, g, b);
+	}
+}
+
+void SpanKernels::shade_scalar(unsigned short * span, unsigned int num_pixels, const gouraud_span& gouraud)
+{
+	shade_scalar_from(span, 0, num_pixels, gouraud);
+}
+
+#ifdef PSX_SIMD
+// each colour is 32 bits a lane while it's worked out, the channels are shifted straight to their place in
+// the 5:6:5 pixel and packed down to 16 bits at the end
+
+__attribute__((target("sse4.1")))
+static void fill_sse41(unsigned short * span, unsigned int num_pixels, unsigned short colour)
+{
+	__m128i colours = _mm_set1_epi16(static_cast<short>(colour));
+	unsigned int idx = 0;
+	for (; idx + 8 <= num_pixels; idx += 8)
+	{
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(span + idx), colours);
+	}
+	SpanKernels::fill_scalar(span + idx, num_pixels - idx, colour);
+}
+
+__attribute__((target("sse4.1")))
+static __m128i pack_colours_sse41(__m128i r, __m128i g, __m128i b)
+{
+	__m128i pixels = _mm_srli_epi32(r, 19);
+	pixels = _mm_or_si128(pixels, _mm_slli_epi32(_mm_srli_epi32(g, 18), 5));
+	pixels = _mm_or_si128(pixels, _mm_slli_epi32(_mm_srli_epi32(b, 19), 11));
+	return pixels;
+}
+
+__attribute__((target("sse4.1")))
+static void shade_sse41(unsigned short * span, unsigned int num_pixels, const SpanKernels::gouraud_span& gouraud)
+{
+	const __m128i lane_idx = _mm_setr_epi32(0, 1, 2, 3);
+	__m128i colours[3];
+	__m128i steps[3];
+	for (unsigned int channel = 0; channel < 3; channel++)
+	{
+		__m128i step = _mm_set1_epi32(gouraud.colour_step[channel]);
+		colours[channel] = _mm_add_epi32(_mm_set1_epi32(gouraud.colour[channel]), _mm_mullo_epi32(step, lane_idx));
+		steps[channel] = _mm_slli_epi32(step, 2);
+	}
+
+	unsigned int idx = 0;
+	for (; idx + 8 <= num_pixels; idx += 8)
+	{
+		__m128i low = pack_colours_sse41(colours[0], colours[1], colours[2]);
+		__m128i high = pack_colours_sse41(_mm_add_epi32(colours[0], steps[0]), _mm_add_epi32(colours[1], steps[1]), _mm_add_epi32(colours[2], steps[2]));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(span + idx), _mm_packus_epi32(low, high));
+
+		for (unsigned int channel = 0; channel < 3; channel++)
+		{
+			colours[channel] = _mm_add_epi32(colours[channel], _mm_slli_epi32(steps[channel], 1));
+		}
+	}
+	shade_scalar_from(span, idx, num_pixels, gouraud);
+}
+
+__attribute__((target("avx2")))
+static void fill_avx2(unsigned short * span, unsigned int num_pixels, unsigned short colour)
+{
+	__m256i colours = _mm256_set1_epi16(static_cast<short>(colour));
+	unsigned int idx = 0;
+	for (; idx + 16 <= num_pixels; idx += 16)
+	{
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(span + idx), colours);
+	}
+	SpanKernels::fill_scalar(span + idx, num_pixels - idx, colour);
+}
+
+__attribute__((target("avx2")))
+static __m256i pack_colours_avx2(__m256i r, __m256i g, __m256i b)
+{
+	__m256i pixels = _mm256_srli_epi32(r, 19);
+	pixels = _mm256_or_si256(pixels, _mm256_slli_epi32(_mm256_srli_epi32(g, 18), 5));
+	pixels = _mm256_or_si256(pixels, _mm256_slli_epi32(_mm256_srli_epi32(b, 19), 11));
+	return pixels;
+}
+
+__attribute__((target("avx2")))
+static void shade_avx2(unsigned short * span, unsigned int num_pixels, const SpanKernels::gouraud_span& gouraud)
+{
+	const __m256i lane_idx = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+	__m256i colours[3];
+	__m256i steps[3];
+	for (unsigned int channel = 0; channel < 3; channel++)
+	{
+		__m256i step = _mm256_set1_epi32(gouraud.colour_step[channel]);
+		colours[channel] = _mm256_add_epi32(_mm256_set1_epi32(gouraud.colour[channel]), _mm256_mullo_epi32(step, lane_idx));
+		steps[channel] = _mm256_slli_epi32(step, 3);
+	}
+
+	unsigned int idx = 0;
+	for (; idx + 16 <= num_pixels; idx += 16)
+	{
+		__m256i low = pack_colours_avx2(colours[0], colours[1], colours[2]);
+		__m256i high = pack_colours_avx2(_mm256_add_epi32(colours[0], steps[0]), _mm256_add_epi32(colours[1], steps[1]), _mm256_add_epi32(colours[2], steps[2]));
+
+		// packing works within each 128 bit half, the middle quarters swap back into pixel order
+		__m256i pixels = _mm256_permute4x64_epi64(_mm256_packus_epi32(low, high), 0xD8);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(span + idx), pixels);
+
+		for (unsigned int channel = 0; channel < 3; channel++)
+		{
+			colours[channel] = _mm256_add_epi32(colours[channel], _mm256_slli_epi32(steps[channel], 1));
+		}
+	}
+	shade_scalar_from(span, idx, num_pixels, gouraud);
+}
+#endif
+
+SpanKernels::SpanKernels()
+{
+	if (is_supported(kernel_set::AVX2))
+	{
+		set_kernel_set(kernel_set::AVX2);
+	}
+	else if (is_supported(kernel_set::SSE41))
+	{
+		set_kernel_set(kernel_set::SSE41);
+	}
+}
+
+bool SpanKernels::is_supported(kernel_set set) const
+{
+	switch (set)
+	{
+		case kernel_set::SCALAR:
+			return true;
+#ifdef PSX_SIMD
+		case kernel_set::SSE41:
+			return __builtin_cpu_supports("sse4.1");
+		case kernel_set::AVX2:
+			return __builtin_cpu_supports("avx2");
+#endif
+		default:
+			return false;
+	}
+}
+
+void SpanKernels::set_kernel_set(kernel_set set)
+{
+	if (is_supported(set) == false)
+	{
+		set = kernel_set::SCALAR;
+	}
+
+	current_set = set;
+	switch (set)
+	{
+#ifdef PSX_SIMD
+		case kernel_set::SSE41:
+		{
+			fill_function = fill_sse41;
+			shade_function = shade_sse41;
+		} break;
+
+		case kernel_set::AVX2:
+		{
+			fill_function = fill_avx2;
+			shade_function = shade_avx2;
+		} break;
+#endif
+		default:
+		{
+			fill_function = fill_scalar;
+			shade_function = shade_scalar;
+		} break;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,55 @@
+#pragma once
+
+// The per pixel work of the software renderer, done a row of pixels at a time once the rasterizer knows where
+// each span starts and ends. The scalar kernels are the reference, the SSE4.1 and AVX2 ones do 8 and 16 pixels
+// at a time and have to write exactly what the scalar ones would. The best set the host supports is picked
+// when the instance is created.
+class SpanKernels
+{
+public:
+	static SpanKernels * get_instance();
+
+	enum class kernel_set : unsigned int
+	{
+		SCALAR,
+		SSE41,
+		AVX2
+	};
+
+	// 16.16 fixed point colour channels (r, g, b) at the first pixel and how much they change each pixel
+	struct gouraud_span
+	{
+		int colour[3];
+		int colour_step[3];
+	};
+
+	// the display shows vram as 5:6:5
+	static unsigned short to_vram_colour(unsigned int r, unsigned int g, unsigned int b)
+	{
+		return static_cast<unsigned short>((r >> 3) | ((g >> 2) << 5) | ((b >> 3) << 11));
+	}
+
+	// SIMD kernels are only built with PSX_SIMD, and the host has to have the instructions
+	bool is_supported(kernel_set set) const;
+	// falls back to scalar if the set isn't supported
+	void set_kernel_set(kernel_set set);
+	kernel_set get_kernel_set() const { return current_set; }
+
+	void fill(unsigned short * span, unsigned int num_pixels, unsigned short colour) { fill_function(span, num_pixels, colour); }
+	// the channels must stay between 0 and 255.99 over the span
+	void shade(unsigned short * span, unsigned int num_pixels, const gouraud_span& gouraud) { shade_function(span, num_pixels, gouraud); }
+
+	static void fill_scalar(unsigned short * span, unsigned int num_pixels, unsigned short colour);
+	static void shade_scalar(unsigned short * span, unsigned int num_pixels, const gouraud_span& gouraud);
+
+private:
+	SpanKernels();
+	~SpanKernels() = default;
+
+	typedef void(*fill_kernel)(unsigned short * span, unsigned int num_pixels, unsigned short colour);
+	typedef void(*shade_kernel)(unsigned short * span, unsigned int num_pixels, const gouraud_span& gouraud);
+
+	kernel_set current_set = kernel_set::SCALAR;
+	fill_kernel fill_function = fill_scalar;
+	shade_kernel shade_function = shade_scalar;
+};
\ No newline at end of file
@@ -48,6 +48,11 @@ void Spu::set_byte(unsigned int address, unsigned char value)
 	//throw std::logic_error("not implemented");
 }
 
+void Spu::register_io_handlers(Bus * bus)
+{
+	bus->register_io_range(SPU_START, SPU_END, this);
+}
+
 void Spu::reset()
 {
 	memset(spu_control, 0, SPU_CONTROL_SIZE);
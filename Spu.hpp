@@ -10,8 +10,10 @@ public:
 	bool init();
 
 	virtual bool is_address_for_device(unsigned int address) final;
+	virtual const char * get_device_name() final { return "Spu"; }
 	virtual unsigned char get_byte(unsigned int address) final;
 	virtual void set_byte(unsigned int address, unsigned char value) final;
+	virtual void register_io_handlers(Bus * bus) final;
 
 	void reset();
 private:
@@ -6,6 +6,7 @@
 #include "Bus.hpp"
 #include "Cpu.hpp"
 #include "Cdrom.hpp"
+#include "Ram.hpp"
 
 static SystemControlCoprocessor * instance = nullptr;
 
@@ -39,7 +40,8 @@ unsigned char SystemControlCoprocessor::get_byte(unsigned int address)
 		return interrupt_mask_register.bytes[address - I_MASK_START];
 	}
 
-	throw std::logic_error("out of bounds");
+	Cpu::get_instance()->raise_pending_exception("interrupt register out of bounds");
+	return 0;
 }
 
 void SystemControlCoprocessor::set_byte(unsigned int address, unsigned char value)
@@ -47,14 +49,16 @@ void SystemControlCoprocessor::set_byte(unsigned int address, unsigned char valu
 	if (address >= I_STAT_START && address < I_STAT_END)
 	{
 		interrupt_status_register.bytes[address - I_STAT_START] &= value;
+		update_interrupt_pending();
 	}
 	else if (address >= I_MASK_START && address < I_MASK_END)
 	{
 		interrupt_mask_register.bytes[address - I_MASK_START] = value;
+		update_interrupt_pending();
 	}
 	else
 	{
-		throw std::logic_error("out of bounds");
+		Cpu::get_instance()->raise_pending_exception("interrupt register out of bounds");
 	}
 }
 
@@ -68,10 +72,9 @@ unsigned int SystemControlCoprocessor::get_word(unsigned int address)
 	{
 		return interrupt_mask_register.value;
 	}
-	else
-	{
-		throw std::logic_error("out of bounds");
-	}
+
+	Cpu::get_instance()->raise_pending_exception("interrupt register out of bounds");
+	return 0;
 }
 
 void SystemControlCoprocessor::set_word(unsigned int address, unsigned int value)
@@ -79,17 +82,42 @@ void SystemControlCoprocessor::set_word(unsigned int address, unsigned int value
 	if (address == I_STAT_START)
 	{
 		interrupt_status_register.value &= value;
+		update_interrupt_pending();
 	}
 	else if (address == I_MASK_START)
 	{
 		interrupt_mask_register.value = value;
+		update_interrupt_pending();
 	}
 	else
 	{
-		throw std::logic_error("out of bounds");
+		Cpu::get_instance()->raise_pending_exception("interrupt register out of bounds");
 	}
 }
 
+void SystemControlCoprocessor::register_io_handlers(Bus * bus)
+{
+	bus->register_io_range(I_STAT_START, I_MASK_END, this);
+
+	// I_STAT is what the bios sits polling, skip the address checks in get_word/set_word
+	bus->register_io_read(I_STAT_START, Bus::io_width::WORD, this, [](void * context, unsigned int address) -> unsigned int {
+		return static_cast<SystemControlCoprocessor*>(context)->interrupt_status_register.value;
+	});
+	bus->register_io_write(I_STAT_START, Bus::io_width::WORD, this, [](void * context, unsigned int address, unsigned int value) {
+		SystemControlCoprocessor * cop0 = static_cast<SystemControlCoprocessor*>(context);
+		cop0->interrupt_status_register.value &= value;
+		cop0->update_interrupt_pending();
+	});
+	bus->register_io_read(I_MASK_START, Bus::io_width::WORD, this, [](void * context, unsigned int address) -> unsigned int {
+		return static_cast<SystemControlCoprocessor*>(context)->interrupt_mask_register.value;
+	});
+	bus->register_io_write(I_MASK_START, Bus::io_width::WORD, this, [](void * context, unsigned int address, unsigned int value) {
+		SystemControlCoprocessor * cop0 = static_cast<SystemControlCoprocessor*>(context);
+		cop0->interrupt_mask_register.value = value;
+		cop0->update_interrupt_pending();
+	});
+}
+
 SystemControlCoprocessor::SystemControlCoprocessor()
 {
 	interrupt_status_register.value = 0x0;
@@ -104,14 +132,20 @@ SystemControlCoprocessor::~SystemControlCoprocessor()
 void SystemControlCoprocessor::save_state(std::stringstream& file)
 {
 	file.write(reinterpret_cast<char*>(&control_registers[0]), sizeof(unsigned int) * 32);
-	// todo save queue of interrupts
+	file.write(reinterpret_cast<char*>(&interrupt_status_register.value), sizeof(unsigned int));
+	file.write(reinterpret_cast<char*>(&interrupt_mask_register.value), sizeof(unsigned int));
 }
 
 void SystemControlCoprocessor::load_state(std::stringstream& file)
 {
 	file.read(reinterpret_cast<char*>(&control_registers[0]), sizeof(unsigned int) * 32);
 
-	// todo load queue of interrupts
+	system_control::status_register sr = get_control_register(system_control::register_names::SR);
+	Ram::get_instance()->set_cache_isolated(sr.Isc);
+
+	file.read(reinterpret_cast<char*>(&interrupt_status_register.value), sizeof(unsigned int));
+	file.read(reinterpret_cast<char*>(&interrupt_mask_register.value), sizeof(unsigned int));
+	update_interrupt_pending();
 }
 
 void SystemControlCoprocessor::execute(const instruction_union& instruction)
@@ -139,7 +173,7 @@ void SystemControlCoprocessor::execute(const instruction_union& instruction)
 				restore_from_exception(instruction);
 			} break;
 			default:
-				throw std::logic_error("not supported on cop0");
+				Cpu::get_instance()->raise_pending_exception("instruction not supported on cop0");
 		}
 	}
 	else
@@ -178,7 +212,7 @@ unsigned int SystemControlCoprocessor::get_control_register(system_control::regi
 void SystemControlCoprocessor::set_control_register(system_control::register_names register_name, unsigned int value)
 {
 	unsigned int index = static_cast<unsigned int>(register_name);
-	control_registers[index] = value;
+	set_control_register(index, value);
 }
 
 unsigned int SystemControlCoprocessor::get_control_register(unsigned int index)
@@ -188,7 +222,34 @@ unsigned int SystemControlCoprocessor::get_control_register(unsigned int index)
 
 void SystemControlCoprocessor::set_control_register(unsigned int index, unsigned int value)
 {
+	system_control::status_register old_sr = control_registers[static_cast<unsigned int>(system_control::register_names::SR)];
+
 	control_registers[index] = value;
+
+	system_control::status_register new_sr = control_registers[static_cast<unsigned int>(system_control::register_names::SR)];
+	if (old_sr.Isc != new_sr.Isc)
+	{
+		Ram::get_instance()->set_cache_isolated(new_sr.Isc);
+	}
+
+	if (index == static_cast<unsigned int>(system_control::register_names::SR) || index == static_cast<unsigned int>(system_control::register_names::CAUSE))
+	{
+		update_interrupt_pending();
+	}
+}
+
+void SystemControlCoprocessor::update_interrupt_pending()
+{
+	// the interrupt controller drives one line, which reaches cop0 as interrupt 2 (cause bit 10), the two
+	// below it are the software interrupts
+	unsigned int& cause_value = control_registers[static_cast<unsigned int>(system_control::register_names::CAUSE)];
+	system_control::cause_register cause = cause_value;
+	bool line_active = (interrupt_status_register.IRQ_BITS & interrupt_mask_register.IRQ_BITS) != 0;
+	cause.Ip = (cause.Ip & 0x3) | (line_active ? 0x4 : 0x0);
+	cause_value = cause.raw;
+
+	system_control::status_register sr = control_registers[static_cast<unsigned int>(system_control::register_names::SR)];
+	interrupt_pending = sr.IEc && (sr.Im & cause.Ip) != 0;
 }
 
 // LWCz rt, offset(base)
@@ -236,7 +297,7 @@ void SystemControlCoprocessor::move_control_from_cop(const instruction_union& in
 // COPz cofun
 void SystemControlCoprocessor::move_control_to_cop_fun(const instruction_union& instr)
 {
-	throw std::logic_error("not supported on cop0");
+	Cpu::get_instance()->raise_pending_exception("instruction not supported on cop0");
 }
 
 void SystemControlCoprocessor::move_to_cp0(const instruction_union& instr)
@@ -266,27 +327,19 @@ void SystemControlCoprocessor::restore_from_exception(const instruction_union& i
 void SystemControlCoprocessor::set_irq_bits(unsigned int irq_bits)
 {
 	interrupt_status_register.IRQ_BITS |= irq_bits;
-	system_control::cause_register cause = get_control_register(system_control::register_names::CAUSE);
-	cause.Ip = 0x4; // apparently the ps1 only uses 1 interrupt line and from looking at the Im of the status register, it appears to be 0x4
-	set_control_register(system_control::register_names::CAUSE, cause.raw);
+	update_interrupt_pending();
 }
 
-void SystemControlCoprocessor::trigger_interrupts()
+bool SystemControlCoprocessor::trigger_interrupts()
 {
-	system_control::status_register sr = get_control_register(system_control::register_names::SR);
-	system_control::cause_register cause = get_control_register(system_control::register_names::CAUSE);
-
-	if (cause.Ip == false) { 
-		return; 
-	}
-
-	if (interrupt_status_register.IRQ_BITS & interrupt_mask_register.IRQ_BITS)
+	if (interrupt_pending == false)
 	{
-		cause.Ip = 0;
-		set_control_register(system_control::register_names::CAUSE, cause.raw);
-
-		generate_interrupt(system_control::excode::INT);
+		return false;
 	}
+
+	// clears IEc, which clears interrupt_pending until the handler returns
+	generate_interrupt(system_control::excode::INT);
+	return true;
 }
 
 void SystemControlCoprocessor::generate_interrupt(system_control::excode excode)
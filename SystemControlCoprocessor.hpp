@@ -10,11 +10,13 @@ public:
 	static SystemControlCoprocessor * get_instance();
 
 	virtual bool is_address_for_device(unsigned int address) final;
+	virtual const char * get_device_name() final { return "Interrupt Control"; }
 
 	virtual unsigned char get_byte(unsigned int address) final;
 	virtual void set_byte(unsigned int address, unsigned char value) final;
 	virtual unsigned int get_word(unsigned int address) final;
 	virtual void set_word(unsigned int address, unsigned int value) final;
+	virtual void register_io_handlers(Bus * bus) final;
 
 	system_control::interrupt_register interrupt_status_register, interrupt_mask_register;
 
@@ -26,8 +28,13 @@ public:
 	unsigned int get_control_register(system_control::register_names register_name);
 	void set_control_register(system_control::register_names register_name, unsigned int value);
 
+	// whether the cpu should take an interrupt before its next instruction, worked out again whenever
+	// I_STAT, I_MASK, SR or CAUSE changes so the cpu only has to test it
+	bool interrupt_pending = false;
+
 	void set_irq_bits(unsigned int irq_bits);
-	void trigger_interrupts();
+	// returns true if an interrupt was raised
+	bool trigger_interrupts();
 	void generate_interrupt(system_control::excode excode);
 
 private:
@@ -43,6 +50,7 @@ private:
 
 	unsigned int get_control_register(unsigned int index);
 	void set_control_register(unsigned int index, unsigned int value);
+	void update_interrupt_pending();
 	void load_word_to_cop(const instruction_union& instr) final;
 	void store_word_from_cop(const instruction_union& instr) final;
 	void move_to_cop(const instruction_union& instr) final;
@@ -8,10 +8,11 @@ namespace system_control
 		DMA_BIT = 0x1 << 3,
 		TMR0_BIT = 0x1 << 4,
 		TMR1_BIT = 0x1 << 5,
-		CTRL_MEM_CRD_BIT = 0x1 << 6,
-		SIO_BIT = 0x1 << 7,
-		SPU_BIT = 0x1 << 8,
-		LIGHTPEN_BIT = 0x1 << 9
+		TMR2_BIT = 0x1 << 6,
+		CTRL_MEM_CRD_BIT = 0x1 << 7,
+		SIO_BIT = 0x1 << 8,
+		SPU_BIT = 0x1 << 9,
+		LIGHTPEN_BIT = 0x1 << 10
 	};
 
 	union interrupt_register
@@ -1,7 +1,35 @@
 #include "Timers.hpp"
+#include "Gpu.hpp"
+#include "Scheduler.hpp"
+#include "SystemControlCoprocessor.hpp"
 
 static Timers * instance = nullptr;
 
+namespace
+{
+	// ticks until the counter next gets to value, 0 if it never will
+	unsigned int get_ticks_until(unsigned int counter, unsigned int target, bool reset_at_target, unsigned int value)
+	{
+		// a counter written past its target has to wrap before it can reset on the target
+		if (reset_at_target && counter > target)
+		{
+			if (value > counter)
+			{
+				return value - counter;
+			}
+			return value <= target ? 0x10000 - counter + value : 0;
+		}
+
+		unsigned int period = reset_at_target ? target + 1 : 0x10000;
+		if (value >= period)
+		{
+			return 0;
+		}
+		unsigned int num_ticks = (value + period - counter) % period;
+		return num_ticks == 0 ? period : num_ticks;
+	}
+}
+
 Timers * Timers::get_instance()
 {
 	if (instance == nullptr)
@@ -23,10 +51,394 @@ bool Timers::is_address_for_device(unsigned int address)
 
 unsigned char Timers::get_byte(unsigned int address)
 {
-	// TODO
-	return 0;
+	return (get_register(address & ~0x3) >> ((address & 0x3) * 8)) & 0xFF;
 }
+
 void Timers::set_byte(unsigned int address, unsigned char value)
 {
-	// TODO
+	unsigned int shift = (address & 0x3) * 8;
+	unsigned int timer_idx = (address - TIMER_START) / TIMER_STRIDE;
+	unsigned int offset = ((address - TIMER_START) % TIMER_STRIDE) & ~0x3;
+
+	// reading the mode through get_register would clear the reached flags
+	unsigned int register_value = 0;
+	if (offset == MODE_OFFSET && timer_idx < NUM_TIMERS)
+	{
+		register_value = timers[timer_idx].mode.int_value;
+	}
+	else
+	{
+		register_value = get_register(address & ~0x3);
+	}
+	set_register(address & ~0x3, (register_value & ~(0xFF << shift)) | (value << shift));
+}
+
+void Timers::register_io_handlers(Bus * bus)
+{
+	bus->register_io_range(TIMER_START, TIMER_END, this);
+
+	// the registers are 16 bit, a halfword write mustn't be split into two writes to the mode
+	const unsigned int offsets[] = { COUNTER_OFFSET, MODE_OFFSET, TARGET_OFFSET };
+	for (unsigned int timer_idx = 0; timer_idx < NUM_TIMERS; timer_idx++)
+	{
+		for (unsigned int offset : offsets)
+		{
+			unsigned int address = TIMER_START + timer_idx * TIMER_STRIDE + offset;
+			for (Bus::io_width width : { Bus::io_width::HALFWORD, Bus::io_width::WORD })
+			{
+				bus->register_io_read(address, width, this, [](void * context, unsigned int address) -> unsigned int {
+					return static_cast<Timers*>(context)->get_register(address);
+				});
+				bus->register_io_write(address, width, this, [](void * context, unsigned int address, unsigned int value) {
+					static_cast<Timers*>(context)->set_register(address, value);
+				});
+			}
+		}
+	}
+}
+
+void Timers::init()
+{
+	for (unsigned int timer_idx = 0; timer_idx < NUM_TIMERS; timer_idx++)
+	{
+		scheduler_event event = static_cast<scheduler_event>(static_cast<unsigned int>(scheduler_event::TIMER0) + timer_idx);
+		Scheduler::get_instance()->register_event(event, &timers[timer_idx], [](void * context) {
+			Timers * timers = Timers::get_instance();
+			unsigned int timer_idx = static_cast<unsigned int>(static_cast<timer*>(context) - timers->timers);
+			timers->update(timer_idx);
+			timers->schedule_irq(timer_idx);
+		});
+	}
+
+	reset();
+}
+
+void Timers::reset()
+{
+	for (unsigned int timer_idx = 0; timer_idx < NUM_TIMERS; timer_idx++)
+	{
+		timers[timer_idx] = timer();
+		timers[timer_idx].mode.irq_not_requested = 1;
+		restart(timer_idx);
+		schedule_irq(timer_idx);
+	}
+}
+
+void Timers::save_state(std::stringstream& file)
+{
+	for (unsigned int timer_idx = 0; timer_idx < NUM_TIMERS; timer_idx++)
+	{
+		update(timer_idx);
+		timer& current = timers[timer_idx];
+		file.write(reinterpret_cast<char*>(&current.counter), sizeof(unsigned int));
+		file.write(reinterpret_cast<char*>(&current.mode.int_value), sizeof(unsigned int));
+		file.write(reinterpret_cast<char*>(&current.target), sizeof(unsigned int));
+		file.write(reinterpret_cast<char*>(&current.irq_fired), sizeof(bool));
+	}
+}
+
+void Timers::load_state(std::stringstream& file)
+{
+	for (unsigned int timer_idx = 0; timer_idx < NUM_TIMERS; timer_idx++)
+	{
+		timer& current = timers[timer_idx];
+		file.read(reinterpret_cast<char*>(&current.counter), sizeof(unsigned int));
+		file.read(reinterpret_cast<char*>(&current.mode.int_value), sizeof(unsigned int));
+		file.read(reinterpret_cast<char*>(&current.target), sizeof(unsigned int));
+		file.read(reinterpret_cast<char*>(&current.irq_fired), sizeof(bool));
+		restart(timer_idx);
+		schedule_irq(timer_idx);
+	}
+}
+
+unsigned int Timers::get_register(unsigned int address)
+{
+	unsigned int timer_idx = (address - TIMER_START) / TIMER_STRIDE;
+	unsigned int offset = (address - TIMER_START) % TIMER_STRIDE;
+	if (timer_idx >= NUM_TIMERS)
+	{
+		return 0;
+	}
+
+	timer& current = timers[timer_idx];
+	switch (offset)
+	{
+		case COUNTER_OFFSET:
+		{
+			update(timer_idx);
+			return current.counter;
+		}
+
+		case MODE_OFFSET:
+		{
+			update(timer_idx);
+			unsigned int value = current.mode.int_value;
+			current.mode.reached_target = 0;
+			current.mode.reached_max = 0;
+			return value;
+		}
+
+		case TARGET_OFFSET:
+			return current.target;
+	}
+
+	return 0;
+}
+
+void Timers::set_register(unsigned int address, unsigned int value)
+{
+	unsigned int timer_idx = (address - TIMER_START) / TIMER_STRIDE;
+	unsigned int offset = (address - TIMER_START) % TIMER_STRIDE;
+	if (timer_idx >= NUM_TIMERS)
+	{
+		return;
+	}
+
+	timer& current = timers[timer_idx];
+	switch (offset)
+	{
+		case COUNTER_OFFSET:
+		{
+			update(timer_idx);
+			restart(timer_idx);
+			current.counter = value & COUNTER_MAX;
+		} break;
+
+		case MODE_OFFSET:
+		{
+			// the reached flags are read only, writing the mode starts the count again from 0
+			update(timer_idx);
+			timer_mode mode = { value };
+			mode.irq_not_requested = 1;
+			mode.reached_target = current.mode.reached_target;
+			mode.reached_max = current.mode.reached_max;
+			mode.na = 0;
+			current.mode = mode;
+			current.counter = 0;
+			current.irq_fired = false;
+			restart(timer_idx);
+		} break;
+
+		case TARGET_OFFSET:
+		{
+			update(timer_idx);
+			current.target = value & COUNTER_MAX;
+		} break;
+
+		default:
+			return;
+	}
+
+	schedule_irq(timer_idx);
+}
+
+void Timers::on_dot_clock_changing()
+{
+	update(0);
+}
+
+void Timers::on_dot_clock_changed()
+{
+	// what's left of a tick carries over, but can't be more than a whole tick on the new clock
+	timer& current = timers[0];
+	unsigned long long divider = 7ull * Gpu::get_instance()->get_dot_clock_divider();
+	if (get_clock_source(0) == clock_source::DOT && current.fraction >= divider)
+	{
+		current.fraction = divider - 1;
+	}
+	schedule_irq(0);
+}
+
+Timers::clock_source Timers::get_clock_source(unsigned int timer_idx) const
+{
+	unsigned int source = timers[timer_idx].mode.clock_source;
+	switch (timer_idx)
+	{
+		case 0: return (source & 0x1) ? clock_source::DOT : clock_source::SYSTEM;
+		case 1: return (source & 0x1) ? clock_source::HBLANK : clock_source::SYSTEM;
+		default: return (source & 0x2) ? clock_source::SYSTEM_DIV_8 : clock_source::SYSTEM;
+	}
+}
+
+bool Timers::is_paused(unsigned int timer_idx) const
+{
+	// only timer 2's sync modes are emulated, 0 and 3 stop it
+	const timer_mode& mode = timers[timer_idx].mode;
+	return timer_idx == 2 && mode.sync_enable && (mode.sync_mode == 0 || mode.sync_mode == 3);
+}
+
+void Timers::update(unsigned int timer_idx)
+{
+	timer& current = timers[timer_idx];
+	unsigned long long current_cycle = Scheduler::get_instance()->current_cycle;
+	unsigned long long num_cycles = current_cycle - current.update_cycle;
+	current.update_cycle = current_cycle;
+	if (num_cycles == 0 || is_paused(timer_idx))
+	{
+		return;
+	}
+
+	unsigned long long num_ticks = 0;
+	switch (get_clock_source(timer_idx))
+	{
+		case clock_source::SYSTEM:
+		{
+			num_ticks = num_cycles;
+		} break;
+
+		case clock_source::SYSTEM_DIV_8:
+		{
+			unsigned long long total = num_cycles + current.fraction;
+			num_ticks = total / 8;
+			current.fraction = total % 8;
+		} break;
+
+		case clock_source::DOT:
+		{
+			unsigned long long divider = 7ull * Gpu::get_instance()->get_dot_clock_divider();
+			unsigned long long total = num_cycles * 11 + current.fraction;
+			num_ticks = total / divider;
+			current.fraction = total % divider;
+		} break;
+
+		case clock_source::HBLANK:
+		{
+			unsigned long long num_scanlines = Gpu::get_instance()->get_num_scanlines();
+			num_ticks = num_scanlines - current.update_scanline;
+			current.update_scanline = num_scanlines;
+		} break;
+	}
+
+	advance(timer_idx, num_ticks);
+}
+
+void Timers::restart(unsigned int timer_idx)
+{
+	timer& current = timers[timer_idx];
+	current.update_cycle = Scheduler::get_instance()->current_cycle;
+	current.fraction = 0;
+	current.update_scanline = get_clock_source(timer_idx) == clock_source::HBLANK ? Gpu::get_instance()->get_num_scanlines() : 0;
+}
+
+void Timers::advance(unsigned int timer_idx, unsigned long long num_ticks)
+{
+	timer& current = timers[timer_idx];
+	if (num_ticks == 0)
+	{
+		return;
+	}
+
+	bool reset_at_target = current.mode.reset_at_target;
+	unsigned int ticks_to_target = get_ticks_until(current.counter, current.target, reset_at_target, current.target);
+	unsigned int ticks_to_max = get_ticks_until(current.counter, current.target, reset_at_target, COUNTER_MAX);
+	bool passed_target = ticks_to_target != 0 && ticks_to_target <= num_ticks;
+	bool passed_max = ticks_to_max != 0 && ticks_to_max <= num_ticks;
+
+	// the counter goes round whatever its period is once it's wrapped or reset
+	unsigned int period = reset_at_target ? current.target + 1 : 0x10000;
+	if (reset_at_target && current.counter > current.target)
+	{
+		unsigned int ticks_to_wrap = 0x10000 - current.counter;
+		current.counter = num_ticks < ticks_to_wrap ? current.counter + static_cast<unsigned int>(num_ticks) : static_cast<unsigned int>((num_ticks - ticks_to_wrap) % period);
+	}
+	else
+	{
+		current.counter = static_cast<unsigned int>((current.counter + num_ticks) % period);
+	}
+
+	if (passed_target)
+	{
+		current.mode.reached_target = 1;
+		if (current.mode.irq_at_target)
+		{
+			raise_irq(timer_idx);
+		}
+	}
+	if (passed_max)
+	{
+		current.mode.reached_max = 1;
+		if (current.mode.irq_at_max)
+		{
+			raise_irq(timer_idx);
+		}
+	}
+}
+
+void Timers::raise_irq(unsigned int timer_idx)
+{
+	timer& current = timers[timer_idx];
+	if (current.mode.irq_repeat == 0 && current.irq_fired)
+	{
+		return;
+	}
+	current.irq_fired = true;
+
+	// a pulse is over before anything could read it, toggling only requests an irq every other time
+	if (current.mode.irq_toggle)
+	{
+		current.mode.irq_not_requested ^= 1;
+		if (current.mode.irq_not_requested)
+		{
+			return;
+		}
+	}
+
+	SystemControlCoprocessor::get_instance()->set_irq_bits(system_control::TMR0_BIT << timer_idx);
+}
+
+void Timers::schedule_irq(unsigned int timer_idx)
+{
+	Scheduler * scheduler = Scheduler::get_instance();
+	scheduler_event event = static_cast<scheduler_event>(static_cast<unsigned int>(scheduler_event::TIMER0) + timer_idx);
+	const timer& current = timers[timer_idx];
+
+	bool can_fire = (current.mode.irq_at_target || current.mode.irq_at_max) && (current.mode.irq_repeat || current.irq_fired == false);
+	if (can_fire == false || is_paused(timer_idx))
+	{
+		scheduler->cancel(event);
+		return;
+	}
+
+	// the number of ticks until the first irq, then the cycle that tick happens on
+	bool reset_at_target = current.mode.reset_at_target;
+	unsigned int ticks_to_target = current.mode.irq_at_target ? get_ticks_until(current.counter, current.target, reset_at_target, current.target) : 0;
+	unsigned int ticks_to_max = current.mode.irq_at_max ? get_ticks_until(current.counter, current.target, reset_at_target, COUNTER_MAX) : 0;
+	unsigned long long num_ticks = ticks_to_target == 0 || (ticks_to_max != 0 && ticks_to_max < ticks_to_target) ? ticks_to_max : ticks_to_target;
+	if (num_ticks == 0)
+	{
+		scheduler->cancel(event);
+		return;
+	}
+
+	unsigned long long irq_cycle = current.update_cycle;
+	switch (get_clock_source(timer_idx))
+	{
+		case clock_source::SYSTEM:
+		{
+			irq_cycle += num_ticks;
+		} break;
+
+		case clock_source::SYSTEM_DIV_8:
+		{
+			irq_cycle += num_ticks * 8 - current.fraction;
+		} break;
+
+		case clock_source::DOT:
+		{
+			unsigned long long divider = 7ull * Gpu::get_instance()->get_dot_clock_divider();
+			irq_cycle += (num_ticks * divider - current.fraction + 10) / 11;
+		} break;
+
+		case clock_source::HBLANK:
+		{
+			irq_cycle = Gpu::get_instance()->get_num_scanlines_cycle(current.update_scanline + num_ticks);
+		} break;
+	}
+
+	// the gpu's estimate of a later field can be early, the event just checks again
+	if (irq_cycle <= scheduler->current_cycle)
+	{
+		irq_cycle = scheduler->current_cycle + 1;
+	}
+	scheduler->schedule(event, irq_cycle);
 }
\ No newline at end of file
@@ -1,14 +1,63 @@
 #pragma once
+#include <sstream>
 #include "Bus.hpp"
 
+union timer_mode
+{
+	unsigned int int_value;
+	struct
+	{
+		unsigned int sync_enable : 1;
+		unsigned int sync_mode : 2;
+		unsigned int reset_at_target : 1;
+		unsigned int irq_at_target : 1;
+		unsigned int irq_at_max : 1;
+		unsigned int irq_repeat : 1;
+		unsigned int irq_toggle : 1;
+		unsigned int clock_source : 2;
+		// 0 while an irq is being requested
+		unsigned int irq_not_requested : 1;
+		// both cleared when the mode is read
+		unsigned int reached_target : 1;
+		unsigned int reached_max : 1;
+		unsigned int na : 19;
+	};
+};
+
+// The three root counters. They're never ticked, each one remembers its value at the cycle it was last
+// brought up to date and works out how far it's counted since when it's accessed. Irqs are scheduled
+// for the cycle the counter gets to its target or 0xFFFF.
 class Timers : public Bus::BusDevice
 {
 public:
 	static Timers * get_instance();
 
 	virtual bool is_address_for_device(unsigned int address) final;
+	virtual const char * get_device_name() final { return "Timers"; }
 	virtual unsigned char get_byte(unsigned int address) final;
 	virtual void set_byte(unsigned int address, unsigned char value) final;
+	virtual void register_io_handlers(Bus * bus) final;
+
+	void init();
+	void reset();
+	void save_state(std::stringstream& file);
+	void load_state(std::stringstream& file);
+
+	static const unsigned int NUM_TIMERS = 3;
+
+	// the register is one of COUNTER_OFFSET, MODE_OFFSET or TARGET_OFFSET from the timer's base
+	unsigned int get_register(unsigned int address);
+	void set_register(unsigned int address, unsigned int value);
+
+	// the gpu calls these either side of changing the resolution, timer 0 counts up to then on the old dot
+	// clock and its irq is scheduled again on the new one
+	void on_dot_clock_changing();
+	void on_dot_clock_changed();
+
+	static const unsigned int COUNTER_OFFSET = 0x0;
+	static const unsigned int MODE_OFFSET = 0x4;
+	static const unsigned int TARGET_OFFSET = 0x8;
+
 private:
 	Timers() = default;
 	~Timers() = default;
@@ -16,4 +65,43 @@ private:
 	static const unsigned int TIMER_SIZE = 45;
 	static const unsigned int TIMER_START = 0x1F801100;
 	static const unsigned int TIMER_END = TIMER_START + TIMER_SIZE;
+	static const unsigned int TIMER_STRIDE = 0x10;
+
+	static const unsigned int COUNTER_MAX = 0xFFFF;
+
+	enum class clock_source : unsigned int
+	{
+		SYSTEM,
+		SYSTEM_DIV_8,
+		DOT,
+		HBLANK
+	};
+
+	struct timer
+	{
+		unsigned int counter = 0;
+		timer_mode mode = { 0 };
+		unsigned int target = 0;
+
+		// where counter was worked out up to, the fraction is what's left of a tick for the clocks slower than the cpu
+		unsigned long long update_cycle = 0;
+		unsigned long long fraction = 0;
+		unsigned long long update_scanline = 0;
+
+		// one shot irqs don't fire again until the mode is written
+		bool irq_fired = false;
+	};
+
+	timer timers[NUM_TIMERS];
+
+	clock_source get_clock_source(unsigned int timer_idx) const;
+	bool is_paused(unsigned int timer_idx) const;
+
+	// counts the timer up to the current cycle, raising whatever irqs it passes on the way
+	void update(unsigned int timer_idx);
+	// starts counting again from the current cycle, for when the clock source or the counter has changed
+	void restart(unsigned int timer_idx);
+	void advance(unsigned int timer_idx, unsigned long long num_ticks);
+	void raise_irq(unsigned int timer_idx);
+	void schedule_irq(unsigned int timer_idx);
 };
\ No newline at end of file
@@ -0,0 +1,52 @@
+#pragma once
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+
+// very small harness for timing the hot paths of the emulator
+// every benchmark reports how many operations it got through per second
+class Benchmark
+{
+public:
+	typedef void(*benchmark_function)();
+
+	struct Registrar
+	{
+		Registrar(const char * name, benchmark_function function)
+		{
+			get_benchmarks().push_back({ name, function });
+		}
+	};
+
+	static std::vector<std::pair<std::string, benchmark_function>>& get_benchmarks()
+	{
+		static std::vector<std::pair<std::string, benchmark_function>> benchmarks;
+		return benchmarks;
+	}
+
+	template <class Function>
+	static double measure(const std::string& name, unsigned long long num_operations, Function function)
+	{
+		auto start_time = std::chrono::high_resolution_clock::now();
+		function();
+		auto end_time = std::chrono::high_resolution_clock::now();
+
+		double seconds = std::chrono::duration<double>(end_time - start_time).count();
+		double operations_per_second = num_operations / seconds;
+
+		std::cout << "  " << std::left << std::setw(40) << name << std::right << std::fixed << std::setprecision(2)
+			<< std::setw(10) << operations_per_second / 1000000.0 << " M/s" << std::endl;
+
+		return operations_per_second;
+	}
+
+	// stops the compiler from throwing away results that are never used
+	static volatile unsigned int sink;
+};
+
+#define BENCHMARK_CASE(name) \
+	static void name(); \
+	static Benchmark::Registrar name##_registrar(#name, name); \
+	static void name()
\ No newline at end of file
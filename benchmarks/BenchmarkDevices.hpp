@@ -0,0 +1,36 @@
+#pragma once
+#include <vector>
+
+#include "../Bus.hpp"
+#include "../Ram.hpp"
+#include "../Rom.hpp"
+#include "../Dma.hpp"
+#include "../Gpu.hpp"
+#include "../Spu.hpp"
+#include "../Cdrom.hpp"
+#include "../MemoryControl.hpp"
+#include "../CacheControl.hpp"
+#include "../ParallelPort.hpp"
+#include "../Timers.hpp"
+#include "../Post.hpp"
+#include "../SystemControlCoprocessor.hpp"
+
+// same devices in the same order as Psx::init, registered with the bus the first time they are asked for
+inline std::vector<Bus::BusDevice*>& get_bus_devices()
+{
+	static std::vector<Bus::BusDevice*> devices;
+	if (devices.empty())
+	{
+		devices = {
+			Cdrom::get_instance(), Ram::get_instance(), Rom::get_instance(), MemoryControl::get_instance(),
+			CacheControl::get_instance(), Spu::get_instance(), ParallelPort::get_instance(), Timers::get_instance(),
+			Dma::get_instance(), Gpu::get_instance(), Post::get_instance(), SystemControlCoprocessor::get_instance()
+		};
+
+		for (Bus::BusDevice * device : devices)
+		{
+			Bus::get_instance()->register_device(device);
+		}
+	}
+	return devices;
+}
\ No newline at end of file
@@ -0,0 +1,91 @@
+#include "Benchmark.hpp"
+
+#include "BenchmarkDevices.hpp"
+
+namespace
+{
+	const unsigned long long NUM_ACCESSES = 20000000;
+
+	struct bus_region
+	{
+		const char * name;
+		unsigned int address;
+		// keeps the accesses inside registers that exist
+		unsigned int word_offset_mask;
+	};
+
+	const bus_region regions[] = {
+		{ "RAM", 0x80010000, 0x3FF },
+		{ "Scratchpad", 0x1F800000, 0xFF },
+		{ "BIOS", 0xBFC00000, 0x3FF },
+		{ "I/O (I_STAT)", 0x1F801070, 0x0 },
+		{ "I/O (GPUSTAT)", 0x1F801814, 0x0 },
+		{ "I/O (DMA channels)", 0x1F801080, 0xF }
+	};
+
+	// how the bus used to find devices, asking each one in turn if it owns the address
+	Bus::BusDevice * linear_scan(std::vector<Bus::BusDevice*>& devices, unsigned int address)
+	{
+		for (Bus::BusDevice * device : devices)
+		{
+			if (device->is_address_for_device(address))
+			{
+				return device;
+			}
+		}
+		return nullptr;
+	}
+}
+
+BENCHMARK_CASE(bus_word_reads)
+{
+	std::vector<Bus::BusDevice*>& devices = get_bus_devices();
+	Bus * bus = Bus::get_instance();
+
+	for (const bus_region& region : regions)
+	{
+		Benchmark::measure(std::string(region.name) + " linear device scan", NUM_ACCESSES, [&]() {
+			unsigned int sum = 0;
+			for (unsigned long long idx = 0; idx < NUM_ACCESSES; idx++)
+			{
+				unsigned int address = region.address + ((idx & region.word_offset_mask) * 4);
+				sum += linear_scan(devices, address)->get_word(address);
+			}
+			Benchmark::sink = sum;
+		});
+
+		Benchmark::measure(std::string(region.name) + " page table", NUM_ACCESSES, [&]() {
+			unsigned int sum = 0;
+			for (unsigned long long idx = 0; idx < NUM_ACCESSES; idx++)
+			{
+				unsigned int address = region.address + ((idx & region.word_offset_mask) * 4);
+				sum += bus->get_word(address);
+			}
+			Benchmark::sink = sum;
+		});
+	}
+}
+
+BENCHMARK_CASE(bus_word_writes)
+{
+	std::vector<Bus::BusDevice*>& devices = get_bus_devices();
+	Bus * bus = Bus::get_instance();
+
+	const bus_region& region = regions[0];
+
+	Benchmark::measure(std::string(region.name) + " linear device scan", NUM_ACCESSES, [&]() {
+		for (unsigned long long idx = 0; idx < NUM_ACCESSES; idx++)
+		{
+			unsigned int address = region.address + ((idx & region.word_offset_mask) * 4);
+			linear_scan(devices, address)->set_word(address, static_cast<unsigned int>(idx));
+		}
+	});
+
+	Benchmark::measure(std::string(region.name) + " page table", NUM_ACCESSES, [&]() {
+		for (unsigned long long idx = 0; idx < NUM_ACCESSES; idx++)
+		{
+			unsigned int address = region.address + ((idx & region.word_offset_mask) * 4);
+			bus->set_word(address, static_cast<unsigned int>(idx));
+		}
+	});
+}
\ No newline at end of file
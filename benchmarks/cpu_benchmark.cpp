@@ -0,0 +1,175 @@
+#include "Benchmark.hpp"
+#include "BenchmarkDevices.hpp"
+#include <cstdlib>
+#include "../Psx.hpp"
+#include "../Cpu.hpp"
+#include "../BlockCache.hpp"
+#include "../InstructionTypes.hpp"
+
+#ifdef PSX_FASTMEM
+#include "../Fastmem.hpp"
+#endif
+
+namespace
+{
+	const unsigned long long NUM_INSTRUCTIONS = 20000000;
+	const unsigned long long NUM_FIELDS = 300;
+	const unsigned int PROGRAM_ADDRESS = 0x80010000;
+
+#ifdef PSX_JIT
+	const cpu_mode modes[] = { cpu_mode::INTERPRETER, cpu_mode::CACHED_INTERPRETER, cpu_mode::JIT };
+#else
+	const cpu_mode modes[] = { cpu_mode::INTERPRETER, cpu_mode::CACHED_INTERPRETER };
+#endif
+
+	const char * get_mode_name(cpu_mode mode)
+	{
+		switch (mode)
+		{
+			case cpu_mode::INTERPRETER: return "interpreter";
+			case cpu_mode::CACHED_INTERPRETER: return "cached interpreter";
+			default: return "jit";
+		}
+	}
+
+	// the same setup as Psx::init, minus registering the devices which get_bus_devices has done
+	bool init_devices()
+	{
+		static bool initialised = false;
+		get_bus_devices();
+		if (initialised == false)
+		{
+			Gpu::get_instance()->init();
+			Spu::get_instance()->init();
+			Cdrom::get_instance()->init();
+			Dma::get_instance()->init();
+#ifdef PSX_FASTMEM
+			if (Fastmem::get_instance()->init() == false)
+			{
+				return false;
+			}
+#endif
+			initialised = true;
+		}
+		return true;
+	}
+
+	// runs from start_pc until the cpu has executed num_instructions
+	void run(cpu_mode mode, unsigned int start_pc, unsigned long long num_instructions)
+	{
+		Psx * psx = Psx::get_instance();
+		Cpu * cpu = Cpu::get_instance();
+
+		cpu->set_mode(mode);
+		cpu->current_pc = start_pc;
+		cpu->next_pc = start_pc;
+		unsigned long long end_count = cpu->instruction_count + num_instructions;
+
+		Benchmark::measure(get_mode_name(mode), num_instructions, [&]() {
+			while (cpu->instruction_count < end_count)
+			{
+				psx->tick();
+			}
+		});
+	}
+
+	// sums a 1KB table into a second one, over and over
+	void load_guest_loop()
+	{
+		std::vector<instruction_union> program = {
+			// start:
+			instruction_union(cpu_instructions::LUI, 0, 8, 0x8002),
+			instruction_union(cpu_instructions::ORI, 0, 9, 256),
+			// loop:
+			instruction_union(cpu_instructions::LW, 8, 10, 0),
+			instruction_union(cpu_instructions::SPECIAL, 11, 10, 11, 0, cpu_special_funcs::ADDU),
+			instruction_union(cpu_instructions::SW, 8, 11, 0x400),
+			instruction_union(cpu_instructions::ADDIU, 8, 8, 4),
+			instruction_union(cpu_instructions::ADDIU, 9, 9, 0xFFFF),
+			instruction_union(cpu_instructions::BNE, 9, 0, 0xFFFA),
+			instruction_union(cpu_instructions::SPECIAL, 0, 0, 0, 0, cpu_special_funcs::SLL),
+			instruction_union(cpu_instructions::J, (PROGRAM_ADDRESS & 0x0FFFFFFF) >> 2),
+			instruction_union(cpu_instructions::SPECIAL, 0, 0, 0, 0, cpu_special_funcs::SLL)
+		};
+
+		Bus * bus = Bus::get_instance();
+		for (unsigned int idx = 0; idx < program.size(); idx++)
+		{
+			bus->set_word(PROGRAM_ADDRESS + idx * 4, program[idx].raw);
+		}
+	}
+}
+
+BENCHMARK_CASE(cpu_guest_loop)
+{
+	if (init_devices() == false)
+	{
+		std::cout << "  unable to initialise the devices" << std::endl;
+		return;
+	}
+
+	for (cpu_mode mode : modes)
+	{
+		Psx::get_instance()->reset();
+		load_guest_loop();
+		run(mode, PROGRAM_ADDRESS, NUM_INSTRUCTIONS);
+	}
+
+	Cpu::get_instance()->set_mode(cpu_mode::INTERPRETER);
+}
+
+// whole fields of the guest loop the way a frontend runs it, in emulated cycles so full speed is 33.87 M/s
+BENCHMARK_CASE(psx_guest_fields)
+{
+	if (init_devices() == false)
+	{
+		std::cout << "  unable to initialise the devices" << std::endl;
+		return;
+	}
+
+	for (cpu_mode mode : modes)
+	{
+		Psx * psx = Psx::get_instance();
+		Cpu * cpu = Cpu::get_instance();
+		psx->reset();
+		load_guest_loop();
+		cpu->set_mode(mode);
+		cpu->current_pc = PROGRAM_ADDRESS;
+		cpu->next_pc = PROGRAM_ADDRESS;
+
+		unsigned long long num_cycles = static_cast<unsigned long long>(NUM_FIELDS * Gpu::CPU_CLOCK / Gpu::get_instance()->get_field_rate());
+		Benchmark::measure(get_mode_name(mode), num_cycles, [&]() {
+			for (unsigned long long idx = 0; idx < NUM_FIELDS; idx++)
+			{
+				psx->run_frame();
+			}
+		});
+	}
+
+	Cpu::get_instance()->set_mode(cpu_mode::INTERPRETER);
+}
+
+// set PSX_BIOS to the path of a bios image to run this one
+BENCHMARK_CASE(cpu_bios_boot)
+{
+	const char * bios_path = std::getenv("PSX_BIOS");
+	if (bios_path == nullptr)
+	{
+		std::cout << "  skipped, PSX_BIOS is not set" << std::endl;
+		return;
+	}
+
+	if (init_devices() == false || Rom::get_instance()->load_bios(bios_path) == false)
+	{
+		std::cout << "  unable to load " << bios_path << std::endl;
+		return;
+	}
+
+	for (cpu_mode mode : modes)
+	{
+		Psx::get_instance()->reset();
+		run(mode, static_cast<unsigned int>(system_control::exception_vector::RESET), NUM_INSTRUCTIONS);
+	}
+
+	Cpu::get_instance()->set_mode(cpu_mode::INTERPRETER);
+}
\ No newline at end of file
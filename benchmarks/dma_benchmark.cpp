@@ -0,0 +1,89 @@
+#include "Benchmark.hpp"
+
+#include "BenchmarkDevices.hpp"
+
+namespace
+{
+	// the size games use for their ordering tables, cleared once a frame
+	const unsigned int TABLE_ENTRIES = 2048;
+	const unsigned int NUM_TABLES = 5000;
+	const unsigned int TABLE_END_ADDRESS = 0x100000 + (TABLE_ENTRIES - 1) * 4;
+
+	const unsigned int SECTOR_SIZE = 2048;
+	const unsigned int SECTORS_PER_READ = 64;
+	const unsigned int NUM_READS = 500;
+	const unsigned int READ_ADDRESS = 0x80000;
+}
+
+BENCHMARK_CASE(dma_ordering_table)
+{
+	get_bus_devices();
+	Bus * bus = Bus::get_instance();
+
+	// how OTC used to clear a table, a word at a time through the bus
+	Benchmark::measure("bus per word", static_cast<unsigned long long>(NUM_TABLES) * TABLE_ENTRIES, [&]() {
+		for (unsigned int table_idx = 0; table_idx < NUM_TABLES; table_idx++)
+		{
+			unsigned int addr = TABLE_END_ADDRESS;
+			for (unsigned int num_words = TABLE_ENTRIES; num_words > 0; num_words--)
+			{
+				bus->set_word(addr, num_words == 1 ? 0xffffffff : (addr - 4) & 0x1fffff);
+				addr -= 4;
+			}
+		}
+		Benchmark::sink = bus->get_word(TABLE_END_ADDRESS);
+	});
+
+	Benchmark::measure("direct span", static_cast<unsigned long long>(NUM_TABLES) * TABLE_ENTRIES, [&]() {
+		for (unsigned int table_idx = 0; table_idx < NUM_TABLES; table_idx++)
+		{
+			DMA_base_address base_address;
+			base_address.int_value = TABLE_END_ADDRESS;
+			DMA_block_control block_control;
+			block_control.int_value = TABLE_ENTRIES;
+			DMA_channel_control channel_control;
+			channel_control.int_value = 0x11000002;
+			Dma::get_instance()->sync_mode_manual(base_address, block_control, channel_control);
+		}
+		Benchmark::sink = bus->get_word(TABLE_END_ADDRESS);
+	});
+}
+
+BENCHMARK_CASE(dma_cdrom_sectors)
+{
+	get_bus_devices();
+	Ram * ram = Ram::get_instance();
+
+	unsigned char sector_data[SECTOR_SIZE];
+	for (unsigned int idx = 0; idx < SECTOR_SIZE; idx++)
+	{
+		sector_data[idx] = static_cast<unsigned char>(idx * 7);
+	}
+
+	// reported in bytes, how the cdrom channel used to copy a sector a byte at a time
+	Benchmark::measure("ram per byte", static_cast<unsigned long long>(NUM_READS) * SECTORS_PER_READ * SECTOR_SIZE, [&]() {
+		for (unsigned int read_idx = 0; read_idx < NUM_READS; read_idx++)
+		{
+			for (unsigned int sector_idx = 0; sector_idx < SECTORS_PER_READ; sector_idx++)
+			{
+				unsigned int address = READ_ADDRESS + sector_idx * SECTOR_SIZE;
+				for (unsigned int idx = 0; idx < SECTOR_SIZE; idx++)
+				{
+					ram->set_byte(address + idx, sector_data[idx]);
+				}
+			}
+		}
+		Benchmark::sink = ram->get_word(READ_ADDRESS);
+	});
+
+	Benchmark::measure("direct span", static_cast<unsigned long long>(NUM_READS) * SECTORS_PER_READ * SECTOR_SIZE, [&]() {
+		for (unsigned int read_idx = 0; read_idx < NUM_READS; read_idx++)
+		{
+			for (unsigned int sector_idx = 0; sector_idx < SECTORS_PER_READ; sector_idx++)
+			{
+				ram->write_dma_span(READ_ADDRESS + sector_idx * SECTOR_SIZE, sector_data, SECTOR_SIZE);
+			}
+		}
+		Benchmark::sink = ram->get_word(READ_ADDRESS);
+	});
+}
\ No newline at end of file
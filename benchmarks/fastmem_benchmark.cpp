@@ -0,0 +1,91 @@
+#include "Benchmark.hpp"
+
+#ifdef PSX_FASTMEM
+#include "BenchmarkDevices.hpp"
+#include "../Fastmem.hpp"
+
+namespace
+{
+	const unsigned long long NUM_ACCESSES = 20000000;
+
+	struct fastmem_region
+	{
+		const char * name;
+		unsigned int address;
+		unsigned int word_offset_mask;
+		// fewer accesses where every one of them has to go through the fault handler
+		unsigned long long num_accesses;
+	};
+
+	const fastmem_region regions[] = {
+		{ "RAM", 0x80010000, 0x3FF, NUM_ACCESSES },
+		{ "Scratchpad", 0x1F800000, 0xFF, NUM_ACCESSES },
+		{ "BIOS", 0xBFC00000, 0x3FF, NUM_ACCESSES },
+		{ "I/O (I_STAT)", 0x1F801070, 0x0, NUM_ACCESSES / 100 }
+	};
+
+	Fastmem * get_fastmem()
+	{
+		static bool initialised = false;
+		get_bus_devices();
+		if (initialised == false)
+		{
+			initialised = Fastmem::get_instance()->init();
+		}
+		return Fastmem::get_instance();
+	}
+}
+
+BENCHMARK_CASE(fastmem_word_reads)
+{
+	Fastmem * fastmem = get_fastmem();
+	Bus * bus = Bus::get_instance();
+
+	for (const fastmem_region& region : regions)
+	{
+		Benchmark::measure(std::string(region.name) + " page table", region.num_accesses, [&]() {
+			unsigned int sum = 0;
+			for (unsigned long long idx = 0; idx < region.num_accesses; idx++)
+			{
+				unsigned int address = region.address + ((idx & region.word_offset_mask) * 4);
+				sum += bus->get_word(address);
+			}
+			Benchmark::sink = sum;
+		});
+
+		Benchmark::measure(std::string(region.name) + " fastmem", region.num_accesses, [&]() {
+			unsigned int sum = 0;
+			for (unsigned long long idx = 0; idx < region.num_accesses; idx++)
+			{
+				unsigned int address = region.address + ((idx & region.word_offset_mask) * 4);
+				sum += fastmem->get_word(address);
+			}
+			Benchmark::sink = sum;
+		});
+	}
+}
+
+BENCHMARK_CASE(fastmem_word_writes)
+{
+	Fastmem * fastmem = get_fastmem();
+	Bus * bus = Bus::get_instance();
+
+	const fastmem_region& region = regions[0];
+
+	Benchmark::measure(std::string(region.name) + " page table", region.num_accesses, [&]() {
+		for (unsigned long long idx = 0; idx < region.num_accesses; idx++)
+		{
+			unsigned int address = region.address + ((idx & region.word_offset_mask) * 4);
+			bus->set_word(address, static_cast<unsigned int>(idx));
+		}
+	});
+
+	Benchmark::measure(std::string(region.name) + " fastmem", region.num_accesses, [&]() {
+		for (unsigned long long idx = 0; idx < region.num_accesses; idx++)
+		{
+			unsigned int address = region.address + ((idx & region.word_offset_mask) * 4);
+			fastmem->set_word(address, static_cast<unsigned int>(idx));
+		}
+	});
+}
+#endif
\ No newline at end of file
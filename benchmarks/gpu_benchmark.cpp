@@ -0,0 +1,150 @@
+#include "Benchmark.hpp"
+
+#include "BenchmarkDevices.hpp"
+#include "../SpanKernels.hpp"
+
+namespace
+{
+	const unsigned int GP0_ADDRESS = 0x1F801810;
+	const unsigned int SHADED_4_PT = 0x38;
+
+	const int QUAD_WIDTH = 256;
+	const int QUAD_HEIGHT = 128;
+	const unsigned int NUM_QUADS = 2000;
+
+	const unsigned int SPAN_LENGTH = 256;
+	const unsigned int NUM_SPANS = 400000;
+
+	struct vertex
+	{
+		int x;
+		int y;
+		unsigned char r;
+		unsigned char g;
+		unsigned char b;
+	};
+
+	const vertex quad[4] = {
+		{ 16, 16, 0xFF, 0x00, 0x00 },
+		{ 16 + QUAD_WIDTH, 16, 0x00, 0xFF, 0x00 },
+		{ 16, 16 + QUAD_HEIGHT, 0x00, 0x00, 0xFF },
+		{ 16 + QUAD_WIDTH, 16 + QUAD_HEIGHT, 0xFF, 0xFF, 0xFF }
+	};
+
+	// how triangles used to be drawn, barycentric weights in floats for every pixel of the bounding box and the
+	// draw area and vram checked for each one that's drawn
+	void draw_triangle_barycentric(unsigned short * video_ram, const vertex& v0, const vertex& v1, const vertex& v2)
+	{
+		int min_x = std::min(v0.x, std::min(v1.x, v2.x));
+		int max_x = std::max(v0.x, std::max(v1.x, v2.x));
+		int min_y = std::min(v0.y, std::min(v1.y, v2.y));
+		int max_y = std::max(v0.y, std::max(v1.y, v2.y));
+
+		float d = static_cast<float>((v1.y - v2.y) * (v0.x - v2.x) + (v2.x - v1.x) * (v0.y - v2.y));
+		for (int y = min_y; y <= max_y; y++)
+		{
+			for (int x = min_x; x <= max_x; x++)
+			{
+				float w0 = ((v1.y - v2.y) * (x - v2.x) + (v2.x - v1.x) * (y - v2.y)) / d;
+				float w1 = ((v2.y - v0.y) * (x - v2.x) + (v0.x - v2.x) * (y - v2.y)) / d;
+				float w2 = 1 - w0 - w1;
+				if (w0 >= 0 && w1 >= 0 && (w0 + w1 <= 1))
+				{
+					unsigned char r = static_cast<unsigned char>(v0.r * w0 + v1.r * w1 + v2.r * w2);
+					unsigned char g = static_cast<unsigned char>(v0.g * w0 + v1.g * w1 + v2.g * w2);
+					unsigned char b = static_cast<unsigned char>(v0.b * w0 + v1.b * w1 + v2.b * w2);
+					if (x >= 0 && x < static_cast<int>(Gpu::FRAME_WIDTH) && y >= 0 && y < static_cast<int>(Gpu::FRAME_HEIGHT))
+					{
+						video_ram[y * Gpu::FRAME_WIDTH + x] = (r >> 3) | ((g >> 2) << 5) | ((b >> 3) << 11);
+					}
+				}
+			}
+		}
+	}
+}
+
+BENCHMARK_CASE(gpu_shaded_quads)
+{
+	get_bus_devices();
+	Bus * bus = Bus::get_instance();
+	Gpu * gpu = Gpu::get_instance();
+	if (gpu->video_ram == nullptr)
+	{
+		gpu->init();
+	}
+	gpu->reset();
+	bus->set_word(GP0_ADDRESS, 0xE3000000);
+	bus->set_word(GP0_ADDRESS, 0xE4000000 | ((Gpu::FRAME_HEIGHT - 1) << 10) | (Gpu::FRAME_WIDTH - 1));
+
+	// reported in pixels
+	unsigned long long num_pixels = static_cast<unsigned long long>(NUM_QUADS) * QUAD_WIDTH * QUAD_HEIGHT;
+
+	Benchmark::measure("float barycentric", num_pixels, [&]() {
+		for (unsigned int quad_idx = 0; quad_idx < NUM_QUADS; quad_idx++)
+		{
+			draw_triangle_barycentric(gpu->video_ram, quad[0], quad[1], quad[2]);
+			draw_triangle_barycentric(gpu->video_ram, quad[1], quad[2], quad[3]);
+		}
+		Benchmark::sink = gpu->video_ram[32 * Gpu::FRAME_WIDTH + 32];
+	});
+
+	Benchmark::measure("integer edge spans", num_pixels, [&]() {
+		for (unsigned int quad_idx = 0; quad_idx < NUM_QUADS; quad_idx++)
+		{
+			for (unsigned int vertex_idx = 0; vertex_idx < 4; vertex_idx++)
+			{
+				const vertex& v = quad[vertex_idx];
+				unsigned int op = vertex_idx == 0 ? SHADED_4_PT << 24 : 0;
+				bus->set_word(GP0_ADDRESS, op | (v.r << 16) | (v.g << 8) | v.b);
+				bus->set_word(GP0_ADDRESS, (static_cast<unsigned int>(v.y) << 16) | static_cast<unsigned int>(v.x));
+			}
+		}
+		Benchmark::sink = gpu->video_ram[32 * Gpu::FRAME_WIDTH + 32];
+	});
+}
+
+BENCHMARK_CASE(gpu_span_kernels)
+{
+	SpanKernels * span_kernels = SpanKernels::get_instance();
+	SpanKernels::kernel_set previous_set = span_kernels->get_kernel_set();
+
+	const std::pair<SpanKernels::kernel_set, const char *> kernel_sets[] = {
+		{ SpanKernels::kernel_set::SCALAR, "scalar" },
+		{ SpanKernels::kernel_set::SSE41, "sse4.1" },
+		{ SpanKernels::kernel_set::AVX2, "avx2" }
+	};
+
+	// a red to blue ramp across the span, reported in pixels
+	std::vector<unsigned short> span(SPAN_LENGTH);
+	SpanKernels::gouraud_span gouraud = { { 0xFF8000, 0x8000, 0x8000 }, { -0xFF00, 0x7F00, 0xFF00 } };
+	unsigned long long num_pixels = static_cast<unsigned long long>(NUM_SPANS) * SPAN_LENGTH;
+
+	for (auto& kernel_set : kernel_sets)
+	{
+		if (span_kernels->is_supported(kernel_set.first) == false)
+		{
+			std::cout << "  " << kernel_set.second << " skipped, not supported" << std::endl;
+			continue;
+		}
+		span_kernels->set_kernel_set(kernel_set.first);
+
+		Benchmark::measure(std::string(kernel_set.second) + " shade", num_pixels, [&]() {
+			for (unsigned int span_idx = 0; span_idx < NUM_SPANS; span_idx++)
+			{
+				gouraud.colour[1] = 0x8000 + (span_idx & 0xFF);
+				span_kernels->shade(&span[0], SPAN_LENGTH, gouraud);
+			}
+			Benchmark::sink = span[SPAN_LENGTH / 2];
+		});
+
+		Benchmark::measure(std::string(kernel_set.second) + " fill", num_pixels, [&]() {
+			for (unsigned int span_idx = 0; span_idx < NUM_SPANS; span_idx++)
+			{
+				span_kernels->fill(&span[0], SPAN_LENGTH, static_cast<unsigned short>(span_idx));
+			}
+			Benchmark::sink = span[SPAN_LENGTH / 2];
+		});
+	}
+
+	span_kernels->set_kernel_set(previous_set);
+}
\ No newline at end of file
@@ -0,0 +1,22 @@
+#include "Benchmark.hpp"
+
+volatile unsigned int Benchmark::sink = 0;
+
+// usage: psx-emu-mk2-benchmark [name filter]
+int main(int num_args, char ** args)
+{
+	std::string filter = num_args > 1 ? args[1] : "";
+
+	for (auto& benchmark : Benchmark::get_benchmarks())
+	{
+		if (benchmark.first.find(filter) == std::string::npos)
+		{
+			continue;
+		}
+
+		std::cout << benchmark.first << std::endl;
+		benchmark.second();
+	}
+
+	return 0;
+}
\ No newline at end of file
@@ -4,6 +4,9 @@
 #include <fstream>
 #include <sstream>
 #include <thread>
+#include <chrono>
+#include <algorithm>
+#include <vector>
 
 #include "Psx.hpp"
 
@@ -19,8 +22,6 @@
 
 #include <GLFW/glfw3.h>
 
-constexpr double FRAME_TIME_SECS = 1.0 / 60.0;
-
 static const char* vertex_shader_src =
 "#version 150 core\n"
 "in vec2 position;\n"
@@ -56,16 +57,59 @@ void key_callback(GLFWwindow * window, int key, int /*scancode*/, int action, in
 
 int main(int num_args, char ** args )
 {
-	if (num_args != 4)
+	// options start with -- and can go anywhere, everything else is a path
+	std::vector<std::string> paths;
+	cpu_mode mode = cpu_mode::INTERPRETER;
+	bool hle_bios_calls = false;
+	std::string exe_path;
+	bool fast_boot = false;
+	for (int idx = 1; idx < num_args; idx++)
 	{
-		std::cerr << "Wrong number of arguments, must specify bios path, bin path and cue path\n";
+		std::string arg(args[idx]);
+		if (arg == "--cpu=interp")
+		{
+			mode = cpu_mode::INTERPRETER;
+		}
+		else if (arg == "--cpu=cached")
+		{
+			mode = cpu_mode::CACHED_INTERPRETER;
+		}
+		else if (arg == "--cpu=jit")
+		{
+			mode = cpu_mode::JIT;
+		}
+		else if (arg == "--hle-bios")
+		{
+			hle_bios_calls = true;
+		}
+		else if (arg.rfind("--exe=", 0) == 0)
+		{
+			exe_path = arg.substr(6);
+		}
+		else if (arg == "--fast-boot")
+		{
+			fast_boot = true;
+		}
+		else if (arg.rfind("--", 0) == 0)
+		{
+			std::cerr << "Unknown option " << arg << ", options are --cpu=interp, --cpu=cached, --cpu=jit, --hle-bios, --exe=<path> and --fast-boot\n";
+			return -1;
+		}
+		else
+		{
+			paths.push_back(arg);
+		}
+	}
+
+	// an exe doesn't need a disc
+	if (paths.size() != 3 && (exe_path.empty() || paths.size() != 1))
+	{
+		std::cerr << "Wrong number of arguments, must specify bios path, bin path and cue path (or just the bios path with --exe)\n";
 		return -1;
 	}
 
 	std::cout << "Create PSX\n";
-	std::string bios_file(args[1]);
-	std::string bin_file(args[2]);
-	std::string cue_file(args[3]);
+	std::string bios_file(paths[0]);
 
 	Psx * psx = Psx::get_instance();
 	if (psx->init(bios_file) == false)
@@ -73,13 +117,25 @@ int main(int num_args, char ** args )
 		std::cerr << "Unable to initialise PSX\n";
 		return -1;
 	}
+	Cpu::get_instance()->set_mode(mode);
+	Cpu::get_instance()->hle_bios_calls = hle_bios_calls;
 
-	if (psx->load(bin_file, cue_file) == false)
+	if (paths.size() == 3 && psx->load(paths[1], paths[2]) == false)
 	{
 		std::cerr << "Unable to load game\n";
 		return -1;
 	}
 
+	if (exe_path.empty() == false && psx->sideload_exe(exe_path) == false)
+	{
+		std::cerr << "Unable to load exe\n";
+		return -1;
+	}
+	else if (exe_path.empty() && fast_boot && paths.size() == 3 && psx->sideload_disc_exe() == false)
+	{
+		std::cerr << "Unable to fast boot, booting through the bios\n";
+	}
+
 	if (!glfwInit())
 	{
 		std::cerr << "Failed to initialize GLFW\n";
@@ -168,17 +224,21 @@ int main(int num_args, char ** args )
 	debug_menu->init(window);
 
 	std::cout << "Running!\n";
-	double current_frame_time = 0.0;
-	int ticks_per_frame = 0;
+	Gpu * gpu = Gpu::get_instance();
 	while (!glfwWindowShouldClose(window))
 	{
 		auto start_time = glfwGetTime();
 
-		if (debug_menu->is_paused() == false || debug_menu->is_forward_step_requested() == true)
+		// a field at a time, stepping goes an instruction at a time
+		if (debug_menu->is_paused() == false)
+		{
+			psx->run_frame();
+			debug_menu->tick();
+		}
+		else if (debug_menu->is_forward_step_requested() == true)
 		{
 			psx->tick();
 			debug_menu->tick();
-			ticks_per_frame++;
 		}
 
 		if (debug_menu->is_save_state_requested())
@@ -210,32 +270,32 @@ int main(int num_args, char ** args )
 			}
 		}
 
-		auto end_time = glfwGetTime();
-		current_frame_time += end_time - start_time;
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, gpu->width, gpu->height, 0, GL_RGB, GL_UNSIGNED_SHORT_5_6_5, gpu->video_ram);
 
-		if (current_frame_time >= FRAME_TIME_SECS)
-		{
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, Gpu::get_instance()->width, Gpu::get_instance()->height, 0, GL_RGB, GL_UNSIGNED_SHORT_5_6_5, Gpu::get_instance()->video_ram);
+		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+		glClear(GL_COLOR_BUFFER_BIT);
 
-			glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-			glClear(GL_COLOR_BUFFER_BIT);
+		glDrawArrays(GL_TRIANGLES, 0, 6);
 
-			glDrawArrays(GL_TRIANGLES, 0, 6);
+		if (show_debug_menus)
+		{
+			debug_menu->draw();
+		}
 
-			if (show_debug_menus)
-			{
-				debug_menu->draw();
-			}
+		// the emulated time of a field is how long it should take, whatever is left over is waited out
+		double frame_time = 1.0 / gpu->get_field_rate();
+		double emulation_time = glfwGetTime() - start_time;
+		if (emulation_time < frame_time)
+		{
+			std::this_thread::sleep_for(std::chrono::duration<double>(frame_time - emulation_time));
+		}
 
-			std::stringstream title_text;
-			title_text << "PSX-EMU-MK2 FPS: " << std::dec<< 1.0f / current_frame_time << " Ticks Per Frame: " << ticks_per_frame;
-			glfwSetWindowTitle(window, title_text.str().c_str());
-			ticks_per_frame = 0;
+		std::stringstream title_text;
+		title_text << "PSX-EMU-MK2 FPS: " << std::dec << 1.0 / (glfwGetTime() - start_time) << " Unthrottled FPS: " << 1.0 / std::max(emulation_time, 0.0001);
+		glfwSetWindowTitle(window, title_text.str().c_str());
 
-			glfwSwapBuffers(window);
-			glfwPollEvents();
-			current_frame_time = 0;
-		}
+		glfwSwapBuffers(window);
+		glfwPollEvents();
 	}
 
 	debug_menu->uninit();
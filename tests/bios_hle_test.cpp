@@ -0,0 +1,139 @@
+#include <catch.hpp>
+
+#include <sstream>
+
+#include "../Bus.hpp"
+#include "../Ram.hpp"
+#include "../Cpu.hpp"
+#include "../SystemControlCoprocessor.hpp"
+#include "../BiosHle.hpp"
+
+namespace
+{
+	const unsigned int RETURN_ADDRESS = 0x80030000;
+	const unsigned int DATA_ADDRESS = 0x80040000;
+
+	// starts the cpu on the first instruction at the entry point, as if it had just jumped there
+	void call(unsigned int entry, unsigned int function, unsigned int a0, unsigned int a1 = 0, unsigned int a2 = 0)
+	{
+		Cpu * cpu = Cpu::get_instance();
+		cpu->set_mode(cpu_mode::INTERPRETER);
+		cpu->register_file.reset();
+		cpu->register_file.set_register(9, function);
+		cpu->register_file.set_register(4, a0);
+		cpu->register_file.set_register(5, a1);
+		cpu->register_file.set_register(6, a2);
+		cpu->register_file.set_register(31, RETURN_ADDRESS);
+		cpu->current_pc = entry;
+		cpu->next_pc = entry + 4;
+		cpu->next_instruction = 0;
+		cpu->tick();
+	}
+
+	void write_string(unsigned int address, const char * text)
+	{
+		Bus * bus = Bus::get_instance();
+		do
+		{
+			bus->set_byte(address++, *text);
+		} while (*text++ != 0);
+	}
+}
+
+TEST_CASE("bios hle")
+{
+	Bus * bus = Bus::get_instance();
+	bus->register_device(Ram::get_instance());
+	bus->register_device(SystemControlCoprocessor::get_instance());
+
+	// no interrupts are taken while the calls run
+	SystemControlCoprocessor * cop0 = SystemControlCoprocessor::get_instance();
+	cop0->set_control_register(system_control::register_names::SR, 0);
+	bus->set_word(0x1F801074, 0);
+
+	// the kernel's own tables point into the kernel
+	for (unsigned int address = 0x200; address < 0x900; address += 4)
+	{
+		bus->set_word(address, 0x1000);
+	}
+
+	Cpu * cpu = Cpu::get_instance();
+	cpu->hle_bios_calls = true;
+	BiosHle * bios_hle = BiosHle::get_instance();
+	bios_hle->reset();
+
+	const unsigned int v0 = 2;
+
+	SECTION("strlen returns to ra with the result in v0")
+	{
+		write_string(DATA_ADDRESS, "hello");
+		call(0xA0, 0x1B, DATA_ADDRESS);
+		REQUIRE(cpu->register_file.get_register(v0) == 5);
+		REQUIRE(cpu->current_pc == RETURN_ADDRESS);
+		REQUIRE(cpu->next_pc == RETURN_ADDRESS + 4);
+		REQUIRE(bios_hle->num_calls_handled == 1);
+	}
+
+	SECTION("memcpy copies and returns dst")
+	{
+		write_string(DATA_ADDRESS, "abcdef");
+		call(0xA0, 0x2A, DATA_ADDRESS + 0x100, DATA_ADDRESS, 7);
+		REQUIRE(cpu->register_file.get_register(v0) == DATA_ADDRESS + 0x100);
+		REQUIRE(bus->get_word(DATA_ADDRESS + 0x100) == bus->get_word(DATA_ADDRESS));
+		REQUIRE(bus->get_byte(DATA_ADDRESS + 0x106) == 0);
+	}
+
+	SECTION("malloc hands out separate blocks once the heap is set up")
+	{
+		call(0xA0, 0x33, 16);
+		REQUIRE(bios_hle->num_calls_passed_through == 1);
+
+		call(0xA0, 0x39, DATA_ADDRESS, 0x100);
+		call(0xA0, 0x33, 16);
+		unsigned int first = cpu->register_file.get_register(v0);
+		call(0xA0, 0x33, 16);
+		unsigned int second = cpu->register_file.get_register(v0);
+		REQUIRE(first >= DATA_ADDRESS);
+		REQUIRE(second >= first + 16);
+
+		call(0xA0, 0x34, first);
+		call(0xA0, 0x33, 8);
+		REQUIRE(cpu->register_file.get_register(v0) == first);
+	}
+
+	SECTION("the heap set up by InitHeap survives a save state")
+	{
+		call(0xA0, 0x39, DATA_ADDRESS, 0x100);
+		call(0xA0, 0x33, 16);
+		unsigned int first = cpu->register_file.get_register(v0);
+
+		std::stringstream state;
+		bios_hle->save_state(state);
+		bios_hle->reset();
+		bios_hle->load_state(state);
+
+		call(0xA0, 0x33, 16);
+		unsigned int second = cpu->register_file.get_register(v0);
+		REQUIRE(bios_hle->num_calls_passed_through == 0);
+		REQUIRE(second >= first + 16);
+		REQUIRE(second < DATA_ADDRESS + 0x100);
+	}
+
+	SECTION("anything else runs the bios")
+	{
+		call(0xB0, 0x5B, 0);
+		REQUIRE(bios_hle->num_calls_passed_through == 1);
+		REQUIRE(cpu->current_pc == 0xB4);
+	}
+
+	SECTION("a function the game has patched runs the game's version")
+	{
+		bus->set_word(0x200 + 0x1B * 4, 0x80050000);
+		call(0xA0, 0x1B, DATA_ADDRESS);
+		REQUIRE(bios_hle->num_calls_handled == 0);
+		REQUIRE(cpu->current_pc == 0xA4);
+	}
+
+	cpu->hle_bios_calls = false;
+	bios_hle->reset();
+}
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include "../Cpu.hpp"
 #include "../Bus.hpp"
 #include "../SystemControlCoprocessor.hpp"
+#include "../Scheduler.hpp"
 
 TEST_CASE("Cdrom commands")
 {
@@ -64,10 +65,9 @@ TEST_CASE("Cdrom commands")
 
 		// trigger the interrupt
 		{
-			for (unsigned int idx = 0; idx < static_cast<unsigned int>(Cdrom::cdrom_response_timings::FIRST_RESPONSE_DELAY); idx++)
-			{
-				cdrom->tick();
-			}
+			Scheduler * scheduler = Scheduler::get_instance();
+			scheduler->current_cycle += static_cast<unsigned int>(Cdrom::cdrom_response_timings::FIRST_RESPONSE_DELAY);
+			scheduler->run_due_events();
 
 			unsigned int excode = 0;
 			REQUIRE(cdrom->trigger_pending_interrupts(cpu->cop0.get(), excode) == true);
@@ -222,4 +222,61 @@ TEST_CASE("Cdrom commands")
 	{
 
 	}
+}
+
+TEST_CASE("Cdrom data reads")
+{
+	Cdrom * cdrom = Cdrom::get_instance();
+	if (cdrom->data_fifo == nullptr)
+	{
+		cdrom->init();
+	}
+
+	// every byte of user data says which sector it came from and where it was in it
+	const unsigned int num_sectors = 300;
+	cdrom->num_sectors = num_sectors;
+	cdrom->rom_data.assign(num_sectors * Cdrom::SECTOR_SIZE, 0);
+	for (unsigned int sector = 0; sector < num_sectors; sector++)
+	{
+		for (unsigned int byte_idx = 0; byte_idx < Cdrom::MODE1_USER_DATA_SIZE; byte_idx++)
+		{
+			cdrom->rom_data[sector * Cdrom::SECTOR_SIZE + 16 + byte_idx] = static_cast<unsigned char>(sector * 7 + byte_idx);
+		}
+	}
+
+	unsigned char data[Cdrom::MODE1_USER_DATA_SIZE];
+
+	SECTION("a sector past the first second of the disc is read from its whole location")
+	{
+		// 00:03:05 is 230 sectors in, 80 after the pregap
+		cdrom->location.amm = 0x00;
+		cdrom->location.ass = 0x03;
+		cdrom->location.asect = 0x05;
+		cdrom->read_data();
+		cdrom->get_next_data_bytes(data, Cdrom::MODE1_USER_DATA_SIZE);
+
+		REQUIRE(cdrom->last_read_lba == 80);
+		for (unsigned int byte_idx = 0; byte_idx < Cdrom::MODE1_USER_DATA_SIZE; byte_idx++)
+		{
+			REQUIRE(data[byte_idx] == static_cast<unsigned char>(80 * 7 + byte_idx));
+		}
+	}
+
+	SECTION("sectors in the pregap read as zeroes")
+	{
+		cdrom->location.amm = 0x00;
+		cdrom->location.ass = 0x01;
+		cdrom->location.asect = 0x10;
+		cdrom->read_data();
+		cdrom->get_next_data_bytes(data, Cdrom::MODE1_USER_DATA_SIZE);
+
+		REQUIRE(cdrom->last_read_lba == Cdrom::NO_SECTOR);
+		REQUIRE(data[0] == 0);
+		REQUIRE(data[Cdrom::MODE1_USER_DATA_SIZE - 1] == 0);
+	}
+
+	cdrom->rom_data.clear();
+	cdrom->num_sectors = 0;
+	cdrom->data_fifo->clear();
+	cdrom->last_read_lba = Cdrom::NO_SECTOR;
 }
\ No newline at end of file
@@ -0,0 +1,345 @@
+#include <catch.hpp>
+
+#include <random>
+#include <vector>
+
+#include "../Bus.hpp"
+#include "../Ram.hpp"
+#include "../Cpu.hpp"
+#include "../SystemControlCoprocessor.hpp"
+#include "../InstructionTypes.hpp"
+#include "../InstructionEnums.hpp"
+
+#ifdef PSX_FASTMEM
+#include "../Fastmem.hpp"
+#endif
+
+namespace
+{
+	const unsigned int PROGRAM_ADDRESS = 0x80011000;
+	const unsigned int DATA_ADDRESS = 0x80020000;
+	const unsigned int DATA_SIZE = 0x400;
+	const unsigned int EXCEPTION_HANDLER_ADDRESS = 0x80000080;
+	const unsigned int I_MASK_ADDRESS = 0x1F801074;
+
+	const unsigned int PROGRAM_LENGTH = 600;
+	const unsigned int NUM_PROGRAMS = 20;
+	const unsigned long long NUM_INSTRUCTIONS = 20000;
+
+	// IEc and interrupt 2 in Im
+	const unsigned int SR_INTERRUPTS_ENABLED = 0x401;
+
+	// registers the generated code doesn't touch, the data and program addresses, the io base and an
+	// instruction to write over the program with
+	const unsigned int NUM_RANDOM_REGISTERS = 24;
+	const unsigned int COP0_VALUE_REGISTER = 25;
+	const unsigned int PATCH_REGISTER = 27;
+	const unsigned int DATA_REGISTER = 28;
+	const unsigned int PROGRAM_REGISTER = 29;
+	const unsigned int IO_REGISTER = 30;
+
+	const unsigned int MTC0 = 0x40800000;
+	const unsigned int RFE = 0x42000010;
+	const unsigned int MFC0_EPC_TO_K0 = 0x401A7000;
+	const unsigned int ADDIU_A1_A1_1 = 0x24A50001;
+
+#ifdef PSX_JIT
+	const cpu_mode modes[] = { cpu_mode::CACHED_INTERPRETER, cpu_mode::JIT };
+#else
+	const cpu_mode modes[] = { cpu_mode::CACHED_INTERPRETER };
+#endif
+
+	unsigned int immediate(cpu_instructions op, unsigned int rs, unsigned int rt, unsigned int value)
+	{
+		return instruction_union(op, rs, rt, value & 0xFFFF).raw;
+	}
+
+	unsigned int special(cpu_special_funcs funct, unsigned int rs, unsigned int rt, unsigned int rd, unsigned int shamt = 0)
+	{
+		return instruction_union(cpu_instructions::SPECIAL, rs, rt, rd, shamt, funct).raw;
+	}
+
+	unsigned int jump(cpu_instructions op, unsigned int address)
+	{
+		return instruction_union(op, (address & 0x0FFFFFFF) >> 2).raw;
+	}
+
+	// everything an instruction leaves behind for the next one, including loads still in flight
+	struct cpu_state
+	{
+		unsigned int current_pc;
+		unsigned int next_pc;
+		unsigned int current_instruction;
+		unsigned int next_instruction;
+		unsigned int hi;
+		unsigned int lo;
+		unsigned int sr;
+		unsigned int epc;
+		RegisterFile register_file;
+
+		bool operator==(const cpu_state& other) const
+		{
+			return current_pc == other.current_pc && next_pc == other.next_pc &&
+				current_instruction == other.current_instruction && next_instruction == other.next_instruction &&
+				hi == other.hi && lo == other.lo && sr == other.sr && epc == other.epc &&
+				register_file == other.register_file;
+		}
+	};
+
+	cpu_state get_cpu_state()
+	{
+		Cpu * cpu = Cpu::get_instance();
+		SystemControlCoprocessor * cop0 = SystemControlCoprocessor::get_instance();
+		cpu_state state;
+		state.current_pc = cpu->current_pc;
+		state.next_pc = cpu->next_pc;
+		state.current_instruction = cpu->current_instruction;
+		state.next_instruction = cpu->next_instruction;
+		state.hi = cpu->hi;
+		state.lo = cpu->lo;
+		state.sr = cop0->get_control_register(system_control::register_names::SR);
+		state.epc = cop0->get_control_register(system_control::register_names::EPC);
+		state.register_file = cpu->register_file;
+		return state;
+	}
+
+	unsigned int random_register(std::mt19937& random)
+	{
+		return random() % NUM_RANDOM_REGISTERS;
+	}
+
+	// straight line code with loads and stores into the data area, forward branches and jumps, cop0 writes
+	// which take interrupts and stores which write over code which hasn't run yet, looping back to the start
+	std::vector<unsigned int> generate_program(unsigned int seed)
+	{
+		std::mt19937 random(seed);
+		std::vector<unsigned int> program(PROGRAM_LENGTH + 2, 0);
+
+		unsigned int idx = 0;
+		program[idx++] = immediate(cpu_instructions::LUI, 0, DATA_REGISTER, DATA_ADDRESS >> 16);
+		program[idx++] = immediate(cpu_instructions::LUI, 0, PROGRAM_REGISTER, PROGRAM_ADDRESS >> 16);
+		program[idx++] = immediate(cpu_instructions::ORI, PROGRAM_REGISTER, PROGRAM_REGISTER, PROGRAM_ADDRESS);
+		program[idx++] = immediate(cpu_instructions::LUI, 0, IO_REGISTER, I_MASK_ADDRESS >> 16);
+		program[idx++] = immediate(cpu_instructions::ORI, 0, COP0_VALUE_REGISTER, system_control::VBLANK_BIT);
+		program[idx++] = immediate(cpu_instructions::SW, IO_REGISTER, COP0_VALUE_REGISTER, I_MASK_ADDRESS);
+		program[idx++] = immediate(cpu_instructions::LUI, 0, PATCH_REGISTER, ADDIU_A1_A1_1 >> 16);
+		program[idx++] = immediate(cpu_instructions::ORI, PATCH_REGISTER, PATCH_REGISTER, ADDIU_A1_A1_1);
+
+		const cpu_special_funcs alu_functions[] = {
+			cpu_special_funcs::ADDU, cpu_special_funcs::SUBU, cpu_special_funcs::AND, cpu_special_funcs::OR,
+			cpu_special_funcs::XOR, cpu_special_funcs::NOR, cpu_special_funcs::SLT, cpu_special_funcs::SLTU,
+			cpu_special_funcs::SLLV, cpu_special_funcs::SRLV, cpu_special_funcs::SRAV, cpu_special_funcs::ADD,
+			cpu_special_funcs::SUB, cpu_special_funcs::MULT, cpu_special_funcs::MULTU, cpu_special_funcs::MFHI,
+			cpu_special_funcs::MFLO, cpu_special_funcs::MTHI, cpu_special_funcs::MTLO, cpu_special_funcs::DIV,
+			cpu_special_funcs::DIVU };
+		const cpu_special_funcs shift_functions[] = { cpu_special_funcs::SLL, cpu_special_funcs::SRL, cpu_special_funcs::SRA };
+		const cpu_instructions immediate_ops[] = {
+			cpu_instructions::ADDIU, cpu_instructions::ADDI, cpu_instructions::ORI, cpu_instructions::ANDI,
+			cpu_instructions::XORI, cpu_instructions::LUI, cpu_instructions::SLTI, cpu_instructions::SLTIU };
+		const cpu_instructions load_ops[] = {
+			cpu_instructions::LB, cpu_instructions::LBU, cpu_instructions::LH, cpu_instructions::LHU,
+			cpu_instructions::LW, cpu_instructions::LWL, cpu_instructions::LWR };
+		const cpu_instructions store_ops[] = {
+			cpu_instructions::SB, cpu_instructions::SH, cpu_instructions::SW, cpu_instructions::SWL, cpu_instructions::SWR };
+		const cpu_instructions branch_ops[] = {
+			cpu_instructions::BEQ, cpu_instructions::BNE, cpu_instructions::BLEZ, cpu_instructions::BGTZ, cpu_instructions::BCOND };
+
+		while (idx < PROGRAM_LENGTH - 8)
+		{
+			unsigned int kind = random() % 100;
+			unsigned int rs = random_register(random);
+			unsigned int rt = random_register(random);
+			unsigned int rd = random_register(random);
+
+			if (kind < 20)
+			{
+				program[idx++] = immediate(immediate_ops[random() % 8], rs, rt, random());
+			}
+			else if (kind < 36)
+			{
+				program[idx++] = special(alu_functions[random() % 21], rs, rt, rd);
+			}
+			else if (kind < 40)
+			{
+				program[idx++] = special(shift_functions[random() % 3], 0, rt, rd, random() % 32);
+			}
+			else if (kind < 55)
+			{
+				// mostly aligned, the rest raise address errors
+				unsigned int offset = random() % DATA_SIZE;
+				offset &= (random() % 10) ? ~3u : ~0u;
+				program[idx++] = immediate(load_ops[random() % 7], DATA_REGISTER, rt, offset);
+			}
+			else if (kind < 65)
+			{
+				unsigned int offset = random() % DATA_SIZE;
+				offset &= (random() % 10) ? ~3u : ~0u;
+				program[idx++] = immediate(store_ops[random() % 5], DATA_REGISTER, rt, offset);
+			}
+			else if (kind < 67)
+			{
+				// enables interrupts, the vblank bit is always set so one is taken straight away
+				program[idx++] = MTC0 | (COP0_VALUE_REGISTER << 16) | (static_cast<unsigned int>(system_control::register_names::SR) << 11);
+			}
+			else if (kind < 69)
+			{
+				// a software interrupt
+				program[idx++] = immediate(cpu_instructions::ORI, 0, rt, 0x400);
+				program[idx++] = MTC0 | (rt << 16) | (static_cast<unsigned int>(system_control::register_names::CAUSE) << 11);
+			}
+			else if (kind < 71)
+			{
+				unsigned int target_idx = idx + 2 + random() % 40;
+				if (target_idx < PROGRAM_LENGTH - 8 && program[target_idx] == 0)
+				{
+					program[idx++] = immediate(cpu_instructions::SW, PROGRAM_REGISTER, PATCH_REGISTER, target_idx * 4);
+				}
+			}
+			else if (kind < 80)
+			{
+				cpu_instructions op = branch_ops[random() % 5];
+				unsigned int branch_rt = 0;
+				if (op == cpu_instructions::BEQ || op == cpu_instructions::BNE)
+				{
+					branch_rt = rt;
+				}
+				else if (op == cpu_instructions::BCOND)
+				{
+					// BLTZ, BGEZ and sometimes the linking versions
+					branch_rt = (random() % 2) | ((random() % 4) == 0 ? 0x10 : 0);
+				}
+				program[idx++] = instruction_union(op, rs, branch_rt, 1 + random() % 5).raw;
+				program[idx++] = immediate(cpu_instructions::ADDIU, rs, rd, random() % 7);
+			}
+			else if (kind < 82)
+			{
+				unsigned int target_idx = idx + 2 + random() % 4;
+				program[idx++] = jump(kind % 2 ? cpu_instructions::JAL : cpu_instructions::J, PROGRAM_ADDRESS + target_idx * 4);
+				program[idx++] = 0;
+			}
+			else if (kind < 84)
+			{
+				unsigned int target_idx = idx + 3 + random() % 3;
+				program[idx++] = immediate(cpu_instructions::ADDIU, PROGRAM_REGISTER, rs, target_idx * 4);
+				program[idx++] = kind % 2 ? special(cpu_special_funcs::JR, rs, 0, 0) : special(cpu_special_funcs::JALR, rs, 0, rd);
+				program[idx++] = special(cpu_special_funcs::ADDU, rs, rt, rd);
+			}
+			else if (kind < 85)
+			{
+				program[idx++] = special(cpu_special_funcs::SYSCALL, 0, 0, 0);
+			}
+			else
+			{
+				idx++;
+			}
+		}
+
+		program[PROGRAM_LENGTH] = jump(cpu_instructions::J, PROGRAM_ADDRESS);
+		return program;
+	}
+
+	// puts the program, its data and an exception handler which skips the instruction that raised it in
+	// memory, and starts the cpu at the program in the given mode
+	void start_program(const std::vector<unsigned int>& program, cpu_mode mode)
+	{
+		Bus * bus = Bus::get_instance();
+		for (unsigned int idx = 0; idx < program.size(); idx++)
+		{
+			bus->set_word(PROGRAM_ADDRESS + idx * 4, program[idx]);
+		}
+		for (unsigned int offset = 0; offset < DATA_SIZE; offset += 4)
+		{
+			bus->set_word(DATA_ADDRESS + offset, offset * 0x9E3779B9);
+		}
+
+		const unsigned int handler[] = {
+			MFC0_EPC_TO_K0,
+			immediate(cpu_instructions::ADDIU, 26, 26, 4),
+			special(cpu_special_funcs::JR, 26, 0, 0),
+			RFE };
+		for (unsigned int idx = 0; idx < 4; idx++)
+		{
+			bus->set_word(EXCEPTION_HANDLER_ADDRESS + idx * 4, handler[idx]);
+		}
+
+		SystemControlCoprocessor * cop0 = SystemControlCoprocessor::get_instance();
+		bus->set_word(I_MASK_ADDRESS, 0);
+		cop0->set_control_register(system_control::register_names::CAUSE, 0);
+		cop0->set_control_register(system_control::register_names::EPC, 0);
+		cop0->set_control_register(system_control::register_names::SR, SR_INTERRUPTS_ENABLED);
+		cop0->set_irq_bits(system_control::VBLANK_BIT);
+
+		Cpu * cpu = Cpu::get_instance();
+		cpu->set_mode(mode);
+		cpu->reset();
+		cpu->current_pc = PROGRAM_ADDRESS;
+		cpu->next_pc = PROGRAM_ADDRESS;
+		cpu->hi = 0;
+		cpu->lo = 0;
+	}
+
+	std::vector<unsigned int> get_data()
+	{
+		std::vector<unsigned int> data;
+		for (unsigned int offset = 0; offset < DATA_SIZE; offset += 4)
+		{
+			data.push_back(Bus::get_instance()->get_word(DATA_ADDRESS + offset));
+		}
+		return data;
+	}
+}
+
+TEST_CASE("cpu modes match the interpreter")
+{
+	Bus * bus = Bus::get_instance();
+	bus->register_device(Ram::get_instance());
+	bus->register_device(SystemControlCoprocessor::get_instance());
+#ifdef PSX_FASTMEM
+	REQUIRE(Fastmem::get_instance()->init());
+#endif
+
+	Cpu * cpu = Cpu::get_instance();
+	for (unsigned int seed = 1; seed <= NUM_PROGRAMS; seed++)
+	{
+		std::vector<unsigned int> program = generate_program(seed);
+
+		// the state after every instruction, blocks can only be checked where they finish
+		std::vector<cpu_state> expected_states;
+		start_program(program, cpu_mode::INTERPRETER);
+		expected_states.push_back(get_cpu_state());
+		for (unsigned long long idx = 0; idx < NUM_INSTRUCTIONS; idx++)
+		{
+			cpu->tick();
+			expected_states.push_back(get_cpu_state());
+		}
+		std::vector<unsigned int> expected_data = get_data();
+
+		for (cpu_mode mode : modes)
+		{
+			INFO("seed " << seed << " mode " << static_cast<unsigned int>(mode));
+			start_program(program, mode);
+
+			unsigned long long num_executed = 0;
+			while (num_executed < NUM_INSTRUCTIONS)
+			{
+				unsigned long long start_count = cpu->instruction_count;
+				cpu->tick();
+				num_executed += cpu->instruction_count - start_count;
+				if (num_executed > NUM_INSTRUCTIONS)
+				{
+					break;
+				}
+
+				INFO("after " << num_executed << " instructions");
+				REQUIRE(get_cpu_state() == expected_states[num_executed]);
+			}
+
+			if (num_executed == NUM_INSTRUCTIONS)
+			{
+				REQUIRE(get_data() == expected_data);
+			}
+		}
+	}
+
+	cpu->set_mode(cpu_mode::INTERPRETER);
+}
\ No newline at end of file
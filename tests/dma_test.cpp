@@ -0,0 +1,238 @@
+#include <catch.hpp>
+
+#include <vector>
+
+#include "../Bus.hpp"
+#include "../Ram.hpp"
+#include "../Cpu.hpp"
+#include "../Dma.hpp"
+#include "../Psx.hpp"
+#include "../Scheduler.hpp"
+#include "../SystemControlCoprocessor.hpp"
+#include "../InstructionTypes.hpp"
+#include "../InstructionEnums.hpp"
+
+namespace
+{
+	const unsigned int DPCR_ADDRESS = 0x1F8010F0;
+	const unsigned int DICR_ADDRESS = 0x1F8010F4;
+
+	const unsigned int CHCR_CHOPPING = 0x1 << 8;
+	const unsigned int CHCR_SYNC_REQUEST = 0x1 << 9;
+	const unsigned int CHCR_START_BUSY = 0x1 << 24;
+	const unsigned int CHCR_START_TRIGGER = 0x1 << 28;
+
+	unsigned int channel_address(unsigned int chan_idx, unsigned int offset)
+	{
+		return 0x1F801080 + chan_idx * 16 + offset;
+	}
+
+	// moves nothing, it only remembers when it was asked to and says how many words it took
+	class FakeDevice : public DMA_interface
+	{
+	public:
+		FakeDevice(unsigned int chan_idx, std::vector<unsigned int>& started) : chan_idx(chan_idx), started(started) {}
+
+		virtual unsigned int sync_mode_request(DMA_base_address& base_address, DMA_block_control& block_control, DMA_channel_control& channel_control) override
+		{
+			started.push_back(chan_idx);
+			return block_control.BS * block_control.BA;
+		}
+
+	private:
+		unsigned int chan_idx;
+		std::vector<unsigned int>& started;
+	};
+
+	bool is_busy(unsigned int chan_idx)
+	{
+		return Bus::get_instance()->get_word(channel_address(chan_idx, 0x8)) & CHCR_START_BUSY;
+	}
+
+	void start_request(unsigned int chan_idx, unsigned int block_size, unsigned int num_blocks, unsigned int extra_control = 0)
+	{
+		Bus * bus = Bus::get_instance();
+		bus->set_word(channel_address(chan_idx, 0x0), 0x1000);
+		bus->set_word(channel_address(chan_idx, 0x4), (num_blocks << 16) | block_size);
+		bus->set_word(channel_address(chan_idx, 0x8), CHCR_START_BUSY | CHCR_SYNC_REQUEST | extra_control);
+	}
+}
+
+TEST_CASE("dma")
+{
+	Bus * bus = Bus::get_instance();
+	Dma * dma = Dma::get_instance();
+	Scheduler * scheduler = Scheduler::get_instance();
+	SystemControlCoprocessor * cop0 = SystemControlCoprocessor::get_instance();
+	bus->register_device(Ram::get_instance());
+	bus->register_device(dma);
+	bus->register_device(cop0);
+
+	scheduler->reset();
+	dma->init();
+	Psx::get_instance()->stall_cpu_until(0);
+	cop0->interrupt_status_register.value = 0;
+
+	std::vector<unsigned int> started;
+	FakeDevice mdec_in(0, started);
+	FakeDevice mdec_out(1, started);
+	DMA_interface * previous_devices[2] = { dma->devices[0], dma->devices[1] };
+	dma->devices[0] = &mdec_in;
+	dma->devices[1] = &mdec_out;
+
+	SECTION("otc fills the table when it starts and finishes once the words have gone over the bus")
+	{
+		const unsigned int table_address = 0x2000;
+		const unsigned int num_entries = 16;
+		bus->set_word(DPCR_ADDRESS, 0x1 << 27);
+		bus->set_word(channel_address(6, 0x0), table_address + (num_entries - 1) * 4);
+		bus->set_word(channel_address(6, 0x4), num_entries);
+		bus->set_word(channel_address(6, 0x8), CHCR_START_BUSY | CHCR_START_TRIGGER | 0x2);
+
+		scheduler->run_events_until(0);
+		REQUIRE(bus->get_word(table_address) == 0xFFFFFFFF);
+		REQUIRE(bus->get_word(table_address + 4) == table_address);
+		REQUIRE(is_busy(6));
+
+		scheduler->run_events_until(num_entries - 1);
+		REQUIRE(is_busy(6));
+		scheduler->run_events_until(num_entries);
+		REQUIRE(is_busy(6) == false);
+	}
+
+	SECTION("otc tables which run below the start of ram wrap around to the end of it")
+	{
+		bus->set_word(DPCR_ADDRESS, 0x1 << 27);
+		bus->set_word(channel_address(6, 0x0), 0x4);
+		bus->set_word(channel_address(6, 0x4), 4);
+		bus->set_word(channel_address(6, 0x8), CHCR_START_BUSY | CHCR_START_TRIGGER | 0x2);
+		scheduler->run_events_until(0);
+
+		REQUIRE(bus->get_word(0x4) == 0x0);
+		REQUIRE(bus->get_word(0x0) == 0x1FFFFC);
+		REQUIRE(bus->get_word(0x1FFFFC) == 0x1FFFF8);
+		REQUIRE(bus->get_word(0x1FFFF8) == 0xFFFFFFFF);
+	}
+
+	SECTION("dma writes to ram wrap at the end of it and are seen by the dirty and watched pages")
+	{
+		Ram * ram = Ram::get_instance();
+		const unsigned int last_page = (0x200000 >> Ram::DIRTY_PAGE_SHIFT) - 1;
+		ram->clear_dirty_pages();
+		ram->set_dma_word(0x0, 0);
+		ram->watch_page_writes(0);
+		REQUIRE(ram->is_page_write_direct(0) == false);
+
+		const unsigned char data[] = { 0x11, 0x22, 0x33, 0x44 };
+		ram->write_dma_span(0x1FFFFE, data, sizeof(data));
+		REQUIRE(bus->get_halfword(0x1FFFFE) == 0x2211);
+		REQUIRE(bus->get_halfword(0x0) == 0x4433);
+		REQUIRE(ram->is_page_dirty(last_page));
+		REQUIRE(ram->is_page_write_direct(0));
+		REQUIRE(ram->get_dma_word(0x200000) == 0x4433);
+	}
+
+	SECTION("manual transfers wait for the trigger and nothing starts without the master enable")
+	{
+		bus->set_word(channel_address(6, 0x4), 4);
+		bus->set_word(channel_address(6, 0x8), CHCR_START_BUSY);
+		start_request(0, 4, 1);
+		scheduler->run_events_until(100);
+		REQUIRE(started.empty());
+		REQUIRE(is_busy(6));
+		REQUIRE(is_busy(0));
+
+		bus->set_word(DPCR_ADDRESS, 0x8);
+		scheduler->run_events_until(200);
+		REQUIRE(started.size() == 1);
+		REQUIRE(is_busy(0) == false);
+		REQUIRE(is_busy(6));
+	}
+
+	SECTION("the irq goes off when the transfer finishes")
+	{
+		bus->set_word(DPCR_ADDRESS, 0x8);
+		bus->set_word(DICR_ADDRESS, (0x1 << 23) | (0x1 << 16));
+		start_request(0, 8, 4);
+
+		scheduler->run_events_until(31);
+		REQUIRE((cop0->interrupt_status_register.value & system_control::DMA_BIT) == 0);
+		scheduler->run_events_until(32);
+		REQUIRE((cop0->interrupt_status_register.value & system_control::DMA_BIT) != 0);
+		REQUIRE(dma->interrupt_register.irq_flags == 0x1);
+		REQUIRE(dma->interrupt_register.irq_master_flag);
+
+		// acknowledging the flag drops the master flag again
+		bus->set_byte(DICR_ADDRESS + 3, 0x1);
+		REQUIRE(dma->interrupt_register.irq_master_flag == false);
+	}
+
+	SECTION("channels go one at a time, lowest priority value first and the higher channel on a tie")
+	{
+		bus->set_word(DPCR_ADDRESS, 0x8 | (0x3 << 4) | 0x80);
+		start_request(0, 10, 1);
+		start_request(1, 10, 1);
+		scheduler->run_events_until(0);
+		REQUIRE(started == std::vector<unsigned int>{ 0 });
+
+		scheduler->run_events_until(10);
+		REQUIRE(started == std::vector<unsigned int>{ 0, 1 });
+		REQUIRE(is_busy(0) == false);
+		REQUIRE(is_busy(1));
+
+		scheduler->run_events_until(20);
+		REQUIRE(is_busy(1) == false);
+		started.clear();
+		bus->set_word(DPCR_ADDRESS, 0x8 | 0x80);
+		start_request(0, 10, 1);
+		start_request(1, 10, 1);
+		scheduler->run_events_until(60);
+		REQUIRE(started == std::vector<unsigned int>{ 1, 0 });
+	}
+
+	SECTION("chopping gives the cpu the bus between chunks")
+	{
+		// 8 word chunks with 16 cycles for the cpu in between
+		bus->set_word(DPCR_ADDRESS, 0x8);
+		start_request(0, 64, 1, CHCR_CHOPPING | (3 << 16) | (4 << 20));
+
+		unsigned long long transfer_cycles = 64 + 7 * 16;
+		scheduler->run_events_until(transfer_cycles - 1);
+		REQUIRE(is_busy(0));
+		scheduler->run_events_until(transfer_cycles);
+		REQUIRE(is_busy(0) == false);
+	}
+
+	SECTION("the cpu doesn't run while a transfer has the bus")
+	{
+		cop0->set_control_register(system_control::register_names::SR, 0);
+
+		// a loop which only ever branches back to itself
+		const unsigned int code_address = 0x80030100;
+		bus->set_word(code_address, instruction_union(cpu_instructions::BEQ, 0, 0, 0xFFFF).raw);
+		bus->set_word(code_address + 4, 0);
+
+		Cpu * cpu = Cpu::get_instance();
+		cpu->set_mode(cpu_mode::INTERPRETER);
+		cpu->register_file.reset();
+		cpu->current_pc = code_address;
+		cpu->next_pc = code_address;
+		cpu->next_instruction = 0;
+
+		bus->set_word(DPCR_ADDRESS, 0x8);
+		start_request(0, 256, 1);
+		unsigned long long instruction_count = cpu->instruction_count;
+		Psx::get_instance()->run_until(256);
+		REQUIRE(cpu->instruction_count == instruction_count);
+		REQUIRE(is_busy(0) == false);
+
+		Psx::get_instance()->run_until(300);
+		REQUIRE(cpu->instruction_count > instruction_count);
+	}
+
+	dma->devices[0] = previous_devices[0];
+	dma->devices[1] = previous_devices[1];
+	scheduler->reset();
+	dma->reset();
+	Psx::get_instance()->stall_cpu_until(0);
+}
\ No newline at end of file
@@ -0,0 +1,158 @@
+#include <catch.hpp>
+
+#include "../Bus.hpp"
+#include "../Gpu.hpp"
+
+namespace
+{
+	const unsigned int GP0_ADDRESS = 0x1F801810;
+
+	const unsigned int MONO_4_PT = 0x28;
+	const unsigned int SHADED_3_PT = 0x30;
+
+	unsigned int vertex(int x, int y)
+	{
+		return (static_cast<unsigned int>(y & 0xFFFF) << 16) | static_cast<unsigned int>(x & 0xFFFF);
+	}
+
+	unsigned int colour(unsigned int op, unsigned int r, unsigned int g, unsigned int b)
+	{
+		return (op << 24) | (r << 16) | (g << 8) | b;
+	}
+
+	void set_draw_area(unsigned int min_x, unsigned int min_y, unsigned int max_x, unsigned int max_y)
+	{
+		Bus::get_instance()->set_word(GP0_ADDRESS, 0xE3000000 | (min_y << 10) | min_x);
+		Bus::get_instance()->set_word(GP0_ADDRESS, 0xE4000000 | (max_y << 10) | max_x);
+	}
+
+	void set_draw_offset(int x, int y)
+	{
+		Bus::get_instance()->set_word(GP0_ADDRESS, 0xE5000000 | ((y & 0x7FF) << 11) | (x & 0x7FF));
+	}
+
+	void draw_mono_quad(int x0, int y0, int x1, int y1, int x2, int y2, int x3, int y3)
+	{
+		Bus * bus = Bus::get_instance();
+		bus->set_word(GP0_ADDRESS, colour(MONO_4_PT, 0xFF, 0xFF, 0xFF));
+		bus->set_word(GP0_ADDRESS, vertex(x0, y0));
+		bus->set_word(GP0_ADDRESS, vertex(x1, y1));
+		bus->set_word(GP0_ADDRESS, vertex(x2, y2));
+		bus->set_word(GP0_ADDRESS, vertex(x3, y3));
+	}
+
+	unsigned int count_drawn(unsigned int min_x, unsigned int min_y, unsigned int max_x, unsigned int max_y)
+	{
+		Gpu * gpu = Gpu::get_instance();
+		unsigned int num_drawn = 0;
+		for (unsigned int y = min_y; y <= max_y; y++)
+		{
+			for (unsigned int x = min_x; x <= max_x; x++)
+			{
+				num_drawn += gpu->video_ram[y * Gpu::FRAME_WIDTH + x] != 0 ? 1 : 0;
+			}
+		}
+		return num_drawn;
+	}
+
+	bool is_drawn(unsigned int x, unsigned int y)
+	{
+		return Gpu::get_instance()->video_ram[y * Gpu::FRAME_WIDTH + x] != 0;
+	}
+}
+
+TEST_CASE("gpu triangle rasterization")
+{
+	Bus * bus = Bus::get_instance();
+	Gpu * gpu = Gpu::get_instance();
+	if (gpu->video_ram == nullptr)
+	{
+		gpu->init();
+	}
+	bus->register_device(gpu);
+	gpu->reset();
+	set_draw_area(0, 0, Gpu::FRAME_WIDTH - 1, Gpu::FRAME_HEIGHT - 1);
+
+	SECTION("a quad covers its top and left edges but not its bottom and right ones")
+	{
+		draw_mono_quad(0, 0, 4, 0, 0, 4, 4, 4);
+		REQUIRE(count_drawn(0, 0, 3, 3) == 16);
+		REQUIRE(count_drawn(0, 0, 8, 8) == 16);
+	}
+
+	SECTION("the winding doesn't change what's drawn")
+	{
+		draw_mono_quad(10, 10, 10, 20, 20, 10, 20, 20);
+		REQUIRE(count_drawn(10, 10, 19, 19) == 100);
+		REQUIRE(count_drawn(0, 0, 30, 30) == 100);
+	}
+
+	SECTION("triangles with no area draw nothing")
+	{
+		draw_mono_quad(0, 0, 8, 8, 16, 16, 24, 24);
+		REQUIRE(count_drawn(0, 0, 30, 30) == 0);
+	}
+
+	SECTION("pixels outside the draw area aren't touched")
+	{
+		set_draw_area(2, 3, 5, 6);
+		draw_mono_quad(0, 0, 16, 0, 0, 16, 16, 16);
+		REQUIRE(count_drawn(2, 3, 5, 6) == 16);
+		REQUIRE(count_drawn(0, 0, 16, 16) == 16);
+	}
+
+	SECTION("vertices are relative to the draw offset")
+	{
+		set_draw_offset(100, 50);
+		draw_mono_quad(-2, -2, 2, -2, -2, 2, 2, 2);
+		REQUIRE(count_drawn(98, 48, 101, 51) == 16);
+		REQUIRE(count_drawn(0, 0, 200, 100) == 16);
+	}
+
+	SECTION("polygons too big for the gpu are skipped")
+	{
+		draw_mono_quad(0, 0, 1024, 0, 0, 8, 1024, 8);
+		REQUIRE(count_drawn(0, 0, Gpu::FRAME_WIDTH - 1, 10) == 0);
+
+		draw_mono_quad(0, 0, 1023, 0, 0, 8, 1023, 8);
+		REQUIRE(count_drawn(0, 0, Gpu::FRAME_WIDTH - 1, 10) == 1023 * 8);
+	}
+
+	SECTION("shaded triangles interpolate their colours")
+	{
+		bus->set_word(GP0_ADDRESS, colour(SHADED_3_PT, 0x0, 0x0, 0x0));
+		bus->set_word(GP0_ADDRESS, vertex(0, 0));
+		bus->set_word(GP0_ADDRESS, colour(0, 0xFF, 0x0, 0x80));
+		bus->set_word(GP0_ADDRESS, vertex(64, 0));
+		bus->set_word(GP0_ADDRESS, colour(0, 0x0, 0xFF, 0x0));
+		bus->set_word(GP0_ADDRESS, vertex(0, 64));
+
+		auto red = [&](unsigned int x, unsigned int y) { return gpu->video_ram[y * Gpu::FRAME_WIDTH + x] & 0x1F; };
+		auto green = [&](unsigned int x, unsigned int y) { return (gpu->video_ram[y * Gpu::FRAME_WIDTH + x] >> 5) & 0x3F; };
+		auto blue = [&](unsigned int x, unsigned int y) { return (gpu->video_ram[y * Gpu::FRAME_WIDTH + x] >> 11) & 0x1F; };
+
+		REQUIRE(gpu->video_ram[0] == 0);
+		// 127.5 rounds up to 128
+		REQUIRE(red(32, 0) == (128 >> 3));
+		REQUIRE(blue(32, 0) == (64 >> 3));
+		REQUIRE(green(32, 0) == 0);
+		REQUIRE(red(63, 0) == (253 >> 3));
+		REQUIRE(green(0, 32) == (128 >> 2));
+		REQUIRE(red(16, 16) == (64 >> 3));
+		REQUIRE(green(16, 16) == (64 >> 2));
+		REQUIRE(is_drawn(63, 0));
+		REQUIRE(is_drawn(64, 0) == false);
+	}
+
+	SECTION("drawing marks the tiles it touched")
+	{
+		gpu->clear_dirty_tiles();
+		draw_mono_quad(60, 0, 70, 0, 60, 4, 70, 4);
+		REQUIRE(gpu->is_tile_dirty(0));
+		REQUIRE(gpu->is_tile_dirty(1));
+		REQUIRE(gpu->is_tile_dirty(2) == false);
+		REQUIRE(gpu->is_tile_dirty(Gpu::NUM_VRAM_TILES_X) == false);
+	}
+
+	gpu->reset();
+}
\ No newline at end of file
@@ -0,0 +1,117 @@
+#include <catch.hpp>
+
+#include "../Bus.hpp"
+#include "../Ram.hpp"
+#include "../Cpu.hpp"
+#include "../Gpu.hpp"
+#include "../Psx.hpp"
+#include "../Scheduler.hpp"
+#include "../SystemControlCoprocessor.hpp"
+#include "../InstructionTypes.hpp"
+#include "../InstructionEnums.hpp"
+
+namespace
+{
+	// GP1(08h) display mode
+	const unsigned int DISPLAY_MODE_COMMAND = 0x08000000;
+	const unsigned int DISPLAY_MODE_PAL = 0x1 << 3;
+	const unsigned int DISPLAY_MODE_480_LINES = 0x1 << 2;
+	const unsigned int DISPLAY_MODE_INTERLACED = 0x1 << 5;
+
+	const unsigned int GP1_ADDRESS = 0x1F801814;
+	const unsigned int EVEN_ODD_BIT = 0x1u << 31;
+	const unsigned int INTERLACE_FIELD_BIT = 0x1 << 13;
+}
+
+TEST_CASE("gpu video timing")
+{
+	Gpu * gpu = Gpu::get_instance();
+	Scheduler * scheduler = Scheduler::get_instance();
+	SystemControlCoprocessor * cop0 = SystemControlCoprocessor::get_instance();
+	if (gpu->video_ram == nullptr)
+	{
+		gpu->init();
+	}
+	scheduler->reset();
+	gpu->reset();
+	cop0->interrupt_status_register.value = 0;
+
+	SECTION("ntsc fields have 263 scanlines and vblank starts at 240")
+	{
+		// 3413 video clocks a scanline at 53.69MHz
+		unsigned long long vblank_cycle = gpu->get_next_vblank_cycle();
+		REQUIRE(vblank_cycle == 240ull * 3413 * Gpu::CPU_CLOCK / 53693175);
+
+		scheduler->run_events_until(vblank_cycle - 1);
+		REQUIRE(gpu->is_in_vblank() == false);
+		REQUIRE(gpu->get_scanline() == 239);
+		REQUIRE((cop0->interrupt_status_register.value & system_control::VBLANK_BIT) == 0);
+
+		scheduler->run_events_until(vblank_cycle);
+		REQUIRE(gpu->is_in_vblank());
+		REQUIRE(gpu->num_fields == 1);
+		REQUIRE((cop0->interrupt_status_register.value & system_control::VBLANK_BIT) != 0);
+		REQUIRE((gpu->get_status() & EVEN_ODD_BIT) == 0);
+
+		unsigned long long field_cycles = 263ull * 3413 * Gpu::CPU_CLOCK / 53693175;
+		scheduler->run_events_until(field_cycles);
+		REQUIRE(gpu->is_in_vblank() == false);
+		REQUIRE(gpu->get_scanline() == 0);
+	}
+
+	SECTION("240 line modes alternate the even/odd bit every scanline")
+	{
+		scheduler->run_events_until(10ull * 3413 * Gpu::CPU_CLOCK / 53693175 + 1);
+		REQUIRE(gpu->get_scanline() == 10);
+		REQUIRE((gpu->get_status() & EVEN_ODD_BIT) == 0);
+		REQUIRE((gpu->get_status() & INTERLACE_FIELD_BIT) != 0);
+		scheduler->run_events_until(11ull * 3413 * Gpu::CPU_CLOCK / 53693175 + 1);
+		REQUIRE((gpu->get_status() & EVEN_ODD_BIT) != 0);
+	}
+
+	SECTION("pal and interlacing start with the next field")
+	{
+		gpu->set_word(GP1_ADDRESS, DISPLAY_MODE_COMMAND | DISPLAY_MODE_PAL | DISPLAY_MODE_480_LINES | DISPLAY_MODE_INTERLACED);
+		REQUIRE(gpu->get_next_vblank_cycle() == 240ull * 3413 * Gpu::CPU_CLOCK / 53693175);
+
+		scheduler->run_events_until(263ull * 3413 * Gpu::CPU_CLOCK / 53693175);
+		unsigned long long field_start = scheduler->current_cycle;
+		REQUIRE(gpu->get_next_vblank_cycle() == field_start + 288ull * 3406 * Gpu::CPU_CLOCK / 53203425);
+
+		// the field and the even/odd bit hold for the whole field and flip with the next one
+		unsigned int status = gpu->get_status();
+		scheduler->run_events_until(field_start + 3406ull * Gpu::CPU_CLOCK / 53203425 + 1);
+		REQUIRE((gpu->get_status() & (EVEN_ODD_BIT | INTERLACE_FIELD_BIT)) == (status & (EVEN_ODD_BIT | INTERLACE_FIELD_BIT)));
+
+		scheduler->run_events_until(field_start + 314ull * 3406 * Gpu::CPU_CLOCK / 53203425 + 1);
+		REQUIRE((gpu->get_status() & INTERLACE_FIELD_BIT) != (status & INTERLACE_FIELD_BIT));
+		REQUIRE((gpu->get_status() & EVEN_ODD_BIT) != (status & EVEN_ODD_BIT));
+	}
+
+	SECTION("run_frame stops at the start of vblank")
+	{
+		Bus * bus = Bus::get_instance();
+		bus->register_device(Ram::get_instance());
+		bus->register_device(cop0);
+		cop0->set_control_register(system_control::register_names::SR, 0);
+
+		// a loop which only ever branches back to itself
+		const unsigned int code_address = 0x80030100;
+		bus->set_word(code_address, instruction_union(cpu_instructions::BEQ, 0, 0, 0xFFFF).raw);
+		bus->set_word(code_address + 4, 0);
+
+		Cpu * cpu = Cpu::get_instance();
+		cpu->set_mode(cpu_mode::INTERPRETER);
+		cpu->register_file.reset();
+		cpu->current_pc = code_address;
+		cpu->next_pc = code_address;
+		cpu->next_instruction = 0;
+
+		Psx::get_instance()->run_frame();
+		REQUIRE(gpu->num_fields == 1);
+		REQUIRE(gpu->is_in_vblank());
+	}
+
+	scheduler->reset();
+	cop0->interrupt_status_register.value = 0;
+}
\ No newline at end of file
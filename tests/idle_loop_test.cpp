@@ -0,0 +1,136 @@
+#include <catch.hpp>
+
+#include <vector>
+
+#include "../Bus.hpp"
+#include "../Ram.hpp"
+#include "../Cpu.hpp"
+#include "../Gpu.hpp"
+#include "../SystemControlCoprocessor.hpp"
+#include "../IdleLoopDetector.hpp"
+#include "../InstructionTypes.hpp"
+#include "../InstructionEnums.hpp"
+
+namespace
+{
+	const unsigned int CODE_ADDRESS = 0x80030000;
+
+	unsigned int immediate(cpu_instructions op, unsigned int rs, unsigned int rt, unsigned int value)
+	{
+		return instruction_union(op, rs, rt, value & 0xFFFF).raw;
+	}
+
+	// runs the code from the start, returns true if the detector decided it was idle
+	bool run_until_idle(const std::vector<unsigned int>& code, unsigned int num_instructions)
+	{
+		Bus * bus = Bus::get_instance();
+		for (unsigned int idx = 0; idx < code.size(); idx++)
+		{
+			bus->set_word(CODE_ADDRESS + idx * 4, code[idx]);
+		}
+
+		Cpu * cpu = Cpu::get_instance();
+		cpu->set_mode(cpu_mode::INTERPRETER);
+		cpu->register_file.reset();
+		cpu->current_pc = CODE_ADDRESS;
+		cpu->next_pc = CODE_ADDRESS;
+		cpu->current_instruction = 0;
+		cpu->next_instruction = 0;
+
+		IdleLoopDetector * detector = IdleLoopDetector::get_instance();
+		detector->reset();
+		for (unsigned int idx = 0; idx < num_instructions; idx++)
+		{
+			cpu->tick();
+			if (detector->is_idle(cpu))
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+}
+
+TEST_CASE("idle loop detection")
+{
+	Bus * bus = Bus::get_instance();
+	bus->register_device(Ram::get_instance());
+	bus->register_device(SystemControlCoprocessor::get_instance());
+
+	// no interrupts are taken while the loops run
+	SystemControlCoprocessor * cop0 = SystemControlCoprocessor::get_instance();
+	cop0->set_control_register(system_control::register_names::SR, 0);
+	bus->set_word(0x1F801074, 0);
+
+	const unsigned int t0 = 8;
+	const unsigned int t1 = 9;
+	const unsigned int t2 = 10;
+
+	SECTION("polling I_STAT is idle")
+	{
+		std::vector<unsigned int> code = {
+			immediate(cpu_instructions::LUI, 0, t0, 0x1F80),
+			immediate(cpu_instructions::LW, t0, t1, 0x1070),
+			0,
+			immediate(cpu_instructions::ANDI, t1, t1, 0x4),
+			immediate(cpu_instructions::BEQ, t1, 0, -4),
+			0,
+		};
+		REQUIRE(run_until_idle(code, 100));
+	}
+
+	SECTION("polling a flag in memory with the address built in the loop is idle")
+	{
+		std::vector<unsigned int> code = {
+			immediate(cpu_instructions::LUI, 0, t0, 0x8004),
+			immediate(cpu_instructions::LW, t0, t1, 0x10),
+			0,
+			immediate(cpu_instructions::BEQ, t1, 0, -4),
+			0,
+		};
+		bus->set_word(0x80040010, 0);
+		REQUIRE(run_until_idle(code, 100));
+	}
+
+	SECTION("polling GPUSTAT isn't idle, the even/odd bit changes without an event")
+	{
+		Gpu * gpu = Gpu::get_instance();
+		if (gpu->video_ram == nullptr)
+		{
+			gpu->init();
+		}
+		bus->register_device(gpu);
+
+		std::vector<unsigned int> code = {
+			immediate(cpu_instructions::LUI, 0, t0, 0x1F80),
+			immediate(cpu_instructions::LW, t0, t1, 0x1814),
+			0,
+			immediate(cpu_instructions::BGTZ, t1, 0, -4),
+			0,
+		};
+		REQUIRE(run_until_idle(code, 1000) == false);
+	}
+
+	SECTION("a counting loop isn't idle")
+	{
+		std::vector<unsigned int> code = {
+			immediate(cpu_instructions::ADDIU, t2, t2, 1),
+			immediate(cpu_instructions::BNE, t2, 0, -2),
+			0,
+		};
+		REQUIRE(run_until_idle(code, 1000) == false);
+	}
+
+	SECTION("a loop which stores isn't idle")
+	{
+		std::vector<unsigned int> code = {
+			immediate(cpu_instructions::LUI, 0, t0, 0x8004),
+			immediate(cpu_instructions::SW, t0, 0, 0x20),
+			immediate(cpu_instructions::BEQ, 0, 0, -2),
+			0,
+		};
+		REQUIRE(run_until_idle(code, 1000) == false);
+	}
+
+	IdleLoopDetector::get_instance()->reset();
+}
\ No newline at end of file
@@ -0,0 +1,76 @@
+#include <catch.hpp>
+
+#include "../Bus.hpp"
+#include "../Ram.hpp"
+#include "../CacheControl.hpp"
+
+TEST_CASE("instruction cache")
+{
+	Bus * bus = Bus::get_instance();
+	Ram * ram = Ram::get_instance();
+	CacheControl * cache_control = CacheControl::get_instance();
+	bus->register_device(ram);
+
+	cache_control->reset();
+	ram->set_cache_isolated(false);
+
+	const unsigned int code_address = 0x80010000;
+	for (unsigned int idx = 0; idx < 8; idx++)
+	{
+		bus->set_word(code_address + idx * 4, 0x1000 + idx);
+	}
+
+	SECTION("fetches go to memory while the cache is disabled")
+	{
+		REQUIRE(cache_control->fetch_instruction(code_address) == 0x1000);
+		bus->set_word(code_address, 0x2000);
+		REQUIRE(cache_control->fetch_instruction(code_address) == 0x2000);
+	}
+
+	SECTION("hits don't see later writes to memory")
+	{
+		cache_control->cache_control_register.code_cache_enable = true;
+
+		REQUIRE(cache_control->fetch_instruction(code_address + 4) == 0x1001);
+		unsigned long long misses = cache_control->instruction_cache_misses;
+
+		// the whole line was filled, KUSEG shares it with KSEG0
+		bus->set_word(code_address, 0x2000);
+		REQUIRE(cache_control->fetch_instruction(code_address) == 0x1000);
+		REQUIRE(cache_control->fetch_instruction(code_address & 0x1FFFFFFF) == 0x1000);
+		REQUIRE(cache_control->instruction_cache_misses == misses);
+
+		// KSEG1 is never cached
+		REQUIRE(cache_control->fetch_instruction(code_address + 0x20000000) == 0x2000);
+
+		// the next line hasn't been filled
+		REQUIRE(cache_control->fetch_instruction(code_address + 16) == 0x1004);
+		REQUIRE(cache_control->instruction_cache_misses == misses + 2);
+	}
+
+	SECTION("isolated stores invalidate lines without touching memory")
+	{
+		cache_control->cache_control_register.code_cache_enable = true;
+		REQUIRE(cache_control->fetch_instruction(code_address) == 0x1000);
+		bus->set_word(code_address, 0x2000);
+		bus->set_word(0x0, 0x1234);
+		bus->set_word(0x1F800000, 0x5678);
+
+		// what the bios does to flush the cache
+		cache_control->cache_control_register.tag_test_mode = true;
+		ram->set_cache_isolated(true);
+		for (unsigned int address = 0; address < 4096; address += 16)
+		{
+			bus->set_word(address, 0);
+		}
+		ram->set_cache_isolated(false);
+		cache_control->cache_control_register.tag_test_mode = false;
+
+		REQUIRE(bus->get_word(0x0) == 0x1234);
+		REQUIRE(bus->get_word(0x1F800000) == 0x5678);
+		REQUIRE(bus->get_word(code_address) == 0x2000);
+		REQUIRE(cache_control->fetch_instruction(code_address) == 0x2000);
+	}
+
+	cache_control->reset();
+}
\ No newline at end of file
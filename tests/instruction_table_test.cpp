@@ -0,0 +1,88 @@
+#include <catch.hpp>
+
+#include <cstring>
+
+#include "../InstructionTable.hpp"
+#include "../InstructionTypes.hpp"
+#include "../InstructionEnums.hpp"
+
+namespace
+{
+	std::string disassemble(unsigned int raw)
+	{
+		char buffer[64];
+		disassemble_instruction(raw, buffer, sizeof(buffer));
+		return buffer;
+	}
+}
+
+TEST_CASE("instruction table")
+{
+	SECTION("every description decodes back to itself")
+	{
+		for (const instruction_description& description : instruction_descriptions)
+		{
+			if (description.id == instruction_id::UNKNOWN)
+			{
+				continue;
+			}
+
+			unsigned int raw = 0;
+			switch (description.group)
+			{
+				case instruction_group::PRIMARY: raw = description.code << 26; break;
+				case instruction_group::SPECIAL: raw = description.code; break;
+				case instruction_group::BCOND: raw = (1 << 26) | (description.code << 16); break;
+				case instruction_group::COP0_MOVE: raw = (020 << 26) | (description.code << 21); break;
+				case instruction_group::COP2_MOVE: raw = (022 << 26) | (description.code << 21); break;
+				case instruction_group::COP0_FUNCTION: raw = (020 << 26) | (1 << 25) | description.code; break;
+				case instruction_group::GTE_COMMAND: raw = (022 << 26) | (1 << 25) | description.code; break;
+			}
+
+			// the generic cop ids are what's left over once the specific ones are taken out
+			if (description.id == instruction_id::COP0 || description.id == instruction_id::COP2)
+			{
+				raw |= 1 << 25;
+			}
+
+			INFO(description.mnemonic);
+			REQUIRE(decode_instruction(raw) == description.id);
+		}
+	}
+
+	SECTION("unused encodings are unknown")
+	{
+		REQUIRE(decode_instruction(instruction_union(cpu_instructions::SPECIAL, 0, 0, 0).raw | 001) == instruction_id::UNKNOWN);
+		REQUIRE(decode_instruction((1 << 26) | (2 << 16)) == instruction_id::UNKNOWN);
+		REQUIRE(decode_instruction(077u << 26) == instruction_id::UNKNOWN);
+	}
+
+	SECTION("disassembly")
+	{
+		REQUIRE(disassemble(0) == "NOP");
+		REQUIRE(disassemble(instruction_union(cpu_instructions::ADDIU, 9, 8, 0xFFFF).raw) == "ADDIU rt[8], rs[9], 0xffffffff");
+		REQUIRE(disassemble(instruction_union(cpu_instructions::ORI, 9, 8, 0xFFFF).raw) == "ORI rt[8], rs[9], 0xffff");
+		REQUIRE(disassemble(instruction_union(cpu_instructions::LUI, 0, 8, 0x1F80).raw) == "LUI rt[8], 0x1f800000");
+		REQUIRE(disassemble(instruction_union(cpu_instructions::LW, 8, 9, 0x1070).raw) == "LW rt[9], @rs[8]+0x1070");
+		REQUIRE(disassemble(instruction_union(cpu_instructions::BEQ, 9, 0, 0xFFFC).raw) == "BEQ rs[9], rt[0], @+0xfffffff0");
+		REQUIRE(disassemble((022u << 26) | (1 << 25) | 0x180001) == "RTPS 0x180001");
+		REQUIRE(disassemble((020u << 26) | (4 << 21) | (8 << 16) | (12 << 11)) == "MTC0 rt[8], rd[12]");
+	}
+
+	SECTION("long text is cut short")
+	{
+		char buffer[8];
+		unsigned int length = disassemble_instruction(instruction_union(cpu_instructions::LW, 8, 9, 0x1070).raw, buffer, sizeof(buffer));
+		REQUIRE(length == 7);
+		REQUIRE(std::strcmp(buffer, "LW rt[9") == 0);
+	}
+
+	SECTION("flags")
+	{
+		REQUIRE((get_instruction_description(instruction_id::JAL).flags & INSTRUCTION_LINK) != 0);
+		REQUIRE((get_instruction_description(instruction_id::LW).flags & INSTRUCTION_LOAD) != 0);
+		REQUIRE((get_instruction_description(instruction_id::SW).flags & INSTRUCTION_STORE) != 0);
+		REQUIRE((get_instruction_description(instruction_id::RFE).flags & INSTRUCTION_ENDS_BLOCK) != 0);
+		REQUIRE((get_instruction_description(instruction_id::ADDU).flags & INSTRUCTION_BRANCH) == 0);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,103 @@
+#include <catch.hpp>
+
+#include <sstream>
+
+#include "../Bus.hpp"
+#include "../Ram.hpp"
+#include "../Cpu.hpp"
+#include "../SystemControlCoprocessor.hpp"
+#include "../InstructionTypes.hpp"
+#include "../InstructionEnums.hpp"
+
+namespace
+{
+	const unsigned int I_STAT_ADDRESS = 0x1F801070;
+	const unsigned int I_MASK_ADDRESS = 0x1F801074;
+
+	// IEc and interrupt 2 in Im
+	const unsigned int SR_INTERRUPTS_ENABLED = 0x401;
+}
+
+TEST_CASE("interrupt pending flag")
+{
+	Bus * bus = Bus::get_instance();
+	SystemControlCoprocessor * cop0 = SystemControlCoprocessor::get_instance();
+	bus->register_device(Ram::get_instance());
+	bus->register_device(cop0);
+
+	bus->set_word(I_STAT_ADDRESS, 0);
+	bus->set_word(I_MASK_ADDRESS, 0);
+	cop0->set_control_register(system_control::register_names::CAUSE, 0);
+	cop0->set_control_register(system_control::register_names::SR, SR_INTERRUPTS_ENABLED);
+	REQUIRE(cop0->interrupt_pending == false);
+
+	SECTION("the flag follows I_STAT, I_MASK and SR")
+	{
+		cop0->set_irq_bits(system_control::VBLANK_BIT);
+		REQUIRE(cop0->interrupt_pending == false);
+
+		bus->set_word(I_MASK_ADDRESS, system_control::VBLANK_BIT);
+		REQUIRE(cop0->interrupt_pending);
+		REQUIRE((cop0->get_control_register(system_control::register_names::CAUSE) & 0x400) != 0);
+
+		cop0->set_control_register(system_control::register_names::SR, SR_INTERRUPTS_ENABLED & ~0x1);
+		REQUIRE(cop0->interrupt_pending == false);
+		cop0->set_control_register(system_control::register_names::SR, SR_INTERRUPTS_ENABLED);
+		REQUIRE(cop0->interrupt_pending);
+
+		// acknowledging it in I_STAT drops the line
+		bus->set_word(I_STAT_ADDRESS, ~system_control::VBLANK_BIT);
+		REQUIRE(cop0->interrupt_pending == false);
+		REQUIRE((cop0->get_control_register(system_control::register_names::CAUSE) & 0x400) == 0);
+	}
+
+	SECTION("taking the interrupt clears the flag until rfe")
+	{
+		const unsigned int code_address = 0x80030200;
+		bus->set_word(code_address, instruction_union(cpu_instructions::BEQ, 0, 0, 0x10).raw);
+		bus->set_word(code_address + 4, 0);
+		bus->set_word(0x80000080, 0);
+
+		Cpu * cpu = Cpu::get_instance();
+		cpu->set_mode(cpu_mode::INTERPRETER);
+		cpu->register_file.reset();
+		cpu->current_pc = code_address;
+		cpu->next_pc = code_address;
+		cpu->next_instruction = 0;
+		cpu->tick();
+
+		// raised after the branch, so EPC is the branch and BD is set
+		bus->set_word(I_MASK_ADDRESS, system_control::DMA_BIT);
+		cop0->set_irq_bits(system_control::DMA_BIT);
+		cpu->tick();
+		REQUIRE(cop0->interrupt_pending == false);
+		REQUIRE(cpu->next_pc == 0x80000080);
+		REQUIRE(cop0->get_control_register(system_control::register_names::EPC) == code_address);
+		REQUIRE((cop0->get_control_register(system_control::register_names::CAUSE) & 0x80000000) != 0);
+
+		// rfe
+		cop0->execute(instruction_union(0x42000010u));
+		REQUIRE(cop0->interrupt_pending);
+	}
+
+	SECTION("save states keep I_STAT and I_MASK")
+	{
+		bus->set_word(I_MASK_ADDRESS, system_control::CDROM_BIT);
+		cop0->set_irq_bits(system_control::CDROM_BIT);
+
+		std::stringstream state;
+		cop0->save_state(state);
+		bus->set_word(I_STAT_ADDRESS, 0);
+		bus->set_word(I_MASK_ADDRESS, 0);
+		cop0->load_state(state);
+
+		REQUIRE(cop0->interrupt_status_register.value == system_control::CDROM_BIT);
+		REQUIRE(cop0->interrupt_mask_register.value == system_control::CDROM_BIT);
+		REQUIRE(cop0->interrupt_pending);
+	}
+
+	bus->set_word(I_STAT_ADDRESS, 0);
+	bus->set_word(I_MASK_ADDRESS, 0);
+	cop0->set_control_register(system_control::register_names::CAUSE, 0);
+	cop0->set_control_register(system_control::register_names::SR, 0);
+}
\ No newline at end of file
@@ -0,0 +1,118 @@
+#include <catch.hpp>
+
+#include <vector>
+#include <string>
+
+#include "../Iso9660.hpp"
+
+namespace
+{
+	const unsigned int SECTOR_SIZE = 2352;
+
+	// mode 2 sectors, the data starts after the sync, header and subheader
+	unsigned char * get_data(std::vector<unsigned char>& disc, unsigned int lba)
+	{
+		disc[lba * SECTOR_SIZE + 15] = 2;
+		return &disc[lba * SECTOR_SIZE + 24];
+	}
+
+	void set_word(unsigned char * data, unsigned int value)
+	{
+		for (unsigned int idx = 0; idx < 4; idx++)
+		{
+			data[idx] = (value >> (idx * 8)) & 0xFF;
+		}
+	}
+
+	// returns the size of the record
+	unsigned int add_record(unsigned char * data, unsigned int lba, unsigned int size, bool is_directory, const std::string& name)
+	{
+		unsigned int length = 33 + name.size() + ((name.size() & 1) ? 0 : 1);
+		data[0] = length;
+		set_word(data + 2, lba);
+		set_word(data + 10, size);
+		data[25] = is_directory ? 0x2 : 0x0;
+		data[32] = name.size();
+		memcpy(data + 33, name.data(), name.size());
+		return length;
+	}
+
+	// \SYSTEM.CNF in the root and \DATA\LEVEL.BIN across two sectors
+	std::vector<unsigned char> make_disc()
+	{
+		std::vector<unsigned char> disc(26 * SECTOR_SIZE, 0);
+
+		unsigned char * volume_descriptor = get_data(disc, 16);
+		volume_descriptor[0] = 1;
+		memcpy(volume_descriptor + 1, "CD001", 5);
+		set_word(volume_descriptor + 132, 22);
+		set_word(volume_descriptor + 140, 18);
+
+		unsigned char * path_table = get_data(disc, 18);
+		const unsigned char root_entry[] = { 1, 0, 20, 0, 0, 0, 1, 0, 0, 0 };
+		const unsigned char data_entry[] = { 4, 0, 21, 0, 0, 0, 1, 0, 'D', 'A', 'T', 'A' };
+		memcpy(path_table, root_entry, sizeof(root_entry));
+		memcpy(path_table + sizeof(root_entry), data_entry, sizeof(data_entry));
+
+		unsigned char * root = get_data(disc, 20);
+		root += add_record(root, 20, 2048, true, std::string(1, '\0'));
+		root += add_record(root, 20, 2048, true, std::string(1, '\1'));
+		root += add_record(root, 21, 2048, true, "DATA");
+		root += add_record(root, 22, 32, false, "SYSTEM.CNF;1");
+
+		unsigned char * data = get_data(disc, 21);
+		data += add_record(data, 21, 2048, true, std::string(1, '\0'));
+		data += add_record(data, 20, 2048, true, std::string(1, '\1'));
+		data += add_record(data, 23, 3000, false, "LEVEL.BIN;1");
+
+		memcpy(get_data(disc, 22), "BOOT = cdrom:\\DATA\\LEVEL.BIN;1\r\n", 32);
+		memset(get_data(disc, 23), 0xAA, 2048);
+		memset(get_data(disc, 24), 0xBB, 2048);
+		return disc;
+	}
+}
+
+TEST_CASE("iso9660 index")
+{
+	std::vector<unsigned char> disc = make_disc();
+	Iso9660 filesystem;
+	REQUIRE(filesystem.build(disc));
+
+	SECTION("files are found however the path is written")
+	{
+		const iso_file * system_cnf = filesystem.find("SYSTEM.CNF");
+		REQUIRE(system_cnf != nullptr);
+		REQUIRE(system_cnf->lba == 22);
+		REQUIRE(system_cnf->size == 32);
+		REQUIRE(filesystem.find("cdrom:\\system.cnf;1") == system_cnf);
+		REQUIRE(filesystem.find("/DATA/LEVEL.BIN") != nullptr);
+		REQUIRE(filesystem.find("\\DATA")->is_directory);
+		REQUIRE(filesystem.find("\\MISSING.BIN") == nullptr);
+	}
+
+	SECTION("files are read across sectors")
+	{
+		std::vector<unsigned char> level;
+		REQUIRE(filesystem.read_file(disc, "\\DATA\\LEVEL.BIN", level));
+		REQUIRE(level.size() == 3000);
+		REQUIRE(level[2047] == 0xAA);
+		REQUIRE(level[2048] == 0xBB);
+		REQUIRE(level[2999] == 0xBB);
+		REQUIRE(filesystem.read_file(disc, "\\DATA", level) == false);
+	}
+
+	SECTION("sectors are traced back to their file")
+	{
+		REQUIRE(*filesystem.find_path(22) == "\\SYSTEM.CNF");
+		REQUIRE(*filesystem.find_path(24) == "\\DATA\\LEVEL.BIN");
+		REQUIRE(filesystem.find_path(16) == nullptr);
+		REQUIRE(filesystem.find_path(25) == nullptr);
+	}
+
+	SECTION("a disc without a filesystem has nothing to index")
+	{
+		disc[16 * SECTOR_SIZE + 24] = 0;
+		REQUIRE(filesystem.build(disc) == false);
+		REQUIRE(filesystem.find("SYSTEM.CNF") == nullptr);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,42 @@
+#include <catch.hpp>
+
+#include "../Bus.hpp"
+#include "../MemoryControl.hpp"
+
+TEST_CASE("memory control read timings")
+{
+	Bus * bus = Bus::get_instance();
+	MemoryControl * memory_control = MemoryControl::get_instance();
+	bus->register_device(memory_control);
+	memory_control->reset();
+
+	SECTION("fixed timings")
+	{
+		const unsigned int main_memory_cycles = MemoryControl::MAIN_MEMORY_READ_CYCLES;
+		const unsigned int io_cycles = MemoryControl::IO_READ_CYCLES;
+		REQUIRE(memory_control->get_read_cycles(0x80010000, Bus::io_width::WORD) == main_memory_cycles);
+		REQUIRE(memory_control->get_read_cycles(0x00610000, Bus::io_width::BYTE) == main_memory_cycles);
+		REQUIRE(memory_control->get_read_cycles(0x1F800010, Bus::io_width::WORD) == 0);
+		REQUIRE(memory_control->get_read_cycles(0x1F801070, Bus::io_width::WORD) == io_cycles);
+		REQUIRE(memory_control->get_read_cycles(0xFFFE0130, Bus::io_width::WORD) == 0);
+	}
+
+	SECTION("the bios is on an 8 bit bus")
+	{
+		unsigned int byte_cycles = memory_control->get_read_cycles(0xBFC00000, Bus::io_width::BYTE);
+		unsigned int word_cycles = memory_control->get_read_cycles(0xBFC00000, Bus::io_width::WORD);
+		REQUIRE(byte_cycles == 7);
+		REQUIRE(word_cycles == 25);
+	}
+
+	SECTION("writing a delay register changes the timings")
+	{
+		// the same but with a 16 bit bus
+		bus->set_word(0x1F801010, 0x0013343F);
+		REQUIRE(bus->get_word(0x1F801010) == 0x0013343F);
+		REQUIRE(memory_control->get_read_cycles(0xBFC00000, Bus::io_width::HALFWORD) == 7);
+		REQUIRE(memory_control->get_read_cycles(0xBFC00000, Bus::io_width::WORD) == 7 + 6);
+	}
+
+	memory_control->reset();
+}
\ No newline at end of file
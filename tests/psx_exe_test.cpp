@@ -0,0 +1,81 @@
+#include <catch.hpp>
+
+#include <vector>
+
+#include "../Bus.hpp"
+#include "../Ram.hpp"
+#include "../Cpu.hpp"
+#include "../CacheControl.hpp"
+#include "../PsxExe.hpp"
+
+namespace
+{
+	void set_word(std::vector<unsigned char>& data, unsigned int offset, unsigned int value)
+	{
+		for (unsigned int idx = 0; idx < 4; idx++)
+		{
+			data[offset + idx] = (value >> (idx * 8)) & 0xFF;
+		}
+	}
+}
+
+TEST_CASE("psx exe")
+{
+	Bus * bus = Bus::get_instance();
+	bus->register_device(Ram::get_instance());
+	CacheControl * cache_control = CacheControl::get_instance();
+	cache_control->reset();
+
+	const unsigned int text_address = 0x80010000;
+	const unsigned int entry = text_address + 8;
+
+	std::vector<unsigned char> data(0x800 + 0x10, 0);
+	memcpy(data.data(), "PS-X EXE", 8);
+	set_word(data, 0x10, entry);
+	set_word(data, 0x14, 0x80018000);
+	set_word(data, 0x18, text_address);
+	set_word(data, 0x1C, 0x800);
+	set_word(data, 0x28, 0x80020000);
+	set_word(data, 0x2C, 0x10);
+	set_word(data, 0x30, 0x801FFF00);
+	set_word(data, 0x34, 0x100);
+	for (unsigned int idx = 0; idx < 4; idx++)
+	{
+		set_word(data, 0x800 + idx * 4, 0x1000 + idx);
+	}
+
+	PsxExe exe;
+	REQUIRE(exe.parse(data));
+	// the header asks for more text than there is
+	REQUIRE(exe.text.size() == 0x10);
+
+	SECTION("starting copies the text and sets up the cpu")
+	{
+		bus->set_word(0x80020004, 0xFFFFFFFF);
+
+		// the line the entry point is in was cached before the text was copied
+		cache_control->cache_control_register.code_cache_enable = true;
+		cache_control->fetch_instruction(entry);
+
+		exe.start();
+
+		Cpu * cpu = Cpu::get_instance();
+		REQUIRE(bus->get_word(text_address + 4) == 0x1001);
+		REQUIRE(bus->get_word(0x80020004) == 0);
+		REQUIRE(cpu->current_pc == entry);
+		REQUIRE(cpu->next_pc == entry + 4);
+		REQUIRE(cpu->next_instruction == 0x1002);
+		REQUIRE(cpu->register_file.get_register(28) == 0x80018000);
+		REQUIRE(cpu->register_file.get_register(29) == 0x80200000);
+	}
+
+	SECTION("anything else isn't an exe")
+	{
+		data[0] = 'X';
+		REQUIRE(exe.parse(data) == false);
+		data.resize(0x100);
+		REQUIRE(exe.parse(data) == false);
+	}
+
+	cache_control->reset();
+}
\ No newline at end of file
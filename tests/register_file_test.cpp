@@ -0,0 +1,129 @@
+#include <catch.hpp>
+
+#include <random>
+#include <cstring>
+
+#include "../RegisterFile.hpp"
+
+namespace
+{
+	// the register file as it was before the pending load slots, three copies of every register
+	// which are shifted along every instruction
+	class StagedRegisterFile
+	{
+	public:
+		void tick()
+		{
+			memcpy(stage_3_registers, stage_2_registers, sizeof(stage_3_registers));
+			memcpy(stage_2_registers, stage_1_registers, sizeof(stage_2_registers));
+		}
+
+		unsigned int get_register(unsigned int index, bool ignore_load_delay = false)
+		{
+			return ignore_load_delay ? stage_1_registers[index] : stage_3_registers[index];
+		}
+
+		void set_register(unsigned int index, unsigned int value, bool load_delay = false)
+		{
+			if (index != 0)
+			{
+				if (load_delay)
+				{
+					stage_1_registers[index] = value;
+				}
+				else
+				{
+					stage_1_registers[index] = stage_2_registers[index] = stage_3_registers[index] = value;
+				}
+			}
+		}
+
+	private:
+		unsigned int stage_1_registers[32] = { 0 };
+		unsigned int stage_2_registers[32] = { 0 };
+		unsigned int stage_3_registers[32] = { 0 };
+	};
+}
+
+TEST_CASE("Register file load delay")
+{
+	RegisterFile register_file;
+	register_file.reset();
+
+	SECTION("A load lands after the next instruction")
+	{
+		register_file.set_register(1, 5);
+		register_file.tick();
+
+		register_file.set_register(1, 10, true);
+		REQUIRE(register_file.get_register(1) == 5);
+		REQUIRE(register_file.get_register(1, true) == 10);
+		register_file.tick();
+
+		REQUIRE(register_file.get_register(1) == 5);
+		register_file.tick();
+
+		REQUIRE(register_file.get_register(1) == 10);
+	}
+
+	SECTION("A write in the delay slot wins over the load")
+	{
+		register_file.set_register(1, 10, true);
+		register_file.tick();
+
+		register_file.set_register(1, 20);
+		register_file.tick();
+		register_file.tick();
+
+		REQUIRE(register_file.get_register(1) == 20);
+	}
+
+	SECTION("Register 0 is never written")
+	{
+		register_file.set_register(0, 10);
+		register_file.set_register(0, 20, true);
+		register_file.tick();
+		register_file.tick();
+
+		REQUIRE(register_file.get_register(0) == 0);
+		REQUIRE(register_file.get_register(0, true) == 0);
+	}
+
+	// every instruction reads a couple of registers (some like LWL and LWR do), then writes at most one,
+	// with or without the load delay, the same as the cpu does
+	SECTION("Random instruction sequences match the staged register file")
+	{
+		std::mt19937 random(1234);
+		StagedRegisterFile staged;
+
+		for (unsigned int instruction = 0; instruction < 100000; instruction++)
+		{
+			// only a few registers so loads and writes keep landing on each other
+			unsigned int num_reads = random() % 3;
+			for (unsigned int idx = 0; idx < num_reads; idx++)
+			{
+				unsigned int index = random() % 4;
+				bool ignore_load_delay = random() % 4 == 0;
+				REQUIRE(register_file.get_register(index, ignore_load_delay) == staged.get_register(index, ignore_load_delay));
+			}
+
+			unsigned int write = random() % 3;
+			if (write > 0)
+			{
+				unsigned int index = random() % 4;
+				unsigned int value = random();
+				register_file.set_register(index, value, write == 2);
+				staged.set_register(index, value, write == 2);
+			}
+
+			register_file.tick();
+			staged.tick();
+
+			for (unsigned int index = 0; index < 32; index++)
+			{
+				REQUIRE(register_file.get_register(index) == staged.get_register(index));
+				REQUIRE(register_file.get_register(index, true) == staged.get_register(index, true));
+			}
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,158 @@
+#include <catch.hpp>
+
+#include <sstream>
+#include <vector>
+
+#include "../Bus.hpp"
+#include "../Ram.hpp"
+#include "../Cpu.hpp"
+#include "../Psx.hpp"
+#include "../SystemControlCoprocessor.hpp"
+#include "../Scheduler.hpp"
+#include "../InstructionTypes.hpp"
+#include "../InstructionEnums.hpp"
+
+namespace
+{
+	// the cycle each handler ran on
+	std::vector<std::pair<scheduler_event, unsigned long long>> handled;
+
+	void record_cdrom(void * /*context*/)
+	{
+		handled.push_back({ scheduler_event::CDROM, Scheduler::get_instance()->current_cycle });
+	}
+
+	void record_dma(void * /*context*/)
+	{
+		handled.push_back({ scheduler_event::DMA, Scheduler::get_instance()->current_cycle });
+	}
+}
+
+TEST_CASE("scheduler")
+{
+	Scheduler * scheduler = Scheduler::get_instance();
+	scheduler->reset();
+	scheduler->register_event(scheduler_event::CDROM, nullptr, record_cdrom);
+	scheduler->register_event(scheduler_event::DMA, nullptr, record_dma);
+	handled.clear();
+
+	SECTION("events run once they're due, earliest first")
+	{
+		scheduler->schedule(scheduler_event::CDROM, 300);
+		scheduler->schedule(scheduler_event::DMA, 100);
+		REQUIRE(scheduler->get_next_event_cycle() == 100);
+
+		scheduler->current_cycle = 50;
+		scheduler->run_due_events();
+		REQUIRE(handled.empty());
+
+		scheduler->current_cycle = 400;
+		scheduler->run_due_events();
+		REQUIRE(handled.size() == 2);
+		REQUIRE(handled[0].first == scheduler_event::DMA);
+		REQUIRE(handled[1].first == scheduler_event::CDROM);
+		REQUIRE(scheduler->get_next_event_cycle() == Scheduler::NEVER);
+	}
+
+	SECTION("rescheduling replaces the deadline and cancelled events don't run")
+	{
+		scheduler->schedule(scheduler_event::DMA, 100);
+		scheduler->schedule(scheduler_event::CDROM, 200);
+		scheduler->schedule(scheduler_event::DMA, 500);
+		REQUIRE(scheduler->get_next_event_cycle() == 200);
+
+		scheduler->cancel(scheduler_event::CDROM);
+		REQUIRE(scheduler->is_scheduled(scheduler_event::CDROM) == false);
+		REQUIRE(scheduler->get_next_event_cycle() == 500);
+
+		scheduler->current_cycle = 1000;
+		scheduler->run_due_events();
+		REQUIRE(handled.size() == 1);
+		REQUIRE(handled[0].first == scheduler_event::DMA);
+	}
+
+	SECTION("periodic events catch up without drifting")
+	{
+		scheduler->register_event(scheduler_event::DMA, nullptr, [](void * /*context*/) {
+			Scheduler * scheduler = Scheduler::get_instance();
+			record_dma(nullptr);
+			scheduler->schedule(scheduler_event::DMA, scheduler->get_event_cycle(scheduler_event::DMA) + 100);
+		});
+		scheduler->schedule(scheduler_event::DMA, 100);
+
+		scheduler->current_cycle = 1050;
+		scheduler->run_due_events();
+		REQUIRE(handled.size() == 10);
+		REQUIRE(scheduler->get_next_event_cycle() == 1100);
+	}
+
+	SECTION("run_events_until runs each event on the cycle it's due")
+	{
+		scheduler->schedule(scheduler_event::CDROM, 300);
+		scheduler->schedule(scheduler_event::DMA, 100);
+		scheduler->run_events_until(500);
+
+		REQUIRE(handled.size() == 2);
+		REQUIRE(handled[0].second == 100);
+		REQUIRE(handled[1].second == 300);
+		REQUIRE(scheduler->current_cycle == 500);
+	}
+
+	SECTION("save states keep the time and the events which were due")
+	{
+		scheduler->current_cycle = 1000;
+		scheduler->schedule(scheduler_event::CDROM, 1300);
+		scheduler->schedule(scheduler_event::DMA, 1100);
+
+		std::stringstream state;
+		scheduler->save_state(state);
+
+		scheduler->reset();
+		scheduler->schedule(scheduler_event::CDROM, 50);
+		scheduler->load_state(state);
+
+		REQUIRE(scheduler->current_cycle == 1000);
+		REQUIRE(scheduler->get_next_event_cycle() == 1100);
+		REQUIRE(scheduler->get_event_cycle(scheduler_event::CDROM) == 1300);
+		REQUIRE(scheduler->is_scheduled(scheduler_event::GPU) == false);
+
+		scheduler->current_cycle = 2000;
+		scheduler->run_due_events();
+		REQUIRE(handled.size() == 2);
+		REQUIRE(handled[0].first == scheduler_event::DMA);
+		REQUIRE(handled[1].first == scheduler_event::CDROM);
+	}
+
+	SECTION("run_until stops the cpu for events and at the target")
+	{
+		Bus * bus = Bus::get_instance();
+		bus->register_device(Ram::get_instance());
+		bus->register_device(SystemControlCoprocessor::get_instance());
+		SystemControlCoprocessor::get_instance()->set_control_register(system_control::register_names::SR, 0);
+
+		// a loop which only ever branches back to itself
+		const unsigned int code_address = 0x80030100;
+		bus->set_word(code_address, instruction_union(cpu_instructions::BEQ, 0, 0, 0xFFFF).raw);
+		bus->set_word(code_address + 4, 0);
+
+		Cpu * cpu = Cpu::get_instance();
+		cpu->set_mode(cpu_mode::INTERPRETER);
+		cpu->register_file.reset();
+		cpu->current_pc = code_address;
+		cpu->next_pc = code_address;
+		cpu->next_instruction = 0;
+
+		scheduler->schedule(scheduler_event::CDROM, 5000);
+		Psx::get_instance()->run_until(10000);
+
+		REQUIRE(handled.size() == 1);
+		REQUIRE(handled[0].second >= 5000);
+		REQUIRE(handled[0].second < 5100);
+		REQUIRE(scheduler->current_cycle >= 10000);
+		REQUIRE(scheduler->current_cycle < 10100);
+	}
+
+	scheduler->register_event(scheduler_event::CDROM, nullptr, nullptr);
+	scheduler->register_event(scheduler_event::DMA, nullptr, nullptr);
+	scheduler->reset();
+}
\ No newline at end of file
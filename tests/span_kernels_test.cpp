@@ -0,0 +1,88 @@
+#include <catch.hpp>
+
+#include <random>
+#include <vector>
+
+#include "../SpanKernels.hpp"
+
+namespace
+{
+	const unsigned short SENTINEL = 0xDEAD;
+	const unsigned int MAX_SPAN_LENGTH = 100;
+
+	const SpanKernels::kernel_set KERNEL_SETS[] = { SpanKernels::kernel_set::SCALAR, SpanKernels::kernel_set::SSE41, SpanKernels::kernel_set::AVX2 };
+
+	// starts and ends somewhere between 0 and 255.5, like the rasterizer's rounded colours
+	SpanKernels::gouraud_span random_gouraud(std::mt19937& random, unsigned int num_pixels)
+	{
+		std::uniform_int_distribution<int> colour_distribution(0, (255 << 16) + 0x8000);
+		SpanKernels::gouraud_span gouraud;
+		for (unsigned int channel = 0; channel < 3; channel++)
+		{
+			int start = colour_distribution(random);
+			int end = colour_distribution(random);
+			gouraud.colour[channel] = start;
+			gouraud.colour_step[channel] = num_pixels > 1 ? (end - start) / static_cast<int>(num_pixels - 1) : 0;
+		}
+		return gouraud;
+	}
+}
+
+TEST_CASE("span kernels")
+{
+	SpanKernels * span_kernels = SpanKernels::get_instance();
+	SpanKernels::kernel_set previous_set = span_kernels->get_kernel_set();
+
+	SECTION("the scalar kernels pack each pixel's colour")
+	{
+		std::vector<unsigned short> span(4, SENTINEL);
+		SpanKernels::gouraud_span gouraud = { { 0, 0xFF0000, 0x800000 }, { 0x80000, -0x40000, 0 } };
+		SpanKernels::shade_scalar(&span[0], 3, gouraud);
+
+		REQUIRE(span[0] == SpanKernels::to_vram_colour(0, 0xFF, 0x80));
+		REQUIRE(span[1] == SpanKernels::to_vram_colour(0x8, 0xFB, 0x80));
+		REQUIRE(span[2] == SpanKernels::to_vram_colour(0x10, 0xF7, 0x80));
+		REQUIRE(span[3] == SENTINEL);
+
+		SpanKernels::fill_scalar(&span[0], 2, 0x1234);
+		REQUIRE(span[0] == 0x1234);
+		REQUIRE(span[1] == 0x1234);
+		REQUIRE(span[2] == SpanKernels::to_vram_colour(0x10, 0xF7, 0x80));
+	}
+
+	SECTION("every supported kernel set writes exactly what the scalar kernels do")
+	{
+		std::mt19937 random(1234);
+		for (SpanKernels::kernel_set set : KERNEL_SETS)
+		{
+			if (span_kernels->is_supported(set) == false)
+			{
+				continue;
+			}
+			span_kernels->set_kernel_set(set);
+			REQUIRE(span_kernels->get_kernel_set() == set);
+
+			for (unsigned int num_pixels = 0; num_pixels <= MAX_SPAN_LENGTH; num_pixels++)
+			{
+				// starting at each alignment, with a pixel either side to catch anything written out of the span
+				for (unsigned int offset = 1; offset <= 8; offset++)
+				{
+					std::vector<unsigned short> expected(MAX_SPAN_LENGTH + 16, SENTINEL);
+					std::vector<unsigned short> actual(MAX_SPAN_LENGTH + 16, SENTINEL);
+
+					SpanKernels::gouraud_span gouraud = random_gouraud(random, num_pixels);
+					SpanKernels::shade_scalar(&expected[offset], num_pixels, gouraud);
+					span_kernels->shade(&actual[offset], num_pixels, gouraud);
+					REQUIRE(actual == expected);
+
+					unsigned short colour = static_cast<unsigned short>(random());
+					SpanKernels::fill_scalar(&expected[offset], num_pixels, colour);
+					span_kernels->fill(&actual[offset], num_pixels, colour);
+					REQUIRE(actual == expected);
+				}
+			}
+		}
+	}
+
+	span_kernels->set_kernel_set(previous_set);
+}
\ No newline at end of file
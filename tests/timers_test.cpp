@@ -0,0 +1,134 @@
+#include <catch.hpp>
+
+#include "../Bus.hpp"
+#include "../Gpu.hpp"
+#include "../Timers.hpp"
+#include "../Scheduler.hpp"
+#include "../SystemControlCoprocessor.hpp"
+
+namespace
+{
+	const unsigned int TIMER_ADDRESSES[] = { 0x1F801100, 0x1F801110, 0x1F801120 };
+	const unsigned int GP1_ADDRESS = 0x1F801814;
+
+	const unsigned int MODE_RESET_AT_TARGET = 0x1 << 3;
+	const unsigned int MODE_IRQ_AT_TARGET = 0x1 << 4;
+	const unsigned int MODE_IRQ_AT_MAX = 0x1 << 5;
+	const unsigned int MODE_IRQ_REPEAT = 0x1 << 6;
+	const unsigned int MODE_REACHED_TARGET = 0x1 << 11;
+	const unsigned int MODE_REACHED_MAX = 0x1 << 12;
+
+	unsigned int read_counter(unsigned int timer_idx)
+	{
+		return Bus::get_instance()->get_halfword(TIMER_ADDRESSES[timer_idx] + Timers::COUNTER_OFFSET);
+	}
+}
+
+TEST_CASE("timers")
+{
+	Bus * bus = Bus::get_instance();
+	Gpu * gpu = Gpu::get_instance();
+	Timers * timers = Timers::get_instance();
+	Scheduler * scheduler = Scheduler::get_instance();
+	SystemControlCoprocessor * cop0 = SystemControlCoprocessor::get_instance();
+	if (gpu->video_ram == nullptr)
+	{
+		gpu->init();
+	}
+	timers->init();
+	bus->register_device(timers);
+
+	scheduler->reset();
+	gpu->reset();
+	timers->reset();
+	cop0->interrupt_status_register.value = 0;
+
+	SECTION("counters are worked out from the time they're read")
+	{
+		scheduler->run_events_until(1000);
+		REQUIRE(read_counter(0) == 1000);
+		REQUIRE(read_counter(1) == 1000);
+
+		// timer 2 can count at an eighth of the system clock, the part of a tick left over isn't lost
+		bus->set_halfword(TIMER_ADDRESSES[2] + Timers::MODE_OFFSET, 0x200);
+		scheduler->run_events_until(1100);
+		REQUIRE(read_counter(2) == 12);
+		scheduler->run_events_until(1104);
+		REQUIRE(read_counter(2) == 13);
+
+		// writing the counter carries on from the value written
+		bus->set_halfword(TIMER_ADDRESSES[0] + Timers::COUNTER_OFFSET, 0xFFF0);
+		scheduler->run_events_until(1120);
+		REQUIRE(read_counter(0) == 0);
+		REQUIRE((bus->get_halfword(TIMER_ADDRESSES[0] + Timers::MODE_OFFSET) & MODE_REACHED_MAX) != 0);
+		REQUIRE((bus->get_halfword(TIMER_ADDRESSES[0] + Timers::MODE_OFFSET) & MODE_REACHED_MAX) == 0);
+	}
+
+	SECTION("byte writes to the mode don't clear the reached flags")
+	{
+		bus->set_halfword(TIMER_ADDRESSES[0] + Timers::COUNTER_OFFSET, 0xFFF0);
+		scheduler->run_events_until(0x20);
+		bus->set_byte(TIMER_ADDRESSES[0] + Timers::MODE_OFFSET, 0);
+		REQUIRE((bus->get_halfword(TIMER_ADDRESSES[0] + Timers::MODE_OFFSET) & MODE_REACHED_MAX) != 0);
+	}
+
+	SECTION("target irqs are scheduled for the cycle the counter reaches the target")
+	{
+		bus->set_halfword(TIMER_ADDRESSES[0] + Timers::TARGET_OFFSET, 99);
+		bus->set_halfword(TIMER_ADDRESSES[0] + Timers::MODE_OFFSET, MODE_RESET_AT_TARGET | MODE_IRQ_AT_TARGET | MODE_IRQ_REPEAT);
+		REQUIRE(scheduler->get_event_cycle(scheduler_event::TIMER0) == 99);
+
+		scheduler->run_events_until(98);
+		REQUIRE((cop0->interrupt_status_register.value & system_control::TMR0_BIT) == 0);
+		scheduler->run_events_until(99);
+		REQUIRE((cop0->interrupt_status_register.value & system_control::TMR0_BIT) != 0);
+		REQUIRE(read_counter(0) == 99);
+
+		// it resets after the target and keeps going
+		scheduler->run_events_until(100);
+		REQUIRE(read_counter(0) == 0);
+		REQUIRE((bus->get_halfword(TIMER_ADDRESSES[0] + Timers::MODE_OFFSET) & MODE_REACHED_TARGET) != 0);
+		REQUIRE(scheduler->get_event_cycle(scheduler_event::TIMER0) == 199);
+	}
+
+	SECTION("one shot irqs only fire once")
+	{
+		bus->set_halfword(TIMER_ADDRESSES[1] + Timers::MODE_OFFSET, MODE_IRQ_AT_MAX);
+		REQUIRE(scheduler->get_event_cycle(scheduler_event::TIMER1) == 0xFFFF);
+
+		scheduler->run_events_until(0x10000);
+		REQUIRE((cop0->interrupt_status_register.value & system_control::TMR1_BIT) != 0);
+		REQUIRE(scheduler->is_scheduled(scheduler_event::TIMER1) == false);
+	}
+
+	SECTION("timer 1 can count scanlines")
+	{
+		bus->set_halfword(TIMER_ADDRESSES[1] + Timers::MODE_OFFSET, 0x100);
+		scheduler->run_events_until(2000000);
+		REQUIRE(read_counter(1) == gpu->get_num_scanlines());
+		REQUIRE(read_counter(1) > 263);
+	}
+
+	SECTION("timer 0 counts dots at the resolution there was at the time")
+	{
+		// 256 wide is 7 * 10 / 11 cycles a dot, 640 wide 7 * 4 / 11
+		bus->set_halfword(TIMER_ADDRESSES[0] + Timers::MODE_OFFSET, 0x100);
+		scheduler->run_events_until(700);
+		bus->register_device(gpu);
+		bus->set_word(GP1_ADDRESS, 0x08000003);
+		scheduler->run_events_until(980);
+		REQUIRE(read_counter(0) == 220);
+	}
+
+	SECTION("timer 2's sync modes 0 and 3 stop it")
+	{
+		bus->set_halfword(TIMER_ADDRESSES[2] + Timers::MODE_OFFSET, 0x1);
+		scheduler->run_events_until(1000);
+		REQUIRE(read_counter(2) == 0);
+	}
+
+	scheduler->reset();
+	gpu->reset();
+	timers->reset();
+	cop0->interrupt_status_register.value = 0;
+}
\ No newline at end of file
@@ -0,0 +1,88 @@
+#pragma once
+#include <vector>
+
+// one bit per block of memory, set when the block is written and cleared by whoever consumes the changes
+class DirtyBitmap
+{
+public:
+	DirtyBitmap(unsigned int _num_entries)
+	{
+		num_entries = _num_entries;
+		bits.resize((num_entries + BITS_PER_WORD - 1) / BITS_PER_WORD, 0);
+	}
+
+	// returns true if the entry was clean before
+	bool set(unsigned int index)
+	{
+		unsigned long long & word = bits[index / BITS_PER_WORD];
+		unsigned long long mask = 1ull << (index % BITS_PER_WORD);
+		bool was_clean = (word & mask) == 0;
+		word |= mask;
+		return was_clean;
+	}
+
+	void clear(unsigned int index)
+	{
+		bits[index / BITS_PER_WORD] &= ~(1ull << (index % BITS_PER_WORD));
+	}
+
+	bool is_set(unsigned int index) const
+	{
+		return (bits[index / BITS_PER_WORD] >> (index % BITS_PER_WORD)) & 0x1;
+	}
+
+	void set_all()
+	{
+		for (unsigned int index = 0; index < num_entries; index++)
+		{
+			set(index);
+		}
+	}
+
+	void clear_all()
+	{
+		for (unsigned long long & word : bits)
+		{
+			word = 0;
+		}
+	}
+
+	bool any() const
+	{
+		for (unsigned long long word : bits)
+		{
+			if (word != 0)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// appends the index of every set entry
+	void get_set(std::vector<unsigned int>& indices) const
+	{
+		for (unsigned int word_index = 0; word_index < bits.size(); word_index++)
+		{
+			unsigned long long word = bits[word_index];
+			for (unsigned int bit = 0; word != 0; bit++, word >>= 1)
+			{
+				if (word & 0x1)
+				{
+					indices.push_back(word_index * BITS_PER_WORD + bit);
+				}
+			}
+		}
+	}
+
+	unsigned int get_num_entries() const
+	{
+		return num_entries;
+	}
+
+private:
+	static const unsigned int BITS_PER_WORD = 64;
+
+	unsigned int num_entries = 0;
+	std::vector<unsigned long long> bits;
+};
\ No newline at end of file
@@ -58,6 +58,16 @@ public:
 		return value;
 	}
 
+	// pops up to count values in one go, returns how many there were
+	unsigned int pop_bulk(T* destination, unsigned int count)
+	{
+		unsigned int num_values = count < current_size ? count : current_size;
+		memcpy((unsigned char*)destination, (unsigned char*)(buffer + top_index), num_values * sizeof(T));
+		top_index += num_values;
+		current_size -= num_values;
+		return num_values;
+	}
+
 	void clear()
 	{
 		memset((unsigned char*)buffer, 0, max_size * sizeof(T));